@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * @file       pacing.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief Deadlines and link budgets shared by the periodic senders
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef _PACING_H
+#define _PACING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//! Longest burst a budget allows after the link has been idle
+#define PACING_BUDGET_DEPTH_MS 100
+
+/**
+ * Token bucket for a link of limited bandwidth.  Zero initialised it is
+ * unlimited; pacing_budget_init fills it.
+ */
+struct pacing_budget {
+	uint32_t bandwidth;   /**< bytes/s the link carries, 0 if not limited */
+	int32_t budget;       /**< in 1/1000 bytes; negative when overdrawn */
+	uint32_t time;        /**< Systime (ms) of the last refill */
+};
+
+/**
+ * Whether systime a is before b, across the wrap of the ms counter.
+ */
+static inline bool pacing_before(uint32_t a, uint32_t b)
+{
+	return (int32_t) (a - b) < 0;
+}
+
+bool pacing_sooner(uint32_t deadline, uint16_t period,
+		uint32_t other_deadline, uint16_t other_period);
+void pacing_advance(uint32_t *deadline, uint16_t period, uint32_t now);
+
+void pacing_budget_init(struct pacing_budget *budget, uint32_t bandwidth,
+		uint32_t now);
+void pacing_budget_refill(struct pacing_budget *budget, uint32_t now);
+void pacing_budget_charge(struct pacing_budget *budget, uint32_t bytes);
+bool pacing_budget_spent(const struct pacing_budget *budget);
+uint32_t pacing_budget_wait(const struct pacing_budget *budget);
+
+#endif
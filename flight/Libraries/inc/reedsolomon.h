@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * @file       reedsolomon.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief Public header for the table driven Reed-Solomon codec
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef _REEDSOLOMON_H
+#define _REEDSOLOMON_H
+
+#include <stdint.h>
+
+/** Largest number of parity bytes supported by the codec */
+#define RS_MAX_PARITY 16
+
+/** Largest codeword (data + parity) in GF(256) */
+#define RS_MAX_CODEWORD 255
+
+/**
+ * Codec context.  Only holds the precomputed generator polynomial, so one
+ * context can be shared by any number of concurrent encoders/decoders.
+ */
+struct rs_codec {
+	uint8_t nparity;			/**< Parity bytes per codeword */
+	uint8_t gen_log[RS_MAX_PARITY];		/**< log of generator coefficients,
+						 * lowest order first, leading 1
+						 * implied */
+};
+
+int rs_init(struct rs_codec *rs, uint8_t nparity);
+
+void rs_encode(const struct rs_codec *rs, const uint8_t *msg, uint16_t len,
+		uint8_t *parity);
+
+int rs_decode(const struct rs_codec *rs, uint8_t *codeword, uint16_t len);
+
+#endif /* _REEDSOLOMON_H */
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ * @file       pacing.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief Earliest deadline first scheduling and token bucket link budgets,
+ * for the modules that send periodic updates over slow links
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include <pacing.h>
+
+/** Whether a deadline should be served before another.
+ * @param[in] deadline Systime (ms) the first is due
+ * @param[in] period Its period (ms)
+ * @param[in] other_deadline Systime (ms) the second is due
+ * @param[in] other_period Its period (ms)
+ * @returns true if the first is due earlier, or at the same time with a
+ * shorter period
+ */
+bool pacing_sooner(uint32_t deadline, uint16_t period,
+		uint32_t other_deadline, uint16_t other_period)
+{
+	if (deadline == other_deadline) {
+		return period < other_period;
+	}
+
+	return pacing_before(deadline, other_deadline);
+}
+
+/** Move a deadline on by a period once it has been served.  One that has
+ * fallen a whole period behind skips the missed updates rather than
+ * sending them in a burst.
+ * @param[in,out] deadline Systime (ms) it was due
+ * @param[in] period Its period (ms)
+ * @param[in] now The systime (ms)
+ */
+void pacing_advance(uint32_t *deadline, uint16_t period, uint32_t now)
+{
+	*deadline += period;
+
+	if (!pacing_before(now, *deadline)) {
+		*deadline = now + period;
+	}
+}
+
+/** Set up a budget, full.
+ * @param[out] budget The budget
+ * @param[in] bandwidth bytes/s the link carries, 0 if not limited
+ * @param[in] now The systime (ms)
+ */
+void pacing_budget_init(struct pacing_budget *budget, uint32_t bandwidth,
+		uint32_t now)
+{
+	budget->bandwidth = bandwidth;
+	budget->budget = PACING_BUDGET_DEPTH_MS * bandwidth;
+	budget->time = now;
+}
+
+/** Credit the budget for the time since it was last refilled, up to
+ * PACING_BUDGET_DEPTH_MS worth.  Call before deciding what to send.
+ * @param[in,out] budget The budget
+ * @param[in] now The systime (ms)
+ */
+void pacing_budget_refill(struct pacing_budget *budget, uint32_t now)
+{
+	if (budget->bandwidth) {
+		uint32_t elapsed = now - budget->time;
+		int32_t depth = PACING_BUDGET_DEPTH_MS * budget->bandwidth;
+
+		if (elapsed > PACING_BUDGET_DEPTH_MS) {
+			elapsed = PACING_BUDGET_DEPTH_MS;
+		}
+
+		budget->budget += elapsed * budget->bandwidth;
+
+		if (budget->budget > depth) {
+			budget->budget = depth;
+		}
+	}
+
+	budget->time = now;
+}
+
+/** Charge what was sent against the budget.
+ * @param[in,out] budget The budget
+ * @param[in] bytes Bytes put on the link
+ */
+void pacing_budget_charge(struct pacing_budget *budget, uint32_t bytes)
+{
+	if (budget->bandwidth) {
+		budget->budget -= bytes * 1000;
+	}
+}
+
+/** Whether the link has to rest before sending more.
+ * @param[in] budget The budget
+ * @returns true if the budget is limited and overdrawn
+ */
+bool pacing_budget_spent(const struct pacing_budget *budget)
+{
+	return budget->bandwidth && budget->budget <= 0;
+}
+
+/** Time until a spent budget is back in credit.
+ * @param[in] budget The budget
+ * @returns ms to wait, 0 if it isn't spent
+ */
+uint32_t pacing_budget_wait(const struct pacing_budget *budget)
+{
+	if (!pacing_budget_spent(budget)) {
+		return 0;
+	}
+
+	return -budget->budget / budget->bandwidth + 1;
+}
@@ -0,0 +1,358 @@
+/**
+ ******************************************************************************
+ * @file       reedsolomon.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief Reentrant, table driven Reed-Solomon codec over GF(256)
+ *
+ * Codewords are bit-compatible with the rscode library (field polynomial
+ * x^8+x^4+x^3+x^2+1, generator roots a^1..a^nparity, parity appended with
+ * the highest order term first).  All working state lives on the caller's
+ * stack, so a single codec context may be used from several tasks at once.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include <reedsolomon.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** Marks a zero coefficient in gen_log, since log(0) is undefined */
+#define RS_LOG_ZERO 0xff
+
+/* Antilog table, doubled so sums of two logs never need a modulo */
+static const uint8_t rs_exp[512] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d, 0x3a, 0x74, 0xe8,
+	0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4, 0x75, 0xea, 0xc9,
+	0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d, 0x27, 0x4e, 0x9c,
+	0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee, 0xc1, 0x9f, 0x23,
+	0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d, 0xba, 0x69, 0xd2,
+	0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99, 0x2f, 0x5e, 0xbc,
+	0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd, 0xe7, 0xd3, 0xbb,
+	0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b, 0xb6, 0x71, 0xe2,
+	0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d, 0x1a, 0x34, 0x68,
+	0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8, 0xed, 0xc7, 0x93,
+	0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85, 0x17, 0x2e, 0x5c,
+	0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84, 0x15, 0x2a, 0x54,
+	0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49, 0x92, 0x39, 0x72,
+	0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6, 0x91, 0x3f, 0x7e,
+	0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3, 0xdb, 0xab, 0x4b,
+	0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5, 0x57, 0xae, 0x41,
+	0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c, 0x38, 0x70, 0xe0,
+	0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79, 0xf2, 0xf9, 0xef,
+	0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12, 0x24, 0x48, 0x90,
+	0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb, 0x8b, 0x0b, 0x16,
+	0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b, 0x36, 0x6c, 0xd8,
+	0xad, 0x47, 0x8e, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1d,
+	0x3a, 0x74, 0xe8, 0xcd, 0x87, 0x13, 0x26, 0x4c, 0x98, 0x2d, 0x5a, 0xb4,
+	0x75, 0xea, 0xc9, 0x8f, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x9d,
+	0x27, 0x4e, 0x9c, 0x25, 0x4a, 0x94, 0x35, 0x6a, 0xd4, 0xb5, 0x77, 0xee,
+	0xc1, 0x9f, 0x23, 0x46, 0x8c, 0x05, 0x0a, 0x14, 0x28, 0x50, 0xa0, 0x5d,
+	0xba, 0x69, 0xd2, 0xb9, 0x6f, 0xde, 0xa1, 0x5f, 0xbe, 0x61, 0xc2, 0x99,
+	0x2f, 0x5e, 0xbc, 0x65, 0xca, 0x89, 0x0f, 0x1e, 0x3c, 0x78, 0xf0, 0xfd,
+	0xe7, 0xd3, 0xbb, 0x6b, 0xd6, 0xb1, 0x7f, 0xfe, 0xe1, 0xdf, 0xa3, 0x5b,
+	0xb6, 0x71, 0xe2, 0xd9, 0xaf, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0d,
+	0x1a, 0x34, 0x68, 0xd0, 0xbd, 0x67, 0xce, 0x81, 0x1f, 0x3e, 0x7c, 0xf8,
+	0xed, 0xc7, 0x93, 0x3b, 0x76, 0xec, 0xc5, 0x97, 0x33, 0x66, 0xcc, 0x85,
+	0x17, 0x2e, 0x5c, 0xb8, 0x6d, 0xda, 0xa9, 0x4f, 0x9e, 0x21, 0x42, 0x84,
+	0x15, 0x2a, 0x54, 0xa8, 0x4d, 0x9a, 0x29, 0x52, 0xa4, 0x55, 0xaa, 0x49,
+	0x92, 0x39, 0x72, 0xe4, 0xd5, 0xb7, 0x73, 0xe6, 0xd1, 0xbf, 0x63, 0xc6,
+	0x91, 0x3f, 0x7e, 0xfc, 0xe5, 0xd7, 0xb3, 0x7b, 0xf6, 0xf1, 0xff, 0xe3,
+	0xdb, 0xab, 0x4b, 0x96, 0x31, 0x62, 0xc4, 0x95, 0x37, 0x6e, 0xdc, 0xa5,
+	0x57, 0xae, 0x41, 0x82, 0x19, 0x32, 0x64, 0xc8, 0x8d, 0x07, 0x0e, 0x1c,
+	0x38, 0x70, 0xe0, 0xdd, 0xa7, 0x53, 0xa6, 0x51, 0xa2, 0x59, 0xb2, 0x79,
+	0xf2, 0xf9, 0xef, 0xc3, 0x9b, 0x2b, 0x56, 0xac, 0x45, 0x8a, 0x09, 0x12,
+	0x24, 0x48, 0x90, 0x3d, 0x7a, 0xf4, 0xf5, 0xf7, 0xf3, 0xfb, 0xeb, 0xcb,
+	0x8b, 0x0b, 0x16, 0x2c, 0x58, 0xb0, 0x7d, 0xfa, 0xe9, 0xcf, 0x83, 0x1b,
+	0x36, 0x6c, 0xd8, 0xad, 0x47, 0x8e, 0x01, 0x02
+};
+
+/* Log table; rs_log[0] is meaningless and never consulted */
+static const uint8_t rs_log[256] = {
+	0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1a, 0xc6, 0x03, 0xdf, 0x33, 0xee,
+	0x1b, 0x68, 0xc7, 0x4b, 0x04, 0x64, 0xe0, 0x0e, 0x34, 0x8d, 0xef, 0x81,
+	0x1c, 0xc1, 0x69, 0xf8, 0xc8, 0x08, 0x4c, 0x71, 0x05, 0x8a, 0x65, 0x2f,
+	0xe1, 0x24, 0x0f, 0x21, 0x35, 0x93, 0x8e, 0xda, 0xf0, 0x12, 0x82, 0x45,
+	0x1d, 0xb5, 0xc2, 0x7d, 0x6a, 0x27, 0xf9, 0xb9, 0xc9, 0x9a, 0x09, 0x78,
+	0x4d, 0xe4, 0x72, 0xa6, 0x06, 0xbf, 0x8b, 0x62, 0x66, 0xdd, 0x30, 0xfd,
+	0xe2, 0x98, 0x25, 0xb3, 0x10, 0x91, 0x22, 0x88, 0x36, 0xd0, 0x94, 0xce,
+	0x8f, 0x96, 0xdb, 0xbd, 0xf1, 0xd2, 0x13, 0x5c, 0x83, 0x38, 0x46, 0x40,
+	0x1e, 0x42, 0xb6, 0xa3, 0xc3, 0x48, 0x7e, 0x6e, 0x6b, 0x3a, 0x28, 0x54,
+	0xfa, 0x85, 0xba, 0x3d, 0xca, 0x5e, 0x9b, 0x9f, 0x0a, 0x15, 0x79, 0x2b,
+	0x4e, 0xd4, 0xe5, 0xac, 0x73, 0xf3, 0xa7, 0x57, 0x07, 0x70, 0xc0, 0xf7,
+	0x8c, 0x80, 0x63, 0x0d, 0x67, 0x4a, 0xde, 0xed, 0x31, 0xc5, 0xfe, 0x18,
+	0xe3, 0xa5, 0x99, 0x77, 0x26, 0xb8, 0xb4, 0x7c, 0x11, 0x44, 0x92, 0xd9,
+	0x23, 0x20, 0x89, 0x2e, 0x37, 0x3f, 0xd1, 0x5b, 0x95, 0xbc, 0xcf, 0xcd,
+	0x90, 0x87, 0x97, 0xb2, 0xdc, 0xfc, 0xbe, 0x61, 0xf2, 0x56, 0xd3, 0xab,
+	0x14, 0x2a, 0x5d, 0x9e, 0x84, 0x3c, 0x39, 0x53, 0x47, 0x6d, 0x41, 0xa2,
+	0x1f, 0x2d, 0x43, 0xd8, 0xb7, 0x7b, 0xa4, 0x76, 0xc4, 0x17, 0x49, 0xec,
+	0x7f, 0x0c, 0x6f, 0xf6, 0x6c, 0xa1, 0x3b, 0x52, 0x29, 0x9d, 0x55, 0xaa,
+	0xfb, 0x60, 0x86, 0xb1, 0xbb, 0xcc, 0x3e, 0x5a, 0xcb, 0x59, 0x5f, 0xb0,
+	0x9c, 0xa9, 0xa0, 0x51, 0x0b, 0xf5, 0x16, 0xeb, 0x7a, 0x75, 0x2c, 0xd7,
+	0x4f, 0xae, 0xd5, 0xe9, 0xe6, 0xe7, 0xad, 0xe8, 0x74, 0xd6, 0xf4, 0xea,
+	0xa8, 0x50, 0x58, 0xaf
+};
+
+static inline uint8_t gf_mul(uint8_t a, uint8_t b)
+{
+	if (a == 0 || b == 0)
+		return 0;
+
+	return rs_exp[rs_log[a] + rs_log[b]];
+}
+
+static inline uint8_t gf_div(uint8_t a, uint8_t b)
+{
+	if (a == 0)
+		return 0;
+
+	return rs_exp[rs_log[a] + 255 - rs_log[b]];
+}
+
+/**
+ * @brief Evaluate a polynomial (lowest order first) at a^x_log.
+ */
+static uint8_t poly_eval(const uint8_t *poly, int deg, uint16_t x_log)
+{
+	uint8_t sum = 0;
+
+	for (int i = deg; i >= 0; i--) {
+		if (sum)
+			sum = rs_exp[rs_log[sum] + x_log];
+
+		sum ^= poly[i];
+	}
+
+	return sum;
+}
+
+/**
+ * @brief Precompute the generator polynomial for a codec.
+ * @param[out] rs The codec context to fill in
+ * @param[in] nparity Number of parity bytes per codeword
+ * @retval 0 on success
+ * @retval -1 if nparity is out of range
+ */
+int rs_init(struct rs_codec *rs, uint8_t nparity)
+{
+	uint8_t gen[RS_MAX_PARITY + 1];
+
+	if (nparity == 0 || nparity > RS_MAX_PARITY)
+		return -1;
+
+	memset(gen, 0, sizeof(gen));
+	gen[0] = 1;
+
+	/* Multiply out (x + a^i) for i = 1..nparity */
+	for (int i = 1; i <= nparity; i++) {
+		for (int j = i; j > 0; j--)
+			gen[j] = gen[j - 1] ^ gf_mul(gen[j], rs_exp[i]);
+
+		gen[0] = gf_mul(gen[0], rs_exp[i]);
+	}
+
+	rs->nparity = nparity;
+
+	for (int i = 0; i < nparity; i++)
+		rs->gen_log[i] = gen[i] ? rs_log[gen[i]] : RS_LOG_ZERO;
+
+	return 0;
+}
+
+/**
+ * @brief Compute the parity bytes for a message.
+ * @param[in] rs The codec context
+ * @param[in] msg The message
+ * @param[in] len Message length in bytes
+ * @param[out] parity Destination for rs->nparity parity bytes; may point
+ * directly after msg to build the codeword in place
+ */
+void rs_encode(const struct rs_codec *rs, const uint8_t *msg, uint16_t len,
+		uint8_t *parity)
+{
+	const int n = rs->nparity;
+	uint8_t lfsr[RS_MAX_PARITY];
+
+	memset(lfsr, 0, n);
+
+	/* lfsr[0] holds the highest order remainder term */
+	for (uint16_t i = 0; i < len; i++) {
+		uint8_t fb = msg[i] ^ lfsr[0];
+
+		memmove(lfsr, lfsr + 1, n - 1);
+		lfsr[n - 1] = 0;
+
+		if (fb == 0)
+			continue;
+
+		uint16_t fb_log = rs_log[fb];
+
+		for (int j = 0; j < n; j++) {
+			uint8_t g = rs->gen_log[n - 1 - j];
+
+			if (g != RS_LOG_ZERO)
+				lfsr[j] ^= rs_exp[g + fb_log];
+		}
+	}
+
+	memcpy(parity, lfsr, n);
+}
+
+/**
+ * @brief Check a codeword and correct it in place if needed.
+ *
+ * The common case of an undamaged codeword only costs the syndrome
+ * computation; Berlekamp-Massey, the Chien search and Forney's algorithm
+ * only run when a syndrome is nonzero.
+ *
+ * @param[in] rs The codec context
+ * @param[in,out] codeword Message followed by its parity bytes
+ * @param[in] len Total codeword length, including parity
+ * @return Number of bytes corrected, 0 if the codeword was clean
+ * @retval -1 if the codeword is malformed or uncorrectable
+ */
+int rs_decode(const struct rs_codec *rs, uint8_t *codeword, uint16_t len)
+{
+	const int n = rs->nparity;
+	uint8_t syn[RS_MAX_PARITY];
+	bool clean = true;
+
+	if (len <= n || len > RS_MAX_CODEWORD)
+		return -1;
+
+	/* S_j = c(a^(j+1)), codeword[0] is the highest order term */
+	for (int j = 0; j < n; j++) {
+		uint8_t sum = 0;
+
+		for (uint16_t i = 0; i < len; i++) {
+			if (sum)
+				sum = rs_exp[rs_log[sum] + j + 1];
+
+			sum ^= codeword[i];
+		}
+
+		syn[j] = sum;
+		clean &= (sum == 0);
+	}
+
+	if (clean)
+		return 0;
+
+	/* Berlekamp-Massey: find the error locator lambda */
+	uint8_t lambda[RS_MAX_PARITY + 1];
+	uint8_t prev[RS_MAX_PARITY + 1];
+	uint8_t tmp[RS_MAX_PARITY + 1];
+	int l = 0, m = 1;
+	uint8_t b = 1;
+
+	memset(lambda, 0, sizeof(lambda));
+	memset(prev, 0, sizeof(prev));
+	lambda[0] = 1;
+	prev[0] = 1;
+
+	for (int r = 0; r < n; r++) {
+		uint8_t d = syn[r];
+
+		for (int i = 1; i <= l; i++)
+			d ^= gf_mul(lambda[i], syn[r - i]);
+
+		if (d == 0) {
+			m++;
+			continue;
+		}
+
+		uint8_t coef = gf_div(d, b);
+
+		memcpy(tmp, lambda, sizeof(tmp));
+
+		for (int i = 0; i + m <= n; i++)
+			lambda[i + m] ^= gf_mul(coef, prev[i]);
+
+		if (2 * l <= r) {
+			l = r + 1 - l;
+			memcpy(prev, tmp, sizeof(prev));
+			b = d;
+			m = 1;
+		} else {
+			m++;
+		}
+	}
+
+	if (2 * l > n)
+		return -1;
+
+	/* Chien search, restricted to positions inside the codeword */
+	uint16_t err_pos[RS_MAX_PARITY / 2];
+	int found = 0;
+
+	for (uint16_t i = 0; i < len; i++) {
+		uint16_t power = len - 1 - i;
+
+		/* Evaluate lambda at X^-1 = a^-power */
+		if (poly_eval(lambda, l, (255 - power) % 255) != 0)
+			continue;
+
+		if (found == l)
+			return -1;
+
+		err_pos[found++] = i;
+	}
+
+	if (found != l)
+		return -1;
+
+	/* Forney: omega = S(x) * lambda(x) mod x^n */
+	uint8_t omega[RS_MAX_PARITY];
+
+	for (int i = 0; i < n; i++) {
+		uint8_t sum = 0;
+
+		for (int j = 0; j <= i && j <= l; j++)
+			sum ^= gf_mul(lambda[j], syn[i - j]);
+
+		omega[i] = sum;
+	}
+
+	/* Formal derivative only keeps the odd terms in characteristic 2 */
+	uint8_t dlambda[RS_MAX_PARITY];
+
+	memset(dlambda, 0, sizeof(dlambda));
+
+	for (int i = 1; i <= l; i += 2)
+		dlambda[i - 1] = lambda[i];
+
+	uint8_t magnitude[RS_MAX_PARITY / 2];
+
+	for (int k = 0; k < found; k++) {
+		uint16_t xinv_log = (255 - (len - 1 - err_pos[k])) % 255;
+		uint8_t num = poly_eval(omega, n - 1, xinv_log);
+		uint8_t den = poly_eval(dlambda, l > 0 ? l - 1 : 0, xinv_log);
+
+		if (den == 0)
+			return -1;
+
+		magnitude[k] = gf_div(num, den);
+	}
+
+	/* Only touch the buffer once the whole correction is known good */
+	for (int k = 0; k < found; k++)
+		codeword[err_pos[k]] ^= magnitude[k];
+
+	return found;
+}
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup AutotuningModule Autotuning Module
+ * @{
+ *
+ * @file       af_filter.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      System identification EKF used by autotune
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ ******************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef AF_FILTER_H
+#define AF_FILTER_H
+
+#include <stdint.h>
+
+#define AF_NUMX 13
+#define AF_NUMP 43
+
+struct at_measurement {
+	float y[3];		/* Gyro measurements */
+	float u[3];		/* Actuator desired */
+};
+
+//! Tunables of the identification filter
+struct af_params {
+	float q_w;		/* Process noise, rates */
+	float q_ud;		/* Process noise, scaled torques */
+	float q_B;		/* Process noise, torque scale (beta) */
+	float q_tau;		/* Process noise, motor time constant */
+	float q_bias;		/* Process noise, torque biases */
+	float s_a;		/* Expected gyro measurement noise */
+	float tau_init;		/* Initial ln(time constant) */
+};
+
+//! The settings used in flight
+extern const struct af_params af_default_params;
+
+//! Reset the filter state and covariance
+void af_init(float X[AF_NUMX], float P[AF_NUMP], const struct af_params *params);
+
+//! Run one predict/update cycle on a new measurement
+void af_predict(float X[AF_NUMX], float P[AF_NUMP],
+		const struct af_params *params,
+		const struct at_measurement *measurement,
+		const float dT_s, const float t_in);
+
+#endif /* AF_FILTER_H */
+
+/**
+ * @}
+ * @}
+ */
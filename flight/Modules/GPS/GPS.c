@@ -71,6 +71,9 @@ static void updateSettings();
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
 
+// Bytes taken from the COM buffer and handed to the parser at a time
+#define GPS_RX_CHUNK_LEN                32
+
 
 #if defined(PIOS_GPS_MINIMAL)
 	#define STACK_SIZE_BYTES            500
@@ -89,6 +92,7 @@ static bool module_enabled = false;
 static struct pios_thread *gpsTaskHandle;
 
 static char* gps_rx_buffer;
+static uint8_t *gps_rx_chunk;
 
 static struct GPS_RX_STATS gpsRxStats;
 
@@ -183,6 +187,12 @@ int32_t GPSInitialize(void)
 		}
 		PIOS_Assert(gps_rx_buffer);
 
+		gps_rx_chunk = PIOS_malloc(GPS_RX_CHUNK_LEN);
+		if (gps_rx_chunk == NULL) {
+			AlarmsSet(SYSTEMALARMS_ALARM_GPS, SYSTEMALARMS_ALARM_ERROR);
+			return -1;
+		}
+
 		return 0;
 	}
 
@@ -274,21 +284,21 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint16_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, gps_rx_chunk, GPS_RX_CHUNK_LEN, xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_buffer (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_buffer (gps_rx_chunk, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
@@ -38,6 +38,9 @@
 #include "gpstime.h"
 #include "gpssatellites.h"
 #include "GPS.h"
+#include "misc_math.h"
+
+#include <string.h>
 
 //#define ENABLE_DEBUG_MSG						///< define to enable debug-messages
 #define DEBUG_PORT		PIOS_COM_TELEM_RF		///< defines which serial port is ued for debug-messages
@@ -107,6 +110,38 @@ const static struct nmea_parser nmea_parsers[] = {
 #endif //PIOS_GPS_MINIMAL
 };
 
+/**
+ * Check and process a sentence received into gps_rx_buffer
+ * \param[in] rx_count length of the sentence, including the '$' and the
+ * trailing \r\n
+ * \return PARSER_COMPLETE if the checksum was good, PARSER_ERROR if not
+ */
+static int process_nmea_sentence (char *gps_rx_buffer, uint8_t rx_count, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	// The NMEA functions require a zero-terminated string
+	// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
+	gps_rx_buffer[rx_count-2] = 0;
+
+	// Our rxBuffer must look like this now:
+	//   [0]           = '$'
+	//   ...           = zero or more bytes of sentence payload
+	//
+	// Validate the checksum over the sentence
+	if (!NMEA_checksum(&gps_rx_buffer[1]))
+	{	// Invalid checksum.  May indicate dropped characters on Rx.
+		gpsRxStats->gpsRxChkSumError++;
+		return PARSER_ERROR;
+	}
+
+	// Valid checksum, use this packet to update the GPS position
+	if (!NMEA_update_position(&gps_rx_buffer[1], GpsData))
+		gpsRxStats->gpsRxParserError++;
+	else
+		gpsRxStats->gpsRxReceived++;
+
+	return PARSER_COMPLETE;
+}
+
 int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	static uint8_t rx_count = 0;
@@ -149,44 +184,82 @@ int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	else
 	if (found_cr && (c == '\n') )
 	{
-		// The NMEA functions require a zero-terminated string
-		// As we detected \r\n, the string as for sure 2 bytes long, we will also strip the \r\n
-		gps_rx_buffer[rx_count-2] = 0;
+		uint8_t len = rx_count;
 
 		// prepare to parse next sentence
 		start_flag = false;
 		found_cr = false;
 		rx_count = 0;
-		// Our rxBuffer must look like this now:
-		//   [0]           = '$'
-		//   ...           = zero or more bytes of sentence payload
-		//   [end_pos - 1] = '\r'
-		//   [end_pos]     = '\n'
-		//
-		// Prepare to consume the sentence from the buffer
-
-		// Validate the checksum over the sentence
-		if (!NMEA_checksum(&gps_rx_buffer[1]))
-		{	// Invalid checksum.  May indicate dropped characters on Rx.
-			//PIOS_DEBUG_PinHigh(2);
-			gpsRxStats->gpsRxChkSumError++;
-			//PIOS_DEBUG_PinLow(2);
-			return PARSER_ERROR;
+
+		return process_nmea_sentence(gps_rx_buffer, len, GpsData, gpsRxStats);
+	}
+	return PARSER_INCOMPLETE;
+}
+
+/**
+ * Parse a block of received bytes for NMEA sentences.  The start and end
+ * of each sentence are found with memchr and the bytes between copied
+ * across whole.  Sentences may be split across calls; the partial
+ * sentence is kept in gps_rx_buffer.
+ * \param[in] data the received bytes
+ * \param[in] len number of bytes
+ * \return PARSER_COMPLETE if at least one sentence was completed and
+ * processed, PARSER_INCOMPLETE otherwise
+ */
+int parse_nmea_buffer (const uint8_t *data, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	static uint8_t rx_count = 0;
+	static bool start_flag = false;
+
+	int ret = PARSER_INCOMPLETE;
+
+	while (len > 0) {
+		if (!start_flag) {
+			const uint8_t *start = memchr(data, '$', len);
+			if (!start)
+				break;
+
+			len -= start - data;
+			data = start;
+			start_flag = true;
+			rx_count = 0;
 		}
-		else
-		{	// Valid checksum, use this packet to update the GPS position
-			if (!NMEA_update_position(&gps_rx_buffer[1], GpsData)) {
-				//PIOS_DEBUG_PinHigh(2);
-				gpsRxStats->gpsRxParserError++;
-				//PIOS_DEBUG_PinLow(2);
-			}
-			else
-				gpsRxStats->gpsRxReceived++;;
-
-			return PARSER_COMPLETE;
+
+		if (rx_count >= NMEA_MAX_PACKET_LENGTH) {
+			// The buffer is already full and we haven't found a valid NMEA sentence.
+			// Flush the buffer, note the overflow event and drop this byte.
+			gpsRxStats->gpsRxOverflow++;
+			start_flag = false;
+			rx_count = 0;
+			data++;
+			len--;
+			continue;
+		}
+
+		// Take everything up to the next '\n', or as much as fits
+		uint16_t n = MIN(NMEA_MAX_PACKET_LENGTH - rx_count, len);
+		const uint8_t *lf = memchr(data, '\n', n);
+		if (lf)
+			n = lf + 1 - data;
+
+		memcpy(&gps_rx_buffer[rx_count], data, n);
+		rx_count += n;
+		data += n;
+		len -= n;
+
+		// look for ending '\r\n' sequence
+		if (lf && gps_rx_buffer[rx_count - 2] == '\r') {
+			uint8_t sentence_len = rx_count;
+
+			start_flag = false;
+			rx_count = 0;
+
+			if (process_nmea_sentence(gps_rx_buffer, sentence_len, GpsData, gpsRxStats) == PARSER_COMPLETE)
+				ret = PARSER_COMPLETE;
 		}
 	}
-	return PARSER_INCOMPLETE;
+
+	return ret;
 }
 
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
@@ -267,7 +340,7 @@ static bool NMEA_parse_real(int32_t * whole, uint32_t * fract, uint8_t * fract_u
 
 	*whole = strtol(field_w, NULL, 10);
 
-	if (field_w) {
+	if (field_f) {
 		/* decimal was found so we may have a fractional part */
 		*fract = strtoul(field_f, NULL, 10);
 		*fract_units = strlen(field_f);
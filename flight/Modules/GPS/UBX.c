@@ -36,6 +36,13 @@
 
 #include "UBX.h"
 #include "GPS.h"
+#include "misc_math.h"
+
+#include <string.h>
+
+// Class, id and length; laid out in struct UBXHeader as on the wire
+#define UBX_HEADER_LEN	4
+#define UBX_CHECKSUM_LEN	2
 
 static uint32_t parse_errors;
 
@@ -134,6 +141,104 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	return PARSER_INCOMPLETE; // message not (yet) complete
 }
 
+/**
+ * Parse a block of received bytes for messages in UBX binary format.
+ * Finds sync with memchr and copies each part of a frame across whole,
+ * so there's no per-byte work outside of the checksum.  Frames may be
+ * split across calls; the partial frame is kept in gps_rx_buffer.
+ * \param[in] data the received bytes
+ * \param[in] len number of bytes
+ * \return PARSER_COMPLETE if at least one message was completed and
+ * processed, PARSER_INCOMPLETE otherwise
+ */
+int parse_ubx_buffer(const uint8_t *data, uint16_t len, char *gps_rx_buffer,
+		GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	enum proto_states {
+		START,
+		UBX_SY2,
+		UBX_FRAME,
+	};
+
+	static enum proto_states proto_state = START;
+	static uint16_t rx_count = 0;	// frame bytes so far, from the class on
+
+	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
+	uint8_t *header = (uint8_t *)&ubx->header;
+	int ret = PARSER_INCOMPLETE;
+
+	while (len > 0) {
+		const uint8_t *sync;
+		uint16_t n;
+
+		switch (proto_state) {
+		case START:
+			sync = memchr(data, UBX_SYNC1, len);
+			if (!sync)
+				return ret;
+
+			len -= sync + 1 - data;
+			data = sync + 1;
+			proto_state = UBX_SY2;
+			break;
+		case UBX_SY2:
+			if (*data == UBX_SYNC2) {
+				data++;
+				len--;
+				rx_count = 0;
+				proto_state = UBX_FRAME;
+			} else {
+				// Look at this byte again; it may be the first sync char
+				proto_state = START;
+			}
+			break;
+		case UBX_FRAME:
+			if (rx_count < UBX_HEADER_LEN) {
+				n = MIN(UBX_HEADER_LEN - rx_count, len);
+				memcpy(&header[rx_count], data, n);
+				rx_count += n;
+
+				if (rx_count == UBX_HEADER_LEN &&
+						ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				}
+			} else if (rx_count < UBX_HEADER_LEN + ubx->header.len) {
+				uint16_t offset = rx_count - UBX_HEADER_LEN;
+
+				n = MIN(ubx->header.len - offset, len);
+				memcpy(&ubx->payload.payload[offset], data, n);
+				rx_count += n;
+			} else {
+				// ck_a and ck_b follow the length in the header
+				uint16_t offset = rx_count - UBX_HEADER_LEN - ubx->header.len;
+
+				n = MIN(UBX_CHECKSUM_LEN - offset, len);
+				memcpy(&ubx->header.ck_a + offset, data, n);
+				rx_count += n;
+
+				if (offset + n == UBX_CHECKSUM_LEN) {
+					if (checksum_ubx_message(ubx)) {
+						parse_ubx_message(ubx, GpsData);
+						gpsRxStats->gpsRxReceived++;
+						ret = PARSER_COMPLETE;
+					} else {
+						gpsRxStats->gpsRxChkSumError++;
+					}
+
+					proto_state = START;
+				}
+			}
+
+			data += n;
+			len -= n;
+			break;
+		}
+	}
+
+	return ret;
+}
+
 
 // Keep track of various GPS messages needed to make up a single UAVO update
 // time-of-week timestamp is used to correlate matching messages
@@ -166,27 +271,34 @@ bool check_msgtracker (uint32_t tow, uint8_t msg_flag)
 	return true;
 }
 
-static bool checksum_ubx_message (const struct UBXPacket *ubx)
+// 8-bit Fletcher over a span, carrying on from ck_a and ck_b
+static void checksum_ubx_span (const uint8_t *data, uint16_t len, uint8_t *ck_a, uint8_t *ck_b)
 {
-	int i;
-	uint8_t ck_a, ck_b;
+	uint8_t a = *ck_a;
+	uint8_t b = *ck_b;
 
-	ck_a = ubx->header.class;
-	ck_b = ck_a;
+	for (uint16_t i = 0; i < len; i++) {
+		a += data[i];
+		b += a;
+	}
 
-	ck_a += ubx->header.id;
-	ck_b += ck_a;
+	*ck_a = a;
+	*ck_b = b;
+}
 
-	ck_a += ubx->header.len & 0xff;
-	ck_b += ck_a;
+static bool checksum_ubx_message (const struct UBXPacket *ubx)
+{
+	uint8_t ck_a = 0, ck_b = 0;
 
-	ck_a += ubx->header.len >> 8;
-	ck_b += ck_a;
+	const uint8_t header[UBX_HEADER_LEN] = {
+		ubx->header.class,
+		ubx->header.id,
+		ubx->header.len & 0xff,
+		ubx->header.len >> 8,
+	};
 
-	for (i = 0; i < ubx->header.len; i++) {
-		ck_a += ubx->payload.payload[i];
-		ck_b += ck_a;
-	}
+	checksum_ubx_span(header, sizeof(header), &ck_a, &ck_b);
+	checksum_ubx_span(ubx->payload.payload, ubx->header.len, &ck_a, &ck_b);
 
 	if (ubx->header.ck_a == ck_a &&
 			ubx->header.ck_b == ck_b)
@@ -7,7 +7,7 @@
  *
  * @file       geofence.c
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
- * @author     dRonin, http://dronin.org Copyright (C) 2015
+ * @author     dRonin, http://dronin.org Copyright (C) 2015-2016
  * @brief      Check the UAV is within the geofence boundaries
  *
  * @see        The GNU Public License (GPL) Version 3
@@ -35,26 +35,25 @@
 #include "misc_math.h"
 #include "physical_constants.h"
 
+#include "geofence_index.h"
+
+#include "geofencepolygon.h"
 #include "geofencesettings.h"
 #include "positionactual.h"
 #include "modulesettings.h"
 
 
-//
-// Configuration
-//
-#define SAMPLE_PERIOD_MS     250
-
 // Private types
 
-// Private variables
-
 // Private functions
 static void settingsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len);
+static void polygonsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len);
 static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len);
 
 // Private variables
 static GeoFenceSettingsData *geofenceSettings;
+static struct geofence_index *fenceIndex;
+static bool polygonsInvalid;
 
 /**
  * Initialise the module, called on startup
@@ -76,7 +75,8 @@ int32_t GeofenceInitialize(void)
 	}
 #endif
 
-	if (GeoFenceSettingsInitialize() == -1) {
+	if (GeoFenceSettingsInitialize() == -1 ||
+			GeoFencePolygonInitialize() == -1) {
 		module_enabled = false;
 		return -1;
 	}
@@ -84,12 +84,24 @@ int32_t GeofenceInitialize(void)
 	if (module_enabled) {
 		// allocate and initialize the static data storage only if module is enabled
 		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
-		if (geofenceSettings == NULL) {
+		fenceIndex = PIOS_malloc(sizeof(*fenceIndex));
+		if (geofenceSettings == NULL || fenceIndex == NULL) {
 			module_enabled = false;
 			return -1;
 		}
 
+		// Only the first instance is loaded with the other settings
+		for (uint16_t i = GeoFencePolygonGetNumInstances();
+				i < GEOFENCE_INDEX_MAX_POLYGONS; i++) {
+			if (GeoFencePolygonCreateInstance() != i) {
+				break;
+			}
+
+			UAVObjLoad(GeoFencePolygonHandle(), i);
+		}
+
 		GeoFenceSettingsConnectCallback(settingsUpdated);
+		GeoFencePolygonConnectCallback(polygonsUpdated);
 		settingsUpdated(NULL, NULL, NULL, 0);
 
 		return 0;
@@ -105,13 +117,8 @@ int32_t GeofenceStart(void)
 		return -1;
 	}
 
-	// Schedule periodic task to check position
-	UAVObjEvent ev = {
-		.obj = PositionActualHandle(),
-		.instId = 0,
-		.event = 0,
-	};
-	EventPeriodicCallbackCreate(&ev, checkPosition, SAMPLE_PERIOD_MS);
+	// Check every position estimate; the fence index keeps this cheap
+	PositionActualConnectCallback(checkPosition);
 
 	return 0;
 }
@@ -119,7 +126,7 @@ int32_t GeofenceStart(void)
 MODULE_INITCALL(GeofenceInitialize, GeofenceStart);
 
 /**
- * Periodic callback that processes changes in position and
+ * Callback that processes changes in position and
  * sets the alarm.
  */
 static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len)
@@ -129,19 +136,73 @@ static void checkPosition(UAVObjEvent* ev, void *ctx, void *obj, int len)
 		PositionActualData positionActual;
 		PositionActualGet(&positionActual);
 
+		SystemAlarmsAlarmOptions severity = SYSTEMALARMS_ALARM_OK;
+
 		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
 
 		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
+		if (geofenceSettings->ErrorRadius == 0) {
+			// Circle disabled
+		} else if (distance2 > geofenceSettings->ErrorRadius) {
+			severity = SYSTEMALARMS_ALARM_ERROR;
 		} else if (distance2 > geofenceSettings->WarningRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
-		} else {
+			severity = SYSTEMALARMS_ALARM_WARNING;
+		}
+
+		switch (geofence_index_check(fenceIndex, positionActual.North,
+					positionActual.East)) {
+		case GEOFENCE_INDEX_VIOLATION:
+			severity = SYSTEMALARMS_ALARM_ERROR;
+			break;
+		case GEOFENCE_INDEX_NEAR:
+			severity = MAX(severity, SYSTEMALARMS_ALARM_WARNING);
+			break;
+		case GEOFENCE_INDEX_CLEAR:
+			break;
+		}
+
+		// A fence that couldn't be loaded must not go unnoticed
+		if (polygonsInvalid) {
+			severity = MAX(severity, SYSTEMALARMS_ALARM_WARNING);
+		}
+
+		if (severity == SYSTEMALARMS_ALARM_OK) {
 			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
+		} else {
+			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, severity);
 		}
 	}
 }
 
+/**
+ * Recompile the polygon fences into the index
+ */
+static void polygonsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len)
+{
+	(void) ev; (void) ctx; (void) obj; (void) len;
+
+	geofence_index_clear(fenceIndex);
+	polygonsInvalid = false;
+
+	for (uint16_t i = 0; i < GeoFencePolygonGetNumInstances(); i++) {
+		GeoFencePolygonData polygon;
+		GeoFencePolygonInstGet(i, &polygon);
+
+		if (polygon.Type == GEOFENCEPOLYGON_TYPE_DISABLED) {
+			continue;
+		}
+
+		if (polygon.Vertices > GEOFENCEPOLYGON_NORTH_NUMELEM ||
+				geofence_index_add_polygon(fenceIndex,
+					polygon.North, polygon.East, polygon.Vertices,
+					polygon.Type == GEOFENCEPOLYGON_TYPE_EXCLUSION)) {
+			polygonsInvalid = true;
+		}
+	}
+
+	geofence_index_build(fenceIndex, geofenceSettings->PolygonMargin);
+}
+
 /**
  * Update the settings
  */
@@ -153,6 +214,9 @@ static void settingsUpdated(UAVObjEvent* ev, void *ctx, void *obj, int len)
 	// Cache squared distances to save computations
 	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
 	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+
+	// The margin is baked into the index
+	polygonsUpdated(NULL, NULL, NULL, 0);
 }
 
 /**
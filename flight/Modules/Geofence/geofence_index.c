@@ -0,0 +1,366 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_index.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Spatial index over the polygon fences
+ *
+ * The polygons are compiled, whenever they change, into a square grid
+ * covering them plus the warning margin.  Each cell keeps the edges that
+ * come within margin of it and which polygons contain its centre.  To
+ * classify a point, the segment from the point to its cell's centre is
+ * tested against the cell's edges only: every crossing flips the point's
+ * membership of that edge's polygon relative to the centre.  The nearest
+ * boundary within margin is necessarily one of the same edges.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "geofence_index.h"
+
+#include <math.h>
+#include <string.h>
+
+// Private functions
+
+/**
+ * Which side of the line a->b the point c is on; > 0 is to the left
+ */
+static inline float orient(float ax, float ay, float bx, float by,
+		float cx, float cy)
+{
+	return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+/**
+ * Whether segment p-q crosses edge k.  Points exactly on a line count as
+ * being on its right, so a path through a vertex is counted once.
+ */
+static inline bool crosses_edge(const struct geofence_index *idx, uint8_t k,
+		float pn, float pe, float qn, float qe)
+{
+	float an = idx->north[k], ae = idx->east[k];
+	float bn = idx->north[idx->edge_next[k]], be = idx->east[idx->edge_next[k]];
+
+	if ((orient(pn, pe, qn, qe, an, ae) > 0) ==
+			(orient(pn, pe, qn, qe, bn, be) > 0)) {
+		return false;
+	}
+
+	return (orient(an, ae, bn, be, pn, pe) > 0) !=
+		(orient(an, ae, bn, be, qn, qe) > 0);
+}
+
+/**
+ * Squared distance from a point to edge k
+ */
+static float edge_distance2(const struct geofence_index *idx, uint8_t k,
+		float n, float e)
+{
+	float an = idx->north[k], ae = idx->east[k];
+	float dn = idx->north[idx->edge_next[k]] - an;
+	float de = idx->east[idx->edge_next[k]] - ae;
+
+	float len2 = dn * dn + de * de;
+	float t = 0;
+
+	if (len2 > 0) {
+		t = ((n - an) * dn + (e - ae) * de) / len2;
+
+		if (t < 0) {
+			t = 0;
+		} else if (t > 1) {
+			t = 1;
+		}
+	}
+
+	float rn = n - (an + t * dn);
+	float re = e - (ae + t * de);
+
+	return rn * rn + re * re;
+}
+
+/**
+ * Classic ray cast along +north against every edge
+ * \return bit i set if polygon i contains the point
+ */
+static uint8_t inside_brute(const struct geofence_index *idx, float n, float e)
+{
+	uint8_t mask = 0;
+
+	for (uint16_t k = 0; k < idx->num_edges; k++) {
+		float an = idx->north[k], ae = idx->east[k];
+		float bn = idx->north[idx->edge_next[k]];
+		float be = idx->east[idx->edge_next[k]];
+
+		if ((ae > e) != (be > e)) {
+			float cross_n = an + (e - ae) * (bn - an) / (be - ae);
+
+			if (n < cross_n) {
+				mask ^= 1 << idx->edge_poly[k];
+			}
+		}
+	}
+
+	return mask;
+}
+
+/**
+ * Find the cell containing a point
+ * \return false if the point is off the grid, and so at least margin
+ * from every polygon
+ */
+static bool find_cell(const struct geofence_index *idx, float n, float e,
+		uint16_t *cell, float *center_n, float *center_e)
+{
+	float fi = (n - idx->origin_north) * idx->inv_cell_size;
+	float fj = (e - idx->origin_east) * idx->inv_cell_size;
+
+	// Compare as floats; far away positions would overflow the cast
+	if (!(fi >= 0 && fi < GEOFENCE_INDEX_GRID &&
+			fj >= 0 && fj < GEOFENCE_INDEX_GRID)) {
+		return false;
+	}
+
+	uint16_t i = fi, j = fj;
+
+	*cell = i * GEOFENCE_INDEX_GRID + j;
+	*center_n = idx->origin_north + (i + 0.5f) * idx->cell_size;
+	*center_e = idx->origin_east + (j + 0.5f) * idx->cell_size;
+
+	return true;
+}
+
+/**
+ * Remove all polygons
+ */
+void geofence_index_clear(struct geofence_index *idx)
+{
+	memset(idx, 0, sizeof(*idx));
+}
+
+/**
+ * Add a polygon.  The grid isn't usable until geofence_index_build.
+ * \param[in] north,east vertices in either winding order
+ * \param[in] num_vertices at least 3
+ * \param[in] exclusion true if the vehicle must stay out of the polygon,
+ * false if it must stay inside it (or one of the other inclusion polygons)
+ * \return 0 on success, -1 if it's degenerate or there is no room
+ */
+int32_t geofence_index_add_polygon(struct geofence_index *idx,
+		const float *north, const float *east, uint8_t num_vertices,
+		bool exclusion)
+{
+	if (num_vertices < 3 ||
+			idx->num_polygons >= GEOFENCE_INDEX_MAX_POLYGONS ||
+			idx->num_edges + num_vertices > GEOFENCE_INDEX_MAX_EDGES) {
+		return -1;
+	}
+
+	uint16_t first = idx->num_edges;
+
+	for (uint8_t v = 0; v < num_vertices; v++) {
+		uint16_t k = first + v;
+
+		idx->north[k] = north[v];
+		idx->east[k] = east[v];
+		idx->edge_next[k] = (v == num_vertices - 1) ? first : k + 1;
+		idx->edge_poly[k] = idx->num_polygons;
+	}
+
+	idx->num_edges += num_vertices;
+
+	if (exclusion) {
+		idx->exclusion_mask |= 1 << idx->num_polygons;
+	} else {
+		idx->inclusion_mask |= 1 << idx->num_polygons;
+	}
+
+	idx->num_polygons++;
+
+	return 0;
+}
+
+/**
+ * Compile the polygons into the grid
+ * \param[in] margin distance from a boundary that counts as near it
+ */
+void geofence_index_build(struct geofence_index *idx, float margin)
+{
+	idx->margin = margin;
+	idx->gridded = false;
+
+	if (idx->num_edges == 0) {
+		return;
+	}
+
+	float min_n = idx->north[0], max_n = idx->north[0];
+	float min_e = idx->east[0], max_e = idx->east[0];
+
+	for (uint16_t k = 1; k < idx->num_edges; k++) {
+		min_n = fminf(min_n, idx->north[k]);
+		max_n = fmaxf(max_n, idx->north[k]);
+		min_e = fminf(min_e, idx->east[k]);
+		max_e = fmaxf(max_e, idx->east[k]);
+	}
+
+	// Anything off the grid is then at least margin from every edge
+	idx->origin_north = min_n - margin;
+	idx->origin_east = min_e - margin;
+
+	float extent = fmaxf(max_n - min_n, max_e - min_e) + 2 * margin;
+
+	idx->cell_size = fmaxf(extent / GEOFENCE_INDEX_GRID, 1.0f);
+	idx->inv_cell_size = 1.0f / idx->cell_size;
+
+	// An edge can matter to a cell if it passes within margin of any
+	// point of it, so test against the centre with the half diagonal added
+	float reach = margin + idx->cell_size * 0.70710678f;
+	float reach2 = reach * reach;
+
+	uint16_t refs = 0;
+
+	for (uint16_t i = 0; i < GEOFENCE_INDEX_GRID; i++) {
+		for (uint16_t j = 0; j < GEOFENCE_INDEX_GRID; j++) {
+			uint16_t cell = i * GEOFENCE_INDEX_GRID + j;
+			float cn = idx->origin_north + (i + 0.5f) * idx->cell_size;
+			float ce = idx->origin_east + (j + 0.5f) * idx->cell_size;
+
+			idx->cell_start[cell] = refs;
+
+			for (uint16_t k = 0; k < idx->num_edges; k++) {
+				if (edge_distance2(idx, k, cn, ce) > reach2) {
+					continue;
+				}
+
+				if (refs >= GEOFENCE_INDEX_MAX_REFS) {
+					// Still correct, just not fast
+					return;
+				}
+
+				idx->cell_edges[refs++] = k;
+			}
+
+			idx->center_inside[cell] = inside_brute(idx, cn, ce);
+		}
+	}
+
+	idx->cell_start[GEOFENCE_INDEX_CELLS] = refs;
+	idx->gridded = true;
+}
+
+/**
+ * Which polygons contain a point
+ * \return bit i set if polygon i (in the order added) contains it
+ */
+uint8_t geofence_index_inside(const struct geofence_index *idx,
+		float north, float east)
+{
+	if (!idx->gridded) {
+		return inside_brute(idx, north, east);
+	}
+
+	uint16_t cell;
+	float cn, ce;
+
+	if (!find_cell(idx, north, east, &cell, &cn, &ce)) {
+		return 0;
+	}
+
+	uint8_t mask = idx->center_inside[cell];
+
+	for (uint16_t r = idx->cell_start[cell]; r < idx->cell_start[cell + 1]; r++) {
+		uint8_t k = idx->cell_edges[r];
+
+		if (crosses_edge(idx, k, north, east, cn, ce)) {
+			mask ^= 1 << idx->edge_poly[k];
+		}
+	}
+
+	return mask;
+}
+
+/**
+ * Distance to the nearest polygon boundary
+ * \return the distance, or margin if that is closer
+ */
+float geofence_index_distance(const struct geofence_index *idx,
+		float north, float east)
+{
+	float best2 = idx->margin * idx->margin;
+
+	if (!idx->gridded) {
+		for (uint16_t k = 0; k < idx->num_edges; k++) {
+			best2 = fminf(best2, edge_distance2(idx, k, north, east));
+		}
+
+		return sqrtf(best2);
+	}
+
+	uint16_t cell;
+	float cn, ce;
+
+	if (!find_cell(idx, north, east, &cell, &cn, &ce)) {
+		return idx->margin;
+	}
+
+	for (uint16_t r = idx->cell_start[cell]; r < idx->cell_start[cell + 1]; r++) {
+		best2 = fminf(best2,
+				edge_distance2(idx, idx->cell_edges[r], north, east));
+	}
+
+	return sqrtf(best2);
+}
+
+/**
+ * Classify a position against all the fences
+ */
+enum geofence_index_status geofence_index_check(
+		const struct geofence_index *idx, float north, float east)
+{
+	if (idx->num_polygons == 0) {
+		return GEOFENCE_INDEX_CLEAR;
+	}
+
+	uint8_t inside = geofence_index_inside(idx, north, east);
+
+	if ((idx->inclusion_mask && !(inside & idx->inclusion_mask)) ||
+			(inside & idx->exclusion_mask)) {
+		return GEOFENCE_INDEX_VIOLATION;
+	}
+
+	if (geofence_index_distance(idx, north, east) < idx->margin) {
+		return GEOFENCE_INDEX_NEAR;
+	}
+
+	return GEOFENCE_INDEX_CLEAR;
+}
+
+/**
+ * @}
+ * @}
+ */
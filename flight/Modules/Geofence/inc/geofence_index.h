@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_index.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Spatial index over the polygon fences
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef GEOFENCE_INDEX_H
+#define GEOFENCE_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GEOFENCE_INDEX_MAX_POLYGONS 8   /* must fit the inside mask */
+#define GEOFENCE_INDEX_MAX_EDGES    128
+#define GEOFENCE_INDEX_GRID         16
+#define GEOFENCE_INDEX_CELLS        (GEOFENCE_INDEX_GRID * GEOFENCE_INDEX_GRID)
+#define GEOFENCE_INDEX_MAX_REFS     2048
+
+enum geofence_index_status {
+	GEOFENCE_INDEX_CLEAR,       /**< Allowed, and at least margin from any boundary */
+	GEOFENCE_INDEX_NEAR,        /**< Allowed, but within margin of a boundary */
+	GEOFENCE_INDEX_VIOLATION,   /**< Outside every inclusion or inside an exclusion */
+};
+
+/**
+ * Polygons compiled into a uniform grid.  Each cell lists the edges that
+ * pass within margin of it and knows which polygons contain its centre,
+ * so a query only has to look at the handful of edges in its own cell.
+ *
+ * Edge k runs from vertex k to vertex edge_next[k]; polygons are stored
+ * as consecutive runs of vertices.
+ */
+struct geofence_index {
+	float north[GEOFENCE_INDEX_MAX_EDGES];
+	float east[GEOFENCE_INDEX_MAX_EDGES];
+	uint8_t edge_next[GEOFENCE_INDEX_MAX_EDGES];
+	uint8_t edge_poly[GEOFENCE_INDEX_MAX_EDGES];
+	uint16_t num_edges;
+
+	uint8_t num_polygons;
+	uint8_t inclusion_mask;
+	uint8_t exclusion_mask;
+
+	float margin;
+	float origin_north;
+	float origin_east;
+	float cell_size;
+	float inv_cell_size;
+
+	/* Without a grid (too many edge references) every query is brute force */
+	bool gridded;
+
+	uint8_t center_inside[GEOFENCE_INDEX_CELLS];
+	uint16_t cell_start[GEOFENCE_INDEX_CELLS + 1];
+	uint8_t cell_edges[GEOFENCE_INDEX_MAX_REFS];
+};
+
+void geofence_index_clear(struct geofence_index *idx);
+int32_t geofence_index_add_polygon(struct geofence_index *idx,
+		const float *north, const float *east, uint8_t num_vertices,
+		bool exclusion);
+void geofence_index_build(struct geofence_index *idx, float margin);
+
+uint8_t geofence_index_inside(const struct geofence_index *idx,
+		float north, float east);
+float geofence_index_distance(const struct geofence_index *idx,
+		float north, float east);
+enum geofence_index_status geofence_index_check(
+		const struct geofence_index *idx, float north, float east);
+
+#endif /* GEOFENCE_INDEX_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -103,10 +103,12 @@ static void logAll(UAVObjHandle obj);
 static void logSettings(UAVObjHandle obj);
 static void writeHeader();
 static void updateSettings();
+static void updateWriteStats();
 
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
+static uint32_t dropped_bytes;
 static bool destination_onboard_flash;
 
 #ifdef PIOS_INCLUDE_LOG_TO_FLASH
@@ -354,6 +356,7 @@ static void loggingTask(void *parameters)
 				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
 
 				LoggingStatsBytesLoggedSet(&written_bytes);
+				updateWriteStats();
 
 				now = PIOS_Thread_Systime();
 			}
@@ -465,8 +468,10 @@ static int32_t send_data(uint8_t *data, int32_t length)
 
 static int32_t send_data_nonblock(uint8_t *data, int32_t length)
 {
-	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0)
+	if (PIOS_COM_SendBufferNonBlocking(logging_com_id, data, length) < 0) {
+		dropped_bytes += length;
 		return -1;
+	}
 
 	written_bytes += length;
 
@@ -739,6 +744,28 @@ static void updateSettings()
 	}
 }
 
+/**
+ * Publish how much didn't fit in the COM buffer and, when logging to
+ * onboard flash, the longest wait for a page to be written
+ */
+static void updateWriteStats()
+{
+	LoggingStatsBytesDroppedSet(&dropped_bytes);
+
+#ifdef PIOS_INCLUDE_LOG_TO_FLASH
+	if (destination_onboard_flash) {
+		struct pios_streamfs_stats stats;
+
+		if (PIOS_STREAMFS_GetStats(logging_com_id, &stats) == 0) {
+			uint32_t latency_ms = stats.write_latency_max_us / 1000;
+			uint16_t max_latency = (latency_ms > UINT16_MAX) ? UINT16_MAX : latency_ms;
+
+			LoggingStatsMaxWriteLatencySet(&max_latency);
+		}
+	}
+#endif /* PIOS_INCLUDE_LOG_TO_FLASH */
+}
+
 /**
   * @}
   * @}
@@ -166,6 +166,8 @@ typedef struct {
 } point_t;
 
 void clearGraphics();
+void clear_dirty_regions(void);
+void finish_dirty_regions(void);
 void draw_image(uint16_t x, uint16_t y, const struct Image * image);
 void plotFourQuadrants(int32_t centerX, int32_t centerY, int32_t deltaX, int32_t deltaY);
 void ellipse(int centerX, int centerY, int horizontalRadius, int verticalRadius);
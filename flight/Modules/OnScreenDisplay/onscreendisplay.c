@@ -1867,7 +1867,7 @@ static void onScreenDisplayTask(__attribute__((unused)) void *parameters)
 				}
 			}
 
-			clearGraphics();
+			clear_dirty_regions();
 			switch (current_page) {
 			case ONSCREENDISPLAYSETTINGS_PAGECONFIG_OFF:
 				break;
@@ -1903,6 +1903,7 @@ static void onScreenDisplayTask(__attribute__((unused)) void *parameters)
 			sprintf(tmp_str, "%03d %03d", (int)in_time, (int)out_time);
 			write_string(tmp_str, GRAPHICS_X_MIDDLE, GRAPHICS_Y_MIDDLE - 20, 0, 0, TEXT_VA_TOP, TEXT_HA_CENTER, 0, FONT8X10);
 #endif
+			finish_dirty_regions();
 		}
 	}
 }
@@ -58,6 +58,138 @@ extern uint8_t *disp_buffer;
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define DIRTY_BUFFER draw_buffer_mask
+#else
+#define DIRTY_BUFFER draw_buffer
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+// Dirty region tracking. Each of the two frame buffers keeps a short list of
+// rectangles (in buffer bytes) covering everything drawn into it since it was
+// last cleared, so that clearing it for the next frame only has to touch
+// those instead of the whole buffer.
+#define DIRTY_RECTS_MAX  16
+#define DIRTY_MERGE_COLS 2
+#define DIRTY_MERGE_ROWS 4
+
+struct dirty_rect {
+	uint8_t col0, col1;
+	uint16_t row0, row1;
+};
+
+struct dirty_list {
+	const uint8_t *buffer;
+	bool unknown;       // not tracked, must be cleared completely
+	uint8_t num_rects;
+	struct dirty_rect rects[DIRTY_RECTS_MAX];
+};
+
+static struct dirty_list dirty_lists[2] = { { .unknown = true }, { .unknown = true } };
+static struct dirty_list *dirty_cur = &dirty_lists[0];
+static struct dirty_rect *dirty_last;
+
+/**
+ * Forget what is in both buffers, e.g. because they were swapped while a
+ * frame was being drawn and part of it landed in the other buffer.
+ */
+static void dirty_invalidate(void)
+{
+	dirty_lists[0].unknown = true;
+	dirty_lists[1].unknown = true;
+}
+
+/**
+ * Add a rectangle to the current buffer's dirty list, growing a rectangle
+ * it touches or, when the list is full, the one that grows the least.
+ */
+static void dirty_add_rect(int col0, int col1, int row0, int row1)
+{
+	struct dirty_list *list = dirty_cur;
+	struct dirty_rect *r = dirty_last;
+
+#define DIRTY_TOUCHES(r) \
+	(col0 <= (r)->col1 + DIRTY_MERGE_COLS && col1 + DIRTY_MERGE_COLS >= (r)->col0 && \
+	 row0 <= (r)->row1 + DIRTY_MERGE_ROWS && row1 + DIRTY_MERGE_ROWS >= (r)->row0)
+
+	if (r == NULL || !DIRTY_TOUCHES(r)) {
+		int best_growth = INT32_MAX;
+
+		r = NULL;
+		for (int i = 0; i < list->num_rects; i++) {
+			struct dirty_rect *cand = &list->rects[i];
+			if (DIRTY_TOUCHES(cand)) {
+				r = cand;
+				break;
+			}
+			if (list->num_rects == DIRTY_RECTS_MAX) {
+				int area = (cand->col1 - cand->col0 + 1) * (cand->row1 - cand->row0 + 1);
+				int grown = (MAX(cand->col1, col1) - MIN(cand->col0, col0) + 1) *
+						(MAX(cand->row1, row1) - MIN(cand->row0, row0) + 1);
+				if (grown - area < best_growth) {
+					best_growth = grown - area;
+					r = cand;
+				}
+			}
+		}
+
+		if (r == NULL) {
+			r = &list->rects[list->num_rects++];
+			r->col0 = col0;
+			r->col1 = col1;
+			r->row0 = row0;
+			r->row1 = row1;
+			dirty_last = r;
+			return;
+		}
+	}
+#undef DIRTY_TOUCHES
+
+	r->col0 = MIN(r->col0, col0);
+	r->col1 = MAX(r->col1, col1);
+	r->row0 = MIN(r->row0, row0);
+	r->row1 = MAX(r->row1, row1);
+	dirty_last = r;
+}
+
+/**
+ * mark_dirty: Record that pixels in a rectangle of the draw buffer are
+ * about to be written. Coordinates are inclusive and are clipped to the
+ * buffer.
+ */
+static inline void mark_dirty(int x0, int x1, int y0, int y1)
+{
+	if (dirty_cur->unknown) {
+		return;
+	}
+	if (dirty_cur->buffer != DIRTY_BUFFER) {
+		dirty_invalidate();
+		return;
+	}
+
+	x0 = MAX(x0, 0);
+	x1 = MIN(x1, BUFFER_WIDTH * PIXELS_PER_BIT - 1);
+	y0 = MAX(y0, 0);
+	y1 = MIN(y1, BUFFER_HEIGHT - 1);
+	if (x0 > x1 || y0 > y1) {
+		return;
+	}
+
+	int col0 = x0 / PIXELS_PER_BIT;
+	int col1 = x1 / PIXELS_PER_BIT;
+	struct dirty_rect *r = dirty_last;
+	if (r != NULL && col0 >= r->col0 && col1 <= r->col1 && y0 >= r->row0 && y1 <= r->row1) {
+		return;
+	}
+	dirty_add_rect(col0, col1, y0, y1);
+}
+
+static inline void put_pixel_lm(int x, int y, int mmode, int lmode);
+
+/**
+ * clearGraphics: Clear the whole draw buffer. Anything drawn afterwards is
+ * not tracked, so both buffers are cleared completely by the next
+ * clear_dirty_regions() on them.
+ */
 void clearGraphics()
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
@@ -66,12 +198,74 @@ void clearGraphics()
 #else
 	memset((uint8_t *)draw_buffer, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	dirty_invalidate();
+}
+
+/**
+ * clear_dirty_regions: Clear the draw buffer before drawing a frame, touching
+ * only what was drawn into this buffer the last time it was used. Pair
+ * with finish_dirty_regions() once the frame has been drawn.
+ */
+void clear_dirty_regions(void)
+{
+	const uint8_t *buffer = DIRTY_BUFFER;
+	struct dirty_list *list;
+
+	if (dirty_lists[0].buffer == buffer) {
+		list = &dirty_lists[0];
+	} else if (dirty_lists[1].buffer == buffer) {
+		list = &dirty_lists[1];
+	} else {
+		list = (dirty_lists[0].buffer == NULL) ? &dirty_lists[0] : &dirty_lists[1];
+		list->buffer = buffer;
+		list->unknown = true;
+	}
+
+	if (list->unknown) {
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+		memset(draw_buffer_mask, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+		memset(draw_buffer_level, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+#else
+		memset(draw_buffer, 0, BUFFER_HEIGHT * BUFFER_WIDTH);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	} else {
+		for (int i = 0; i < list->num_rects; i++) {
+			const struct dirty_rect *r = &list->rects[i];
+			int len = r->col1 - r->col0 + 1;
+			for (int row = r->row0; row <= r->row1; row++) {
+				int addr = row * BUFFER_WIDTH + r->col0;
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+				memset(&draw_buffer_mask[addr], 0, len);
+				memset(&draw_buffer_level[addr], 0, len);
+#else
+				memset(&draw_buffer[addr], 0, len);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+			}
+		}
+	}
+
+	list->unknown = false;
+	list->num_rects = 0;
+	dirty_cur = list;
+	dirty_last = NULL;
+}
+
+/**
+ * finish_dirty_regions: Called once a frame has been drawn. If the buffers
+ * were swapped while it was being drawn, the tracking can't be trusted.
+ */
+void finish_dirty_regions(void)
+{
+	if (dirty_cur->buffer != DIRTY_BUFFER) {
+		dirty_invalidate();
+	}
 }
 
 void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 {
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 	CHECK_COORDS(x + image->width, y + image->height);
+	mark_dirty(x, x + image->width + PIXELS_PER_BIT - 1, y, y + image->height - 1);
 	uint8_t byte_width = image->width / 8;
 	uint8_t pixel_offset = x % 8;
 	uint8_t mask1 = 0xFF;
@@ -98,6 +292,7 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 	}
 #else
 	CHECK_COORDS(x + image->width, y + image->height);
+	mark_dirty(x, x + image->width + PIXELS_PER_BIT - 1, y, y + image->height - 1);
 	uint8_t byte_width = image->width / 4;
 	uint8_t pixel_offset = 2 * (x % 4);
 	uint8_t mask1 = 0xFF;
@@ -136,10 +331,11 @@ void draw_image(uint16_t x, uint16_t y, const struct Image * image)
 /// \param color the color to draw the pixels with.
 void plotFourQuadrants(int32_t centerX, int32_t centerY, int32_t deltaX, int32_t deltaY)
 {
-	write_pixel_lm(centerX + deltaX, centerY + deltaY, 1, 1); // Ist      Quadrant
-	write_pixel_lm(centerX - deltaX, centerY + deltaY, 1, 1); // IInd     Quadrant
-	write_pixel_lm(centerX - deltaX, centerY - deltaY, 1, 1); // IIIrd    Quadrant
-	write_pixel_lm(centerX + deltaX, centerY - deltaY, 1, 1); // IVth     Quadrant
+	mark_dirty(centerX - abs(deltaX), centerX + abs(deltaX), centerY - abs(deltaY), centerY + abs(deltaY));
+	put_pixel_lm(centerX + deltaX, centerY + deltaY, 1, 1); // Ist      Quadrant
+	put_pixel_lm(centerX - deltaX, centerY + deltaY, 1, 1); // IInd     Quadrant
+	put_pixel_lm(centerX - deltaX, centerY - deltaY, 1, 1); // IIIrd    Quadrant
+	put_pixel_lm(centerX + deltaX, centerY - deltaY, 1, 1); // IVth     Quadrant
 }
 
 /// Implements the midpoint ellipse drawing algorithm which is a bresenham
@@ -162,6 +358,8 @@ void ellipse(int centerX, int centerY, int horizontalRadius, int verticalRadius)
 	int deltaX = 0;
 	int deltaY = (doubleHorizontalRadius << 1) * y;
 
+	mark_dirty(centerX - horizontalRadius - 1, centerX + horizontalRadius + 1,
+			centerY - verticalRadius - 1, centerY + verticalRadius + 1);
 	plotFourQuadrants(centerX, centerY, x, y);
 
 	while (deltaY >= deltaX) {
@@ -220,7 +418,19 @@ void drawBox(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
 	write_line_lm(x1, y2, x2, y2, 1, 1); // bottom
 }
 
+// The put_pixel variants don't mark the pixel dirty; they are for drawing
+// routines that have already marked the area they draw in.
 #if defined(PIOS_VIDEO_SPLITBUFFER)
+static inline void put_pixel(uint8_t *buff, int x, int y, int mode)
+{
+	CHECK_COORDS(x, y);
+	// Determine the bit in the word to be set and the word
+	// index to set it in.
+	int wordnum = CALC_BUFF_ADDR(x, y);
+	uint8_t mask = CALC_BIT_MASK(x);
+	WRITE_WORD_MODE(buff, wordnum, mask, mode);
+}
+
 /**
  * write_pixel: Write a pixel at an x,y position to a given surface.
  *
@@ -230,25 +440,43 @@ void drawBox(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2)
  * @param       mode    0 = clear bit, 1 = set bit, 2 = toggle bit
  */
 void write_pixel(uint8_t *buff, int x, int y, int mode)
+{
+	mark_dirty(x, x, y, y);
+	put_pixel(buff, x, y, mode);
+}
+#else
+static inline void put_pixel(int x, int y, uint8_t value)
 {
 	CHECK_COORDS(x, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
 	int wordnum = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
-	WRITE_WORD_MODE(buff, wordnum, mask, mode);
+	WRITE_WORD(draw_buffer, wordnum, mask, value);
 }
-#else
+
 void write_pixel(int x, int y, uint8_t value)
+{
+	mark_dirty(x, x, y, y);
+	put_pixel(x, y, value);
+}
+#endif /* PIOS_VIDEO_SPLITBUFFER */
+
+static inline void put_pixel_lm(int x, int y, int mmode, int lmode)
 {
 	CHECK_COORDS(x, y);
 	// Determine the bit in the word to be set and the word
 	// index to set it in.
-	int wordnum = CALC_BUFF_ADDR(x, y);
+	int addr   = CALC_BUFF_ADDR(x, y);
 	uint8_t mask = CALC_BIT_MASK(x);
-	WRITE_WORD(draw_buffer, wordnum, mask, value);
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	WRITE_WORD_MODE(draw_buffer_mask, addr, mask, mmode);
+	WRITE_WORD_MODE(draw_buffer_level, addr, mask, lmode);
+#else
+	uint8_t value = PACK_BITS(mmode, lmode);
+	WRITE_WORD(draw_buffer, addr, mask, value);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 }
-#endif /* PIOS_VIDEO_SPLITBUFFER */
 
 /**
  * write_pixel_lm: write the pixel on both surfaces (level and mask.)
@@ -261,19 +489,59 @@ void write_pixel(int x, int y, uint8_t value)
  */
 void write_pixel_lm(int x, int y, int mmode, int lmode)
 {
-	CHECK_COORDS(x, y);
-	// Determine the bit in the word to be set and the word
-	// index to set it in.
-	int addr   = CALC_BUFF_ADDR(x, y);
-	uint8_t mask = CALC_BIT_MASK(x);
+	mark_dirty(x, x, y, y);
+	put_pixel_lm(x, y, mmode, lmode);
+}
+
+// The buffers are stored most significant pixel first, so a 32-bit word
+// loaded from them on our little-endian CPUs has its bytes backwards.
+#define BUFFER_WORD(w) __builtin_bswap32(w)
+
+static inline uint32_t load_word(const uint8_t *p)
+{
+	uint32_t w;
+	memcpy(&w, p, sizeof(w));
+	return w;
+}
+
+static inline void store_word(uint8_t *p, uint32_t w)
+{
+	memcpy(p, &w, sizeof(w));
+}
+
 #if defined(PIOS_VIDEO_SPLITBUFFER)
-	WRITE_WORD_MODE(draw_buffer_mask, addr, mask, mmode);
-	WRITE_WORD_MODE(draw_buffer_level, addr, mask, lmode);
-#else
-	uint8_t value = PACK_BITS(mmode, lmode);
-	WRITE_WORD(draw_buffer, addr, mask, value);
-#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+/**
+ * write_span_mode: write whole bytes from addr0 to addr1 (inclusive), a word
+ * at a time rather than through WRITE_WORD_MODE for every byte.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr0   first byte
+ * @param       addr1   last byte
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static inline void write_span_mode(uint8_t *buff, int addr0, int addr1, int mode)
+{
+	if (addr1 < addr0) {
+		return;
+	}
+	switch (mode) {
+	case 0:
+		memset(&buff[addr0], 0x00, addr1 - addr0 + 1);
+		break;
+	case 1:
+		memset(&buff[addr0], 0xff, addr1 - addr0 + 1);
+		break;
+	case 2:
+		for (; addr0 + 3 <= addr1; addr0 += 4) {
+			store_word(&buff[addr0], ~load_word(&buff[addr0]));
+		}
+		for (; addr0 <= addr1; addr0++) {
+			buff[addr0] ^= 0xff;
+		}
+		break;
+	}
 }
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
 /**
  * write_hline: optimised horizontal line writing algorithm
@@ -296,13 +564,14 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 	if (x0 == x1) {
 		return;
 	}
+	mark_dirty(x0, x1, y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x0);
 	int addr1_bit = CALC_BIT_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -314,11 +583,8 @@ void write_hline(uint8_t *buff, int x0, int x1, int y, int mode)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD_MODE(buff, addr0, mask_l, mode);
 		WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD_MODE(buff, i, m, mode);
-		}
+		// Now fill the whole bytes from start+1 to end-1.
+		write_span_mode(buff, addr0 + 1, addr1 - 1, mode);
 	}
 }
 #else
@@ -333,13 +599,14 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 	if (x0 == x1) {
 		return;
 	}
+	mark_dirty(x0, x1, y, y);
 	/* This is an optimised algorithm for writing horizontal lines.
 	 * We begin by finding the addresses of the x0 and x1 points. */
 	int addr0     = CALC_BUFF_ADDR(x0, y);
 	int addr1     = CALC_BUFF_ADDR(x1, y);
 	int addr0_bit = CALC_BIT1_IN_WORD(x0);
 	int addr1_bit = CALC_BIT0_IN_WORD(x1);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	/* If the addresses are equal, we only need to write one word
 	 * which is an island. */
 	if (addr0 == addr1) {
@@ -351,10 +618,9 @@ void write_hline(int x0, int x1, int y, uint8_t value)
 		mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
 		WRITE_WORD(draw_buffer, addr0, mask_l, value);
 		WRITE_WORD(draw_buffer, addr1, mask_r, value);
-		// Now write 0xffff words from start+1 to end-1.
-		for (i = addr0 + 1; i <= addr1 - 1; i++) {
-			uint8_t m = 0xff;
-			WRITE_WORD(draw_buffer, i, m, value);
+		// Now fill the whole bytes from start+1 to end-1.
+		if (addr1 - addr0 > 1) {
+			memset(&draw_buffer[addr0 + 1], value, addr1 - addr0 - 1);
 		}
 	}
 }
@@ -433,6 +699,7 @@ void write_vline(uint8_t *buff, int x, int y0, int y1, int mode)
 	if (y0 == y1) {
 		return;
 	}
+	mark_dirty(x, x, y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -457,6 +724,7 @@ void write_vline(int x, int y0, int y1, uint8_t value)
 	if (y0 == y1) {
 		return;
 	}
+	mark_dirty(x, x, y0, y1);
 	/* This is an optimised algorithm for writing vertical lines.
 	 * We begin by finding the addresses of the x,y0 and x,y1 points. */
 	int addr0  = CALC_BUFF_ADDR(x, y0);
@@ -547,13 +815,14 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_dirty(x, x + width, y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -576,15 +845,12 @@ void write_filled_rectangle(uint8_t *buff, int x, int y, int width, int height,
 			addr1 += BUFFER_WIDTH;
 			yy++;
 		}
-		// Now write 0xffff words from start+1 to end-1 for each row.
+		// Now fill the whole bytes from start+1 to end-1 for each row.
 		yy    = 0;
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD_MODE(buff, i, m, mode);
-			}
+			write_span_mode(buff, addr0 + 1, addr1 - 1, mode);
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
 			yy++;
@@ -601,13 +867,14 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 	if (width <= 0 || height <= 0) {
 		return;
 	}
+	mark_dirty(x, x + width, y, y + height - 1);
 	// Calculate as if the rectangle was only a horizontal line. We then
 	// step these addresses through each row until we iterate `height` times.
 	int addr0     = CALC_BUFF_ADDR(x, y);
 	int addr1     = CALC_BUFF_ADDR(x + width, y);
 	int addr0_bit = CALC_BIT_IN_WORD(x);
 	int addr1_bit = CALC_BIT_IN_WORD(x + width);
-	int mask, mask_l, mask_r, i;
+	int mask, mask_l, mask_r;
 	// If the addresses are equal, we need to write one word vertically.
 	if (addr0 == addr1) {
 		mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -630,14 +897,13 @@ void write_filled_rectangle(int x, int y, int width, int height, uint8_t value)
 			addr1 += BUFFER_WIDTH;
 			yy++;
 		}
-		// Now write 0xffff words from start+1 to end-1 for each row.
+		// Now fill the whole bytes from start+1 to end-1 for each row.
 		yy    = 0;
 		addr0 = addr0_old;
 		addr1 = addr1_old;
 		while (yy < height) {
-			for (i = addr0 + 1; i <= addr1 - 1; i++) {
-				uint8_t m = 0xff;
-				WRITE_WORD(draw_buffer, i, m, value);
+			if (addr1 - addr0 > 1) {
+				memset(&draw_buffer[addr0 + 1], value, addr1 - addr0 - 1);
 			}
 			addr0 += BUFFER_WIDTH;
 			addr1 += BUFFER_WIDTH;
@@ -702,6 +968,7 @@ void write_rectangle_outlined(int x, int y, int width, int height, int mode, int
 void write_circle(uint8_t *buff, int cx, int cy, int r, int dashp, int mode)
 {
 	CHECK_COORDS(cx, cy);
+	mark_dirty(cx - r, cx + r, cy - r, cy + r);
 	int error = -r, x = r, y = 0;
 	while (x >= y) {
 		if (dashp == 0 || (y % dashp) < (dashp / 2)) {
@@ -732,6 +999,7 @@ void write_circle_outlined(int cx, int cy, int r, int dashp, int bmode, int mode
 	int stroke, fill;
 
 	CHECK_COORDS(cx, cy);
+	mark_dirty(cx - r - 1, cx + r + 1, cy - r - 1, cy + r + 1);
 	SETUP_STROKE_FILL(stroke, fill, mode);
 	// This is a two step procedure. First, we draw the outline of the
 	// circle, then we draw the inner part.
@@ -836,6 +1104,7 @@ void write_circle_filled(uint8_t *buff, int cx, int cy, int r, int mode)
 void write_line(uint8_t *buff, int x0, int y0, int x1, int y1, int mode)
 {
 	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+	mark_dirty(MIN(x0, x1), MAX(x0, x1), MIN(y0, y1), MAX(y0, y1));
 	int steep = abs(y1 - y0) > abs(x1 - x0);
 
 	if (steep) {
@@ -859,9 +1128,9 @@ void write_line(uint8_t *buff, int x0, int y0, int x1, int y1, int mode)
 	}
 	for (x = x0; x < x1; x++) {
 		if (steep) {
-			write_pixel(buff, y, x, mode);
+			put_pixel(buff, y, x, mode);
 		} else {
-			write_pixel(buff, x, y, mode);
+			put_pixel(buff, x, y, mode);
 		}
 		error -= deltay;
 		if (error < 0) {
@@ -874,6 +1143,7 @@ void write_line(uint8_t *buff, int x0, int y0, int x1, int y1, int mode)
 void write_line(int x0, int y0, int x1, int y1, uint8_t value)
 {
 	// Based on http://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
+	mark_dirty(MIN(x0, x1), MAX(x0, x1), MIN(y0, y1), MAX(y0, y1));
 	int steep = abs(y1 - y0) > abs(x1 - x0);
 
 	if (steep) {
@@ -897,9 +1167,9 @@ void write_line(int x0, int y0, int x1, int y1, uint8_t value)
 	}
 	for (x = x0; x < x1; x++) {
 		if (steep) {
-			write_pixel(y, x, value);
+			put_pixel(y, x, value);
 		} else {
-			write_pixel(x, y, value);
+			put_pixel(x, y, value);
 		}
 		error -= deltay;
 		if (error < 0) {
@@ -958,6 +1228,7 @@ void write_line_outlined(int x0, int y0, int x1, int y1,
 		omode = 1;
 		imode = 0;
 	}
+	mark_dirty(MIN(x0, x1) - 1, MAX(x0, x1) + 1, MIN(y0, y1) - 1, MAX(y0, y1) + 1);
 	int steep = abs(y1 - y0) > abs(x1 - x0);
 	if (steep) {
 		SWAP(x0, y0);
@@ -981,15 +1252,15 @@ void write_line_outlined(int x0, int y0, int x1, int y1,
 	// Draw the outline.
 	for (x = x0; x < x1; x++) {
 		if (steep) {
-			write_pixel_lm(y - 1, x, mmode, omode);
-			write_pixel_lm(y + 1, x, mmode, omode);
-			write_pixel_lm(y, x - 1, mmode, omode);
-			write_pixel_lm(y, x + 1, mmode, omode);
+			put_pixel_lm(y - 1, x, mmode, omode);
+			put_pixel_lm(y + 1, x, mmode, omode);
+			put_pixel_lm(y, x - 1, mmode, omode);
+			put_pixel_lm(y, x + 1, mmode, omode);
 		} else {
-			write_pixel_lm(x - 1, y, mmode, omode);
-			write_pixel_lm(x + 1, y, mmode, omode);
-			write_pixel_lm(x, y - 1, mmode, omode);
-			write_pixel_lm(x, y + 1, mmode, omode);
+			put_pixel_lm(x - 1, y, mmode, omode);
+			put_pixel_lm(x + 1, y, mmode, omode);
+			put_pixel_lm(x, y - 1, mmode, omode);
+			put_pixel_lm(x, y + 1, mmode, omode);
 		}
 		error -= deltay;
 		if (error < 0) {
@@ -1002,9 +1273,9 @@ void write_line_outlined(int x0, int y0, int x1, int y1,
 	y     = y0;
 	for (x = x0; x < x1; x++) {
 		if (steep) {
-			write_pixel_lm(y, x, mmode, imode);
+			put_pixel_lm(y, x, mmode, imode);
 		} else {
-			write_pixel_lm(x, y, mmode, imode);
+			put_pixel_lm(x, y, mmode, imode);
 		}
 		error -= deltay;
 		if (error < 0) {
@@ -1042,6 +1313,7 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 		omode = 1;
 		imode = 0;
 	}
+	mark_dirty(MIN(x0, x1) - 1, MAX(x0, x1) + 1, MIN(y0, y1) - 1, MAX(y0, y1) + 1);
 	int steep = abs(y1 - y0) > abs(x1 - x0);
 	if (steep) {
 		SWAP(x0, y0);
@@ -1071,15 +1343,15 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 		}
 		if (draw % 2) {
 			if (steep) {
-				write_pixel_lm(y - 1, x, mmode, omode);
-				write_pixel_lm(y + 1, x, mmode, omode);
-				write_pixel_lm(y, x - 1, mmode, omode);
-				write_pixel_lm(y, x + 1, mmode, omode);
+				put_pixel_lm(y - 1, x, mmode, omode);
+				put_pixel_lm(y + 1, x, mmode, omode);
+				put_pixel_lm(y, x - 1, mmode, omode);
+				put_pixel_lm(y, x + 1, mmode, omode);
 			} else {
-				write_pixel_lm(x - 1, y, mmode, omode);
-				write_pixel_lm(x + 1, y, mmode, omode);
-				write_pixel_lm(x, y - 1, mmode, omode);
-				write_pixel_lm(x, y + 1, mmode, omode);
+				put_pixel_lm(x - 1, y, mmode, omode);
+				put_pixel_lm(x + 1, y, mmode, omode);
+				put_pixel_lm(x, y - 1, mmode, omode);
+				put_pixel_lm(x, y + 1, mmode, omode);
 			}
 		}
 		error -= deltay;
@@ -1099,9 +1371,9 @@ void write_line_outlined_dashed(int x0, int y0, int x1, int y1,
 		}
 		if (draw % 2) {
 			if (steep) {
-				write_pixel_lm(y, x, mmode, imode);
+				put_pixel_lm(y, x, mmode, imode);
 			} else {
-				write_pixel_lm(x, y, mmode, imode);
+				put_pixel_lm(x, y, mmode, imode);
 			}
 		}
 		error -= deltay;
@@ -1195,6 +1467,58 @@ void write_word_misaligned_MASKED(uint8_t *buff, uint16_t word, uint16_t mask, u
 	}
 }
 
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+// Bytes of a line write_glyph_word touches
+#define GLYPH_WORD_BYTES(font_info) 4
+
+/**
+ * write_glyph_word: Draw one row of a glyph, up to 16 pixels at an x offset,
+ * with a single 32-bit read-modify-write of each buffer.
+ *
+ * This does what write_word_misaligned_OR on both buffers followed by
+ * write_word_misaligned_NAND on the level buffer do a byte at a time.
+ *
+ * @param       addr    address of first byte
+ * @param       mask    glyph mask, leftmost pixel in bit 15
+ * @param       levels  glyph levels, leftmost pixel in bit 15
+ * @param       xoff    x offset (0-7)
+ */
+static inline void write_glyph_word(unsigned int addr, uint16_t mask, uint16_t levels, unsigned int xoff)
+{
+	uint32_t m = BUFFER_WORD((uint32_t)mask << (16 - xoff));
+	uint32_t l = BUFFER_WORD((uint32_t)levels << (16 - xoff));
+
+	store_word(&draw_buffer_mask[addr], load_word(&draw_buffer_mask[addr]) | m);
+	store_word(&draw_buffer_level[addr], (load_word(&draw_buffer_level[addr]) | m) & ~(m & l));
+}
+#else
+// Bytes of a line write_glyph_word touches
+#define GLYPH_WORD_BYTES(font_info) (((font_info)->width > 8) ? 5 : 4)
+
+/**
+ * write_glyph_word: Draw one row of a glyph, up to 16 pixels at an x offset,
+ * with a single 32-bit read-modify-write (and one more byte if the row
+ * is 16 pixels wide and not byte aligned).
+ *
+ * This does what one or two write_word_misaligned_MASKED calls do a byte
+ * at a time.
+ *
+ * @param       addr    address of first byte
+ * @param       data    glyph pixels, leftmost pixel in bits 31-30
+ * @param       mask    mask for data
+ * @param       xoff    x offset in bits (0, 2, 4 or 6)
+ */
+static inline void write_glyph_word(unsigned int addr, uint32_t data, uint32_t mask, unsigned int xoff)
+{
+	uint32_t d = BUFFER_WORD(data >> xoff);
+	uint32_t m = BUFFER_WORD(mask >> xoff);
+
+	store_word(&draw_buffer[addr], (load_word(&draw_buffer[addr]) & ~m) | (d & m));
+	if (xoff > 0 && (uint8_t)(mask << (8 - xoff))) {
+		WRITE_WORD(draw_buffer, addr + 4, (uint8_t)(mask << (8 - xoff)), (uint8_t)(data << (8 - xoff)));
+	}
+}
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 
 /**
  * write_char: Draw a character on the current draw buffer.
@@ -1225,11 +1549,18 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 		return;
 	}
 
+	// Glyph rows are 8 or 16 pixels, plus up to a byte for the x offset
+	mark_dirty(x, x + ((font_info->width > 8) ? 16 : 8) + PIXELS_PER_BIT - 1, y, y + font_info->height - 1);
+
 	// Compute starting address of character
 	int addr = CALC_BUFF_ADDR(x, y);
 	int wbit = CALC_BIT_IN_WORD(x);
 	row = ch * font_info->height;
 
+	// Rows are written a word at a time unless that would run past the
+	// end of the line.
+	bool word_fits = x >= 0 && CALC_BUFF_ADDR(x, 0) + GLYPH_WORD_BYTES(font_info) <= BUFFER_WIDTH;
+
 	if (font_info->width > 8) {
 		uint32_t data;
 		for (yy = y; yy < y + font_info->height; yy++) {
@@ -1238,19 +1569,29 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				mask = data & 0xFFFF;
 				levels   = (data >> 16) & 0xFFFF;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				if (word_fits) {
+					write_glyph_word(addr, mask, levels, wbit);
+				} else {
+					// mask
+					write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
+					// level
+					write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
+					mask = (mask & levels);
+					write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				}
 #else
 				data16 = (data & 0xFFFF0000) >> 16;
 				mask = data16 | (data16 << 1);
-				write_word_misaligned_MASKED(draw_buffer, data16, mask, addr, wbit);
-				data16 = (data & 0x0000FFFF);
-				mask = data16 | (data16 << 1);
-				write_word_misaligned_MASKED(draw_buffer, data16, mask, addr + 2, wbit);
+				if (word_fits) {
+					uint16_t data16_r = data & 0x0000FFFF;
+					uint16_t mask_r = data16_r | (data16_r << 1);
+					write_glyph_word(addr, data, (uint32_t)mask << 16 | mask_r, wbit);
+				} else {
+					write_word_misaligned_MASKED(draw_buffer, data16, mask, addr, wbit);
+					data16 = (data & 0x0000FFFF);
+					mask = data16 | (data16 << 1);
+					write_word_misaligned_MASKED(draw_buffer, data16, mask, addr + 2, wbit);
+				}
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 			}
 			addr += BUFFER_WIDTH;
@@ -1265,15 +1606,23 @@ void write_char(uint8_t ch, int x, int y, const struct FontEntry *font_info)
 #if defined(PIOS_VIDEO_SPLITBUFFER)
 				levels = data & 0xFF00;
 				mask = (data & 0x00FF) << 8;
-				// mask
-				write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
-				// level
-				write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
-				mask = (mask & levels);
-				write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				if (word_fits) {
+					write_glyph_word(addr, mask, levels, wbit);
+				} else {
+					// mask
+					write_word_misaligned_OR(draw_buffer_mask, mask, addr, wbit);
+					// level
+					write_word_misaligned_OR(draw_buffer_level, mask, addr, wbit);
+					mask = (mask & levels);
+					write_word_misaligned_NAND(draw_buffer_level, mask, addr, wbit);
+				}
 #else
 				mask = data | (data << 1);
-				write_word_misaligned_MASKED(draw_buffer, data, mask, addr, wbit);
+				if (word_fits) {
+					write_glyph_word(addr, (uint32_t)data << 16, (uint32_t)mask << 16, wbit);
+				} else {
+					write_word_misaligned_MASKED(draw_buffer, data, mask, addr, wbit);
+				}
 #endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
 			}
 			addr += BUFFER_WIDTH;
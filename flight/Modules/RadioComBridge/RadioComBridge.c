@@ -47,6 +47,7 @@
 #include <uavtalk.h>
 #include <uavtalk_priv.h>
 #include <pios_rfm22b.h>
+#include "uavtalkscan.h"
 #if defined(PIOS_INCLUDE_FLASH_EEPROM)
 #include <pios_eeprom.h>
 #endif
@@ -90,6 +91,10 @@ typedef struct {
 	UAVTalkConnection telemUAVTalkCon;
 	UAVTalkConnection radioUAVTalkCon;
 
+	// Receive windows; frames are relayed from them as they stand.
+	struct uavtalk_scan telemScan;
+	struct uavtalk_scan radioScan;
+
 	// Queue handles.
 	struct pios_queue *uavtalkEventQueue;
 	struct pios_queue *radioEventQueue;
@@ -114,10 +119,10 @@ static int32_t UAVTalkSendHandler(uint8_t * buf, int32_t length);
 static int32_t RadioSendHandler(uint8_t * buf, int32_t length);
 static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
 				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte);
+				   struct uavtalk_scan *scan);
 static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte);
+			       struct uavtalk_scan *scan);
 static void objectPersistenceUpdatedCb(UAVObjEvent * objEv, void *ctx,
 				void *obj, int len);
 static void registerObject(UAVObjHandle obj);
@@ -225,6 +230,15 @@ static int32_t RadioComBridgeInitialize(void)
 	if (data->telemUAVTalkCon == 0 || data->radioUAVTalkCon == 0) {
 		return -1;
 	}
+
+	// Frames are unpacked with UAVTalkReceiveFrame, so the connections'
+	// receive buffers are free to scan in.  They hold the longest frame.
+	uint16_t windowSize;
+	uint8_t *window = UAVTalkGetRxBuffer(data->telemUAVTalkCon, &windowSize);
+	uavtalk_scan_init(&data->telemScan, window, windowSize);
+	window = UAVTalkGetRxBuffer(data->radioUAVTalkCon, &windowSize);
+	uavtalk_scan_init(&data->radioScan, window, windowSize);
+
 	// Initialize the queues.
 	data->uavtalkEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
 	data->radioEventQueue = PIOS_Queue_Create(EVENT_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -287,16 +301,19 @@ static void updateRadioComBridgeStats()
 	radioComBridgeStats.TelemetryTxFailures +=
 	    telemetryUAVTalkStats.txErrors;
 
+	// Every received byte passes the scanner; UAVTalk only sees the
+	// frames unpacked locally
 	radioComBridgeStats.TelemetryRxBytes +=
-	    telemetryUAVTalkStats.rxBytes;
+	    data->telemScan.rx_bytes;
 	radioComBridgeStats.TelemetryRxFailures +=
-	    telemetryUAVTalkStats.rxErrors;
+	    telemetryUAVTalkStats.rxErrors + data->telemScan.rx_errors;
 
 	radioComBridgeStats.RadioTxBytes += radioUAVTalkStats.txBytes;
 	radioComBridgeStats.RadioTxFailures += radioUAVTalkStats.txErrors;
 
-	radioComBridgeStats.RadioRxBytes += radioUAVTalkStats.rxBytes;
-	radioComBridgeStats.RadioRxFailures += radioUAVTalkStats.rxErrors;
+	radioComBridgeStats.RadioRxBytes += data->radioScan.rx_bytes;
+	radioComBridgeStats.RadioRxFailures +=
+	    radioUAVTalkStats.rxErrors + data->radioScan.rx_errors;
 
 	// Update stats object data
 	RadioComBridgeStatsSet(&radioComBridgeStats);
@@ -397,20 +414,19 @@ static void radioRxTask( __attribute__ ((unused))
 		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
 		if (PIOS_COM_RFM22B) {
-			uint8_t serial_data[32];
+			uint16_t space;
+			uint8_t *serial_data =
+			    uavtalk_scan_space(&data->radioScan, &space);
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(PIOS_COM_RFM22B,
-						   serial_data,
-						   sizeof(serial_data),
+						   serial_data, space,
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
-				// Pass the data through the UAVTalk parser.
-				for (uint8_t i = 0;
-				     i < bytes_to_process; i++) {
-					ProcessRadioStream(data->radioUAVTalkCon,
-							   data->telemUAVTalkCon,
-							   serial_data[i]);
-				}
+				uavtalk_scan_received(&data->radioScan,
+						      bytes_to_process);
+				ProcessRadioStream(data->radioUAVTalkCon,
+						   data->telemUAVTalkCon,
+						   &data->radioScan);
 			}
 		} else {
 			PIOS_Thread_Sleep(3);
@@ -439,22 +455,19 @@ static void telemetryRxTask( __attribute__ ((unused))
 		}
 #endif /* PIOS_INCLUDE_USB */
 		if (inputPort) {
-			uint8_t serial_data[32];
+			uint16_t space;
+			uint8_t *serial_data =
+			    uavtalk_scan_space(&data->telemScan, &space);
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(inputPort, serial_data,
-						   sizeof(serial_data),
-						   MAX_PORT_DELAY);
+						   space, MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				PIOS_ANNUNC_Toggle(PIOS_LED_RX);
-				for (uint8_t i = 0; i < bytes_to_process;
-				     i++) {
-					ProcessTelemetryStream(data->
-							       telemUAVTalkCon,
-							       data->
-							       radioUAVTalkCon,
-							       serial_data
-							       [i]);
-				}
+				uavtalk_scan_received(&data->telemScan,
+						      bytes_to_process);
+				ProcessTelemetryStream(data->telemUAVTalkCon,
+						       data->radioUAVTalkCon,
+						       &data->telemScan);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -556,23 +569,25 @@ static int32_t RadioSendHandler(uint8_t * buf, int32_t length)
 
 #define MetaObjectId(x) (x+1)
 /**
- * @brief Process a byte of data received on the telemetry stream
+ * @brief Process the data received on the telemetry stream
+ *
+ * Frames are relayed to the radio as received; only the objects the modem
+ * handles itself are unpacked.
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the telemetry port
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] scan  The receive window of the telemetry port
  */
 static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
 				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte)
+				   struct uavtalk_scan *scan)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+	uint8_t *frame;
+	uint16_t len;
 
-	if (state == UAVTALK_STATE_COMPLETE) {
+	while ((len = uavtalk_scan_next(scan, &frame)) != 0) {
 		// We only want to unpack certain telemetry objects
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
+		uint32_t objId = uavtalk_frame_objid(frame);
 		switch (objId) {
 		case HWTAULINK_OBJID:
 		case RFM22BRECEIVER_OBJID:
@@ -581,13 +596,13 @@ static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
 		case MetaObjectId(RFM22BSTATUS_OBJID):
 
 			// These objects are received here and only here
-			UAVTalkReceiveObject(inConnectionHandle);
+			UAVTalkReceiveFrame(inConnectionHandle, frame, len);
 			break;
 
 		case OBJECTPERSISTENCE_OBJID:
 		case MetaObjectId(OBJECTPERSISTENCE_OBJID):
 			// Handle saving settings on modem
-			UAVTalkReceiveObject(inConnectionHandle);
+			UAVTalkReceiveFrame(inConnectionHandle, frame, len);
 
 			ObjectPersistenceData objectPersistence;
 			ObjectPersistenceGet(&objectPersistence);
@@ -595,50 +610,49 @@ static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
 				objectPersistence.ObjectID != MetaObjectId(HWTAULINK_OBJID)) {
 				// relay packet to remote modem except for requests to save
 				// the settings which happens locally
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+				UAVTalkSendBuf(outConnectionHandle, frame, len);
 			}
 
 			break;
 
 		case RFM22BSTATUS_OBJID:
 		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
+			uint32_t inst_id = uavtalk_frame_instid(frame, len);
 			if (inst_id == 0) {
 				// dealing with local modem
-				UAVTalkReceiveObject(inConnectionHandle);
+				UAVTalkReceiveFrame(inConnectionHandle, frame, len);
 			} else {
 				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+				UAVTalkSendBuf(outConnectionHandle, frame, len);
 			}
 		}
 			break;
 		default:
 			// all other packets are transparently relayed to the remote modem
-			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+			UAVTalkSendBuf(outConnectionHandle, frame, len);
 			break;
 		}
 	}
 }
 
 /**
- * @brief Process a byte of data received on the radio data stream.
+ * @brief Process the data received on the radio data stream.
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the radio port.
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the telemetry port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] scan  The receive window of the radio port
  */
 static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte)
+			       struct uavtalk_scan *scan)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+	uint8_t *frame;
+	uint16_t len;
 
-	if (state == UAVTALK_STATE_COMPLETE) {
+	while ((len = uavtalk_scan_next(scan, &frame)) != 0) {
 		// We only want to unpack certain objects from the remote modem
 		// Similarly we only want to relay certain objects to the telemetry port
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
+		uint32_t objId = uavtalk_frame_objid(frame);
 		switch (objId) {
 		case HWTAULINK_OBJID:
 		case MetaObjectId(RFM22BSTATUS_OBJID):
@@ -654,7 +668,7 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 			// These objects are received by the modem and are not transmitted to the telemetry port
 			// - RFM22BRECEIVER_OBJID : sent periodically from flight controller, not needed to echo
 			// some objects will send back a response to the remote modem
-			UAVTalkReceiveObject(inConnectionHandle);
+			UAVTalkReceiveFrame(inConnectionHandle, frame, len);
 			break;
 		case FLIGHTBATTERYSTATE_OBJID:
 		case FLIGHTSTATUS_OBJID:
@@ -663,20 +677,20 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 		case BAROALTITUDE_OBJID:
 
 			// process the battery voltage locally for relaying to taranis
-			UAVTalkReceiveObject(inConnectionHandle);
-			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+			UAVTalkReceiveFrame(inConnectionHandle, frame, len);
+			UAVTalkSendBuf(outConnectionHandle, frame, len);
 			break;
 		case RFM22BSTATUS_OBJID:
 		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
+			uint32_t inst_id = uavtalk_frame_instid(frame, len);
 			if (inst_id == 0) {
 				// instance 0 is from modem. do not pass this version
 			} else {
 				// process the remote link state locally for relaying to taranis
-				UAVTalkReceiveObject(inConnectionHandle);
+				UAVTalkReceiveFrame(inConnectionHandle, frame, len);
 
 				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+				UAVTalkSendBuf(outConnectionHandle, frame, len);
 			}
 
 		}
@@ -684,8 +698,7 @@ static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
 
 		default:
 			// all other packets are relayed to the telemetry port
-			UAVTalkRelayPacket(inConnectionHandle,
-					   outConnectionHandle);
+			UAVTalkSendBuf(outConnectionHandle, frame, len);
 			break;
 		}
 	}
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup RadioComBridgeModule Com Port to Radio Bridge Module
+ * @{
+ *
+ * @file       uavtalkscan.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Finds UAVTalk frame boundaries for relaying without decoding
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef UAVTALKSCAN_H
+#define UAVTALKSCAN_H
+
+#include <stdint.h>
+
+/**
+ * Receive window of a relayed UAVTalk stream.  Bytes are read straight into
+ * the window and complete frames are handed out in place, so a frame that
+ * is relayed is never copied or decoded on the way.  Only the sync byte,
+ * type, size and checksum are checked; anything that doesn't frame is
+ * skipped a byte at a time, like the full parser does.
+ */
+struct uavtalk_scan {
+	uint8_t *buf;
+	uint16_t size;        /**< Window size, also the longest frame */
+	uint16_t head;        /**< First byte not yet scanned */
+	uint16_t tail;        /**< End of the bytes received */
+	uint32_t rx_bytes;
+	uint32_t rx_frames;
+	uint32_t rx_errors;   /**< Frames that failed the checksum */
+};
+
+void uavtalk_scan_init(struct uavtalk_scan *scan, uint8_t *buf, uint16_t size);
+uint8_t *uavtalk_scan_space(struct uavtalk_scan *scan, uint16_t *len);
+void uavtalk_scan_received(struct uavtalk_scan *scan, uint16_t len);
+uint16_t uavtalk_scan_next(struct uavtalk_scan *scan, uint8_t **frame);
+uint32_t uavtalk_frame_objid(const uint8_t *frame);
+uint16_t uavtalk_frame_instid(const uint8_t *frame, uint16_t len);
+
+#endif /* UAVTALKSCAN_H */
+
+/**
+ * @}
+ * @}
+ */
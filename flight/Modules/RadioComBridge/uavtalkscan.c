@@ -0,0 +1,193 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup RadioComBridgeModule Com Port to Radio Bridge Module
+ * @{
+ *
+ * @file       uavtalkscan.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Finds UAVTalk frame boundaries for relaying without decoding
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "uavtalkscan.h"
+#include "uavtalk_framing.h"
+#include "pios_crc.h"
+
+#include <string.h>
+
+// Private constants
+
+//! Bytes needed to know a frame's length: sync, type and size
+#define SCAN_HEADER_LENGTH         4
+
+// Private functions
+
+/**
+ * Length of the frame starting with a header.
+ * \return frame length including the checksum
+ * \return 0 if the header can't start a frame
+ */
+static uint16_t frame_length(const struct uavtalk_scan *scan, const uint8_t *header)
+{
+	if ((header[1] & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER)
+		return 0;
+
+	uint32_t size = header[UAVTALK_SIZE_OFFSET] |
+		(header[UAVTALK_SIZE_OFFSET + 1] << 8);
+
+	if (size < UAVTALK_MIN_HEADER_LENGTH ||
+			size + UAVTALK_CHECKSUM_LENGTH > scan->size)
+		return 0;
+
+	return size + UAVTALK_CHECKSUM_LENGTH;
+}
+
+/**
+ * Set up a receive window.
+ * \param[out] scan The scanner
+ * \param[in] buf Window storage
+ * \param[in] size Bytes at buf, at least the longest frame to relay
+ */
+void uavtalk_scan_init(struct uavtalk_scan *scan, uint8_t *buf, uint16_t size)
+{
+	memset(scan, 0, sizeof(*scan));
+
+	scan->buf = buf;
+	scan->size = size;
+}
+
+/**
+ * Make room to receive into.  The unscanned tail of the window, at most one
+ * partial frame, moves to the front.
+ * \param[in] scan The scanner
+ * \param[out] len Bytes that may be received
+ * \return where to receive them
+ */
+uint8_t *uavtalk_scan_space(struct uavtalk_scan *scan, uint16_t *len)
+{
+	if (scan->head > 0) {
+		memmove(scan->buf, scan->buf + scan->head, scan->tail - scan->head);
+		scan->tail -= scan->head;
+		scan->head = 0;
+	}
+
+	*len = scan->size - scan->tail;
+
+	return scan->buf + scan->tail;
+}
+
+/**
+ * Account for bytes received into the space from uavtalk_scan_space.
+ */
+void uavtalk_scan_received(struct uavtalk_scan *scan, uint16_t len)
+{
+	scan->tail += len;
+	scan->rx_bytes += len;
+}
+
+/**
+ * Find the next complete frame in the window.  It stays valid until the
+ * next call to uavtalk_scan_space.
+ * \param[in] scan The scanner
+ * \param[out] frame The frame, from its sync byte to its checksum
+ * \return length of the frame
+ * \return 0 if no complete frame is left
+ */
+uint16_t uavtalk_scan_next(struct uavtalk_scan *scan, uint8_t **frame)
+{
+	while (scan->head < scan->tail) {
+		uint8_t *p = scan->buf + scan->head;
+		uint16_t avail = scan->tail - scan->head;
+
+		if (*p != UAVTALK_SYNC_VAL) {
+			uint8_t *sync = memchr(p, UAVTALK_SYNC_VAL, avail);
+
+			if (!sync) {
+				scan->head = scan->tail;
+				break;
+			}
+
+			scan->head = sync - scan->buf;
+			continue;
+		}
+
+		if (avail < SCAN_HEADER_LENGTH)
+			break;
+
+		uint16_t len = frame_length(scan, p);
+
+		if (!len) {
+			scan->head++;
+			continue;
+		}
+
+		if (avail < len)
+			break;
+
+		if (PIOS_CRC_updateCRC(0, p, len - UAVTALK_CHECKSUM_LENGTH) != p[len - 1]) {
+			// Look for a frame starting inside this one
+			scan->rx_errors++;
+			scan->head++;
+			continue;
+		}
+
+		scan->head += len;
+		scan->rx_frames++;
+
+		*frame = p;
+		return len;
+	}
+
+	return 0;
+}
+
+/**
+ * Object id of a frame.
+ */
+uint32_t uavtalk_frame_objid(const uint8_t *frame)
+{
+	const uint8_t *id = frame + UAVTALK_OBJID_OFFSET;
+
+	return id[0] | (id[1] << 8) | (id[2] << 16) | ((uint32_t) id[3] << 24);
+}
+
+/**
+ * Instance id of a frame.  Only frames of multi-instance objects carry one;
+ * the caller has to know which those are.
+ * \return the instance id, 0 if the frame is too short to carry one
+ */
+uint16_t uavtalk_frame_instid(const uint8_t *frame, uint16_t len)
+{
+	if (len < UAVTALK_INSTID_OFFSET + 2 + UAVTALK_CHECKSUM_LENGTH)
+		return 0;
+
+	return frame[UAVTALK_INSTID_OFFSET] | (frame[UAVTALK_INSTID_OFFSET + 1] << 8);
+}
+
+/**
+ * @}
+ * @}
+ */
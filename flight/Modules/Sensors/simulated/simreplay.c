@@ -0,0 +1,386 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Sensors Sensor acquisition module
+ * @{
+ *
+ * @file       simreplay.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Feeds logged sensor objects back into the simulator
+ *
+ * Reads either a log written by the Logging module (or the simulator's -l
+ * option), which is a raw UAVTalk stream with 16 bit millisecond
+ * timestamps in each packet, or a GCS .drlog, where every packet is
+ * preceded by a 32 bit millisecond timestamp and a 64 bit length.  Only
+ * the sensor objects are applied; everything the rest of the stack
+ * derives from them is recomputed.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ ******************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "openpilot.h"
+
+#include "accels.h"
+#include "baroaltitude.h"
+#include "gyros.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "magnetometer.h"
+
+#include "simreplay.h"
+#include "uavtalk_framing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private constants
+
+#define MAX_PACKET_LENGTH (UAVTALK_MAX_HEADER_LENGTH + UAVOBJECTS_LARGEST + 1 + \
+		UAVTALK_CHECKSUM_LENGTH)
+
+// GCS records: u32 timestamp, i64 size, packet
+#define GCS_RECORD_HEADER 12
+
+#define READ_BUF_LEN 16384
+
+// Private types
+
+struct replay_object {
+	uint32_t obj_id;
+	const char *name;
+	UAVObjHandle handle;
+	uint32_t applied;
+};
+
+// Private variables
+static FILE *replay_file;
+static bool gcs_format;
+
+static uint8_t read_buf[READ_BUF_LEN];
+static uint32_t buf_len;
+static uint32_t buf_pos;
+
+static uint32_t log_time;       // ms, unwrapped
+static uint16_t last_ts;
+static bool have_ts;
+static uint32_t first_time;
+static bool have_first;
+
+// The packet decoded but not yet due
+static bool pending;
+static struct replay_object *pending_obj;
+static uint16_t pending_inst;
+static uint32_t pending_time;
+static uint8_t pending_data[UAVOBJECTS_LARGEST];
+
+static uint32_t bad_frames;
+static uint32_t size_mismatches;
+
+static struct replay_object replay_objects[] = {
+	{ .obj_id = GYROS_OBJID, .name = "Gyros" },
+	{ .obj_id = ACCELS_OBJID, .name = "Accels" },
+	{ .obj_id = MAGNETOMETER_OBJID, .name = "Magnetometer" },
+	{ .obj_id = BAROALTITUDE_OBJID, .name = "BaroAltitude" },
+	{ .obj_id = GPSPOSITION_OBJID, .name = "GPSPosition" },
+	{ .obj_id = GPSVELOCITY_OBJID, .name = "GPSVelocity" },
+};
+
+// Private functions
+
+/**
+ * Make sure at least need bytes are buffered after buf_pos
+ * \return false if the file ends first
+ */
+static bool fill(uint32_t need)
+{
+	if (buf_len - buf_pos >= need) {
+		return true;
+	}
+
+	memmove(read_buf, read_buf + buf_pos, buf_len - buf_pos);
+	buf_len -= buf_pos;
+	buf_pos = 0;
+
+	buf_len += fread(read_buf + buf_len, 1, sizeof(read_buf) - buf_len,
+			replay_file);
+
+	return buf_len >= need;
+}
+
+static struct replay_object *find_object(uint32_t obj_id)
+{
+	for (uint32_t i = 0; i < NELEMENTS(replay_objects); i++) {
+		if (replay_objects[i].obj_id == obj_id) {
+			return &replay_objects[i];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Check the UAVTalk packet at p and, if it's one of ours, make it the
+ * pending packet.
+ * \param[in] p packet, starting at the sync byte
+ * \param[in] avail bytes available at p
+ * \return size of the packet including the CRC, or 0 if p doesn't
+ * start a valid packet
+ */
+static uint32_t decode_packet(const uint8_t *p, uint32_t avail)
+{
+	if (avail < UAVTALK_MIN_HEADER_LENGTH + 1 || p[0] != UAVTALK_SYNC_VAL ||
+			(p[1] & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER) {
+		return 0;
+	}
+
+	uint32_t size = p[2] | (p[3] << 8);
+
+	if (size < UAVTALK_MIN_HEADER_LENGTH || size + 1 > MAX_PACKET_LENGTH ||
+			size + 1 > avail) {
+		return 0;
+	}
+
+	if (PIOS_CRC_updateCRC(0, p, size) != p[size]) {
+		return 0;
+	}
+
+	uint32_t hdr = UAVTALK_MIN_HEADER_LENGTH;
+
+	uint32_t obj_id = p[4] | (p[5] << 8) | (p[6] << 16) | (p[7] << 24);
+	struct replay_object *obj = find_object(obj_id);
+
+	uint16_t inst = 0;
+	UAVObjHandle handle = obj ? obj->handle : UAVObjGetByID(obj_id);
+
+	if (handle && !UAVObjIsSingleInstance(handle)) {
+		inst = p[hdr] | (p[hdr + 1] << 8);
+		hdr += 2;
+	} else if (!handle) {
+		// Can't tell where the timestamp is; keep the previous one
+		return size + 1;
+	}
+
+	if ((p[1] & UAVTALK_TIMESTAMPED) && !gcs_format) {
+		uint16_t ts = p[hdr] | (p[hdr + 1] << 8);
+
+		if (have_ts) {
+			log_time += (uint16_t) (ts - last_ts);
+		} else {
+			log_time = ts;
+			have_ts = true;
+		}
+
+		last_ts = ts;
+	}
+
+	if (p[1] & UAVTALK_TIMESTAMPED) {
+		hdr += 2;
+	}
+
+	if (!obj || !obj->handle) {
+		return size + 1;
+	}
+
+	if (size - hdr != UAVObjGetNumBytes(obj->handle)) {
+		// Logged with different object definitions
+		size_mismatches++;
+		return size + 1;
+	}
+
+	memcpy(pending_data, p + hdr, size - hdr);
+	pending_obj = obj;
+	pending_inst = inst;
+	pending_time = log_time;
+	pending = true;
+
+	return size + 1;
+}
+
+/**
+ * Read forward to the next sensor packet
+ * \return false at the end of the file
+ */
+static bool read_packet(void)
+{
+	while (!pending) {
+		if (gcs_format) {
+			if (!fill(GCS_RECORD_HEADER)) {
+				return false;
+			}
+
+			const uint8_t *r = read_buf + buf_pos;
+			uint32_t ts;
+			int64_t size;
+
+			memcpy(&ts, r, sizeof(ts));
+			memcpy(&size, r + sizeof(ts), sizeof(size));
+
+			if (size <= 0 || size > MAX_PACKET_LENGTH) {
+				// Lost the record framing; nothing to resync on
+				bad_frames++;
+				return false;
+			}
+
+			if (!fill(GCS_RECORD_HEADER + size)) {
+				return false;
+			}
+
+			log_time = ts;
+
+			if (!decode_packet(read_buf + buf_pos + GCS_RECORD_HEADER, size)) {
+				bad_frames++;
+			}
+
+			buf_pos += GCS_RECORD_HEADER + size;
+		} else {
+			if (!fill(UAVTALK_MIN_HEADER_LENGTH + 1)) {
+				return false;
+			}
+
+			if (read_buf[buf_pos] != UAVTALK_SYNC_VAL) {
+				buf_pos++;
+				continue;
+			}
+
+			// Short reads near the end are handled by decode_packet
+			fill(MAX_PACKET_LENGTH);
+
+			uint32_t used = decode_packet(read_buf + buf_pos,
+					buf_len - buf_pos);
+
+			if (used) {
+				buf_pos += used;
+			} else {
+				bad_frames++;
+				buf_pos++;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Skip the text header.  Both formats start with the same three lines;
+ * the GCS adds a "##" line after them.
+ */
+static void skip_header(void)
+{
+	char line[128];
+
+	if (!fgets(line, sizeof(line), replay_file) ||
+			strcmp(line, "dRonin git hash:\n")) {
+		// No header, assume a bare UAVTalk stream
+		rewind(replay_file);
+		return;
+	}
+
+	for (int i = 0; i < 2; i++) {
+		if (!fgets(line, sizeof(line), replay_file)) {
+			return;
+		}
+	}
+
+	long body = ftell(replay_file);
+
+	if (fgets(line, sizeof(line), replay_file) && !strcmp(line, "##\n")) {
+		gcs_format = true;
+	} else {
+		fseek(replay_file, body, SEEK_SET);
+	}
+}
+
+/**
+ * Open a log for replay.  Call after the sensor objects are initialized.
+ * \param[in] path log file
+ * \return 0 on success, -1 if it can't be opened
+ */
+int32_t SimReplayOpen(const char *path)
+{
+	replay_file = fopen(path, "rb");
+
+	if (!replay_file) {
+		perror("fopen");
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < NELEMENTS(replay_objects); i++) {
+		replay_objects[i].handle =
+			UAVObjGetByID(replay_objects[i].obj_id);
+	}
+
+	skip_header();
+
+	printf("SimReplayOpen: replaying %s log %s\n",
+			gcs_format ? "GCS" : "flight", path);
+
+	return 0;
+}
+
+/**
+ * Apply every sensor sample logged up to now_ms after the first one
+ * \param[in] now_ms time since the start of the replay
+ * \param[out] next_ms when the next sample is due
+ * \return 0, or -1 once the log is exhausted
+ */
+int32_t SimReplayStep(uint32_t now_ms, uint32_t *next_ms)
+{
+	while (read_packet()) {
+		if (!have_first) {
+			first_time = pending_time;
+			have_first = true;
+		}
+
+		uint32_t due = pending_time - first_time;
+
+		if (due > now_ms) {
+			*next_ms = due;
+			return 0;
+		}
+
+		UAVObjSetInstanceData(pending_obj->handle, pending_inst,
+				pending_data);
+		pending_obj->applied++;
+		pending = false;
+	}
+
+	return -1;
+}
+
+void SimReplayPrintStats(void)
+{
+	for (uint32_t i = 0; i < NELEMENTS(replay_objects); i++) {
+		if (replay_objects[i].handle) {
+			printf("  %-14s %u samples\n",
+					replay_objects[i].name,
+					(unsigned int) replay_objects[i].applied);
+		}
+	}
+
+	printf("  %u bad frames, %u size mismatches\n",
+			(unsigned int) bad_frames,
+			(unsigned int) size_mismatches);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -59,6 +59,7 @@
 #include "systemsettings.h"
 
 #include "coordinate_conversions.h"
+#include "simreplay.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
@@ -77,6 +78,7 @@ static void simulateModelAgnostic();
 static void simulateModelQuadcopter();
 static void simulateModelAirplane();
 static void simulateModelCar();
+static void replaySensors();
 
 static void magOffsetEstimation(MagnetometerData *mag);
 
@@ -85,6 +87,7 @@ static float accel_bias[3];
 static float rand_gauss();
 
 static bool use_real_sensors;
+static bool replaying;
 
 enum sensor_sim_type {CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLANE, MODEL_CAR} sensor_sim_type;
 
@@ -136,6 +139,16 @@ static int32_t SimSensorsInitialize(void)
 	MagnetometerInitialize();
 	MagBiasInitialize();
 
+	const char *replay_log = PIOS_SYS_GetReplayLog();
+
+	if (replay_log) {
+		if (SimReplayOpen(replay_log)) {
+			return -1;
+		}
+
+		replaying = true;
+	}
+
 	return 0;
 }
 
@@ -173,6 +186,13 @@ static void SensorsTask(void *parameters)
 	AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
 
 	PIOS_SENSORS_SetMaxGyro(500);
+
+	if (replaying) {
+		replaySensors();
+	}
+
+	uint32_t last_run = PIOS_Thread_Systime();
+
 	// Main task loop
 	while (1) {
 		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
@@ -226,9 +246,52 @@ static void SensorsTask(void *parameters)
 				simulateModelCar();
 		}
 
-		PIOS_Thread_Sleep(2);
+		// Keep the models on the sensor period regardless of how long
+		// they took, so a lockstep run steps them identically
+		PIOS_Thread_Sleep_Until(&last_run, SENSOR_PERIOD);
+	}
+}
+
+/**
+ * Feed the logged sensor data in with its original timing.  In lockstep
+ * mode (-L) the clock doesn't wait for the wall clock, so this runs as
+ * fast as the rest of the stack can keep up.  Exits the simulator at the
+ * end of the log so scripted runs terminate.
+ */
+static void replaySensors()
+{
+	uint32_t start = PIOS_Thread_Systime();
+
+	while (1) {
+		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
+
+		uint32_t now = PIOS_Thread_Systime() - start;
+		uint32_t next;
+
+		if (SimReplayStep(now, &next)) {
+			break;
+		}
+
+		sensors_count++;
 
+		uint32_t delay = next - now;
+
+		// Don't let a gap in the log trip the watchdog
+		if (delay > 100) {
+			delay = 100;
+		}
+
+		PIOS_Thread_Sleep(delay);
 	}
+
+	printf("Sensor replay finished after %u ms\n",
+			(unsigned int) (PIOS_Thread_Systime() - start));
+	SimReplayPrintStats();
+
+	// Let the logging and telemetry queues drain
+	PIOS_Thread_Sleep(500);
+
+	exit(0);
 }
 
 static void simulateConstant()
@@ -1134,12 +1197,27 @@ static void simulateModelCar()
 }
 
 
+static uint32_t rand_state = 2463534242UL;
+
+/**
+ * Uniform random number in [0, 1].  A private xorshift generator so the
+ * noise sequence doesn't depend on other users of rand().
+ */
+static float rand_uniform(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return (float) rand_state / UINT32_MAX;
+}
+
 static float rand_gauss (void) {
 	float v1,v2,s;
 	
 	do {
-		v1 = 2.0 * ((float) rand()/RAND_MAX) - 1;
-		v2 = 2.0 * ((float) rand()/RAND_MAX) - 1;
+		v1 = 2.0 * rand_uniform() - 1;
+		v2 = 2.0 * rand_uniform() - 1;
 		
 		s = v1*v1 + v2*v2;
 	} while ( s >= 1.0 );
@@ -0,0 +1,262 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup SystemModule System Module
+ * @{
+ *
+ * @file       eventheap.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Deadline ordered schedule of the periodic events
+ *
+ * The system task only ever needs the earliest deadline, so the events are
+ * kept in a binary heap: finding what is due is O(1), and adding, changing
+ * or rescheduling an event is O(log n).  A fired event is moved on by whole
+ * periods from its previous deadline rather than from when it ran, so its
+ * phase never drifts however late the task gets to it.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "eventheap.h"
+#include "pacing.h"
+#include "pios_heap.h"
+
+#include <string.h>
+
+// Private functions
+
+static inline void place(struct eventheap *heap, uint16_t pos,
+		struct eventheap_entry *entry)
+{
+	heap->nodes[pos] = entry;
+	entry->pos = pos;
+}
+
+static void sift_up(struct eventheap *heap, uint16_t pos)
+{
+	struct eventheap_entry *entry = heap->nodes[pos];
+
+	while (pos > 0) {
+		uint16_t parent = (pos - 1) / 2;
+
+		if (!pacing_before(entry->deadline, heap->nodes[parent]->deadline)) {
+			break;
+		}
+
+		place(heap, pos, heap->nodes[parent]);
+		pos = parent;
+	}
+
+	place(heap, pos, entry);
+}
+
+static void sift_down(struct eventheap *heap, uint16_t pos)
+{
+	struct eventheap_entry *entry = heap->nodes[pos];
+
+	while (true) {
+		uint32_t child = 2 * pos + 1;
+
+		if (child >= heap->num) {
+			break;
+		}
+
+		if (child + 1 < heap->num &&
+				pacing_before(heap->nodes[child + 1]->deadline,
+					heap->nodes[child]->deadline)) {
+			child++;
+		}
+
+		if (!pacing_before(heap->nodes[child]->deadline, entry->deadline)) {
+			break;
+		}
+
+		place(heap, pos, heap->nodes[child]);
+		pos = child;
+	}
+
+	place(heap, pos, entry);
+}
+
+/**
+ * Double the space for nodes
+ * \return 0 on success, -1 if out of memory or at the limit of the indices
+ */
+static int32_t grow(struct eventheap *heap)
+{
+	uint32_t size = heap->size ? 2 * heap->size : 8;
+
+	if (size > UINT16_MAX) {
+		size = UINT16_MAX;
+	}
+
+	if (size <= heap->num) {
+		return -1;
+	}
+
+	struct eventheap_entry **nodes =
+		PIOS_malloc_no_dma(size * sizeof(*nodes));
+
+	if (nodes == NULL) {
+		return -1;
+	}
+
+	if (heap->nodes) {
+		memcpy(nodes, heap->nodes, heap->num * sizeof(*nodes));
+		PIOS_free(heap->nodes);
+	}
+
+	heap->nodes = nodes;
+	heap->size = size;
+
+	return 0;
+}
+
+/**
+ * Set up an empty heap
+ * \param[in] size number of entries to make room for up front; the heap
+ * grows as needed
+ * \return 0 on success, -1 if out of memory
+ */
+int32_t eventheap_init(struct eventheap *heap, uint16_t size)
+{
+	memset(heap, 0, sizeof(*heap));
+
+	if (size == 0) {
+		return 0;
+	}
+
+	heap->nodes = PIOS_malloc_no_dma(size * sizeof(*heap->nodes));
+
+	if (heap->nodes == NULL) {
+		return -1;
+	}
+
+	heap->size = size;
+
+	return 0;
+}
+
+/**
+ * Add an entry, change its period or deadline, or remove it
+ * \param[in] entry the entry, which may or may not be in the heap already
+ * \param[in] period ms between events; 0 removes the entry
+ * \param[in] deadline systime the event is first due
+ * \return 0 on success, -1 if out of memory
+ */
+int32_t eventheap_schedule(struct eventheap *heap,
+		struct eventheap_entry *entry, uint16_t period, uint32_t deadline)
+{
+	if (entry->period == 0) {
+		if (period == 0) {
+			return 0;
+		}
+
+		if (heap->num >= heap->size && grow(heap)) {
+			return -1;
+		}
+
+		entry->period = period;
+		entry->deadline = deadline;
+
+		place(heap, heap->num++, entry);
+		sift_up(heap, entry->pos);
+
+		return 0;
+	}
+
+	struct eventheap_entry *moved = entry;
+
+	if (period == 0) {
+		// Move the last node into the hole
+		entry->period = 0;
+
+		moved = heap->nodes[--heap->num];
+
+		if (moved == entry) {
+			return 0;
+		}
+
+		place(heap, entry->pos, moved);
+	} else {
+		entry->period = period;
+		entry->deadline = deadline;
+	}
+
+	// Only one of these will move it
+	sift_up(heap, moved->pos);
+	sift_down(heap, moved->pos);
+
+	return 0;
+}
+
+/**
+ * Take the earliest entry if it is due, and move its deadline on past now
+ * by whole periods; any periods missed entirely are skipped, not bunched up.
+ * Call repeatedly until it returns NULL to fire everything that is due.
+ * \param[in] now current systime
+ * \return the entry whose event should fire, or NULL if none are due
+ */
+struct eventheap_entry *eventheap_next_due(struct eventheap *heap,
+		uint32_t now)
+{
+	if (heap->num == 0) {
+		return NULL;
+	}
+
+	struct eventheap_entry *entry = heap->nodes[0];
+
+	if (pacing_before(now, entry->deadline)) {
+		return NULL;
+	}
+
+	uint32_t late = now - entry->deadline;
+
+	entry->deadline += entry->period * (late / entry->period + 1);
+
+	sift_down(heap, 0);
+
+	return entry;
+}
+
+/**
+ * When the next entry is due
+ * \param[out] deadline its deadline
+ * \return false if the heap is empty
+ */
+bool eventheap_peek(const struct eventheap *heap, uint32_t *deadline)
+{
+	if (heap->num == 0) {
+		return false;
+	}
+
+	*deadline = heap->nodes[0]->deadline;
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
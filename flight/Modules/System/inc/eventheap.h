@@ -0,0 +1,75 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup SystemModule System Module
+ * @{
+ *
+ * @file       eventheap.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Deadline ordered schedule of the periodic events
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef EVENTHEAP_H
+#define EVENTHEAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * One periodic event.  Embed it in whatever describes the event; an entry
+ * is in the heap exactly when its period is non-zero, so it must start out
+ * zeroed.
+ */
+struct eventheap_entry {
+	uint32_t deadline;   /**< Systime (ms) the event is next due */
+	uint16_t period;     /**< ms, or 0 if not scheduled */
+	uint16_t pos;        /**< Index in the heap */
+};
+
+/**
+ * Binary min-heap of entries keyed by deadline.  Deadlines are compared
+ * modulo 2^32, so the systime may wrap as long as no deadline is more than
+ * 2^31 ms away.
+ */
+struct eventheap {
+	struct eventheap_entry **nodes;
+	uint16_t num;
+	uint16_t size;
+};
+
+int32_t eventheap_init(struct eventheap *heap, uint16_t size);
+int32_t eventheap_schedule(struct eventheap *heap,
+		struct eventheap_entry *entry, uint16_t period, uint32_t deadline);
+struct eventheap_entry *eventheap_next_due(struct eventheap *heap,
+		uint32_t now);
+bool eventheap_peek(const struct eventheap *heap, uint32_t *deadline);
+
+#endif /* EVENTHEAP_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -35,12 +35,14 @@
 #include <utlist.h>
 
 #include "systemmod.h"
+#include "eventheap.h"
 #include "sanitycheck.h"
 #include "taskinfo.h"
 #include "taskmonitor.h"
 #include "pios_thread.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
+#include "pios_struct_helper.h"
 #include "misc_math.h"
 #include "morsel.h"
 
@@ -48,6 +50,7 @@
 #include "flightstatus.h"
 #include "manualcontrolsettings.h"
 #include "objectpersistence.h"
+#include "objectpersistencebatch.h"
 #include "rfm22bstatus.h"
 #include "stabilizationsettings.h"
 #include "stateestimation.h"
@@ -113,16 +116,22 @@ typedef struct {
  */
 struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
-	uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-	int32_t timeToNextUpdateMs; /** Time delay to the next update */
+	struct eventheap_entry sched; /** Period and next deadline, 0 period if no periodic updates are needed */
 	struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
 // Private types
 
+/* Registrations are found by hash; the heap only orders them by deadline */
+#define OBJ_LIST_BUCKETS 16
+
 // Private variables
-static PeriodicObjectList* objList;
+static PeriodicObjectList* objList[OBJ_LIST_BUCKETS];
+static struct eventheap schedule;
+static uint32_t wakeTime;
+static bool wakeTimeValid;
+static volatile bool wakePending;
 static struct pios_recursive_mutex *mutex;
 static EventStats stats;
 
@@ -184,10 +193,16 @@ int32_t SystemModInitialize(void)
 	if (mutex == NULL)
 		return -1;
 
+	if (eventheap_init(&schedule, 32) != 0)
+		return -1;
+
 	if (SystemSettingsInitialize() == -1
 			|| SystemStatsInitialize() == -1
 			|| FlightStatusInitialize() == -1
 			|| ObjectPersistenceInitialize() == -1
+#ifndef PIPXTREME
+			|| ObjectPersistenceBatchInitialize() == -1
+#endif
 			|| AnnunciatorSettingsInitialize() == -1
 #ifdef SYSTEMMOD_RGBLED_SUPPORT
 			|| RGBLEDSettingsInitialize() == -1
@@ -204,7 +219,8 @@ int32_t SystemModInitialize(void)
 		return -1;
 #endif
 
-	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	// Room for a schedule wakeup on top of persistence requests
+	objectPersistenceQueue = PIOS_Queue_Create(3, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
 		return -1;
 
@@ -238,6 +254,11 @@ static void systemTask(void *parameters)
 
 	// Listen for SettingPersistance object updates, connect a callback function
 	ObjectPersistenceConnectQueue(objectPersistenceQueue);
+#ifndef PIPXTREME
+	// Only batch requests from telemetry; our own progress updates are ignored
+	UAVObjConnectQueue(ObjectPersistenceBatchHandle(), objectPersistenceQueue,
+			EV_UNPACKED);
+#endif
 
 #ifndef NO_SENSORS
 	// Run this initially to make sure the configuration is checked
@@ -260,13 +281,18 @@ static void systemTask(void *parameters)
 
 	// Main system loop
 	while (1) {
-		int32_t delayTime = processPeriodicUpdates();
+		uint32_t delayTime = processPeriodicUpdates();
 
 		UAVObjEvent ev;
 
 		if (PIOS_Queue_Receive(objectPersistenceQueue, &ev, delayTime) == true) {
-			// If object persistence is updated call the callback
-			objectUpdatedCb(&ev, NULL, NULL, 0);
+			// If object persistence is updated call the callback;
+			// no object means the schedule changed
+			if (ev.obj) {
+				objectUpdatedCb(&ev, NULL, NULL, 0);
+			} else {
+				wakePending = false;
+			}
 		}
 	}
 }
@@ -552,6 +578,56 @@ static void systemPeriodicCb(UAVObjEvent *ev, void *ctx, void *obj_data, int len
 }
 
 
+#ifndef PIPXTREME
+/**
+ * Report the result of one object of a batch save back to the GCS
+ */
+static void objectPersistenceBatchProgress(void *ctx, uint16_t idx, int32_t rc)
+{
+	ObjectPersistenceBatchData *batch = (ObjectPersistenceBatchData *) ctx;
+
+	batch->Result[idx] = (rc == 0) ?
+		OBJECTPERSISTENCEBATCH_RESULT_SAVED :
+		OBJECTPERSISTENCEBATCH_RESULT_ERROR;
+	batch->Progress = idx + 1;
+
+	ObjectPersistenceBatchSet(batch);
+}
+
+/**
+ * Save all of the objects listed in ObjectPersistenceBatch in one go
+ */
+static void objectPersistenceBatchUpdated()
+{
+	ObjectPersistenceBatchData batch;
+	ObjectPersistenceBatchGet(&batch);
+
+	if (batch.Operation != OBJECTPERSISTENCEBATCH_OPERATION_SAVE) {
+		return;
+	}
+
+	if (batch.NumObjects > OBJECTPERSISTENCEBATCH_OBJECTID_NUMELEM) {
+		batch.Operation = OBJECTPERSISTENCEBATCH_OPERATION_ERROR;
+		ObjectPersistenceBatchSet(&batch);
+		return;
+	}
+
+	batch.Operation = OBJECTPERSISTENCEBATCH_OPERATION_INPROGRESS;
+	batch.Progress = 0;
+	for (uint8_t i = 0; i < OBJECTPERSISTENCEBATCH_RESULT_NUMELEM; i++) {
+		batch.Result[i] = OBJECTPERSISTENCEBATCH_RESULT_PENDING;
+	}
+
+	int32_t retval = UAVObjSaveBatch(batch.NumObjects, batch.ObjectID,
+			batch.InstanceID, objectPersistenceBatchProgress, &batch);
+
+	batch.Operation = (retval == 0) ?
+		OBJECTPERSISTENCEBATCH_OPERATION_COMPLETED :
+		OBJECTPERSISTENCEBATCH_OPERATION_ERROR;
+	ObjectPersistenceBatchSet(&batch);
+}
+#endif /* PIPXTREME */
+
 /**
  * Function called in response to object updates
  */
@@ -564,6 +640,11 @@ static void objectUpdatedCb(UAVObjEvent * ev, void *ctx, void *obj_data, int len
 	ObjectPersistenceData objper;
 	UAVObjHandle obj;
 
+	if (ev->obj == ObjectPersistenceBatchHandle()) {
+		objectPersistenceBatchUpdated();
+		return;
+	}
+
 	// If the object updated was the ObjectPersistence execute requested action
 	if (ev->obj == ObjectPersistenceHandle()) {
 		// Get object data
@@ -931,6 +1012,61 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 	return eventPeriodicUpdate(ev, 0, queue, periodMs);
 }
 
+/**
+ * Find a registration
+ * \return the entry, or NULL if there is none
+ */
+static PeriodicObjectList *findPeriodic(UAVObjEvent *ev, UAVObjEventCallback cb, struct pios_queue *queue, PeriodicObjectList ***bucket)
+{
+	PeriodicObjectList* objEntry;
+
+	uintptr_t hash = (uintptr_t) ev->obj ^ (uintptr_t) cb ^ (uintptr_t) queue;
+	hash ^= hash >> 8;
+	*bucket = &objList[(hash >> 2) % OBJ_LIST_BUCKETS];
+
+	LL_FOREACH(**bucket, objEntry)
+	{
+		if (objEntry->evInfo.cb == cb &&
+				objEntry->evInfo.queue == queue &&
+				objEntry->evInfo.ev.obj == ev->obj &&
+				objEntry->evInfo.ev.instId == ev->instId &&
+				objEntry->evInfo.ev.event == ev->event)
+		{
+			return objEntry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * (Re)schedule an entry, first due within a period from now, and make sure
+ * the system task wakes in time for it.  Call with the lock held.
+ */
+static int32_t schedulePeriodic(PeriodicObjectList *objEntry, uint16_t periodMs)
+{
+	uint32_t deadline = PIOS_Thread_Systime() + randomize_int(periodMs); // avoid bunching of updates
+
+	if (eventheap_schedule(&schedule, &objEntry->sched, periodMs, deadline) != 0) {
+		return -1;
+	}
+
+	if (periodMs > 0 && (!wakeTimeValid || (int32_t) (deadline - wakeTime) < 0)) {
+		// The task is sleeping past the new deadline; wake it
+		UAVObjEvent wake = { .obj = NULL };
+
+		wakeTime = deadline;
+		wakeTimeValid = true;
+
+		// One wakeup in the queue is enough
+		if (objectPersistenceQueue && !wakePending) {
+			wakePending = PIOS_Queue_Send(objectPersistenceQueue, &wake, 0);
+		}
+	}
+
+	return 0;
+}
+
 /**
  * Dispatch an event through a callback at periodic intervals.
  * \param[in] ev The event to be dispatched
@@ -942,37 +1078,34 @@ int32_t EventPeriodicQueueUpdate(UAVObjEvent* ev, struct pios_queue *queue, uint
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
 	PeriodicObjectList* objEntry;
+	PeriodicObjectList** bucket;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Check that the object is not already connected
-	LL_FOREACH(objList, objEntry)
+	if (findPeriodic(ev, cb, queue, &bucket))
 	{
-		if (objEntry->evInfo.cb == cb &&
-				objEntry->evInfo.queue == queue &&
-				objEntry->evInfo.ev.obj == ev->obj &&
-				objEntry->evInfo.ev.instId == ev->instId &&
-				objEntry->evInfo.ev.event == ev->event)
-		{
-			// Already registered, do nothing
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return -1;
-		}
+		// Already registered, do nothing
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
 	// Create handle
 	objEntry = (PeriodicObjectList*)PIOS_malloc_no_dma(sizeof(PeriodicObjectList));
-	if (objEntry == NULL) return -1;
+	if (objEntry == NULL) {
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+	}
+	memset(objEntry, 0, sizeof(*objEntry));
 	objEntry->evInfo.ev.obj = ev->obj;
 	objEntry->evInfo.ev.instId = ev->instId;
 	objEntry->evInfo.ev.event = ev->event;
 	objEntry->evInfo.cb = cb;
 	objEntry->evInfo.queue = queue;
-	objEntry->updatePeriodMs = periodMs;
-	objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
 	// Add to list
-	LL_APPEND(objList, objEntry);
+	LL_PREPEND(*bucket, objEntry);
+	int32_t ret = schedulePeriodic(objEntry, periodMs);
 	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return 0;
+	return ret;
 }
 
 /**
@@ -986,91 +1119,71 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs)
 {
 	PeriodicObjectList* objEntry;
+	PeriodicObjectList** bucket;
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	// Find object
-	LL_FOREACH(objList, objEntry)
+	objEntry = findPeriodic(ev, cb, queue, &bucket);
+	if (objEntry == NULL)
 	{
-		if (objEntry->evInfo.cb == cb &&
-				objEntry->evInfo.queue == queue &&
-				objEntry->evInfo.ev.obj == ev->obj &&
-				objEntry->evInfo.ev.instId == ev->instId &&
-				objEntry->evInfo.ev.event == ev->event)
-		{
-			// Object found, update period
-			objEntry->updatePeriodMs = periodMs;
-			objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
-			// Release lock
-			PIOS_Recursive_Mutex_Unlock(mutex);
-			return 0;
-		}
+		// If this point is reached the object was not found
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
 	}
-	// If this point is reached the object was not found
+	// Object found, update period
+	int32_t ret = schedulePeriodic(objEntry, periodMs);
+	// Release lock
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return -1;
+	return ret;
 }
 
-/* It can take this long before a "first callback" on a registration,
- * so it's advantageous for it to not be too long.  (e.g. we don't have a
- * mechanism to wakeup on list change */
-#define MAX_UPDATE_PERIOD_MS 350
-
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Fire the periodic events that are due.
+ * \return The system time until the next update (in ms)
  */
 static uint32_t processPeriodicUpdates()
 {
-	PeriodicObjectList* objEntry;
-	int32_t timeNow;
-	int32_t offset;
+	struct eventheap_entry *entry;
+	uint32_t delay = PIOS_QUEUE_TIMEOUT_MAX;
 
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Iterate through each object and update its timer, if zero then transmit object.
-	// Also calculate smallest delay to next update.
 	uint32_t now = PIOS_Thread_Systime();
-	uint32_t timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-	LL_FOREACH(objList, objEntry)
+
+	while ((entry = eventheap_next_due(&schedule, now)) != NULL)
 	{
-		// If object is configured for periodic updates
-		if (objEntry->updatePeriodMs > 0)
+		PeriodicObjectList *objEntry = container_of(entry, PeriodicObjectList, sched);
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
 		{
-			// Check if time for the next update
-			timeNow = PIOS_Thread_Systime();
-			if (objEntry->timeToNextUpdateMs <= timeNow)
-			{
-				// Reset timer
-				offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-				objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-				// Invoke callback, if one
-				if ( objEntry->evInfo.cb != 0)
-				{
-					objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
-				}
-				// Push event to queue, if one
-				if ( objEntry->evInfo.queue != 0)
-				{
-					if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-					{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-						++stats.eventErrors;
-					}
-				}
-			}
-			// Update minimum delay
-			if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
+			objEntry->evInfo.cb(&objEntry->evInfo.ev, NULL, NULL, 0); // the function is expected to copy the event information
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
 			{
-				timeToNextUpdate = objEntry->timeToNextUpdateMs;
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
 			}
 		}
 	}
 
+	// Sleep until the earliest deadline, or until a registration wakes us
+	wakeTimeValid = eventheap_peek(&schedule, &wakeTime);
+	if (wakeTimeValid)
+	{
+		// The callbacks may have taken a while
+		now = PIOS_Thread_Systime();
+		delay = ((int32_t) (wakeTime - now) > 0) ? wakeTime - now : 0;
+	}
+
 	// Done
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return timeToNextUpdate - now;
+	return delay;
 }
 
 /**
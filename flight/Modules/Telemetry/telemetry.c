@@ -10,6 +10,15 @@
  * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
  * @author     dRonin, http://dronin.org Copyright (C) 2015-2016
  * @brief      Telemetry module, handles telemetry and UAVObject updates
+ *
+ * Periodic objects are not driven by individual timers.  The transmit task
+ * keeps their deadlines itself and, each time round, sends the ones that
+ * are due earliest deadline first, packed back to back into as few COM
+ * writes as possible.  On a serial link the updates are paced against the
+ * configured baud rate, so an over-subscribed link slows every periodic
+ * object down a little rather than overflowing the port buffer; the rates
+ * actually achieved are reported in TelemetryRates.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -39,10 +48,13 @@
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
 #include "sessionmanaging.h"
+#include "telemetryrates.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
 #include "pios_hal.h"
+#include "misc_math.h"
+#include "pacing.h"
 
 #include <uavtalk.h>
 
@@ -56,9 +68,19 @@
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
 #define USB_ACTIVITY_TIMEOUT_MS 6000
+#define TX_BATCH_LEN 128
 
 // Private types
 
+//! An object sent periodically, and its next deadline
+struct periodic_object {
+	struct periodic_object *next;
+	UAVObjHandle obj;
+	uint32_t next_due;   /* ms */
+	uint16_t period;     /* ms, 0 if the object is no longer periodic */
+	uint16_t sent;       /* updates since the rates were last reported */
+};
+
 // Private variables
 static struct pios_queue *queue;
 
@@ -67,6 +89,13 @@ static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
 
+static struct periodic_object *periodicObjects;
+static uint8_t *txBatch;
+static uint16_t txBatchLen;
+static uint32_t rfBandwidth;     /* bytes/s the telemetry serial port can carry */
+static struct pacing_budget linkBudget;   /* of the port in use */
+static uint32_t ratesTime;
+
 #if defined(PIOS_INCLUDE_USB)
 static volatile uint32_t usb_timeout_time;
 #endif
@@ -79,6 +108,8 @@ static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static void processObjEvent(UAVObjEvent * ev);
+static uint32_t processPeriodicObjects(void);
+static void updateTelemetryRates(void);
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
 static void updateSettings();
@@ -123,7 +154,13 @@ int32_t TelemetryStart(void)
  */
 int32_t TelemetryInitialize(void)
 {
-	if (FlightTelemetryStatsInitialize() == -1 || GCSTelemetryStatsInitialize() == -1) {
+	if (FlightTelemetryStatsInitialize() == -1 || GCSTelemetryStatsInitialize() == -1 ||
+			TelemetryRatesInitialize() == -1) {
+		return -1;
+	}
+
+	txBatch = PIOS_malloc(TX_BATCH_LEN);
+	if (txBatch == NULL) {
 		return -1;
 	}
 
@@ -162,23 +199,6 @@ static void registerObject(UAVObjHandle obj)
 		UAVObjConnectQueue(obj, queue, EV_MASK_ALL_UPDATES);
 		return;
 	} else {
-		UAVObjMetadata metadata;
-		UAVObjUpdateMode updateMode;
-		UAVObjGetMetadata(obj, &metadata);
-		updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
-
-		// Setup object for periodic updates
-		UAVObjEvent ev = {
-			.obj    = obj,
-			.instId = UAVOBJ_ALL_INSTANCES,
-			.event  = EV_UPDATED_PERIODIC,
-		};
-
-		/* Only create a periodic event for objects that are periodic */
-		if (updateMode == UPDATEMODE_PERIODIC) {
-			EventPeriodicQueueCreate(&ev, queue, 0);
-		}
-
 		// Setup object for telemetry updates
 		updateObject(obj, EV_NONE);
 	}
@@ -212,8 +232,8 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
 		// Set update period
 		setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
 
-		// Connect queue
-		eventMask = EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL;
+		// Connect queue; the periodic updates come from the schedule
+		eventMask = EV_UPDATED_MANUAL;
 		UAVObjConnectQueueThrottled(obj, queue, eventMask, 0);
 		break;
 	case UPDATEMODE_ONCHANGE:
@@ -242,42 +262,92 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
 	}
 }
 
+/**
+ * Number of bytes an update of the object takes on the link
+ * \param[in] obj The object
+ * \param[in] instId The instance, or UAVOBJ_ALL_INSTANCES
+ */
+static uint32_t updateBytes(UAVObjHandle obj, uint16_t instId)
+{
+	uint32_t bytes = UAVObjGetNumBytes(obj) + 8 + 1;
+
+	if (UAVObjIsSingleInstance(obj)) {
+		return bytes;
+	}
+
+	bytes += 2;
+
+	if (instId == UAVOBJ_ALL_INSTANCES) {
+		bytes *= UAVObjGetNumInstances(obj);
+	}
+
+	return bytes;
+}
+
+/**
+ * Send an update to the GCS right away, with retries
+ * \param[in] obj The object to send
+ * \param[in] instId The instance, or UAVOBJ_ALL_INSTANCES
+ * \param[in] acked Whether the GCS must acknowledge it
+ */
+static void sendObject(UAVObjHandle obj, uint16_t instId, uint8_t acked)
+{
+	int32_t retries = 0;
+	int32_t success = -1;
+
+	while (retries < MAX_RETRIES && success == -1) {
+		success = UAVTalkSendObject(uavTalkCon, obj, instId, acked, REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
+
+		++retries;
+	}
+
+	// Update stats
+	txRetries += (retries - 1);
+	if (success == -1) {
+		++txErrors;
+	}
+}
+
+/**
+ * Send whatever has been packed into the batch buffer
+ */
+static void flushBatch(void)
+{
+	if (txBatchLen == 0) {
+		return;
+	}
+
+	if (UAVTalkSendBuf(uavTalkCon, txBatch, txBatchLen) < 0) {
+		++txErrors;
+	}
+
+	txBatchLen = 0;
+}
+
 /**
  * Processes queue events
  */
 static void processObjEvent(UAVObjEvent * ev)
 {
 	UAVObjMetadata metadata;
-	FlightTelemetryStatsData flightStats;
-	int32_t retries;
-	int32_t success;
 
 	if (ev->obj == 0) {
 		updateTelemetryStats();
 	} else if (ev->obj == GCSTelemetryStatsHandle()) {
 		gcsTelemetryStatsUpdated();
 	} else {
-		FlightTelemetryStatsGet(&flightStats);
 		// Get object metadata
 		UAVObjGetMetadata(ev->obj, &metadata);
 
 		// Act on event
-		retries = 0;
-		success = -1;
 		if (ev->event == EV_UPDATED || ev->event == EV_UPDATED_MANUAL ||
 				ev->event == EV_UPDATED_PERIODIC) {
 			// Send update to GCS (with retries)
-			while (retries < MAX_RETRIES && success == -1) {
-				success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
+			sendObject(ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata));
 
-				++retries;
-			}
-			// Update stats
-			txRetries += (retries - 1);
-			if (success == -1) {
-				++txErrors;
-			}
-		} 
+			// Event driven updates share the link with the schedule
+			pacing_budget_charge(&linkBudget, updateBytes(ev->obj, ev->instId));
+		}
 
 		// If this is a metaobject then make necessary telemetry updates
 		if (UAVObjIsMetaobject(ev->obj)) {
@@ -296,16 +366,157 @@ static void telemetryTxTask(void *parameters)
 
 	UAVObjEvent ev;
 
+	ratesTime = PIOS_Thread_Systime();
+
 	// Loop forever
 	while (1) {
+		// Send what is due, then wait for events until more is due
+		uint32_t wait = processPeriodicObjects();
+
+		if (PIOS_Thread_Systime() - ratesTime >= STATS_UPDATE_PERIOD_MS) {
+			updateTelemetryRates();
+		}
+
 		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
+		if (PIOS_Queue_Receive(queue, &ev, wait) == true) {
 			// Process event
 			processObjEvent(&ev);
 		}
 	}
 }
 
+/**
+ * Send the periodic objects that are due, earliest deadline first, for as
+ * long as the link budget lasts.  Ties go to the shorter period.  An object
+ * that has fallen a whole period behind skips the missed updates rather
+ * than sending them in a burst.
+ * \return ms until something is next due
+ */
+static uint32_t processPeriodicObjects(void)
+{
+	uint32_t now = PIOS_Thread_Systime();
+	uint32_t wait = PIOS_QUEUE_TIMEOUT_MAX;
+
+	linkBudget.bandwidth = (getComPort() == PIOS_COM_TELEM_RF) ? rfBandwidth : 0;
+	pacing_budget_refill(&linkBudget, now);
+
+	while (true) {
+		struct periodic_object *next = NULL;
+
+		for (struct periodic_object *p = periodicObjects; p; p = p->next) {
+			if (p->period == 0 || pacing_before(now, p->next_due)) {
+				continue;
+			}
+
+			if (!next || pacing_sooner(p->next_due, p->period,
+						next->next_due, next->period)) {
+				next = p;
+			}
+		}
+
+		if (!next) {
+			break;
+		}
+
+		if (pacing_budget_spent(&linkBudget)) {
+			// Time until the budget is back in credit
+			wait = pacing_budget_wait(&linkBudget);
+			break;
+		}
+
+		UAVObjMetadata metadata;
+		UAVObjGetMetadata(next->obj, &metadata);
+
+		if (UAVObjGetTelemetryAcked(&metadata)) {
+			flushBatch();
+			sendObject(next->obj, UAVOBJ_ALL_INSTANCES, true);
+		} else {
+			uint16_t numInst = UAVObjGetNumInstances(next->obj);
+
+			for (uint16_t i = 0; i < numInst; i++) {
+				int32_t len = UAVTalkPackObject(next->obj, i,
+						txBatch + txBatchLen,
+						TX_BATCH_LEN - txBatchLen);
+
+				if (len < 0) {
+					flushBatch();
+
+					len = UAVTalkPackObject(next->obj, i,
+							txBatch, TX_BATCH_LEN);
+				}
+
+				if (len < 0) {
+					// Bigger than the batch buffer
+					sendObject(next->obj, i, false);
+				} else {
+					txBatchLen += len;
+				}
+			}
+		}
+
+		pacing_budget_charge(&linkBudget,
+				updateBytes(next->obj, UAVOBJ_ALL_INSTANCES));
+
+		next->sent++;
+		pacing_advance(&next->next_due, next->period, now);
+	}
+
+	flushBatch();
+
+	for (struct periodic_object *p = periodicObjects; p; p = p->next) {
+		int32_t until = p->next_due - now;
+
+		if (p->period && until > 0 && (uint32_t) until < wait) {
+			wait = until;
+		}
+	}
+
+	return wait;
+}
+
+/**
+ * Report the requested and achieved rate of each periodic object
+ */
+static void updateTelemetryRates(void)
+{
+	TelemetryRatesData rates;
+	memset(&rates, 0, sizeof(rates));
+
+	uint32_t now = PIOS_Thread_Systime();
+	float interval = (now - ratesTime) / 1000.0f;
+	uint32_t demand = 0;
+	uint32_t n = 0;
+
+	ratesTime = now;
+
+	for (struct periodic_object *p = periodicObjects; p; p = p->next) {
+		if (p->period == 0) {
+			p->sent = 0;
+			continue;
+		}
+
+		demand += updateBytes(p->obj, UAVOBJ_ALL_INSTANCES) * 1000 / p->period;
+
+		if (n < TELEMETRYRATES_OBJECTID_NUMELEM) {
+			rates.ObjectID[n] = UAVObjGetID(p->obj);
+			// In tenths of Hz, to keep the object small
+			rates.Requested[n] = (10000 + p->period / 2) / p->period;
+			rates.Achieved[n] = MIN(p->sent * 10 / interval + 0.5f, UINT16_MAX);
+			n++;
+		}
+
+		p->sent = 0;
+	}
+
+	rates.LinkBandwidth = linkBudget.bandwidth;
+
+	if (linkBudget.bandwidth) {
+		rates.Load = MIN(demand * 100 / linkBudget.bandwidth, UINT16_MAX);
+	}
+
+	TelemetryRatesSet(&rates);
+}
+
 #if defined(PIOS_INCLUDE_USB)
 /**
  * Updates the USB activity timer, and returns whether we should use USB this
@@ -410,13 +621,34 @@ static int32_t transmitData(uint8_t * data, int32_t length)
  */
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
 {
-	UAVObjEvent ev;
+	struct periodic_object *p;
+
+	for (p = periodicObjects; p; p = p->next) {
+		if (p->obj == obj) {
+			break;
+		}
+	}
+
+	if (!p) {
+		if (updatePeriodMs <= 0) {
+			return 0;
+		}
 
-	// Add object for periodic updates
-	ev.obj = obj;
-	ev.instId = UAVOBJ_ALL_INSTANCES;
-	ev.event = EV_UPDATED_PERIODIC;
-	return EventPeriodicQueueUpdate(&ev, queue, updatePeriodMs);
+		p = PIOS_malloc_no_dma(sizeof(*p));
+		if (p == NULL) {
+			return -1;
+		}
+
+		p->obj = obj;
+		p->sent = 0;
+		p->next = periodicObjects;
+		periodicObjects = p;
+	}
+
+	p->period = MAX(MIN(updatePeriodMs, UINT16_MAX), 0);
+	p->next_due = PIOS_Thread_Systime() + p->period;
+
+	return 0;
 }
 
 /**
@@ -537,6 +769,9 @@ static void updateSettings()
 		ModuleSettingsTelemetrySpeedGet(&speed);
 
 		PIOS_HAL_ConfigureSerialSpeed(PIOS_COM_TELEM_RF, speed);
+
+		// 8N1: ten bits on the wire per byte
+		rfBandwidth = PIOS_HAL_SerialSpeedBaud(speed) / 10;
 	}
 #endif
 }
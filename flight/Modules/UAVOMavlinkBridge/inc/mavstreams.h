@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules TauLabs Modules
+ * @{
+ * @addtogroup UAVOMavlinkBridge UAVO to Mavlink Bridge Module
+ * @{
+ *
+ * @file       mavstreams.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Rate bucket schedule and in-place framing of the Mavlink streams
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef MAVSTREAMS_H
+#define MAVSTREAMS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pacing.h"
+
+#define MAVSTREAMS_MAX_BUCKETS 8
+
+//! Sender ids put in every frame
+#define MAVSTREAMS_SYSTEM_ID    0
+#define MAVSTREAMS_COMPONENT_ID 200
+
+/**
+ * The streams that share a rate, sent together.
+ */
+struct mavstreams_bucket {
+	uint32_t deadline;   /**< Systime (ms) the bucket is next due */
+	uint16_t period;     /**< ms */
+	uint16_t streams;    /**< Bit n set for stream n */
+};
+
+/**
+ * Schedule of the streams.  Buckets that are due go out earliest deadline
+ * first; on a link with limited bandwidth they are paced by a token bucket,
+ * and a bucket that falls a whole period behind skips the missed sends
+ * rather than bursting.
+ */
+struct mavstreams {
+	struct mavstreams_bucket buckets[MAVSTREAMS_MAX_BUCKETS];
+	uint8_t num_buckets;
+	uint8_t seq;          /**< Sequence number of the next frame */
+	struct pacing_budget budget;
+};
+
+void mavstreams_init(struct mavstreams *sched, const uint8_t *rates,
+		uint8_t num_streams, uint32_t bandwidth, uint32_t now);
+uint16_t mavstreams_next_due(struct mavstreams *sched, uint32_t now);
+void mavstreams_sent(struct mavstreams *sched, uint16_t bytes);
+uint32_t mavstreams_wait(const struct mavstreams *sched, uint32_t now);
+uint16_t mavstreams_frame(struct mavstreams *sched, uint8_t *buf,
+		uint8_t msgid, const void *payload, uint8_t len);
+
+#endif /* MAVSTREAMS_H */
+
+/**
+ * @}
+ * @}
+ */
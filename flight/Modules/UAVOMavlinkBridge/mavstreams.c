@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules TauLabs Modules
+ * @{
+ * @addtogroup UAVOMavlinkBridge UAVO to Mavlink Bridge Module
+ * @{
+ *
+ * @file       mavstreams.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Rate bucket schedule and in-place framing of the Mavlink streams
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "mavstreams.h"
+#include "mavlink.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Private constants
+
+static const uint8_t mavlink_message_crcs[256] = MAVLINK_MESSAGE_CRCS;
+
+// Private functions
+
+/**
+ * Set up the schedule.  Streams with the same rate share a bucket.
+ * \param[out] sched The schedule
+ * \param[in] rates Rate of each stream in Hz, 0 for off
+ * \param[in] num_streams Number of entries in rates, at most 16
+ * \param[in] bandwidth bytes/s the link carries, 0 if not limited
+ * \param[in] now The systime (ms)
+ */
+void mavstreams_init(struct mavstreams *sched, const uint8_t *rates,
+		uint8_t num_streams, uint32_t bandwidth, uint32_t now)
+{
+	memset(sched, 0, sizeof(*sched));
+
+	pacing_budget_init(&sched->budget, bandwidth, now);
+
+	for (uint8_t i = 0; i < num_streams && i < 16; i++) {
+		if (rates[i] == 0) {
+			continue;
+		}
+
+		uint16_t period = 1000 / rates[i];
+		struct mavstreams_bucket *bucket = NULL;
+
+		for (uint8_t j = 0; j < sched->num_buckets; j++) {
+			if (sched->buckets[j].period == period) {
+				bucket = &sched->buckets[j];
+				break;
+			}
+		}
+
+		if (!bucket && sched->num_buckets < MAVSTREAMS_MAX_BUCKETS) {
+			bucket = &sched->buckets[sched->num_buckets++];
+			bucket->period = period;
+			bucket->deadline = now;
+		}
+
+		if (!bucket) {
+			// Out of buckets; ride along with the nearest rate
+			bucket = &sched->buckets[0];
+
+			for (uint8_t j = 1; j < sched->num_buckets; j++) {
+				if (abs(sched->buckets[j].period - period) <
+						abs(bucket->period - period)) {
+					bucket = &sched->buckets[j];
+				}
+			}
+		}
+
+		bucket->streams |= 1 << i;
+	}
+}
+
+/**
+ * Take the next bucket that is due.  Ties go to the shorter period.
+ * \param[in] sched The schedule
+ * \param[in] now The systime (ms)
+ * \return The streams of the bucket, or 0 if none is due or the link
+ * budget is spent
+ */
+uint16_t mavstreams_next_due(struct mavstreams *sched, uint32_t now)
+{
+	pacing_budget_refill(&sched->budget, now);
+
+	struct mavstreams_bucket *next = NULL;
+
+	for (uint8_t i = 0; i < sched->num_buckets; i++) {
+		struct mavstreams_bucket *bucket = &sched->buckets[i];
+
+		if (pacing_before(now, bucket->deadline)) {
+			continue;
+		}
+
+		if (!next || pacing_sooner(bucket->deadline, bucket->period,
+					next->deadline, next->period)) {
+			next = bucket;
+		}
+	}
+
+	if (!next || pacing_budget_spent(&sched->budget)) {
+		return 0;
+	}
+
+	pacing_advance(&next->deadline, next->period, now);
+
+	return next->streams;
+}
+
+/**
+ * Charge what was sent against the link budget.
+ * \param[in] sched The schedule
+ * \param[in] bytes Bytes put on the link
+ */
+void mavstreams_sent(struct mavstreams *sched, uint16_t bytes)
+{
+	pacing_budget_charge(&sched->budget, bytes);
+}
+
+/**
+ * Time until mavstreams_next_due has something, once it has returned 0.
+ * \param[in] sched The schedule
+ * \param[in] now The systime (ms)
+ * \return ms to wait, at least 1
+ */
+uint32_t mavstreams_wait(const struct mavstreams *sched, uint32_t now)
+{
+	uint32_t wait = 1000;
+
+	for (uint8_t i = 0; i < sched->num_buckets; i++) {
+		int32_t until = sched->buckets[i].deadline - now;
+
+		if (until < (int32_t) wait) {
+			wait = (until > 0) ? until : 0;
+		}
+	}
+
+	// Time until the budget is back in credit
+	uint32_t credit = pacing_budget_wait(&sched->budget);
+
+	if (credit > wait) {
+		wait = credit;
+	}
+
+	return (wait > 0) ? wait : 1;
+}
+
+/**
+ * Build a complete Mavlink frame, so it can go straight into the transmit
+ * buffer without a mavlink_message_t in between.
+ * \param[in] sched The schedule, which numbers the frames
+ * \param[out] buf Where the frame goes; len + MAVLINK_NUM_NON_PAYLOAD_BYTES
+ * \param[in] msgid The message id
+ * \param[in] payload The message, a mavlink_*_t
+ * \param[in] len The message length
+ * \return Bytes in the frame
+ */
+uint16_t mavstreams_frame(struct mavstreams *sched, uint8_t *buf,
+		uint8_t msgid, const void *payload, uint8_t len)
+{
+	buf[0] = MAVLINK_STX;
+	buf[1] = len;
+	buf[2] = sched->seq++;
+	buf[3] = MAVSTREAMS_SYSTEM_ID;
+	buf[4] = MAVSTREAMS_COMPONENT_ID;
+	buf[5] = msgid;
+	memcpy(&buf[MAVLINK_NUM_HEADER_BYTES], payload, len);
+
+	uint16_t checksum = crc_calculate(&buf[1], MAVLINK_CORE_HEADER_LEN + len);
+	crc_accumulate(mavlink_message_crcs[msgid], &checksum);
+
+	buf[MAVLINK_NUM_HEADER_BYTES + len] = checksum & 0xff;
+	buf[MAVLINK_NUM_HEADER_BYTES + len + 1] = checksum >> 8;
+
+	return len + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -67,6 +67,10 @@ void hal_lld_init(void) {
     .sa_handler = port_tick_signal_handler,
   };
 
+  /* Don't let an I/O interrupt nest inside the tick */
+  sigemptyset(&sigtick.sa_mask);
+  sigaddset(&sigtick.sa_mask, PORT_IO_SIGNAL);
+
   if (sigaction(PORT_TIMER_SIGNAL, &sigtick, NULL) < 0)
     port_halt();
 
@@ -39,6 +39,7 @@
 #include "ucontext/winucontext.c"
 #else
 #include <ucontext.h>
+#include <sys/time.h>
 #endif
 
 #include <unistd.h>
@@ -77,6 +78,72 @@ void port_tick_signal_handler(int signo, siginfo_t *info, void *context) {
 void port_init(void) {
 }
 
+/*
+ * Lockstep mode: instead of the interval timer, time is a virtual
+ * microsecond counter that only moves when the idle thread runs (every
+ * thread is waiting, so jump straight to the next tick) or when code
+ * busy-waits.  Nothing preempts on a wall-clock signal any more, so a run
+ * is as fast as the host allows and repeatable given the same inputs.
+ */
+#define LOCKSTEP_TICK_US (1000000 / CH_FREQUENCY)
+
+static bool_t lockstep;
+static uint64_t lockstep_us;
+static uint64_t lockstep_next_tick_us;
+
+/**
+ * @brief   Stop the interval timer and drive time from the virtual clock.
+ * @note    Must be called from a thread, with the system unlocked.
+ */
+void port_lockstep_enable(void) {
+  if (lockstep)
+    return;
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+  struct itimerval itimer = { { 0, 0 }, { 0, 0 } };
+
+  if (setitimer(PORT_TIMER_TYPE, &itimer, NULL) < 0)
+    port_halt();
+#endif
+
+  chSysLock();
+  /* Continue from the current system time */
+  lockstep_us = (uint64_t) chTimeNow() * LOCKSTEP_TICK_US;
+  lockstep_next_tick_us = lockstep_us + LOCKSTEP_TICK_US;
+  lockstep = TRUE;
+  chSysUnlock();
+}
+
+bool_t port_lockstep_enabled(void) {
+  return lockstep;
+}
+
+/**
+ * @brief   Current virtual time, only meaningful in lockstep mode.
+ */
+uint64_t port_lockstep_time_us(void) {
+  return lockstep_us;
+}
+
+/**
+ * @brief   Let virtual time pass, running every system tick it crosses.
+ * @details Ticks can wake up higher priority threads, which then run
+ *          before this returns, just as they would preempt a busy-wait.
+ * @note    Must be called from a thread, with the system unlocked.
+ */
+void port_lockstep_advance(uint32_t us) {
+  lockstep_us += us;
+
+  while (lockstep_us >= lockstep_next_tick_us) {
+    lockstep_next_tick_us += LOCKSTEP_TICK_US;
+
+    chSysLock();
+    chSysTimerHandlerI();
+    chSchRescheduleS();
+    chSysUnlock();
+  }
+}
+
 /**
  * @brief   Kernel-lock action.
  * @details Usually this function just disables interrupts but may perform more
@@ -97,6 +164,8 @@ void port_lock(void) {
     port_halt();
   if (sigaddset(&set, PORT_TIMER_SIGNAL) < 0)
     port_halt();
+  if (sigaddset(&set, PORT_IO_SIGNAL) < 0)
+    port_halt();
   if (sigprocmask(SIG_BLOCK, &set, &saved) > 0)
     port_halt();
 #endif
@@ -163,6 +232,12 @@ void port_enable(void) {
  *          modes.
  */
 void port_wait_for_interrupt(void) {
+	if (lockstep) {
+		/* Nothing is ready to run until the next tick */
+		port_lockstep_advance(lockstep_next_tick_us - lockstep_us);
+		return;
+	}
+
 	select(0, NULL, NULL, NULL, NULL);
 }
 
@@ -218,6 +293,8 @@ void _port_thread_start(void (*func)(int), int arg) {
     port_halt();
   if (sigaddset(&set, PORT_TIMER_SIGNAL) < 0)
     port_halt();
+  if (sigaddset(&set, PORT_IO_SIGNAL) < 0)
+    port_halt();
   if (sigprocmask(SIG_UNBLOCK, &set, NULL) > 0)
     port_halt();
 #endif
@@ -115,6 +115,15 @@
 #define PORT_TIMER_SIGNAL               SIGALRM
 #endif
 
+/**
+ * @brief   Signal drivers use as an I/O interrupt.
+ * @details Masked in critical sections along with the timer signal, so
+ *          its handler may use the I-class APIs like the tick handler.
+ */
+#if !defined(PORT_IO_SIGNAL) || defined(__DOXYGEN__)
+#define PORT_IO_SIGNAL                  SIGIO
+#endif
+
 /*===========================================================================*/
 /* Port derived parameters.                                                  */
 /*===========================================================================*/
@@ -262,6 +271,11 @@ extern "C" {
   void port_halt(void);
   void port_switch(Thread *ntp, Thread *otp);
 
+  void port_lockstep_enable(void);
+  bool_t port_lockstep_enabled(void);
+  uint64_t port_lockstep_time_us(void);
+  void port_lockstep_advance(uint32_t us);
+
   void _port_thread_start(void (*func)(int), int arg);
 #ifdef __cplusplus
 }
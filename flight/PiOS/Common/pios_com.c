@@ -382,6 +382,86 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return sent;
 }
 
+/**
+* Reserves room in the transmit buffer so that data can be built there in
+* place, instead of being built elsewhere and copied in.  On success the
+* port stays locked against other senders until PIOS_COM_CommitTx.
+* \param[in] port COM port
+* \param[in] len number of contiguous bytes needed
+* \param[out] buffer where to build the data
+* \return -1 if port not available
+* \return -2 if len contiguous bytes are not free; the caller can fall
+*            back to PIOS_COM_SendBuffer, which wraps around the buffer
+* \return -3 another thread is already sending
+* \return number of contiguous bytes that may be written on success
+*/
+int32_t PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len, uint8_t **buffer)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	PIOS_Assert(com_dev->tx);
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, 0) != true) {
+		return -3;
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	if (com_dev->driver->available && !com_dev->driver->available(com_dev->lower_id)) {
+		/* Device is down; drop what is queued, as
+		 * SendBufferNonBlockingImpl does */
+		circ_queue_clear(com_dev->tx);
+	}
+
+	uint16_t contig;
+
+	*buffer = circ_queue_write_pos(com_dev->tx, &contig, NULL);
+
+	if (contig < len) {
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+		PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+		return -2;
+	}
+
+	return contig;
+}
+
+/**
+* Queues data built in place after PIOS_COM_ReserveTx succeeded, and
+* unlocks the port.
+* \param[in] port COM port
+* \param[in] len number of bytes written, at most what was reserved
+*/
+void PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+	bool valid = PIOS_COM_validate(com_dev);
+	PIOS_Assert(valid);
+
+	if (len > 0) {
+		circ_queue_advance_write_multi(com_dev->tx, len);
+
+		if (com_dev->driver->tx_start) {
+			uint16_t tx_avail;
+
+			circ_queue_read_pos(com_dev->tx, NULL, &tx_avail);
+			com_dev->driver->tx_start(com_dev->lower_id,
+						  tx_avail);
+		}
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* PIOS_INCLUDE_FREERTOS */
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
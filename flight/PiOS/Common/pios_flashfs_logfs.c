@@ -844,42 +844,19 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 #include "pios_flashfs.h"	/* API for flash filesystem */
 
 /**
- * @brief Saves one object instance to the filesystem
- * @param[in] fs_id The filesystem to use for this action
- * @param[in] obj UAVObject ID of the object to save
- * @param[in] obj_inst_id The instance number of the object being saved
- * @param[in] obj_data Contents of the object being saved
- * @param[in] obj_size Size of the object being saved
+ * @brief Saves one object instance to the log of a filesystem
+ * @note Must be called with a flash transaction already started
  * @return 0 if success or error code
- * @retval -1 if fs_id is not a valid filesystem instance
- * @retval -2 if failed to start transaction
  * @retval -3 if failure to delete any previous versions of the object
  * @retval -4 if filesystem is entirely full and garbage collection won't help
  * @retval -5 if garbage collection failed
  * @retval -6 if filesystem is full even after garbage collection should have freed space
  * @retval -7 if writing the new object to the filesystem failed
  */
-int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+static int8_t logfs_save_object(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
 {
-	int8_t rc;
-
-	struct logfs_state *logfs = (struct logfs_state *)fs_id;
-
-	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
-		rc = -1;
-		goto out_exit;
-	}
-
-	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
-
-	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
-		rc = -2;
-		goto out_exit;
-	}
-
 	if (logfs_delete_object (logfs, obj_id, obj_inst_id) != 0) {
-		rc = -3;
-		goto out_end_trans;
+		return -3;
 	}
 
 	/*
@@ -890,16 +867,14 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	/* Check if the arena is entirely full. */
 	if (logfs_fs_is_full(logfs)) {
 		/* Note: Filesystem Full means we're full of *active* records so gc won't help at all. */
-		rc = -4;
-		goto out_end_trans;
+		return -4;
 	}
 
 	/* Is garbage collection required? */
 	if (logfs_log_is_full(logfs)) {
 		/* Note: Log Full means the log is full but may contain obsolete slots so gc may free some space */
 		if (logfs_garbage_collect(logfs) != 0) {
-			rc = -5;
-			goto out_end_trans;
+			return -5;
 		}
 		/* Check one more time just to be sure we actually free'd some space */
 		if (logfs_log_is_full(logfs)) {
@@ -909,28 +884,118 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 			 *       when we checked above so gc should have helped.
 			 */
 			PIOS_DEBUG_Assert(0);
-			rc = -6;
-			goto out_end_trans;
+			return -6;
 		}
 	}
 
 	/* We have room for our new object.  Append it to the log. */
 	if (logfs_append_to_log(logfs, obj_id, obj_inst_id, obj_data, obj_size) != 0) {
 		/* Error during append */
-		rc = -7;
-		goto out_end_trans;
+		return -7;
 	}
 
 	/* Object successfully written to the log */
-	rc = 0;
+	return 0;
+}
+
+/**
+ * @brief Saves one object instance to the filesystem
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] obj UAVObject ID of the object to save
+ * @param[in] obj_inst_id The instance number of the object being saved
+ * @param[in] obj_data Contents of the object being saved
+ * @param[in] obj_size Size of the object being saved
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if failure to delete any previous versions of the object
+ * @retval -4 if filesystem is entirely full and garbage collection won't help
+ * @retval -5 if garbage collection failed
+ * @retval -6 if filesystem is full even after garbage collection should have freed space
+ * @retval -7 if writing the new object to the filesystem failed
+ */
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	int8_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	PIOS_Assert(obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header)));
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	rc = logfs_save_object(logfs, obj_id, obj_inst_id, obj_data, obj_size);
 
-out_end_trans:
 	PIOS_FLASH_end_transaction(logfs->partition_id);
 
 out_exit:
 	return rc;
 }
 
+/**
+ * @brief Saves a batch of object instances within a single flash transaction
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] num_objs Number of objects in the batch
+ * @param[in] source Called to fetch the id, instance and contents of each object
+ * @param[in] done Called after each object with its result, may be NULL
+ * @param[in] ctx Opaque context handed to the callbacks
+ * @return 0 if every object was saved or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -8 if one or more of the objects failed to save
+ * @note The per-object result passed to done uses the same codes as
+ *       PIOS_FLASHFS_ObjSave, plus -1 for a skipped or oversized object.
+ *       The object data only needs to remain valid until the next call
+ *       to source.
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, uint16_t num_objs, pios_flashfs_obj_source_t source, pios_flashfs_obj_done_t done, void *ctx)
+{
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		return -1;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		return -2;
+	}
+
+	uint16_t num_failed = 0;
+
+	for (uint16_t i = 0; i < num_objs; i++) {
+		uint32_t obj_id;
+		uint16_t obj_inst_id;
+		uint8_t *obj_data;
+		uint16_t obj_size;
+		int8_t rc = -1;
+
+		if (source(ctx, i, &obj_id, &obj_inst_id, &obj_data, &obj_size) &&
+				obj_size <= (logfs->cfg->slot_size - sizeof(struct slot_header))) {
+			rc = logfs_save_object(logfs, obj_id, obj_inst_id, obj_data, obj_size);
+		}
+
+		if (rc != 0) {
+			num_failed++;
+		}
+
+		if (done) {
+			done(ctx, i, rc);
+		}
+	}
+
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+	return (num_failed == 0) ? 0 : -8;
+}
+
 /**
  * @brief Load one object instance from the filesystem
  * @param[in] fs_id The filesystem to use for this action
@@ -1214,6 +1214,38 @@ void PIOS_HAL_ConfigureSerialSpeed(uintptr_t com_id,
 	}
 }
 
+/**
+ * Baud rate a port is left at by PIOS_HAL_ConfigureSerialSpeed
+ * \param[in] speed the configured speed
+ * \return the baud rate
+ */
+uint32_t PIOS_HAL_SerialSpeedBaud(HwSharedSpeedBpsOptions speed)
+{
+	switch (speed) {
+		case HWSHARED_SPEEDBPS_1200:
+		case HWSHARED_SPEEDBPS_2400:
+			return 2400;
+		case HWSHARED_SPEEDBPS_4800:
+			return 4800;
+		case HWSHARED_SPEEDBPS_9600:
+			return 9600;
+		case HWSHARED_SPEEDBPS_19200:
+			return 19200;
+		case HWSHARED_SPEEDBPS_38400:
+			return 38400;
+		case HWSHARED_SPEEDBPS_57600:
+			return 57600;
+		case HWSHARED_SPEEDBPS_230400:
+			return 230400;
+		case HWSHARED_SPEEDBPS_INITHM10:
+		case HWSHARED_SPEEDBPS_INITHC06:
+		case HWSHARED_SPEEDBPS_INITHC05:
+		case HWSHARED_SPEEDBPS_115200:
+		default:
+			return 115200;
+	}
+}
+
 #ifdef PIOS_INCLUDE_I2C
 static int PIOS_HAL_ConfigureI2C(uint32_t *id,
 		const struct pios_i2c_adapter_cfg *cfg) {
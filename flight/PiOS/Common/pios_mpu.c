@@ -51,6 +51,9 @@
 
 #define PIOS_MPU_QUEUE_LEN       2
 
+/* Frames per FIFO read at most, which keeps an I2C read under 256 bytes */
+#define PIOS_MPU_FIFO_MAX_FRAMES 18
+
 #ifndef PIOS_MPU_SPI_HIGH_SPEED
 #define PIOS_MPU_SPI_HIGH_SPEED              20000000	// should result in 10.5MHz clock on F4 targets like Sparky2
 #endif // PIOS_MPU_SPI_HIGH_SPEED
@@ -68,6 +71,7 @@ static const uint8_t pios_mpu_whoami[PIOS_MPU_NUM] = {
 	[PIOS_ICM20608G] = 0xAF,
 };
 
+#if defined(PIOS_INCLUDE_I2C)
 /**
  * I2C addresses to probe for device
  */
@@ -75,6 +79,7 @@ static const uint8_t pios_mpu_i2c_addr[] = {
 	0x68,
 	0x69,
 };
+#endif // defined(PIOS_INCLUDE_I2C)
 
 /**
  * The available underlying communication drivers
@@ -113,6 +118,11 @@ struct pios_mpu_dev {
 	struct pios_queue *mag_queue;
 #endif // PIOS_INCLUDE_MPU_MAG
 	volatile uint32_t interrupt_count;
+	uint8_t user_ctrl;                          /**< USER_CTRL, less the FIFO bits */
+	uint8_t fifo_burst;                         /**< Samples per FIFO read, 0 when interrupt driven */
+	uint8_t *fifo_buf;
+	uint32_t sample_period_us;
+	struct pios_mpu_fifo_stats fifo_stats;
 };
 
 //! Global structure for this device device
@@ -145,6 +155,13 @@ static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg);
 static void PIOS_MPU_Task(void *parameters);
 static int32_t PIOS_MPU_ReadReg(uint8_t reg);
 static int32_t PIOS_MPU_WriteReg(uint8_t reg, uint8_t data);
+/**
+ * @brief Read consecutive registers, or bytes from the FIFO, at full speed
+ * @return 0 if successful
+ */
+static int32_t PIOS_MPU_ReadBlock(uint8_t reg, uint8_t *buffer, uint16_t len);
+static int32_t PIOS_MPU_FIFO_Reset(void);
+static void PIOS_MPU_FIFO_Task(void *parameters);
 
 #if defined(PIOS_INCLUDE_SPI) || defined(__DOXYGEN__)
 /**
@@ -186,16 +203,38 @@ static struct pios_mpu_dev *PIOS_MPU_Alloc(const struct pios_mpu_cfg *cfg)
 		return NULL;
 
 	dev->magic = PIOS_MPU_DEV_MAGIC;
+	dev->fifo_stats = (struct pios_mpu_fifo_stats) { 0 };
+	dev->fifo_buf = NULL;
+
+	// Each read takes up to two bursts, to catch up after the task was late
+	dev->fifo_burst = cfg->fifo_burst;
+	if (dev->fifo_burst > PIOS_MPU_FIFO_MAX_FRAMES / 2)
+		dev->fifo_burst = PIOS_MPU_FIFO_MAX_FRAMES / 2;
+
+	// and all of a read is queued at once
+	size_t queue_len = PIOS_MPU_QUEUE_LEN;
+	if (queue_len < 2 * dev->fifo_burst)
+		queue_len = 2 * dev->fifo_burst;
+
+	if (dev->fifo_burst) {
+		dev->fifo_buf = PIOS_malloc(2 * dev->fifo_burst * PIOS_MPU_FIFO_FRAME_LEN);
+		if (dev->fifo_buf == NULL) {
+			PIOS_free(dev);
+			return NULL;
+		}
+	}
 
-	dev->accel_queue = PIOS_Queue_Create(PIOS_MPU_QUEUE_LEN, sizeof(struct pios_sensor_accel_data));
+	dev->accel_queue = PIOS_Queue_Create(queue_len, sizeof(struct pios_sensor_accel_data));
 	if (dev->accel_queue == NULL) {
+		PIOS_free(dev->fifo_buf);
 		PIOS_free(dev);
 		return NULL;
 	}
 
-	dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU_QUEUE_LEN, sizeof(struct pios_sensor_gyro_data));
+	dev->gyro_queue = PIOS_Queue_Create(queue_len, sizeof(struct pios_sensor_gyro_data));
 	if (dev->gyro_queue == NULL) {
 		PIOS_Queue_Delete(dev->accel_queue);
+		PIOS_free(dev->fifo_buf);
 		PIOS_free(dev);
 		return NULL;
 	}
@@ -204,6 +243,7 @@ static struct pios_mpu_dev *PIOS_MPU_Alloc(const struct pios_mpu_cfg *cfg)
 	if (dev->data_ready_sema == NULL) {
 		PIOS_Queue_Delete(dev->accel_queue);
 		PIOS_Queue_Delete(dev->gyro_queue);
+		PIOS_free(dev->fifo_buf);
 		PIOS_free(dev);
 		return NULL;
 	}
@@ -254,13 +294,13 @@ static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg)
 		return -PIOS_MPU_ERROR_WRITEFAILED;
 
 	// user control
-	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
-		if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_USERCTL_DIS_I2C | PIOS_MPU_USERCTL_I2C_MST_EN) != 0)
-			return -PIOS_MPU_ERROR_WRITEFAILED;
-	} else {
-		if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, PIOS_MPU_USERCTL_I2C_MST_EN) != 0)
-			return -PIOS_MPU_ERROR_WRITEFAILED;
-	}
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI)
+		mpu_dev->user_ctrl = PIOS_MPU_USERCTL_DIS_I2C | PIOS_MPU_USERCTL_I2C_MST_EN;
+	else
+		mpu_dev->user_ctrl = PIOS_MPU_USERCTL_I2C_MST_EN;
+
+	if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, mpu_dev->user_ctrl) != 0)
+		return -PIOS_MPU_ERROR_WRITEFAILED;
 
 	// Digital low-pass filter and scale
 	// set this before sample rate else sample rate calculation will fail
@@ -277,11 +317,22 @@ static int32_t PIOS_MPU_Config(struct pios_mpu_cfg const *cfg)
 	// Set the accel scale
 	PIOS_MPU_SetAccelRange(PIOS_MPU_SCALE_8G);
 
-	// Interrupt configuration
-	PIOS_MPU_WriteReg(PIOS_MPU_INT_CFG_REG, PIOS_MPU_INT_CLR_ANYRD);
+	if (mpu_dev->fifo_burst) {
+		// The task polls, and only needs INT_STATUS to flag overflows.
+		// Don't let the FIFO reads clear that.
+		PIOS_MPU_WriteReg(PIOS_MPU_INT_CFG_REG, 0);
+		PIOS_MPU_WriteReg(PIOS_MPU_INT_EN_REG, PIOS_MPU_INTEN_OVERFLOW);
 
-	// Interrupt enable
-	PIOS_MPU_WriteReg(PIOS_MPU_INT_EN_REG, PIOS_MPU_INTEN_DATA_RDY);
+		// Frames are then laid out like ACCEL_XOUT_H to GYRO_ZOUT_L
+		PIOS_MPU_WriteReg(PIOS_MPU_FIFO_EN_REG, PIOS_MPU_ACCEL_OUT | PIOS_MPU_FIFO_TEMP_OUT |
+				PIOS_MPU_FIFO_GYRO_X_OUT | PIOS_MPU_FIFO_GYRO_Y_OUT | PIOS_MPU_FIFO_GYRO_Z_OUT);
+	} else {
+		// Interrupt configuration
+		PIOS_MPU_WriteReg(PIOS_MPU_INT_CFG_REG, PIOS_MPU_INT_CLR_ANYRD);
+
+		// Interrupt enable
+		PIOS_MPU_WriteReg(PIOS_MPU_INT_EN_REG, PIOS_MPU_INTEN_DATA_RDY);
+	}
 
 	return 0;
 }
@@ -421,26 +472,34 @@ static int32_t PIOS_MPU_Common_Init(void)
 	}
 #endif // PIOS_INCLUDE_MPU_MAG
 
-	/* Set up EXTI line */
-	PIOS_EXTI_Init(mpu_dev->cfg->exti_cfg);
-
-	/* Wait 20 ms for data ready interrupt and make sure it happens twice */
-	if (!mpu_dev->cfg->skip_startup_irq_check) {
-		for (int i=0; i<2; i++) {
-			uint32_t ref_val = mpu_dev->interrupt_count;
-			uint32_t raw_start = PIOS_DELAY_GetRaw();
-
-			while (mpu_dev->interrupt_count == ref_val) {
-				if (PIOS_DELAY_DiffuS(raw_start) > 20000) {
-					PIOS_EXTI_DeInit(mpu_dev->cfg->exti_cfg);
-					return -PIOS_MPU_ERROR_NOIRQ;
+	/* FIFO mode polls, so has no use for the interrupt */
+	if (!mpu_dev->fifo_burst) {
+#ifndef SIM_POSIX
+		/* Set up EXTI line */
+		PIOS_EXTI_Init(mpu_dev->cfg->exti_cfg);
+
+		/* Wait 20 ms for data ready interrupt and make sure it happens twice */
+		if (!mpu_dev->cfg->skip_startup_irq_check) {
+			for (int i=0; i<2; i++) {
+				uint32_t ref_val = mpu_dev->interrupt_count;
+				uint32_t raw_start = PIOS_DELAY_GetRaw();
+
+				while (mpu_dev->interrupt_count == ref_val) {
+					if (PIOS_DELAY_DiffuS(raw_start) > 20000) {
+						PIOS_EXTI_DeInit(mpu_dev->cfg->exti_cfg);
+						return -PIOS_MPU_ERROR_NOIRQ;
+					}
 				}
 			}
 		}
+#else
+		return -PIOS_MPU_ERROR_NOIRQ;
+#endif // SIM_POSIX
 	}
 
 	mpu_dev->task_handle = PIOS_Thread_Create(
-			PIOS_MPU_Task, "pios_mpu", PIOS_MPU_TASK_STACK, NULL, PIOS_MPU_TASK_PRIORITY);
+			mpu_dev->fifo_burst ? PIOS_MPU_FIFO_Task : PIOS_MPU_Task,
+			"pios_mpu", PIOS_MPU_TASK_STACK, NULL, PIOS_MPU_TASK_PRIORITY);
 	PIOS_Assert(mpu_dev->task_handle != NULL);
 	TaskMonitorAdd(TASKINFO_RUNNING_IMU, mpu_dev->task_handle);
 
@@ -656,6 +715,8 @@ int32_t PIOS_MPU_SetSampleRate(uint16_t samplerate_hz)
 	int32_t retval = PIOS_MPU_WriteReg(PIOS_MPU_SMPLRT_DIV_REG, (uint8_t)divisor);
 
 	if (retval == 0) {
+		mpu_dev->sample_period_us = 1000000 / samplerate_hz;
+
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_ACCEL, samplerate_hz);
 		PIOS_SENSORS_SetSampleRate(PIOS_SENSOR_GYRO, samplerate_hz);
 #ifdef PIOS_INCLUDE_MPU_MAG
@@ -877,6 +938,30 @@ static int32_t PIOS_MPU_ReadReg(uint8_t reg)
 		return data;
 }
 
+static int32_t PIOS_MPU_ReadBlock(uint8_t reg, uint8_t *buffer, uint16_t len)
+{
+#if defined(PIOS_INCLUDE_I2C)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C)
+		return (PIOS_MPU_I2C_Read(reg, buffer, len) < 0) ? -1 : 0;
+#endif // defined(PIOS_INCLUDE_I2C)
+#if defined(PIOS_INCLUDE_SPI)
+	if (mpu_dev->com_driver_type == PIOS_MPU_COM_SPI) {
+		// claim bus in high speed mode
+		if (PIOS_MPU_ClaimBus(false) != 0)
+			return -1;
+
+		PIOS_SPI_TransferByte(mpu_dev->com_driver_id, 0x80 | reg);
+		int32_t retval = PIOS_SPI_TransferBlock(mpu_dev->com_driver_id, NULL, buffer, len);
+
+		PIOS_MPU_ReleaseBus(false);
+
+		return (retval < 0) ? -1 : 0;
+	}
+#endif // defined(PIOS_INCLUDE_SPI)
+
+	return -1;
+}
+
 bool PIOS_MPU_IRQHandler(void)
 {
 	if (PIOS_MPU_Validate(mpu_dev) != 0)
@@ -891,13 +976,15 @@ bool PIOS_MPU_IRQHandler(void)
 	return woken;
 }
 
-static void PIOS_MPU_Task(void *parameters)
+/**
+ * @brief Convert one sample to our frame and units and queue it
+ * @param[in] raw accels, temperature and gyros in register order, as read
+ * from ACCEL_XOUT_H to GYRO_ZOUT_L or from the FIFO
+ */
+static void PIOS_MPU_PushSample(const uint8_t *raw)
 {
-	(void)parameters;
-
 	enum {
-		IDX_SPI_DUMMY_BYTE = 0,
-		IDX_ACCEL_XOUT_H,
+		IDX_ACCEL_XOUT_H = 0,
 		IDX_ACCEL_XOUT_L,
 		IDX_ACCEL_YOUT_H,
 		IDX_ACCEL_YOUT_L,
@@ -911,8 +998,125 @@ static void PIOS_MPU_Task(void *parameters)
 		IDX_GYRO_YOUT_L,
 		IDX_GYRO_ZOUT_H,
 		IDX_GYRO_ZOUT_L,
+	};
+
+	struct pios_sensor_accel_data accel_data;
+	struct pios_sensor_gyro_data gyro_data;
+
+	float accel_x = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+	float accel_y = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+	float accel_z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+	float gyro_x  = (int16_t)(raw[IDX_GYRO_XOUT_H]  << 8 | raw[IDX_GYRO_XOUT_L]);
+	float gyro_y  = (int16_t)(raw[IDX_GYRO_YOUT_H]  << 8 | raw[IDX_GYRO_YOUT_L]);
+	float gyro_z  = (int16_t)(raw[IDX_GYRO_ZOUT_H]  << 8 | raw[IDX_GYRO_ZOUT_L]);
+
+	// Rotate the sensor to our convention.  The datasheet defines X as towards the right
+	// and Y as forward. Our convention transposes this.  Also the Z is defined negatively
+	// to our convention. This is true for accels and gyros.
+	switch (mpu_dev->cfg->orientation) {
+	case PIOS_MPU_TOP_0DEG:
+		accel_data.y =  accel_x;
+		accel_data.x =  accel_y;
+		accel_data.z = -accel_z;
+		gyro_data.y  =  gyro_x;
+		gyro_data.x  =  gyro_y;
+		gyro_data.z  = -gyro_z;
+		break;
+	case PIOS_MPU_TOP_90DEG:
+		accel_data.y = -accel_y;
+		accel_data.x =  accel_x;
+		accel_data.z = -accel_z;
+		gyro_data.y  = -gyro_y;
+		gyro_data.x  =  gyro_x;
+		gyro_data.z  = -gyro_z;
+		break;
+	case PIOS_MPU_TOP_180DEG:
+		accel_data.y = -accel_x;
+		accel_data.x = -accel_y;
+		accel_data.z = -accel_z;
+		gyro_data.y  = -gyro_x;
+		gyro_data.x  = -gyro_y;
+		gyro_data.z  = -gyro_z;
+		break;
+	case PIOS_MPU_TOP_270DEG:
+		accel_data.y =  accel_y;
+		accel_data.x = -accel_x;
+		accel_data.z = -accel_z;
+		gyro_data.y  =  gyro_y;
+		gyro_data.x  = -gyro_x;
+		gyro_data.z  = -gyro_z;
+		break;
+	case PIOS_MPU_BOTTOM_0DEG:
+		accel_data.y = -accel_x;
+		accel_data.x =  accel_y;
+		accel_data.z =  accel_z;
+		gyro_data.y  = -gyro_x;
+		gyro_data.x  =  gyro_y;
+		gyro_data.z  =  gyro_z;
+		break;
+
+	case PIOS_MPU_BOTTOM_90DEG:
+		accel_data.y =  accel_y;
+		accel_data.x =  accel_x;
+		accel_data.z =  accel_z;
+		gyro_data.y  =  gyro_y;
+		gyro_data.x  =  gyro_x;
+		gyro_data.z  =  gyro_z;
+		break;
+
+	case PIOS_MPU_BOTTOM_180DEG:
+		accel_data.y =  accel_x;
+		accel_data.x = -accel_y;
+		accel_data.z =  accel_z;
+		gyro_data.y  =  gyro_x;
+		gyro_data.x  = -gyro_y;
+		gyro_data.z  =  gyro_z;
+		break;
+
+	case PIOS_MPU_BOTTOM_270DEG:
+		accel_data.y = -accel_y;
+		accel_data.x = -accel_x;
+		accel_data.z =  accel_z;
+		gyro_data.y  = -gyro_y;
+		gyro_data.x  = -gyro_x;
+		gyro_data.z  =  gyro_z;
+		break;
+	}
+
+	int16_t raw_temp = (int16_t)(raw[IDX_TEMP_OUT_H] << 8 | raw[IDX_TEMP_OUT_L]);
+	float temperature;
+	if (mpu_dev->mpu_type == PIOS_MPU6500 || mpu_dev->mpu_type == PIOS_MPU9250)
+		temperature = 21.0f + ((float)raw_temp) / 333.87f;
+	else
+		temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
+
+	// Apply sensor scaling
+	float accel_scale = PIOS_MPU_GetAccelScale();
+	accel_data.x *= accel_scale;
+	accel_data.y *= accel_scale;
+	accel_data.z *= accel_scale;
+	accel_data.temperature = temperature;
+
+	float gyro_scale = PIOS_MPU_GetGyroScale();
+	gyro_data.x *= gyro_scale;
+	gyro_data.y *= gyro_scale;
+	gyro_data.z *= gyro_scale;
+	gyro_data.temperature = temperature;
+
+	PIOS_Queue_Send(mpu_dev->accel_queue, &accel_data, 0);
+	PIOS_Queue_Send(mpu_dev->gyro_queue, &gyro_data, 0);
+}
+
 #ifdef PIOS_INCLUDE_MPU_MAG
-		IDX_MAG_ST1,
+/**
+ * @brief Check a magnetometer sample, convert it and queue it
+ * @param[in] raw AK89xx registers from ST1 to ST2, as copied by the
+ * MPU's I2C master into EXT_SENS_DATA
+ */
+static void PIOS_MPU_PushMag(const uint8_t *raw)
+{
+	enum {
+		IDX_MAG_ST1 = 0,
 		IDX_MAG_XOUT_L,
 		IDX_MAG_XOUT_H,
 		IDX_MAG_YOUT_L,
@@ -920,25 +1124,110 @@ static void PIOS_MPU_Task(void *parameters)
 		IDX_MAG_ZOUT_L,
 		IDX_MAG_ZOUT_H,
 		IDX_MAG_ST2,
+	};
+
+	// check data ready
+	bool mag_ok = raw[IDX_MAG_ST1] & PIOS_MPU_AK89XX_ST1_DRDY;
+	// check for overflow
+	mag_ok &= !(raw[IDX_MAG_ST2] & PIOS_MPU_AK89XX_ST2_HOFL);
+	// check for data error on mpu-9150
+	mag_ok &= (mpu_dev->mpu_type != PIOS_MPU9150 || !(raw[IDX_MAG_ST2] & PIOS_MPU_AK8975_ST2_DERR));
+	if (!mag_ok)
+		return;
+
+	struct pios_sensor_mag_data mag_data;
+
+	float mag_x = (int16_t)(raw[IDX_MAG_XOUT_H] << 8 | raw[IDX_MAG_XOUT_L]);
+	float mag_y = (int16_t)(raw[IDX_MAG_YOUT_H] << 8 | raw[IDX_MAG_YOUT_L]);
+	float mag_z = (int16_t)(raw[IDX_MAG_ZOUT_H] << 8 | raw[IDX_MAG_ZOUT_L]);
+
+	// Magnetometer corresponds our convention.
+	switch (mpu_dev->cfg->orientation) {
+	case PIOS_MPU_TOP_0DEG:
+		mag_data.x   =  mag_x;
+		mag_data.y   =  mag_y;
+		mag_data.z   =  mag_z;
+		break;
+	case PIOS_MPU_TOP_90DEG:
+		mag_data.x   = -mag_y;
+		mag_data.y   =  mag_x;
+		mag_data.z   =  mag_z;
+		break;
+	case PIOS_MPU_TOP_180DEG:
+		mag_data.x   = -mag_x;
+		mag_data.y   = -mag_y;
+		mag_data.z   =  mag_z;
+		break;
+	case PIOS_MPU_TOP_270DEG:
+		mag_data.x   =  mag_y;
+		mag_data.y   = -mag_x;
+		mag_data.z   =  mag_z;
+		break;
+	case PIOS_MPU_BOTTOM_0DEG:
+		mag_data.x   =  mag_x;
+		mag_data.y   = -mag_y;
+		mag_data.z   = -mag_z;
+		break;
+	case PIOS_MPU_BOTTOM_90DEG:
+		mag_data.x   = -mag_y;
+		mag_data.y   = -mag_x;
+		mag_data.z   = -mag_z;
+		break;
+	case PIOS_MPU_BOTTOM_180DEG:
+		mag_data.x   = -mag_x;
+		mag_data.y   =  mag_y;
+		mag_data.z   = -mag_z;
+		break;
+	case PIOS_MPU_BOTTOM_270DEG:
+		mag_data.x   =  mag_y;
+		mag_data.y   =  mag_x;
+		mag_data.z   = -mag_z;
+		break;
+	}
+
+	float mag_scale;
+	if (mpu_dev->mpu_type == PIOS_MPU9150)
+		mag_scale = 3.0f; // 12-bit sampling
+	else if (raw[IDX_MAG_ST2] & PIOS_MPU_AK8963_ST2_BITM)
+		mag_scale = 1.5f; // 16-bit sampling
+	else
+		mag_scale = 6.0f; // 14-bit sampling
+	mag_data.x *= mag_scale;
+	mag_data.y *= mag_scale;
+	mag_data.z *= mag_scale;
+	PIOS_Queue_Send(mpu_dev->mag_queue, &mag_data, 0);
+
+	// trigger another sample
+	if (mpu_dev->mpu_type == PIOS_MPU9150)
+		PIOS_MPU_Mag_WriteReg(PIOS_MPU_AK89XX_CNTL1_REG, PIOS_MPU_AK8975_MODE_SINGLE_12B);
+}
+#endif // PIOS_INCLUDE_MPU_MAG
+
+static void PIOS_MPU_Task(void *parameters)
+{
+	(void)parameters;
+
+	enum {
+		IDX_SPI_DUMMY_BYTE = 0,
+		IDX_SAMPLE,
+#ifdef PIOS_INCLUDE_MPU_MAG
+		IDX_MAG = IDX_SAMPLE + PIOS_MPU_FIFO_FRAME_LEN,
+		BUFFER_SIZE = IDX_MAG + 8
+#else
+		BUFFER_SIZE = IDX_SAMPLE + PIOS_MPU_FIFO_FRAME_LEN
 #endif // PIOS_INCLUDE_MPU_MAG
-		BUFFER_SIZE
 	};
 
 	uint8_t mpu_rec_buf[BUFFER_SIZE];
 
 #ifdef PIOS_INCLUDE_MPU_MAG
 	uint8_t transfer_size = (mpu_dev->use_mag) ? BUFFER_SIZE : BUFFER_SIZE - 8;
-#ifdef PIOS_INCLUDE_SPI
-	uint8_t mpu_tx_buf[BUFFER_SIZE] = {PIOS_MPU_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0,
-			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-#endif // PIOS_INCLUDE_SPI
 #else
 	uint8_t transfer_size = BUFFER_SIZE;
+#endif // PIOS_INCLUDE_MPU_MAG
 #ifdef PIOS_INCLUDE_SPI
-	uint8_t mpu_tx_buf[BUFFER_SIZE] = {PIOS_MPU_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0,
-			0, 0, 0, 0, 0, 0, 0, 0, 0};
+	uint8_t mpu_tx_buf[BUFFER_SIZE] = {PIOS_MPU_ACCEL_X_OUT_MSB | 0x80};
 #endif // PIOS_INCLUDE_SPI
-#endif // PIOS_INCLUDE_MPU_MAG
 
 	if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C)
 		transfer_size -= 1;
@@ -966,195 +1255,143 @@ static void PIOS_MPU_Task(void *parameters)
 #if defined(PIOS_INCLUDE_I2C)
 		if (mpu_dev->com_driver_type == PIOS_MPU_COM_I2C) {
 			// we skip the SPI dummy byte at the beginning of the buffer here
-			if (PIOS_MPU_I2C_Read(PIOS_MPU_ACCEL_X_OUT_MSB, &mpu_rec_buf[IDX_ACCEL_XOUT_H], transfer_size) < 0)
+			if (PIOS_MPU_I2C_Read(PIOS_MPU_ACCEL_X_OUT_MSB, &mpu_rec_buf[IDX_SAMPLE], transfer_size) < 0)
 				continue;
 		}
 #endif // defined(PIOS_INCLUDE_I2C)
 
-		struct pios_sensor_accel_data accel_data;
-		struct pios_sensor_gyro_data gyro_data;
-
-		float accel_x = (int16_t)(mpu_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_XOUT_L]);
-		float accel_y = (int16_t)(mpu_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_YOUT_L]);
-		float accel_z = (int16_t)(mpu_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu_rec_buf[IDX_ACCEL_ZOUT_L]);
-		float gyro_x  = (int16_t)(mpu_rec_buf[IDX_GYRO_XOUT_H]  << 8 | mpu_rec_buf[IDX_GYRO_XOUT_L]);
-		float gyro_y  = (int16_t)(mpu_rec_buf[IDX_GYRO_YOUT_H]  << 8 | mpu_rec_buf[IDX_GYRO_YOUT_L]);
-		float gyro_z  = (int16_t)(mpu_rec_buf[IDX_GYRO_ZOUT_H]  << 8 | mpu_rec_buf[IDX_GYRO_ZOUT_L]);
+		PIOS_MPU_PushSample(&mpu_rec_buf[IDX_SAMPLE]);
 
 #ifdef PIOS_INCLUDE_MPU_MAG
-		struct pios_sensor_mag_data mag_data;
-
-		float mag_x = (int16_t)(mpu_rec_buf[IDX_MAG_XOUT_H] << 8 | mpu_rec_buf[IDX_MAG_XOUT_L]);
-		float mag_y = (int16_t)(mpu_rec_buf[IDX_MAG_YOUT_H] << 8 | mpu_rec_buf[IDX_MAG_YOUT_L]);
-		float mag_z = (int16_t)(mpu_rec_buf[IDX_MAG_ZOUT_H] << 8 | mpu_rec_buf[IDX_MAG_ZOUT_L]);
+		if (mpu_dev->use_mag)
+			PIOS_MPU_PushMag(&mpu_rec_buf[IDX_MAG]);
 #endif // PIOS_INCLUDE_MPU_MAG
+	}
+}
 
-		// Rotate the sensor to our convention.  The datasheet defines X as towards the right
-		// and Y as forward. Our convention transposes this.  Also the Z is defined negatively
-		// to our convention. This is true for accels and gyros. Magnetometer corresponds our convention.
-		switch (mpu_dev->cfg->orientation) {
-		case PIOS_MPU_TOP_0DEG:
-			accel_data.y =  accel_x;
-			accel_data.x =  accel_y;
-			accel_data.z = -accel_z;
-			gyro_data.y  =  gyro_x;
-			gyro_data.x  =  gyro_y;
-			gyro_data.z  = -gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   =  mag_x;
-			mag_data.y   =  mag_y;
-			mag_data.z   =  mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
-		case PIOS_MPU_TOP_90DEG:
-			accel_data.y = -accel_y;
-			accel_data.x =  accel_x;
-			accel_data.z = -accel_z;
-			gyro_data.y  = -gyro_y;
-			gyro_data.x  =  gyro_x;
-			gyro_data.z  = -gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   = -mag_y;
-			mag_data.y   =  mag_x;
-			mag_data.z   =  mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
-		case PIOS_MPU_TOP_180DEG:
-			accel_data.y = -accel_x;
-			accel_data.x = -accel_y;
-			accel_data.z = -accel_z;
-			gyro_data.y  = -gyro_x;
-			gyro_data.x  = -gyro_y;
-			gyro_data.z  = -gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   = -mag_x;
-			mag_data.y   = -mag_y;
-			mag_data.z   =  mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
-		case PIOS_MPU_TOP_270DEG:
-			accel_data.y =  accel_y;
-			accel_data.x = -accel_x;
-			accel_data.z = -accel_z;
-			gyro_data.y  =  gyro_y;
-			gyro_data.x  = -gyro_x;
-			gyro_data.z  = -gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   =  mag_y;
-			mag_data.y   = -mag_x;
-			mag_data.z   =  mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
-		case PIOS_MPU_BOTTOM_0DEG:
-			accel_data.y = -accel_x;
-			accel_data.x =  accel_y;
-			accel_data.z =  accel_z;
-			gyro_data.y  = -gyro_x;
-			gyro_data.x  =  gyro_y;
-			gyro_data.z  =  gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   =  mag_x;
-			mag_data.y   = -mag_y;
-			mag_data.z   = -mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
+/**
+ * @brief Empty the FIFO and start filling it again
+ * @return 0 if successful
+ */
+static int32_t PIOS_MPU_FIFO_Reset(void)
+{
+	// The reset bit only takes effect with the FIFO disabled
+	if (PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, mpu_dev->user_ctrl | PIOS_MPU_USERCTL_FIFO_RST) != 0)
+		return -1;
 
-		case PIOS_MPU_BOTTOM_90DEG:
-			accel_data.y =  accel_y;
-			accel_data.x =  accel_x;
-			accel_data.z =  accel_z;
-			gyro_data.y  =  gyro_y;
-			gyro_data.x  =  gyro_x;
-			gyro_data.z  =  gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   = -mag_y;
-			mag_data.y   = -mag_x;
-			mag_data.z   = -mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
+	return PIOS_MPU_WriteReg(PIOS_MPU_USER_CTRL_REG, mpu_dev->user_ctrl | PIOS_MPU_USERCTL_FIFO_EN);
+}
 
-		case PIOS_MPU_BOTTOM_180DEG:
-			accel_data.y =  accel_x;
-			accel_data.x = -accel_y;
-			accel_data.z =  accel_z;
-			gyro_data.y  =  gyro_x;
-			gyro_data.x  = -gyro_y;
-			gyro_data.z  =  gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   = -mag_x;
-			mag_data.y   =  mag_y;
-			mag_data.z   = -mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
+/**
+ * @brief Task for FIFO mode.  Rather than waking for every sample, wake
+ * once per burst and drain everything the MPU has queued up in one transfer.
+ *
+ * The samples are timestamped from the sample rate: each is one period
+ * after the one before it, kept within a period of the time the FIFO was
+ * read so the two clocks can't drift apart.
+ */
+static void PIOS_MPU_FIFO_Task(void *parameters)
+{
+	(void)parameters;
 
-		case PIOS_MPU_BOTTOM_270DEG:
-			accel_data.y = -accel_y;
-			accel_data.x = -accel_x;
-			accel_data.z =  accel_z;
-			gyro_data.y  = -gyro_y;
-			gyro_data.x  = -gyro_x;
-			gyro_data.z  =  gyro_z;
-#ifdef PIOS_INCLUDE_MPU_MAG
-			mag_data.x   =  mag_y;
-			mag_data.y   =  mag_x;
-			mag_data.z   = -mag_z;
-#endif // PIOS_INCLUDE_MPU_MAG
-			break;
+	struct pios_mpu_fifo_stats *stats = &mpu_dev->fifo_stats;
+	uint32_t period_us = mpu_dev->sample_period_us;
+
+	uint32_t burst_ms = mpu_dev->fifo_burst * period_us / 1000;
+	if (burst_ms < 1)
+		burst_ms = 1;
+
+	// Start from an empty FIFO now rather than whatever built up since
+	// it was configured
+	PIOS_MPU_FIFO_Reset();
+	stats->last_sample_us = PIOS_DELAY_GetuS();
+
+	uint32_t wake_ms = PIOS_Thread_Systime();
+
+	while (true) {
+		PIOS_Thread_Sleep_Until(&wake_ms, burst_ms);
+
+		uint8_t status;
+		uint8_t count_buf[2];
+
+		if (PIOS_MPU_ReadBlock(PIOS_MPU_INT_STATUS_REG, &status, sizeof(status)) != 0)
+			continue;
+
+		if (PIOS_MPU_ReadBlock(PIOS_MPU_FIFO_CNT_MSB, count_buf, sizeof(count_buf)) != 0)
+			continue;
+
+		uint32_t now_us = PIOS_DELAY_GetuS();
+		uint16_t count = count_buf[0] << 8 | count_buf[1];
+
+		// An overflow overwrites the oldest bytes, after which frames no
+		// longer start where we expect.  A nearly full FIFO could overflow
+		// while it's being read, so don't trust that either.
+		if ((status & PIOS_MPU_INT_STATUS_OVERFLOW) ||
+				(count % PIOS_MPU_FIFO_FRAME_LEN) != 0 ||
+				count > PIOS_MPU_FIFO_SIZE - 2 * PIOS_MPU_FIFO_FRAME_LEN) {
+			PIOS_MPU_FIFO_Reset();
+
+			stats->overflows++;
+			stats->dropped += (now_us - stats->last_sample_us) / period_us;
+			stats->last_sample_us = now_us;
+			continue;
 		}
 
-		int16_t raw_temp = (int16_t)(mpu_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu_rec_buf[IDX_TEMP_OUT_L]);
-		float temperature;
-		if (mpu_dev->mpu_type == PIOS_MPU6500 || mpu_dev->mpu_type == PIOS_MPU9250)
-			temperature = 21.0f + ((float)raw_temp) / 333.87f;
-		else
-			temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
+		uint16_t queued = count / PIOS_MPU_FIFO_FRAME_LEN;
+		uint16_t frames = queued;
+
+		// Anything beyond one read waits for the next burst
+		if (frames > 2 * mpu_dev->fifo_burst)
+			frames = 2 * mpu_dev->fifo_burst;
 
-		// Apply sensor scaling
-		float accel_scale = PIOS_MPU_GetAccelScale();
-		accel_data.x *= accel_scale;
-		accel_data.y *= accel_scale;
-		accel_data.z *= accel_scale;
-		accel_data.temperature = temperature;
+		if (frames == 0)
+			continue;
+
+		if (PIOS_MPU_ReadBlock(PIOS_MPU_FIFO_REG, mpu_dev->fifo_buf, frames * PIOS_MPU_FIFO_FRAME_LEN) != 0) {
+			// No telling how much was consumed
+			PIOS_MPU_FIFO_Reset();
+
+			stats->overflows++;
+			stats->dropped += (now_us - stats->last_sample_us) / period_us;
+			stats->last_sample_us = now_us;
+			continue;
+		}
 
-		float gyro_scale = PIOS_MPU_GetGyroScale();
-		gyro_data.x *= gyro_scale;
-		gyro_data.y *= gyro_scale;
-		gyro_data.z *= gyro_scale;
-		gyro_data.temperature = temperature;
+		uint32_t newest_us = stats->last_sample_us + queued * period_us;
 
-		PIOS_Queue_Send(mpu_dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(mpu_dev->gyro_queue, &gyro_data, 0);
+		if ((int32_t)(newest_us - now_us) > 0)
+			newest_us = now_us;
+		else if (now_us - newest_us > period_us)
+			newest_us = now_us - period_us;
+
+		for (uint16_t i = 0; i < frames; i++)
+			PIOS_MPU_PushSample(&mpu_dev->fifo_buf[i * PIOS_MPU_FIFO_FRAME_LEN]);
+
+		stats->last_sample_us = newest_us - (queued - frames) * period_us;
+		stats->samples += frames;
+		stats->bursts++;
 
 #ifdef PIOS_INCLUDE_MPU_MAG
 		if (mpu_dev->use_mag) {
-			// check data ready
-			bool mag_ok = mpu_rec_buf[IDX_MAG_ST1] & PIOS_MPU_AK89XX_ST1_DRDY;
-			// check for overflow
-			mag_ok &= !(mpu_rec_buf[IDX_MAG_ST2] & PIOS_MPU_AK89XX_ST2_HOFL);
-			// check for data error on mpu-9150
-			mag_ok &= (mpu_dev->mpu_type != PIOS_MPU9150 || !(mpu_rec_buf[IDX_MAG_ST2] & PIOS_MPU_AK8975_ST2_DERR));
-			if (mag_ok) {
-				float mag_scale;
-				if (mpu_dev->mpu_type == PIOS_MPU9150)
-					mag_scale = 3.0f; // 12-bit sampling
-				else if (mpu_rec_buf[IDX_MAG_ST2] & PIOS_MPU_AK8963_ST2_BITM)
-					mag_scale = 1.5f; // 16-bit sampling
-				else
-					mag_scale = 6.0f; // 14-bit sampling
-				mag_data.x *= mag_scale;
-				mag_data.y *= mag_scale;
-				mag_data.z *= mag_scale;
-				PIOS_Queue_Send(mpu_dev->mag_queue, &mag_data, 0);
-
-				// trigger another sample
-				if (mpu_dev->mpu_type == PIOS_MPU9150)
-					PIOS_MPU_Mag_WriteReg(PIOS_MPU_AK89XX_CNTL1_REG, PIOS_MPU_AK8975_MODE_SINGLE_12B);
-			}
+			uint8_t mag_buf[8];
+
+			if (PIOS_MPU_ReadBlock(PIOS_MPU_EXT_SENS_DATA_00, mag_buf, sizeof(mag_buf)) == 0)
+				PIOS_MPU_PushMag(mag_buf);
 		}
 #endif // PIOS_INCLUDE_MPU_MAG
 	}
 }
 
+void PIOS_MPU_GetFIFOStats(struct pios_mpu_fifo_stats *stats)
+{
+	if (PIOS_MPU_Validate(mpu_dev) != 0) {
+		*stats = (struct pios_mpu_fifo_stats) { 0 };
+		return;
+	}
+
+	*stats = mpu_dev->fifo_stats;
+}
+
 #endif // PIOS_INCLUDE_MPU
 
 /**
@@ -95,7 +95,7 @@
 #include <pios_spi_priv.h>
 #include <pios_rfm22b_priv.h>
 #include <pios_rfm22b_rcvr_priv.h>
-#include <ecc.h>
+#include <reedsolomon.h>
 
 /* Local Defines */
 #define STACK_SIZE_BYTES                 800
@@ -242,6 +242,9 @@ static void rfm22_write(struct pios_rfm22b_dev *rfm22b_dev, uint8_t addr,
 static uint8_t rfm22_read(struct pios_rfm22b_dev *rfm22b_dev,
 			  uint8_t addr);
 
+/* Reed-Solomon codec shared by the transmit and receive paths */
+static struct rs_codec rfm22b_rs;
+
 /* The state transition table */
 static const struct pios_rfm22b_transition
     rfm22b_transitions[RADIO_STATE_NUM_STATES] = {
@@ -504,7 +507,7 @@ int32_t PIOS_RFM22B_Init(uint32_t * rfm22b_id, uint32_t spi_id,
 #endif /* PIOS_WDG_RFM22B */
 
 	// Initialize the ECC library.
-	initialize_ecc();
+	rs_init(&rfm22b_rs, RS_ECC_NPARITY);
 
 	// Set the state to initializing.
 	rfm22b_dev->state = RADIO_STATE_UNINITIALIZED;
@@ -1886,7 +1889,7 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev
 	// Add the error correcting code.
 	if (!radio_dev->ppm_only_mode) {
 		if (len != 0) {
-			encode_data((unsigned char *)p, len, (unsigned char *)p);
+			rs_encode(&rfm22b_rs, p, len, p + len);
 		} else {
 			for (uint32_t i = 0; i < RS_ECC_NPARITY; i++)
 				p[i] = EMPTY_PACKET + i;
@@ -1972,15 +1975,10 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 
 		// Attempt to correct any errors in the packet.
 		if (data_len > 0) {
-			decode_data((unsigned char *)p, rx_len);
-			good_packet = check_syndrome() == 0;
-
-			// We have an error.  Try to correct it.
-			if (!good_packet &&
-			    (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
-				// We corrected it
-				corrected_packet = true;
-			}
+			int corrected = rs_decode(&rfm22b_rs, p, rx_len);
+
+			good_packet = corrected == 0;
+			corrected_packet = corrected > 0;
 		} else {
 			// Empty packets have specific code for ECC
 			empty_packet = true;
@@ -29,6 +29,7 @@
 #include "pios.h"
 
 #include "pios_flash.h"		     /* PIOS_FLASH_* */
+#include "pios_streamfs.h"      /* PIOS_STREAMFS_* */
 #include "pios_streamfs_priv.h" /* Internal API */
 #include "pios_mutex.h"
 #include "pios_semaphore.h"
@@ -36,6 +37,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memset */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
@@ -51,6 +53,17 @@
  * sector has a footer to indicate the file id and the sector id.
  *
  * Arenas map onto sectors. 
+ *
+ * Data from the COM buffer is collected into a pair of write_size page
+ * buffers.  While the task programs one, the other keeps filling; the
+ * sender moves data into it directly, so a slow program or erase doesn't
+ * leave everything sitting in the COM buffer.  The arena after the active
+ * one is erased while the task has nothing else to do, rather than when
+ * the write pointer reaches it.
+ *
+ * What each footer says is read once at init into a table in RAM, and the
+ * table is kept up to date as footers are written and arenas erased.
+ * Finding a file never has to go back to the flash.
  */
 
 #include <pios_com.h>
@@ -58,6 +71,14 @@
 #define PIOS_STREAMFS_TASK_PRIORITY    PIOS_THREAD_PRIO_LOW
 #define PIOS_STREAMFS_TASK_STACK_BYTES 1000
 
+/* Erase the next arena once this fraction of the active one is written.
+ * Any later risks stalling; any earlier eats into old logs for nothing
+ * when the file is short. */
+#define PIOS_STREAMFS_ERASE_AHEAD_DIV  2
+
+/* Pages close writes out at most; more than any COM buffer holds */
+#define PIOS_STREAMFS_CLOSE_FLUSH_PAGES 16
+
 /* Provide a COM driver */
 static void PIOS_STREAMFS_RegisterTxCallback(uintptr_t fs_id, pios_com_callback tx_out_cb, uintptr_t context);
 static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail);
@@ -75,6 +96,20 @@ enum pios_flashfs_streamfs_dev_magic {
 	PIOS_FLASHFS_STREAMFS_DEV_MAGIC = 0x93A40F82,
 };
 
+enum streamfs_arena_state {
+	STREAMFS_ARENA_ERASED,		/* footer is blank */
+	STREAMFS_ARENA_USED,		/* footer for one of our files */
+	STREAMFS_ARENA_FOREIGN,		/* anything else; erase before use */
+};
+
+/* The contents of an arena's footer */
+struct streamfs_arena {
+	uint32_t file_id;
+	uint32_t written_bytes;
+	uint16_t file_segment;
+	uint8_t state;
+};
+
 struct streamfs_state {
 	enum pios_flashfs_streamfs_dev_magic magic;
 	const struct streamfs_cfg *cfg;
@@ -88,7 +123,17 @@ struct streamfs_state {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
-	uint8_t *com_buffer;
+
+	/* Page buffers.  page_mutex covers these and the stats, and is the
+	 * only lock the sending side takes (and never waits for).  The page
+	 * that isn't filling is either empty or ready to be programmed. */
+	struct pios_mutex *page_mutex;
+	uint8_t *page_buffer[2];
+	uint16_t page_len[2];
+	bool page_ready[2];
+	uint32_t page_ready_time[2];
+	uint8_t fill_page;
+	bool flushing;
 
 	/* Information for current file handle */
 	bool file_open_writing;
@@ -98,9 +143,16 @@ struct streamfs_state {
 	int32_t active_file_arena;
 	int32_t active_file_arena_offset;
 
+	/* Arena already erased ahead of the write pointer, or -1 */
+	int32_t erased_arena;
+
+	struct pios_streamfs_stats stats;
+	uint64_t write_latency_total_us;
+
 	/* Information about file system contents */
 	int32_t min_file_id;
 	int32_t max_file_id;
+	struct streamfs_arena *arenas;
 
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
@@ -141,7 +193,7 @@ struct streamfs_footer {
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint32_t arena_id)
+static int32_t streamfs_erase_arena(struct streamfs_state *streamfs, uint32_t arena_id)
 {
 	uintptr_t arena_addr = streamfs_get_addr(streamfs, arena_id, 0);
 
@@ -151,6 +203,8 @@ static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint3
 	}
 
 	/* Arena is ready to be written to */
+	streamfs->arenas[arena_id].state = STREAMFS_ARENA_ERASED;
+
 	return 0;
 }
 
@@ -159,7 +213,7 @@ static int32_t streamfs_erase_arena(const struct streamfs_state *streamfs, uint3
  * @return 0 if success, < 0 on failure
  * @note Must be called while holding the flash transaction lock
  */
-static int32_t streamfs_erase_all_arenas(const struct streamfs_state *streamfs)
+static int32_t streamfs_erase_all_arenas(struct streamfs_state *streamfs)
 {
 	uint32_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 
@@ -171,6 +225,56 @@ static int32_t streamfs_erase_all_arenas(const struct streamfs_state *streamfs)
 	return 0;
 }
 
+/**
+ * @brief Record what the footer of an arena says
+ */
+static void streamfs_set_arena(struct streamfs_state *streamfs, uint32_t arena_id,
+		const struct streamfs_footer *footer)
+{
+	struct streamfs_arena *arena = &streamfs->arenas[arena_id];
+	const uint8_t *raw = (const uint8_t *) footer;
+
+	arena->state = STREAMFS_ARENA_ERASED;
+
+	for (int i = 0; i < sizeof(*footer); i++) {
+		if (raw[i] != 0xFF) {
+			arena->state = STREAMFS_ARENA_FOREIGN;
+			break;
+		}
+	}
+
+	if (footer->magic == streamfs->cfg->fs_magic &&
+			footer->written_bytes <= streamfs->cfg->arena_size - sizeof(*footer)) {
+		arena->state = STREAMFS_ARENA_USED;
+	}
+
+	arena->file_id = footer->file_id;
+	arena->written_bytes = footer->written_bytes;
+	arena->file_segment = footer->file_segment;
+}
+
+/**
+ * @brief Read the footer of every arena into the arena table
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_load_arenas(struct streamfs_state *streamfs)
+{
+	for (uint32_t arena = 0; arena < streamfs->partition_arenas; arena++) {
+		struct streamfs_footer footer;
+		uint32_t start_address = streamfs_get_addr(streamfs, arena,
+				streamfs->cfg->arena_size - sizeof(footer));
+
+		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+			return -1;
+		}
+
+		streamfs_set_arena(streamfs, arena, &footer);
+	}
+
+	return 0;
+}
+
 static bool streamfs_validate(const struct streamfs_state *streamfs)
 {
 	return (streamfs && (streamfs->magic == PIOS_FLASHFS_STREAMFS_DEV_MAGIC));
@@ -183,16 +287,18 @@ static struct streamfs_state *streamfs_alloc(void)
 	streamfs = (struct streamfs_state *)PIOS_malloc_no_dma(sizeof(*streamfs));
 	if (!streamfs) return (NULL);
 
+	/* The task can run before the COM layer binds its callback */
+	memset(streamfs, 0, sizeof(*streamfs));
+
 	streamfs->magic = PIOS_FLASHFS_STREAMFS_DEV_MAGIC;
 	return(streamfs);
 }
 
 /**
- * Write footer to current sector and reset pointers for writing to
- * next sector
+ * Close this sector by writing footer. Does not prepare next sector.
  */
-/* NOTE: Must be called while holding the flash transaction lock */ 
-static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
+/* NOTE: Must be called while holding the flash transaction lock */
+static int32_t streamfs_close_sector(struct streamfs_state *streamfs)
 {
 	struct streamfs_footer footer;
 	footer.magic = streamfs->cfg->fs_magic;
@@ -207,82 +313,101 @@ static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
 		return -1;
 	}
 
+	streamfs_set_arena(streamfs, streamfs->active_file_arena, &footer);
+
+	return 0;
+}
+
+/**
+ * Write footer to current sector and reset pointers for writing to
+ * next sector
+ */
+/* NOTE: Must be called while holding the flash transaction lock */ 
+static int32_t streamfs_new_sector(struct streamfs_state *streamfs)
+{
+	if (streamfs_close_sector(streamfs) != 0) {
+		return -1;
+	}
+
 	// Reset pointers for writing to next sector
 	streamfs->active_file_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
 	streamfs->active_file_arena_offset = 0;
 	streamfs->active_file_segment++;
 
-	// Test whether the sector has already been erased by checking the footer
-	start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                          streamfs->cfg->arena_size - sizeof(footer));
-	if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-		return -2;
+	if (streamfs->active_file_arena == streamfs->erased_arena) {
+		streamfs->erased_arena = -1;
+		return 0;
 	}
 
-	for (int i=0; i < sizeof(footer); i++) {
-		if (((uint8_t*)&footer)[i] != 0xFF) {
-			if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
-				return -3;
-			}
-			break;
+	// Erase unless the footer says the sector already is
+	if (streamfs->arenas[streamfs->active_file_arena].state != STREAMFS_ARENA_ERASED) {
+		if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
+			return -3;
 		}
+		streamfs->stats.erases_inline++;
 	}
 
 	return 0;
 }
 
 /**
- * Close this sector by writing footer. Does not prepare next sector.
+ * Whether the arena after the active one still needs erasing, and the
+ * active one is far enough along that it's time to do it
  */
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t streamfs_close_sector(struct streamfs_state *streamfs)
+static bool streamfs_erase_ahead_due(const struct streamfs_state *streamfs)
 {
-	struct streamfs_footer footer;
-	footer.magic = streamfs->cfg->fs_magic;
-	footer.written_bytes = streamfs->active_file_arena_offset;
-	footer.file_id = streamfs->active_file_id;
-	footer.file_segment = streamfs->active_file_segment;
+	if (!streamfs->file_open_writing) {
+		return false;
+	}
 
-	uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-			                                   streamfs->cfg->arena_size - sizeof(footer));
+	int32_t next_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
 
-	if (PIOS_FLASH_write_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
+	if (streamfs->erased_arena == next_arena) {
+		return false;
+	}
+
+	return streamfs->active_file_arena_offset >=
+		streamfs->cfg->arena_size / PIOS_STREAMFS_ERASE_AHEAD_DIV;
+}
+
+/**
+ * Erase the arena after the active one, so moving into it doesn't stall
+ * @return 0 if success, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_erase_ahead(struct streamfs_state *streamfs)
+{
+	uint32_t next_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
+
+	if (streamfs_erase_arena(streamfs, next_arena) != 0) {
 		return -1;
 	}
 
+	streamfs->erased_arena = next_arena;
+	streamfs->stats.erases_ahead++;
+
 	return 0;
 }
 
-
 /**
  * Find the first arena for a file
  * @param[in] streamfs the file system handle
  * @param[in] file_id the file to find
  * @return the sector number if found, or negative if there was an error
- *
- * @NOTE: Must be called while holding the flash transaction lock
  */
 static int32_t streamfs_find_first_arena(struct streamfs_state *streamfs, int32_t file_id)
 {
-	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
-
 	bool found_file = false;
 	uint32_t min_segment = 0xFFFFFFFF;
 	uint32_t sector = 0xFFFFFFFF;
 
-	for (uint16_t arena = 0; arena < num_arenas; arena++) {
-		// Read footer for each arena
-		struct streamfs_footer footer;
-		uint32_t start_address = streamfs_get_addr(streamfs, arena,
-				                                   streamfs->cfg->arena_size - sizeof(footer));
-		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -1;
-		}
+	for (uint32_t arena = 0; arena < streamfs->partition_arenas; arena++) {
+		const struct streamfs_arena *info = &streamfs->arenas[arena];
 
-		if (footer.magic == streamfs->cfg->fs_magic && footer.file_id == file_id) {
+		if (info->state == STREAMFS_ARENA_USED && info->file_id == file_id) {
 			found_file = true;
-			if (footer.file_segment < min_segment) {
-				min_segment = footer.file_segment;
+			if (info->file_segment < min_segment) {
+				min_segment = info->file_segment;
 				sector = arena;
 			}
 		}
@@ -300,30 +425,20 @@ static int32_t streamfs_find_first_arena(struct streamfs_state *streamfs, int32_
  * @param[in] streamfs the file system handle
  * @param[in] file_id the file to find
  * @return the sector number if found, or negative if there was an error
- *
- * @NOTE: Must be called while holding the flash transaction lock
  */
 static int32_t streamfs_find_last_arena(struct streamfs_state *streamfs, int32_t file_id)
 {
-	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
-
 	bool found_file = false;
 	int32_t max_segment = -1;
 	uint32_t sector = 0;
 
-	for (uint16_t arena = 0; arena < num_arenas; arena++) {
-		// Read footer for each arena
-		struct streamfs_footer footer;
-		uint32_t start_address = streamfs_get_addr(streamfs, arena,
-				                                   streamfs->cfg->arena_size - sizeof(footer));
-		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -3;
-		}
+	for (uint32_t arena = 0; arena < streamfs->partition_arenas; arena++) {
+		const struct streamfs_arena *info = &streamfs->arenas[arena];
 
-		if (footer.magic == streamfs->cfg->fs_magic && footer.file_id == file_id) {
+		if (info->state == STREAMFS_ARENA_USED && info->file_id == file_id) {
 			found_file = true;
-			if (footer.file_segment > max_segment) {
-				max_segment = footer.file_segment;
+			if (info->file_segment > max_segment) {
+				max_segment = info->file_segment;
 				sector = arena;
 			}
 		}
@@ -353,8 +468,7 @@ static int32_t streamfs_find_new_sector(struct streamfs_state *streamfs)
 	int32_t last_sector = streamfs_find_last_arena(streamfs, streamfs->max_file_id);
 	PIOS_Assert(last_sector >= 0);
 
-	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
-	return (last_sector + 1) % num_arenas;
+	return (last_sector + 1) % streamfs->partition_arenas;
 }
 
 /* NOTE: Must be called while holding the flash transaction lock */
@@ -409,33 +523,23 @@ static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t
 		return -2;
 
 	uint32_t total_read_len = 0;
-	int32_t current_segment = 0;
 	while (len > 0) {
-		struct streamfs_footer footer;
-		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
-				                                   streamfs->cfg->arena_size - sizeof(footer));
-
-		PIOS_Assert(start_address < streamfs->partition_size);
-		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -3;
-		}
-
-		// Return error if at the end of the file
-		if (footer.magic != streamfs->cfg->fs_magic && footer.file_id != streamfs->active_file_id) {
-			return total_read_len;
-		}
+		const struct streamfs_arena *arena = &streamfs->arenas[streamfs->active_file_arena];
 
-		// Detected wrap around of file
-		if (footer.file_segment < current_segment) {
+		// End of the file, or the rest of it was overwritten as the
+		// buffer wrapped around
+		if (arena->state != STREAMFS_ARENA_USED ||
+				arena->file_id != streamfs->active_file_id ||
+				arena->file_segment != (uint16_t) streamfs->active_file_segment) {
 			return total_read_len;
 		}
 
 		// End of file
-		if (streamfs->active_file_arena_offset == footer.written_bytes) {
+		if (streamfs->active_file_arena_offset == arena->written_bytes) {
 			return total_read_len;
 		}
 
-		start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
+		uint32_t start_address = streamfs_get_addr(streamfs, streamfs->active_file_arena,
 			                                        streamfs->active_file_arena_offset);
 
 		// Read either remaining bytes or until the footer
@@ -445,8 +549,8 @@ static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t
 		}
 
 		// Do not read more than valid bytes
-		if ((streamfs->active_file_arena_offset + bytes_to_read) > footer.written_bytes) {
-			bytes_to_read = footer.written_bytes - streamfs->active_file_arena_offset;
+		if ((streamfs->active_file_arena_offset + bytes_to_read) > arena->written_bytes) {
+			bytes_to_read = arena->written_bytes - streamfs->active_file_arena_offset;
 		}
 
 		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, data, bytes_to_read) != 0) {
@@ -461,16 +565,15 @@ static int32_t streamfs_read_from_file(struct streamfs_state *streamfs, uint8_t
 		streamfs->active_file_arena_offset += bytes_to_read;
 		PIOS_Assert(streamfs->active_file_arena_offset <= (streamfs->cfg->arena_size - sizeof(struct streamfs_footer)));
 		if (streamfs->active_file_arena_offset == streamfs->cfg->arena_size - sizeof(struct streamfs_footer)) {
-			uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
-			streamfs->active_file_arena = (streamfs->active_file_arena + 1) % num_arenas;
+			streamfs->active_file_arena = (streamfs->active_file_arena + 1) % streamfs->partition_arenas;
 			streamfs->active_file_arena_offset = 0;
+			streamfs->active_file_segment++;
 		}
 	}
 
 	return total_read_len;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
 static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 {
 	// Don't try and read while actively writing
@@ -479,27 +582,22 @@ static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 	if (streamfs->file_open_reading)
 		return -2;
 
-	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 	streamfs->min_file_id = -1;
 	streamfs->max_file_id = 0;
 
 	bool found_file = false;
 
-	for (uint16_t arena = 0; arena < num_arenas; arena++) {
-		// Read footer for each arena
-		struct streamfs_footer footer;
-		uint32_t start_address = streamfs_get_addr(streamfs, arena,
-				                                   streamfs->cfg->arena_size - sizeof(footer));
-		if (PIOS_FLASH_read_data(streamfs->partition_id, start_address, (uint8_t *) &footer, sizeof(footer)) != 0) {
-			return -3;
-		}
+	for (uint32_t arena = 0; arena < streamfs->partition_arenas; arena++) {
+		const struct streamfs_arena *info = &streamfs->arenas[arena];
+
+		if (info->state == STREAMFS_ARENA_USED) {
+			int32_t file_id = info->file_id;
 
-		if (footer.magic == streamfs->cfg->fs_magic) {
+			if (!found_file || file_id < streamfs->min_file_id)
+				streamfs->min_file_id = file_id;
+			if (file_id > streamfs->max_file_id)
+				streamfs->max_file_id = file_id;
 			found_file = true;
-			if (footer.file_id < streamfs->min_file_id)
-				streamfs->min_file_id = footer.file_id;
-			if (footer.file_id > streamfs->max_file_id)
-				streamfs->max_file_id = footer.file_id;
 		}
 	}
 
@@ -511,6 +609,116 @@ static int32_t streamfs_scan_filesystem(struct streamfs_state *streamfs)
 	return 0;
 }
 
+/**
+ * Move what's waiting in the COM buffer into the page buffers
+ * @return true if a page is ready to be programmed
+ * @note Must be called while holding page_mutex
+ */
+static bool streamfs_fill_pages(struct streamfs_state *streamfs)
+{
+	uint16_t write_size = streamfs->cfg->write_size;
+
+	while (streamfs->tx_out_cb) {
+		uint8_t fill = streamfs->fill_page;
+
+		if (streamfs->page_len[fill] == write_size) {
+			if (streamfs->page_ready[fill ^ 1]) {
+				// Both full; the rest waits in the COM buffer
+				break;
+			}
+
+			streamfs->page_ready[fill] = true;
+			streamfs->page_ready_time[fill] = PIOS_DELAY_GetRaw();
+			fill ^= 1;
+			streamfs->fill_page = fill;
+		}
+
+		uint16_t bytes = (streamfs->tx_out_cb)(
+				streamfs->tx_out_context,
+				&streamfs->page_buffer[fill][streamfs->page_len[fill]],
+				write_size - streamfs->page_len[fill],
+				NULL, NULL);
+
+		if (bytes == 0) {
+			break;
+		}
+
+		if (!streamfs->file_open_writing || streamfs->flushing) {
+			// Nowhere for it to go
+			streamfs->stats.bytes_dropped += bytes;
+			continue;
+		}
+
+		streamfs->page_len[fill] += bytes;
+	}
+
+	return streamfs->page_ready[streamfs->fill_page ^ 1];
+}
+
+/**
+ * Hand a partly filled page over for programming, if the other one is free
+ * @note Must be called while holding page_mutex
+ */
+static void streamfs_release_partial_page(struct streamfs_state *streamfs)
+{
+	uint8_t fill = streamfs->fill_page;
+
+	if (streamfs->page_ready[fill ^ 1] || streamfs->page_len[fill] == 0) {
+		return;
+	}
+
+	streamfs->page_ready[fill] = true;
+	streamfs->page_ready_time[fill] = PIOS_DELAY_GetRaw();
+	streamfs->fill_page = fill ^ 1;
+}
+
+/**
+ * Program the page that's ready, if there is one, and free it for filling
+ * @return 0 if success or nothing to do, < 0 on failure
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t streamfs_write_ready_page(struct streamfs_state *streamfs)
+{
+	bool tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	uint8_t page = streamfs->fill_page ^ 1;
+	bool ready = streamfs->page_ready[page];
+
+	PIOS_Mutex_Unlock(streamfs->page_mutex);
+
+	if (!ready) {
+		return 0;
+	}
+
+	// The sending side leaves a ready page alone, so no lock while writing
+	uint16_t len = streamfs->page_len[page];
+	int32_t rc = streamfs_append_to_file(streamfs, streamfs->page_buffer[page], len);
+	uint32_t latency = PIOS_DELAY_DiffuS(streamfs->page_ready_time[page]);
+
+	tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	if (rc < 0) {
+		streamfs->stats.bytes_dropped += len;
+	} else {
+		streamfs->stats.bytes_written += len;
+		streamfs->stats.pages_written++;
+		streamfs->write_latency_total_us += latency;
+
+		if (latency > streamfs->stats.write_latency_max_us) {
+			streamfs->stats.write_latency_max_us = latency;
+		}
+	}
+
+	streamfs->page_len[page] = 0;
+	streamfs->page_ready[page] = false;
+
+	PIOS_Mutex_Unlock(streamfs->page_mutex);
+
+	return (rc < 0) ? -1 : 0;
+}
+
 static void PIOS_STREAMFS_Task(void *parameters)
 {
 	struct streamfs_state *streamfs = parameters;
@@ -519,17 +727,18 @@ static void PIOS_STREAMFS_Task(void *parameters)
 	PIOS_Assert(tmp);
 
 	while (1) {
-		int32_t bytes_to_write = 0;
+		tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		PIOS_Assert(tmp);
 
-		if (streamfs->tx_out_cb) {
-			bytes_to_write = (streamfs->tx_out_cb)(
-				streamfs->tx_out_context,
-				streamfs->com_buffer,
-				streamfs->cfg->write_size,
-				NULL, NULL);
-		}
+		bool page_ready = streamfs_fill_pages(streamfs);
 
-		if (bytes_to_write <= 0) {
+		PIOS_Mutex_Unlock(streamfs->page_mutex);
+
+		// Erasing only when there's no page waiting keeps it from
+		// holding up data that's already arrived.
+		bool erase_ahead = !page_ready && streamfs_erase_ahead_due(streamfs);
+
+		if (!page_ready && !erase_ahead) {
 			// Block here until woken.
 			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Semaphore_Take(streamfs->sem, PIOS_SEMAPHORE_TIMEOUT_MAX);
@@ -538,11 +747,6 @@ static void PIOS_STREAMFS_Task(void *parameters)
 			continue;
 		}
 
-		if (!streamfs->file_open_writing) {
-			// Drain out pending data while file not open
-			continue;
-		}
-
 		if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
 			PIOS_Mutex_Unlock(streamfs->mutex);
 			PIOS_Thread_Sleep(50);	// Don't spin
@@ -551,21 +755,23 @@ static void PIOS_STREAMFS_Task(void *parameters)
 			continue;
 		}
 
-		// Flush available data from PIOS_COM interface to
-		// file system
-		while (bytes_to_write > 0) {
-			if (streamfs_append_to_file(streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
-				break;
-			}
+		bool erase_failed = false;
 
-			bytes_to_write = (streamfs->tx_out_cb)(
-					streamfs->tx_out_context,
-					streamfs->com_buffer,
-					streamfs->cfg->write_size,
-					NULL, NULL);
+		if (page_ready) {
+			streamfs_write_ready_page(streamfs);
+		} else if (streamfs_erase_ahead(streamfs) != 0) {
+			erase_failed = true;
 		}
 
 		PIOS_FLASH_end_transaction(streamfs->partition_id);
+
+		if (erase_failed) {
+			// streamfs_new_sector tries again if this keeps failing
+			PIOS_Mutex_Unlock(streamfs->mutex);
+			PIOS_Thread_Sleep(50);
+			tmp = PIOS_Mutex_Lock(streamfs->mutex, PIOS_MUTEX_TIMEOUT_MAX);
+			PIOS_Assert(tmp);
+		}
 	}
 }
 
@@ -611,12 +817,29 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
-	streamfs->com_buffer = (uint8_t *)PIOS_malloc(cfg->write_size);
-	if (!streamfs->com_buffer) {
+	for (int i = 0; i < 2; i++) {
+		streamfs->page_buffer[i] = (uint8_t *)PIOS_malloc(cfg->write_size);
+		streamfs->page_len[i] = 0;
+		streamfs->page_ready[i] = false;
+	}
+
+	streamfs->arenas = (struct streamfs_arena *)PIOS_malloc_no_dma(
+			(partition_size / cfg->arena_size) * sizeof(struct streamfs_arena));
+
+	if (!streamfs->page_buffer[0] || !streamfs->page_buffer[1] || !streamfs->arenas) {
+		PIOS_free(streamfs->page_buffer[0]);
+		PIOS_free(streamfs->page_buffer[1]);
+		PIOS_free(streamfs->arenas);
 		PIOS_free(streamfs);
 		return -1;
 	}
 
+	streamfs->fill_page = 0;
+	streamfs->flushing = false;
+	streamfs->erased_arena = -1;
+	memset(&streamfs->stats, 0, sizeof(streamfs->stats));
+	streamfs->write_latency_total_us = 0;
+
 	/* Bind configuration parameters to this filesystem instance */
 	streamfs->cfg            = cfg;	/* filesystem configuration */
 	streamfs->partition_id   = partition_id; /* underlying partition */
@@ -636,6 +859,13 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
+	streamfs->page_mutex = PIOS_Mutex_Create();
+
+	if (!streamfs->page_mutex) {
+		rc = -1;
+		goto out_exit;
+	}
+
 	streamfs->sem = PIOS_Semaphore_Create();
 
 	if (!streamfs->sem) {
@@ -648,9 +878,14 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 		goto out_exit;
 	}
 
-	// TODO: find the first sector after the last file
 	// TODO: validate that the partition is valid for streaming (magic?)
 
+	// The only time every footer gets read
+	if (streamfs_load_arenas(streamfs) != 0) {
+		rc = -1;
+		goto out_end_trans;
+	}
+
 	// Scan filesystem contents
 	streamfs_scan_filesystem(streamfs);
 
@@ -658,9 +893,13 @@ int32_t PIOS_STREAMFS_Init(uintptr_t *fs_id, const struct streamfs_cfg *cfg, enu
 
 	*fs_id = (uintptr_t) streamfs;
 
-//out_end_trans:
+out_end_trans:
 	PIOS_FLASH_end_transaction(streamfs->partition_id);
 
+	if (rc != 0) {
+		goto out_exit;
+	}
+
 	streamfs->task = PIOS_Thread_Create(PIOS_STREAMFS_Task,
 			"pios_streamfs", PIOS_STREAMFS_TASK_STACK_BYTES,
 			streamfs, PIOS_STREAMFS_TASK_PRIORITY);
@@ -696,11 +935,15 @@ int32_t PIOS_STREAMFS_Format(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	streamfs->erased_arena = -1;
+
 	if (streamfs_erase_all_arenas(streamfs) != 0) {
 		rc = -3;
 		goto out_end_trans;
 	}
 
+	streamfs_scan_filesystem(streamfs);
+
 	/* Chip erased and log remounted successfully */
 	rc = 0;
 
@@ -765,8 +1008,10 @@ int32_t PIOS_STREAMFS_OpenWrite(uintptr_t fs_id)
 	streamfs->active_file_arena_offset = 0;
 	streamfs->file_open_writing = true;
 
-	// Erase this sector to prepare for streaming
-	if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
+	// Erase this sector to prepare for streaming, unless that's been done
+	if (streamfs->active_file_arena == streamfs->erased_arena) {
+		streamfs->erased_arena = -1;
+	} else if (streamfs_erase_arena(streamfs, streamfs->active_file_arena) != 0) {
 		rc = -5;
 		goto out_end_trans;
 	}
@@ -823,7 +1068,8 @@ int32_t PIOS_STREAMFS_OpenRead(uintptr_t fs_id, uint32_t file_id)
 	streamfs->active_file_arena = streamfs_find_first_arena(streamfs, file_id);
 	if (streamfs->active_file_arena >= 0) {
 		streamfs->active_file_id = file_id;
-		streamfs->active_file_segment = 0;
+		streamfs->active_file_segment =
+			streamfs->arenas[streamfs->active_file_arena].file_segment;
 		streamfs->active_file_arena_offset = 0;
 		streamfs->file_open_reading = true;
 	} else {
@@ -906,6 +1152,41 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		goto out_exit;
 	}
 
+	// Write out what's buffered, including any partial page.  Someone
+	// could keep sending as fast as we write, so after a while stop
+	// taking more, and drop whatever arrives after that.
+	bool page_ready;
+	bool tmp;
+	int32_t pages_left = PIOS_STREAMFS_CLOSE_FLUSH_PAGES;
+
+	do {
+		tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		PIOS_Assert(tmp);
+
+		if (pages_left-- > 0) {
+			streamfs_fill_pages(streamfs);
+		} else {
+			streamfs->flushing = true;
+		}
+
+		streamfs_release_partial_page(streamfs);
+		page_ready = streamfs->page_ready[streamfs->fill_page ^ 1];
+
+		PIOS_Mutex_Unlock(streamfs->page_mutex);
+
+		if (page_ready) {
+			streamfs_write_ready_page(streamfs);
+		}
+	} while (page_ready);
+
+	tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	streamfs->file_open_writing = false;
+	streamfs->flushing = false;
+
+	PIOS_Mutex_Unlock(streamfs->page_mutex);
+
 	if (streamfs->active_file_arena_offset != 0) {
 		// Close segment when something has been written. This avoids creating
 		// null files with an open/close operation
@@ -915,10 +1196,6 @@ int32_t PIOS_STREAMFS_Close(uintptr_t fs_id)
 		}
 	}
 
-
-	// TODO: make sure to flush remaining data
-	streamfs->file_open_writing = false;
-
 	if (streamfs_scan_filesystem(streamfs) != 0) {
 		rc = -4;
 		goto out_end_trans;
@@ -948,14 +1225,13 @@ int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len) {
 	bool valid = streamfs_validate(streamfs);
 	PIOS_Assert(valid);
 
-	uint16_t num_arenas = streamfs->partition_size / streamfs->cfg->arena_size;
 	if (streamfs->file_open_writing)
 		return -3;
 
 	if (!streamfs->file_open_reading)
 		return -4;
 
-	if (streamfs->active_file_arena >= num_arenas)
+	if ((uint32_t) streamfs->active_file_arena >= streamfs->partition_arenas)
 		return -1;
 
 	if (PIOS_FLASH_start_transaction(streamfs->partition_id) != 0) {
@@ -972,6 +1248,36 @@ int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len) {
 	return rc;
 }
 
+/**
+ * Get the counters kept while writing
+ * @param[in] fs_id the streaming device handle
+ * @param[out] stats filled in with the counters since init
+ * @return 0 if successful, -1 if fs_id is not a valid filesystem
+ */
+int32_t PIOS_STREAMFS_GetStats(uintptr_t fs_id, struct pios_streamfs_stats *stats)
+{
+	struct streamfs_state *streamfs = (struct streamfs_state *)
+		PIOS_COM_GetDriverCtx(fs_id);
+
+	if (!streamfs_validate(streamfs)) {
+		return -1;
+	}
+
+	bool tmp = PIOS_Mutex_Lock(streamfs->page_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Assert(tmp);
+
+	*stats = streamfs->stats;
+
+	if (streamfs->stats.pages_written) {
+		stats->write_latency_avg_us = streamfs->write_latency_total_us /
+			streamfs->stats.pages_written;
+	}
+
+	PIOS_Mutex_Unlock(streamfs->page_mutex);
+
+	return 0;
+}
+
 // Testing methods for unit tests
 int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len)
 {
@@ -1016,6 +1322,15 @@ static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail)
 	bool valid = streamfs_validate(streamfs);
 	PIOS_Assert(valid);
 
+	/* Take what we can into the free page now, rather than leave it in
+	 * the COM buffer while the task is busy with the flash.  If the task
+	 * holds the lock it's draining anyway, and the semaphore makes sure
+	 * it looks again. */
+	if (PIOS_Mutex_Lock(streamfs->page_mutex, 0)) {
+		streamfs_fill_pages(streamfs);
+		PIOS_Mutex_Unlock(streamfs->page_mutex);
+	}
+
 	PIOS_Semaphore_Give(streamfs->sem);
 }
 
@@ -28,9 +28,22 @@
 #define PIOS_FLASHFS_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Supplies the idx'th object of a batch save.  Returns false if the entry
+ * should be skipped (it is then reported to the done callback as -1).
+ */
+typedef bool (*pios_flashfs_obj_source_t)(void *ctx, uint16_t idx,
+		uint32_t *obj_id, uint16_t *obj_inst_id,
+		uint8_t **obj_data, uint16_t *obj_size);
+
+/** Reports the result of saving the idx'th object of a batch save. */
+typedef void (*pios_flashfs_obj_done_t)(void *ctx, uint16_t idx, int32_t rc);
 
 int32_t PIOS_FLASHFS_Format(uintptr_t fs_id);
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, uint16_t num_objs, pios_flashfs_obj_source_t source, pios_flashfs_obj_done_t done, void *ctx);
 int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id);
 
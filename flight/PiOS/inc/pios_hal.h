@@ -128,6 +128,7 @@ void PIOS_HAL_ConfigureRFM22B(HwSharedRadioPortOptions radio_type,
 
 void PIOS_HAL_ConfigureSerialSpeed(uintptr_t com_id,
 		                HwSharedSpeedBpsOptions speed);
+uint32_t PIOS_HAL_SerialSpeedBaud(HwSharedSpeedBpsOptions speed);
 
 void PIOS_HAL_SetReceiver(int receiver_type, uintptr_t value);
 
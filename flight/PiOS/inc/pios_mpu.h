@@ -141,6 +141,7 @@ struct pios_mpu_cfg {
 	uint16_t default_samplerate;
 	enum pios_mpu_orientation orientation;
 	bool skip_startup_irq_check;
+	uint8_t fifo_burst;		/* Samples to drain from the FIFO per transfer, 0 to read each sample on its data ready interrupt */
 #ifdef PIOS_INCLUDE_MPU_MAG
 	bool use_internal_mag;		/* Flag to indicate whether or not to use the internal mag on MPU9x50 devices */
 #endif // PIOS_INCLUDE_MPU_MAG
@@ -148,6 +149,17 @@ struct pios_mpu_cfg {
 
 typedef struct pios_mpu_dev * pios_mpu_dev_t;
 
+/**
+ * Counters kept in FIFO mode
+ */
+struct pios_mpu_fifo_stats {
+	uint32_t bursts;            /**< FIFO reads that returned samples */
+	uint32_t samples;           /**< Samples pushed to the queues */
+	uint32_t overflows;         /**< FIFO resets after an overflow or lost framing */
+	uint32_t dropped;           /**< Samples lost to overflows, from the timestamps */
+	uint32_t last_sample_us;    /**< Timestamp of the newest sample pushed */
+};
+
 /**
  * @brief Initialize the MPU-xxxx 6/9-axis sensor on I2C
  * @param[in] i2c_id PiOS I2C driver instance ID/pointer
@@ -197,6 +209,12 @@ bool PIOS_MPU_IRQHandler(void);
  */
 enum pios_mpu_type PIOS_MPU_GetType(void);
 
+/**
+ * @brief Get the FIFO mode counters
+ * @param[out] stats all zero unless the driver runs in FIFO mode
+ */
+void PIOS_MPU_GetFIFOStats(struct pios_mpu_fifo_stats *stats);
+
 #endif /* PIOS_MPU_H */
 
 /** 
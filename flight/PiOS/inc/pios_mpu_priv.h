@@ -66,6 +66,7 @@
 #define PIOS_MPU_GYRO_Y_OUT_LSB       0x46
 #define PIOS_MPU_GYRO_Z_OUT_MSB       0x47
 #define PIOS_MPU_GYRO_Z_OUT_LSB       0x48
+#define PIOS_MPU_EXT_SENS_DATA_00     0x49
 #define PIOS_MPU_SIGNAL_PATH_RESET    0x68
 #define PIOS_MPU_USER_CTRL_REG        0x6A
 #define PIOS_MPU_PWR_MGMT_REG         0x6B
@@ -81,6 +82,11 @@
 #define PIOS_MPU_FIFO_GYRO_Z_OUT      0x10
 #define PIOS_MPU_ACCEL_OUT            0x08
 
+/* One FIFO frame with the accels, temperature and gyros enabled */
+#define PIOS_MPU_FIFO_FRAME_LEN       14
+/* Smallest FIFO of the supported parts (MPU-6500 and later) */
+#define PIOS_MPU_FIFO_SIZE            512
+
 /* Interrupt Configuration */
 #define PIOS_MPU_INT_ACTL             0x80
 #define PIOS_MPU_INT_OPEN             0x40
@@ -100,7 +106,7 @@
 #define PIOS_MPU_USERCTL_FIFO_EN      0X40
 #define PIOS_MPU_USERCTL_I2C_MST_EN   0X20
 #define PIOS_MPU_USERCTL_DIS_I2C      0X10
-#define PIOS_MPU_USERCTL_FIFO_RST     0X02
+#define PIOS_MPU_USERCTL_FIFO_RST     0X04
 #define PIOS_MPU_USERCTL_GYRO_RST     0X01
 
 /* Power management and clock selection */
@@ -29,6 +29,19 @@
 
 #include <stdint.h>
 
+/**
+ * Counters kept while writing
+ */
+struct pios_streamfs_stats {
+	uint32_t bytes_written;
+	uint32_t bytes_dropped;        /* taken from the COM buffer, never written */
+	uint32_t pages_written;
+	uint32_t erases_ahead;         /* arenas erased before they were needed */
+	uint32_t erases_inline;        /* arenas erased with data waiting */
+	uint32_t write_latency_max_us; /* from a page filling to it being on flash */
+	uint32_t write_latency_avg_us;
+};
+
 /* fs_id here is actually the com driver ID, to avoid having to do too
  * much bookkeepin' */
 int32_t PIOS_STREAMFS_Format(uintptr_t fs_id);
@@ -38,6 +51,7 @@ int32_t PIOS_STREAMFS_MinFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_MaxFileId(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Close(uintptr_t fs_id);
 int32_t PIOS_STREAMFS_Read(uintptr_t fs_id, uint8_t *data, uint32_t len);
+int32_t PIOS_STREAMFS_GetStats(uintptr_t fs_id, struct pios_streamfs_stats *stats);
 
 
 #endif	/* PIOS_FLASHFS_STREAMFS_H_ */
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_MPU Invensense MPU Functions
+ * @{
+ *
+ * @file       pios_mpu_model.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Register level model of an Invensense MPU on SPI
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef PIOS_MPU_MODEL_H
+#define PIOS_MPU_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIOS_MPU_MODEL_FIFO_SIZE 512
+
+/**
+ * Produce the raw sample with the given index, in LSBs at the configured
+ * ranges.  temp is the raw TEMP_OUT value.
+ */
+typedef void (*pios_mpu_model_sample_fn)(void *ctx, uint32_t index,
+		int16_t accel[3], int16_t *temp, int16_t gyro[3]);
+
+/**
+ * An MPU-6000/6500 as seen over SPI: the register file, the sample clock
+ * and the FIFO, including its habit of overwriting the oldest bytes when
+ * it's full.  Time only moves when PIOS_MPU_Model_SetTime is called, which
+ * the SPI glue does on every chip select.
+ */
+struct pios_mpu_model {
+	uint8_t whoami;
+	uint8_t regs[128];
+
+	uint8_t fifo[PIOS_MPU_MODEL_FIFO_SIZE];
+	uint16_t fifo_head;             /**< oldest byte */
+	uint16_t fifo_count;
+
+	bool have_time;
+	uint32_t next_sample_us;
+	uint32_t sample_index;
+
+	bool selected;
+	bool addressed;
+	bool reading;
+	uint8_t addr;
+
+	pios_mpu_model_sample_fn sample_fn;
+	void *sample_ctx;
+
+	/* For tests */
+	uint32_t selects;
+	uint32_t bytes;
+	uint32_t fifo_overflows;
+};
+
+void PIOS_MPU_Model_Init(struct pios_mpu_model *model, uint8_t whoami);
+void PIOS_MPU_Model_SetSampleFn(struct pios_mpu_model *model,
+		pios_mpu_model_sample_fn fn, void *ctx);
+void PIOS_MPU_Model_SetTime(struct pios_mpu_model *model, uint32_t now_us);
+void PIOS_MPU_Model_Select(struct pios_mpu_model *model, bool selected);
+uint8_t PIOS_MPU_Model_Transfer(struct pios_mpu_model *model, uint8_t out);
+
+#endif /* PIOS_MPU_MODEL_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,45 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_reactor_priv.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Single thread that waits on all the posix COM descriptors
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef PIOS_REACTOR_PRIV_H
+#define PIOS_REACTOR_PRIV_H
+
+#include <pios.h>
+
+/**
+ * Called on the reactor thread when fd has data (or an error / hangup) to
+ * read.  It must drain what it can without blocking; it is called again
+ * for as long as the descriptor stays readable.
+ */
+typedef void (*pios_reactor_cb)(int fd, uintptr_t context);
+
+extern int32_t PIOS_REACTOR_Add(int fd, pios_reactor_cb readable, uintptr_t context);
+extern void PIOS_REACTOR_Remove(int fd);
+
+#endif /* PIOS_REACTOR_PRIV_H */
@@ -3,6 +3,7 @@
 
 #include <pios.h>
 #include "pios_semaphore.h"
+#include "pios_mpu_model.h"
 
 #include <limits.h>
 
@@ -17,8 +18,14 @@ struct pios_spi_dev {
 	int fd[SPI_MAX_SUBDEV];
 
 	int selected;
+
+	/* In place of spidev, when the base path is PIOS_SPI_MODEL_MPU */
+	struct pios_mpu_model *model;
 };
 
+#define PIOS_SPI_MODEL_MPU "model:mpu"
+
+
 struct pios_spi_cfg {
 	char base_path[PATH_MAX];
 };
@@ -57,7 +57,6 @@ struct pios_udp_cfg {
 
 typedef struct {
   const struct pios_udp_cfg * cfg;
-  struct pios_thread *rxThread;
 
   int socket;
   struct sockaddr_in server;
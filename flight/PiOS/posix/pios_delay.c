@@ -125,6 +125,13 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	if (port_lockstep_enabled()) {
+		port_lockstep_advance(uS);
+		return 0;
+	}
+#endif
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -149,6 +156,13 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	if (port_lockstep_enabled()) {
+		port_lockstep_advance(mS * 1000);
+		return 0;
+	}
+#endif
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -162,6 +176,13 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	/* In lockstep mode time is whatever the scheduler says it is */
+	if (port_lockstep_enabled()) {
+		return port_lockstep_time_us();
+	}
+#endif
+
 	uint32_t raw_us = get_monotonic_us_time() - base_time;
 	return raw_us;
 }
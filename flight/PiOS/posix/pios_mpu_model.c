@@ -0,0 +1,362 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_MPU Invensense MPU Functions
+ * @{
+ *
+ * @file       pios_mpu_model.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Register level model of an Invensense MPU on SPI
+ *
+ * Enough of the part for the driver to run against it: reset, WHOAMI, the
+ * sample rate divider, the data registers, INT_STATUS and the FIFO.  The
+ * FIFO behaves as the datasheet describes; when full, each new byte
+ * replaces the oldest one, so after an overflow the frames read back are
+ * no longer aligned.  Register reads auto-increment except at FIFO_R_W,
+ * which streams the FIFO.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "pios_mpu_model.h"
+#include "pios_mpu_priv.h"
+
+#include <string.h>
+
+// Private constants
+
+#define PWRMGMT_SLEEP     0x40
+#define USERCTL_RESETS    (PIOS_MPU_USERCTL_FIFO_RST | 0x03)
+
+// Samples generated in one go at most; more than fill the FIFO
+#define MAX_CATCHUP       64
+
+// Private functions
+
+/**
+ * Level and still, at room temperature
+ */
+static void default_sample(void *ctx, uint32_t index,
+		int16_t accel[3], int16_t *temp, int16_t gyro[3])
+{
+	struct pios_mpu_model *model = ctx;
+	uint8_t range = (model->regs[PIOS_MPU_ACCEL_CFG_REG] >> 3) & 0x03;
+
+	accel[0] = 0;
+	accel[1] = 0;
+	accel[2] = 16384 >> range;
+	*temp = -3912;     // 25 C on an MPU-6000
+	gyro[0] = 0;
+	gyro[1] = 0;
+	gyro[2] = 0;
+}
+
+static void reset(struct pios_mpu_model *model)
+{
+	memset(model->regs, 0, sizeof(model->regs));
+	model->regs[PIOS_MPU_PWR_MGMT_REG] = PWRMGMT_SLEEP;
+
+	model->fifo_head = 0;
+	model->fifo_count = 0;
+}
+
+static uint32_t sample_period_us(const struct pios_mpu_model *model)
+{
+	uint8_t dlpf = model->regs[PIOS_MPU_DLPF_CFG_REG] & 0x07;
+	uint32_t div = 1 + model->regs[PIOS_MPU_SMPLRT_DIV_REG];
+
+	// The gyro runs at 8 kHz with the low pass filter off
+	if (dlpf == 0 || dlpf == 7) {
+		return 125 * div;
+	}
+
+	return 1000 * div;
+}
+
+static void fifo_push(struct pios_mpu_model *model, const uint8_t *data,
+		uint16_t len, bool *overflowed)
+{
+	for (uint16_t i = 0; i < len; i++) {
+		if (model->fifo_count < PIOS_MPU_MODEL_FIFO_SIZE) {
+			uint16_t tail = (model->fifo_head + model->fifo_count) %
+				PIOS_MPU_MODEL_FIFO_SIZE;
+
+			model->fifo[tail] = data[i];
+			model->fifo_count++;
+		} else {
+			model->fifo[model->fifo_head] = data[i];
+			model->fifo_head = (model->fifo_head + 1) %
+				PIOS_MPU_MODEL_FIFO_SIZE;
+			*overflowed = true;
+		}
+	}
+}
+
+static void take_sample(struct pios_mpu_model *model)
+{
+	int16_t accel[3], temp, gyro[3];
+
+	model->sample_fn(model->sample_ctx, model->sample_index++,
+			accel, &temp, gyro);
+
+	int16_t words[7] = {
+		accel[0], accel[1], accel[2], temp, gyro[0], gyro[1], gyro[2]
+	};
+
+	uint8_t *raw = &model->regs[PIOS_MPU_ACCEL_X_OUT_MSB];
+
+	for (int i = 0; i < 7; i++) {
+		raw[2 * i] = (uint16_t) words[i] >> 8;
+		raw[2 * i + 1] = words[i] & 0xff;
+	}
+
+	model->regs[PIOS_MPU_INT_STATUS_REG] |= PIOS_MPU_INT_STATUS_DATA_RDY;
+
+	if (!(model->regs[PIOS_MPU_USER_CTRL_REG] & PIOS_MPU_USERCTL_FIFO_EN)) {
+		return;
+	}
+
+	uint8_t enabled = model->regs[PIOS_MPU_FIFO_EN_REG];
+	bool overflowed = false;
+
+	// Always in register order
+	if (enabled & PIOS_MPU_ACCEL_OUT) {
+		fifo_push(model, raw, 6, &overflowed);
+	}
+	if (enabled & PIOS_MPU_FIFO_TEMP_OUT) {
+		fifo_push(model, raw + 6, 2, &overflowed);
+	}
+	if (enabled & PIOS_MPU_FIFO_GYRO_X_OUT) {
+		fifo_push(model, raw + 8, 2, &overflowed);
+	}
+	if (enabled & PIOS_MPU_FIFO_GYRO_Y_OUT) {
+		fifo_push(model, raw + 10, 2, &overflowed);
+	}
+	if (enabled & PIOS_MPU_FIFO_GYRO_Z_OUT) {
+		fifo_push(model, raw + 12, 2, &overflowed);
+	}
+
+	if (overflowed) {
+		model->regs[PIOS_MPU_INT_STATUS_REG] |= PIOS_MPU_INT_STATUS_OVERFLOW;
+		model->fifo_overflows++;
+	}
+}
+
+static uint8_t read_reg(struct pios_mpu_model *model, uint8_t reg)
+{
+	uint8_t value;
+
+	switch (reg) {
+	case PIOS_MPU_INT_STATUS_REG:
+		value = model->regs[reg];
+		model->regs[reg] = 0;
+		break;
+	case PIOS_MPU_FIFO_CNT_MSB:
+		value = model->fifo_count >> 8;
+		break;
+	case PIOS_MPU_FIFO_CNT_LSB:
+		value = model->fifo_count & 0xff;
+		break;
+	case PIOS_MPU_FIFO_REG:
+		if (model->fifo_count == 0) {
+			value = 0xff;
+			break;
+		}
+
+		value = model->fifo[model->fifo_head];
+		model->fifo_head = (model->fifo_head + 1) % PIOS_MPU_MODEL_FIFO_SIZE;
+		model->fifo_count--;
+		break;
+	case PIOS_MPU_WHOAMI:
+		value = model->whoami;
+		break;
+	default:
+		value = model->regs[reg];
+		break;
+	}
+
+	if (model->regs[PIOS_MPU_INT_CFG_REG] & PIOS_MPU_INT_CLR_ANYRD) {
+		model->regs[PIOS_MPU_INT_STATUS_REG] = 0;
+	}
+
+	return value;
+}
+
+static void write_reg(struct pios_mpu_model *model, uint8_t reg, uint8_t value)
+{
+	switch (reg) {
+	case PIOS_MPU_PWR_MGMT_REG:
+		if (value & PIOS_MPU_PWRMGMT_IMU_RST) {
+			reset(model);
+		} else {
+			model->regs[reg] = value;
+		}
+		break;
+	case PIOS_MPU_USER_CTRL_REG:
+		if (value & PIOS_MPU_USERCTL_FIFO_RST) {
+			model->fifo_head = 0;
+			model->fifo_count = 0;
+		}
+
+		model->regs[reg] = value & ~USERCTL_RESETS;
+		break;
+	case PIOS_MPU_INT_STATUS_REG:
+	case PIOS_MPU_FIFO_CNT_MSB:
+	case PIOS_MPU_FIFO_CNT_LSB:
+	case PIOS_MPU_FIFO_REG:
+	case PIOS_MPU_WHOAMI:
+		// Read only, or not modelled
+		break;
+	default:
+		if (reg >= PIOS_MPU_ACCEL_X_OUT_MSB && reg <= PIOS_MPU_GYRO_Z_OUT_LSB) {
+			break;
+		}
+
+		model->regs[reg] = value;
+		break;
+	}
+}
+
+/**
+ * Start the part out as just powered up
+ * \param[in] whoami value of the WHOAMI register
+ */
+void PIOS_MPU_Model_Init(struct pios_mpu_model *model, uint8_t whoami)
+{
+	memset(model, 0, sizeof(*model));
+
+	model->whoami = whoami;
+	model->sample_fn = default_sample;
+	model->sample_ctx = model;
+
+	reset(model);
+}
+
+/**
+ * Replace the level-and-still samples
+ */
+void PIOS_MPU_Model_SetSampleFn(struct pios_mpu_model *model,
+		pios_mpu_model_sample_fn fn, void *ctx)
+{
+	model->sample_fn = fn;
+	model->sample_ctx = ctx;
+}
+
+/**
+ * Take every sample due up to now
+ * \param[in] now_us microseconds, from any epoch, wrapping
+ */
+void PIOS_MPU_Model_SetTime(struct pios_mpu_model *model, uint32_t now_us)
+{
+	uint32_t period = sample_period_us(model);
+
+	if (!model->have_time) {
+		model->next_sample_us = now_us + period;
+		model->have_time = true;
+		return;
+	}
+
+	if ((int32_t) (now_us - model->next_sample_us) < 0) {
+		return;
+	}
+
+	uint32_t due = (now_us - model->next_sample_us) / period + 1;
+
+	bool awake = !(model->regs[PIOS_MPU_PWR_MGMT_REG] & PWRMGMT_SLEEP);
+
+	if (due > MAX_CATCHUP) {
+		// These would only be overwritten; the FIFO ends up the same
+		uint32_t skip = due - MAX_CATCHUP;
+
+		if (awake) {
+			model->sample_index += skip;
+		}
+
+		model->next_sample_us += skip * period;
+		due = MAX_CATCHUP;
+	}
+
+	for (uint32_t i = 0; i < due; i++) {
+		if (awake) {
+			take_sample(model);
+		}
+
+		model->next_sample_us += period;
+	}
+}
+
+/**
+ * Chip select.  The first byte after selecting is the address, with the
+ * top bit set for a read.
+ */
+void PIOS_MPU_Model_Select(struct pios_mpu_model *model, bool selected)
+{
+	if (selected && !model->selected) {
+		model->selects++;
+		model->addressed = false;
+	}
+
+	model->selected = selected;
+}
+
+/**
+ * Clock one byte each way
+ * \param[in] out the byte from the master
+ * \return the byte from the part
+ */
+uint8_t PIOS_MPU_Model_Transfer(struct pios_mpu_model *model, uint8_t out)
+{
+	if (!model->selected) {
+		return 0xff;
+	}
+
+	model->bytes++;
+
+	if (!model->addressed) {
+		model->addr = out & 0x7f;
+		model->reading = (out & 0x80) != 0;
+		model->addressed = true;
+
+		return 0;
+	}
+
+	uint8_t in = 0;
+
+	if (model->reading) {
+		in = read_reg(model, model->addr);
+	} else {
+		write_reg(model, model->addr, out);
+	}
+
+	if (model->addr != PIOS_MPU_FIFO_REG) {
+		model->addr = (model->addr + 1) & 0x7f;
+	}
+
+	return in;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,258 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_reactor.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Single thread that waits on all the posix COM descriptors
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   PIOS_REACTOR Reactor Functions
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+/*
+ * The simulator's threads all share one host thread, so a driver can't
+ * block in read() without stopping everything.  Instead of every driver
+ * polling its descriptor once a tick, all descriptors are handed to one
+ * high priority thread.  The kernel raises PORT_IO_SIGNAL when any of
+ * them becomes readable; the handler wakes the reactor thread the same
+ * way a UART interrupt would wake a task, and the reactor calls the
+ * driver to move the data into the COM layer.  When nothing is coming in
+ * nothing runs.
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+
+#include <pios_reactor_priv.h>
+#include "pios_thread.h"
+#include "pios_semaphore.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
+#define poll WSAPoll
+/* No I/O signal, so fall back to looking every tick */
+#define PIOS_REACTOR_BACKSTOP_MS 1
+#else
+#include <poll.h>
+/* Only matters if a descriptor doesn't support O_ASYNC */
+#define PIOS_REACTOR_BACKSTOP_MS 100
+#endif
+
+#define PIOS_REACTOR_MAX_FDS 16
+
+struct pios_reactor_entry {
+	pios_reactor_cb readable;
+	uintptr_t context;
+};
+
+static struct pollfd reactor_fds[PIOS_REACTOR_MAX_FDS];
+static struct pios_reactor_entry reactor_entries[PIOS_REACTOR_MAX_FDS];
+static int reactor_num_fds;
+
+static struct pios_semaphore *reactor_sem;
+static struct pios_thread *reactor_thread;
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+/**
+ * I/O "interrupt": wake the reactor and switch to it right away, rather
+ * than on the next tick.  Same shape as port_tick_signal_handler.
+ */
+static void PIOS_REACTOR_SignalHandler(int signum)
+{
+	bool woken = false;
+
+	CH_IRQ_PROLOGUE();
+
+	PIOS_Semaphore_Give_FromISR(reactor_sem, &woken);
+
+	CH_IRQ_EPILOGUE();
+
+	dbg_check_lock();
+	if (chSchIsPreemptionRequired())
+		chSchDoReschedule();
+	dbg_check_unlock();
+}
+#endif
+
+/**
+ * Have the kernel signal us when fd becomes readable
+ */
+static void PIOS_REACTOR_SetAsync(int fd, bool async)
+{
+#if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
+	unsigned long flag = 1;
+	ioctlsocket(fd, FIONBIO, &flag);
+#else
+	int flags = fcntl(fd, F_GETFL, 0);
+
+	if (flags == -1) {
+		return;
+	}
+
+	if (async) {
+		fcntl(fd, F_SETOWN, getpid());
+		fcntl(fd, F_SETFL, flags | O_NONBLOCK | O_ASYNC);
+	} else {
+		fcntl(fd, F_SETFL, flags & ~O_ASYNC);
+	}
+#endif
+}
+
+/**
+ * Reactor task.  Dispatches every readable descriptor until none are,
+ * then sleeps until the next I/O signal.
+ */
+static void PIOS_REACTOR_Task(void *parameters)
+{
+	while (1) {
+		int ready = poll(reactor_fds, reactor_num_fds, 0);
+
+		if (ready <= 0) {
+			/* A signal between the poll and here leaves the
+			 * semaphore given, so nothing is missed. */
+			PIOS_Semaphore_Take(reactor_sem,
+					PIOS_REACTOR_BACKSTOP_MS);
+			continue;
+		}
+
+		for (int i = 0; i < reactor_num_fds; i++) {
+			if (reactor_fds[i].fd < 0 || !reactor_fds[i].revents) {
+				continue;
+			}
+
+			reactor_fds[i].revents = 0;
+
+			reactor_entries[i].readable(reactor_fds[i].fd,
+					reactor_entries[i].context);
+		}
+	}
+}
+
+static int32_t PIOS_REACTOR_Init(void)
+{
+	reactor_sem = PIOS_Semaphore_Create();
+
+	if (!reactor_sem) {
+		return -1;
+	}
+
+#if !(defined(_WIN32) || defined(WIN32) || defined(__MINGW32__))
+	struct sigaction sa_io = {
+		.sa_handler = PIOS_REACTOR_SignalHandler,
+		.sa_flags = SA_RESTART,
+	};
+
+	/* Don't let the tick nest inside the I/O interrupt */
+	sigemptyset(&sa_io.sa_mask);
+	sigaddset(&sa_io.sa_mask, PORT_TIMER_SIGNAL);
+
+	if (sigaction(PORT_IO_SIGNAL, &sa_io, NULL)) {
+		perror("sigaction");
+		return -1;
+	}
+#endif
+
+	reactor_thread = PIOS_Thread_Create(PIOS_REACTOR_Task,
+			"pios_reactor", PIOS_THREAD_STACK_SIZE_MIN, NULL,
+			PIOS_THREAD_PRIO_HIGHEST);
+
+	if (!reactor_thread) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Start watching a descriptor.  It is made non-blocking.
+ * \param[in] fd descriptor to watch
+ * \param[in] readable called on the reactor thread when fd is readable
+ * \param[in] context passed to readable
+ * \return < 0 if there is no room or the reactor couldn't be started
+ */
+int32_t PIOS_REACTOR_Add(int fd, pios_reactor_cb readable, uintptr_t context)
+{
+	PIOS_Assert(readable);
+
+	if (!reactor_thread && PIOS_REACTOR_Init()) {
+		return -1;
+	}
+
+	int slot;
+
+	for (slot = 0; slot < reactor_num_fds; slot++) {
+		if (reactor_fds[slot].fd < 0) {
+			break;
+		}
+	}
+
+	if (slot >= PIOS_REACTOR_MAX_FDS) {
+		return -1;
+	}
+
+	reactor_entries[slot].readable = readable;
+	reactor_entries[slot].context = context;
+
+	reactor_fds[slot].events = POLLIN;
+	reactor_fds[slot].revents = 0;
+
+	PIOS_REACTOR_SetAsync(fd, true);
+
+	/* Publish the descriptor last; the reactor skips negative ones */
+	reactor_fds[slot].fd = fd;
+
+	if (slot == reactor_num_fds) {
+		reactor_num_fds++;
+	}
+
+	/* Data may have arrived before we asked to be signalled */
+	PIOS_Semaphore_Give(reactor_sem);
+
+	return 0;
+}
+
+/**
+ * Stop watching a descriptor.  Safe to call from a readable callback,
+ * including for the descriptor being dispatched.
+ */
+void PIOS_REACTOR_Remove(int fd)
+{
+	for (int i = 0; i < reactor_num_fds; i++) {
+		if (reactor_fds[i].fd == fd) {
+			reactor_fds[i].fd = -1;
+
+			PIOS_REACTOR_SetAsync(fd, false);
+		}
+	}
+}
+
+#endif /* PIOS_INCLUDE_CHIBIOS */
+
+/**
+  * @}
+  */
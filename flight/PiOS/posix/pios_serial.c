@@ -37,6 +37,7 @@
 #if defined(PIOS_INCLUDE_SERIAL)
 
 #include <pios_serial_priv.h>
+#include <pios_reactor_priv.h>
 #include "pios_thread.h"
 #include <unistd.h>
 #include <sys/types.h>
@@ -79,43 +80,26 @@ static pios_ser_dev * find_ser_dev_by_id(uintptr_t serial)
 	return (pios_ser_dev *) serial;
 }
 
-static int set_nonblock(int fd) {
-	int flags;
-	if ((flags = fcntl(fd, F_GETFL, 0)) != -1) {
-		if (fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1) {
-			return 0;
-		}
-	}
-
-	return -1;
-}
-
 /**
- * RxTask
+ * Called by the reactor when the port has data
  */
-static void PIOS_SERIAL_RxTask(void *ser_dev_n)
+static void PIOS_SERIAL_Readable(int fd, uintptr_t serial_id)
 {
-	pios_ser_dev *ser_dev = (pios_ser_dev*)ser_dev_n;
-
-	const int INCOMING_BUFFER_SIZE = 16;
-	char incoming_buffer[INCOMING_BUFFER_SIZE];
+	pios_ser_dev *ser_dev = find_ser_dev_by_id(serial_id);
 
-	while (1) {
-		int result = read(ser_dev->fd, incoming_buffer, INCOMING_BUFFER_SIZE);
+	int result = read(fd, ser_dev->rx_buffer, PIOS_SERIAL_RX_BUFFER_SIZE);
 
-		if (result > 0 && ser_dev->rx_in_cb) {
+	if (result > 0) {
+		if (ser_dev->rx_in_cb) {
 			bool rx_need_yield = false;
 
-			ser_dev->rx_in_cb(ser_dev->rx_in_context, (uint8_t*)incoming_buffer, result, NULL, &rx_need_yield);
-		}
-
-		if (result == 0) {
-			break;
-		}
-
-		if (result == -1) {
-			PIOS_Thread_Sleep(1);
+			ser_dev->rx_in_cb(ser_dev->rx_in_context,
+					ser_dev->rx_buffer, result,
+					NULL, &rx_need_yield);
 		}
+	} else if (result == 0 || (errno != EAGAIN && errno != EINTR)) {
+		/* The device went away */
+		PIOS_REACTOR_Remove(fd);
 	}
 }
 
@@ -140,11 +124,13 @@ int32_t PIOS_SERIAL_Init(uintptr_t *serial_id, const char *path)
 		return -1;
 	}
 
-	/* Set nonblocking. */
-	set_nonblock(ser_dev->fd);
-
-	PIOS_Thread_Create(PIOS_SERIAL_RxTask, "pios_serial_rx",
-		PIOS_THREAD_STACK_SIZE_MIN, ser_dev, PIOS_THREAD_PRIO_HIGHEST);
+	/* Also makes the fd nonblocking. */
+	if (PIOS_REACTOR_Add(ser_dev->fd, PIOS_SERIAL_Readable,
+				(uintptr_t) ser_dev)) {
+		printf("Can't watch serial port\n");
+		close(ser_dev->fd);
+		return -1;
+	}
 
 	printf("serial dev %p - path %s - fd %i opened\n", ser_dev,
 		path, ser_dev->fd);
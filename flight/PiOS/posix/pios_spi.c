@@ -32,6 +32,7 @@
 
 #if defined(PIOS_INCLUDE_SPI)
 #include <stdio.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -65,6 +66,24 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
 
 	spi_dev->busy = PIOS_Semaphore_Create();
 	spi_dev->slave_count = 0;
+	spi_dev->model = NULL;
+	spi_dev->selected = -1;
+
+	if (!strcmp(cfg->base_path, PIOS_SPI_MODEL_MPU)) {
+		/* One simulated MPU-6000, for trying the driver without one */
+		spi_dev->model = PIOS_malloc(sizeof(*spi_dev->model));
+		if (!spi_dev->model) goto out_fail;
+
+		PIOS_MPU_Model_Init(spi_dev->model, 0x68);
+
+		spi_dev->slave_count = 1;
+
+		printf("PIOS_SPI: Inited MPU model\n");
+
+		*spi_id = (uint32_t)spi_dev;
+
+		return 0;
+	}
 
 	for (int i=0; i < SPI_MAX_SUBDEV; i++) {
 		char path[PATH_MAX];
@@ -150,6 +169,20 @@ int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, bool pin_value)
 	PIOS_Assert(valid)
 	PIOS_Assert(slave_id < spi_dev->slave_count)
 
+	if (spi_dev->model) {
+		if (!pin_value) {
+			spi_dev->selected = slave_id;
+
+			PIOS_MPU_Model_SetTime(spi_dev->model, PIOS_DELAY_GetuS());
+		} else {
+			spi_dev->selected = -1;
+		}
+
+		PIOS_MPU_Model_Select(spi_dev->model, !pin_value);
+
+		return 0;
+	}
+
         struct spi_ioc_transfer xfer = {
 		.delay_usecs = 1,
 	};
@@ -197,6 +230,19 @@ int32_t PIOS_SPI_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint
 	PIOS_Assert(slave_id < spi_dev->slave_count)
 	PIOS_Assert(slave_id >= 0);
 
+	if (spi_dev->model) {
+		for (uint16_t i = 0; i < len; i++) {
+			uint8_t b = PIOS_MPU_Model_Transfer(spi_dev->model,
+					send_buffer ? send_buffer[i] : 0xff);
+
+			if (receive_buffer) {
+				receive_buffer[i] = b;
+			}
+		}
+
+		return 0;
+	}
+
         struct spi_ioc_transfer xfer = {
 		.rx_buf = (uintptr_t) receive_buffer,
 		.tx_buf = (uintptr_t) send_buffer,
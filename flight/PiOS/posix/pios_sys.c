@@ -78,19 +78,23 @@ int num_spi = 0;
 uintptr_t spi_devs[16];
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f] [-r] [-l logfile] [-s spibase] [-d drvname:bus:id]\n"
+	printf( "usage: %s [-f] [-r] [-L] [-p port] [-l logfile] [-R logfile] [-s spibase] [-d drvname:bus:id]\n"
 		"\n"
 		"\t-f\tEnables floating point exception trapping mode\n"
 		"\t-r\tGoes realtime-class and pins all memory (requires root)\n"
+		"\t-L\tLockstep: runs on a virtual clock, as fast as possible\n"
+		"\t-p port\tListens for telemetry on port instead of 9000\n"
 		"\t-l log\tWrites simulation data to a log\n"
+		"\t-R log\tReplays the sensor data recorded in a log\n"
 #ifdef PIOS_INCLUDE_SERIAL
 		"\t-S drvname:serialpath\tStarts a serial driver on serialpath\n"
 		"\t\t\tAvailable drivers: gps msp lighttelemetry telemetry\n"
 #endif
 #ifdef PIOS_INCLUDE_SPI
 		"\t-s spibase\tConfigures a SPI interface on the base path\n"
+		"\t\t\t" PIOS_SPI_MODEL_MPU " simulates an MPU-6000 instead\n"
 		"\t-d drvname:bus:id\tStarts driver drvname on bus/id\n"
-		"\t\t\tAvailable drivers: bmm150 bmx055 flyingpio ms5611\n"
+		"\t\t\tAvailable drivers: bmm150 bmx055 flyingpio mpu ms5611\n"
 #endif
 		"",
 		cmdName);
@@ -242,6 +246,24 @@ static int handle_device(const char *optarg) {
 		int ret = PIOS_BMM150_SPI_Init(&dev, spi_devs[bus_num], dev_num, bmm150_cfg);
 
 		if (ret) goto fail;
+#ifdef PIOS_INCLUDE_MPU
+	} else if (!strcmp(drv_name, "mpu")) {
+		struct pios_mpu_cfg *mpu_cfg;
+		pios_mpu_dev_t dev = NULL;
+
+		mpu_cfg = PIOS_malloc(sizeof(*mpu_cfg));
+		bzero(mpu_cfg, sizeof(*mpu_cfg));
+
+		/* There's no interrupt line, so this has to poll the FIFO */
+		mpu_cfg->default_samplerate = 1000;
+		mpu_cfg->orientation = PIOS_MPU_TOP_0DEG;
+		mpu_cfg->skip_startup_irq_check = true;
+		mpu_cfg->fifo_burst = 4;
+
+		int ret = PIOS_MPU_SPI_Init(&dev, spi_devs[bus_num], dev_num, mpu_cfg);
+
+		if (ret) goto fail;
+#endif
 	} else if (!strcmp(drv_name, "flyingpio")) {
 		pios_flyingpio_dev_t dev;
 
@@ -322,8 +344,48 @@ static void go_realtime() {
 #endif
 }
 
+#define SYS_OPTIONS "frLp:l:R:s:d:S:"
+
 static int saved_argc;
 static char **saved_argv;
+static const char *replay_log;
+static uint16_t telemetry_port;
+
+/**
+ * Picks out the options the board init depends on, which have to be known
+ * before PIOS_SYS_Args can run.
+ */
+void PIOS_SYS_EarlyArgs(int argc, char *argv[]) {
+	int opt;
+
+	/* Leave complaining about bad options to PIOS_SYS_Args */
+	opterr = 0;
+
+	while ((opt = getopt(argc, argv, SYS_OPTIONS)) != -1) {
+		if (opt == 'p') {
+			telemetry_port = atoi(optarg);
+		}
+	}
+
+	opterr = 1;
+	optind = 1;
+}
+
+/**
+ * The port given with -p, or 0 to use the board default
+ */
+uint16_t PIOS_SYS_GetTelemetryPort(void)
+{
+	return telemetry_port;
+}
+
+/**
+ * The log given with -R, or NULL if the sensors should be simulated
+ */
+const char *PIOS_SYS_GetReplayLog(void)
+{
+	return replay_log;
+}
 
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	saved_argc = argc;
@@ -331,7 +393,7 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 
 	int opt;
 
-	while ((opt = getopt(argc, argv, "frl:s:d:S:")) != -1) {
+	while ((opt = getopt(argc, argv, SYS_OPTIONS)) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe = true;
@@ -339,6 +401,11 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 			case 'r':
 				go_realtime();
 				break;
+#if defined(PIOS_INCLUDE_CHIBIOS)
+			case 'L':
+				port_lockstep_enable();
+				break;
+#endif
 			case 'l':
 			{
 				uintptr_t tmp;
@@ -359,6 +426,12 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 				}
 				break;
 			}
+			case 'p':
+				/* Handled by PIOS_SYS_EarlyArgs */
+				break;
+			case 'R':
+				replay_log = optarg;
+				break;
 #ifdef PIOS_INCLUDE_SERIAL
 			case 'S':
 				if (handle_serial_device(optarg)) {
@@ -38,6 +38,7 @@
 #if defined(PIOS_INCLUDE_TCP)
 
 #include <pios_tcp_priv.h>
+#include <pios_reactor_priv.h>
 #include "pios_thread.h"
 #include <unistd.h>
 #include <sys/types.h>
@@ -82,107 +83,98 @@ static pios_tcp_dev * find_tcp_dev_by_id(uintptr_t tcp)
 	return (pios_tcp_dev *) tcp;
 }
 
-static int set_nonblock(int sock) {
-#if defined(_WIN32) || defined(WIN32) || defined(__MINGW32__)
-	unsigned long flag = 1;
-	if (!ioctlsocket(sock, FIONBIO, &flag)) {
-		return 0;
-	}
-#else
-	int flags;
-	if ((flags = fcntl(sock, F_GETFL, 0)) != -1) {
-		if (fcntl(sock, F_SETFL, flags | O_NONBLOCK) != -1) {
-			return 0;
-		}
-	}
-#endif
-
-	return -1;
-}
+static void PIOS_TCP_Readable(int fd, uintptr_t tcp_id);
 
 /**
- * RxTask
+ * Called by the reactor when the listening socket has a connection
  */
-static void PIOS_TCP_RxTask(void *tcp_dev_n)
+static void PIOS_TCP_Accept(int fd, uintptr_t tcp_id)
 {
-	pios_tcp_dev *tcp_dev = (pios_tcp_dev*)tcp_dev_n;
-	
-	const int INCOMING_BUFFER_SIZE = 16;
-	char incoming_buffer[INCOMING_BUFFER_SIZE];
-	int error;
+	pios_tcp_dev *tcp_dev = find_tcp_dev_by_id(tcp_id);
 
-	while (1) {
-	
-		do
-		{
-			/* Polling the fd has to be executed in thread suspended mode
-			 * to get a correct errno value. */
-			PIOS_Thread_Scheduler_Suspend();
-
-			tcp_dev->socket_connection = accept(tcp_dev->socket, NULL, NULL);
-			error = errno;
-
-			PIOS_Thread_Scheduler_Resume();
-
-			PIOS_Thread_Sleep(1);
-		} while (tcp_dev->socket_connection == INVALID_SOCKET && (error == EINTR || error == EAGAIN));
-
-		if (tcp_dev->socket_connection < 0) {
-			int error = errno;
-			(void)error;
-			perror("Accept failed");
-			close(tcp_dev->socket);
-			exit(EXIT_FAILURE);
+	/* Polling the fd has to be executed in thread suspended mode
+	 * to get a correct errno value. */
+	PIOS_Thread_Scheduler_Suspend();
+
+	int conn = accept(fd, NULL, NULL);
+	int error = errno;
+
+	PIOS_Thread_Scheduler_Resume();
+
+	if (conn == INVALID_SOCKET) {
+		if (error == EINTR || error == EAGAIN) {
+			return;
 		}
 
-		set_nonblock(tcp_dev->socket_connection);
-		
-		fprintf(stderr, "Connection accepted\n");
+		perror("Accept failed");
+		close(tcp_dev->socket);
+		exit(EXIT_FAILURE);
+	}
 
-		while (1) {
-			// Received is used to track the scoket whereas the dev variable is only updated when it can be
+	fprintf(stderr, "Connection accepted\n");
 
-			/* Polling the fd has to be executed in thread suspended mode
-			 * to get a correct errno value. */
-			PIOS_Thread_Scheduler_Suspend();
+	/* One client at a time; the next waits in the backlog until this
+	 * one goes away */
+	PIOS_REACTOR_Remove(tcp_dev->socket);
 
-			int result = read(tcp_dev->socket_connection, incoming_buffer, INCOMING_BUFFER_SIZE);
-			error = errno;
+	tcp_dev->socket_connection = conn;
 
-			PIOS_Thread_Scheduler_Resume();
-			
-			if (result > 0 && tcp_dev->rx_in_cb) {
+	if (PIOS_REACTOR_Add(conn, PIOS_TCP_Readable, tcp_id)) {
+		fprintf(stderr, "Can't watch connection\n");
+		close(conn);
+		tcp_dev->socket_connection = INVALID_SOCKET;
+		PIOS_REACTOR_Add(tcp_dev->socket, PIOS_TCP_Accept, tcp_id);
+	}
+}
 
-				bool rx_need_yield = false;
+/**
+ * Called by the reactor when the connection has data, or has closed
+ */
+static void PIOS_TCP_Readable(int fd, uintptr_t tcp_id)
+{
+	pios_tcp_dev *tcp_dev = find_tcp_dev_by_id(tcp_id);
 
-				tcp_dev->rx_in_cb(tcp_dev->rx_in_context, (uint8_t*)incoming_buffer, result, NULL, &rx_need_yield);
+	/* Polling the fd has to be executed in thread suspended mode
+	 * to get a correct errno value. */
+	PIOS_Thread_Scheduler_Suspend();
 
-			}
+	int result = read(fd, tcp_dev->rx_buffer, PIOS_TCP_RX_BUFFER_SIZE);
+	int error = errno;
 
-			if (result == 0) {
-				break;
-			}
+	PIOS_Thread_Scheduler_Resume();
 
-			if (result == -1) {
-				if (error == EAGAIN)
-					PIOS_Thread_Sleep(1);
-				else if (error == EINTR)
-					(void)error;
-				else
-					break;
-			}
+	if (result > 0) {
+		/* Like the USART driver, whatever doesn't fit in the COM
+		 * buffer is dropped.  Anything left in the socket gets
+		 * dispatched again. */
+		if (tcp_dev->rx_in_cb) {
+			bool rx_need_yield = false;
+
+			tcp_dev->rx_in_cb(tcp_dev->rx_in_context,
+					tcp_dev->rx_buffer, result,
+					NULL, &rx_need_yield);
 		}
-		
-		close(tcp_dev->socket_connection);
-		tcp_dev->socket_connection = INVALID_SOCKET;
+
+		return;
+	}
+
+	if (result == -1 && (error == EAGAIN || error == EINTR)) {
+		return;
 	}
+
+	/* Closed by the other end, or failed */
+	PIOS_REACTOR_Remove(fd);
+
+	tcp_dev->socket_connection = INVALID_SOCKET;
+	close(fd);
+
+	PIOS_REACTOR_Add(tcp_dev->socket, PIOS_TCP_Accept, tcp_id);
 }
 
 
 /**
  * Open TCP socket
  */
-struct pios_thread *tcpRxTaskHandle;
 int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 {
 	pios_tcp_dev *tcp_dev = PIOS_malloc(sizeof(pios_tcp_dev));
@@ -235,12 +227,12 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 		exit(EXIT_FAILURE);
 	}
 	
-	/* Set socket nonblocking. */
-	set_nonblock(tcp_dev->socket);
+	/* Wait for a client; this also makes the socket nonblocking. */
+	if (PIOS_REACTOR_Add(tcp_dev->socket, PIOS_TCP_Accept, (uintptr_t) tcp_dev)) {
+		printf("Can't watch TCP socket\n");
+		return -1;
+	}
 
-	tcpRxTaskHandle = PIOS_Thread_Create(
-			PIOS_TCP_RxTask, "pios_tcp_rx", PIOS_THREAD_STACK_SIZE_MIN, tcp_dev, PIOS_THREAD_PRIO_HIGHEST);
-	
 	printf("tcp dev %p - socket %i opened - result %i\n", tcp_dev, tcp_dev->socket, res);
 	
 	*tcp_id = (uintptr_t) tcp_dev;
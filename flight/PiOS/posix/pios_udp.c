@@ -33,8 +33,8 @@
 
 #if defined(PIOS_INCLUDE_UDP)
 
-#include <signal.h>
 #include <pios_udp_priv.h>
+#include <pios_reactor_priv.h>
 #include "pios_thread.h"
 
 /* We need a list of UDP devices */
@@ -75,47 +75,27 @@ static pios_udp_dev * find_udp_dev_by_id (uint8_t udp)
 }
 
 /**
- * RxThread
+ * Called by the reactor when a datagram has arrived
  */
-void PIOS_UDP_RxThread(void * udp_dev_n)
+static void PIOS_UDP_Readable(int fd, uintptr_t udp_id)
 {
+	pios_udp_dev * udp_dev = find_udp_dev_by_id(udp_id);
 
-	/* needed because of FreeRTOS.posix scheduling */
-	sigset_t set;
-	sigfillset(&set);
-	sigprocmask(SIG_BLOCK, &set, NULL);
-
-	pios_udp_dev * udp_dev = (pios_udp_dev*) udp_dev_n;
-
-   /**
-	* com devices never get closed except by application "reboot"
-	* we also never give up our mutex except for waiting
-	*/
-   while(1) {
-
-		/**
-		 * receive 
-		 */
-		int received;
-		udp_dev->clientLength=sizeof(udp_dev->client);
-		if ((received = recvfrom(udp_dev->socket,
-				&udp_dev->rx_buffer,
-				PIOS_UDP_RX_BUFFER_SIZE,
-				0,
-				(struct sockaddr *) &udp_dev->client,
-				(socklen_t*)&udp_dev->clientLength)) >= 0)
-		{
-
-			/* copy received data to buffer if possible */
-			/* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
-			/* (thats what the USART driver does too!) */
-			bool rx_need_yield = false;
-			if (udp_dev->rx_in_cb) {
-			  (void) (udp_dev->rx_in_cb)(udp_dev->rx_in_context, udp_dev->rx_buffer, received, NULL, &rx_need_yield);
-			}
-		}
+	udp_dev->clientLength=sizeof(udp_dev->client);
 
+	int received = recvfrom(fd,
+			&udp_dev->rx_buffer,
+			PIOS_UDP_RX_BUFFER_SIZE,
+			0,
+			(struct sockaddr *) &udp_dev->client,
+			(socklen_t*)&udp_dev->clientLength);
 
+	/* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
+	/* (thats what the USART driver does too!) */
+	if (received > 0 && udp_dev->rx_in_cb) {
+		bool rx_need_yield = false;
+
+		(void) (udp_dev->rx_in_cb)(udp_dev->rx_in_context, udp_dev->rx_buffer, received, NULL, &rx_need_yield);
 	}
 }
 
@@ -145,9 +125,11 @@ int32_t PIOS_UDP_Init(uint32_t * udp_id, const struct pios_udp_cfg * cfg)
   udp_dev->server.sin_port = htons(udp_dev->cfg->port);
   int res= bind(udp_dev->socket, (struct sockaddr *)&udp_dev->server,sizeof(udp_dev->server));
 
-  /* Create transmit thread for this connection */
-  udp_dev->rxThread = PIOS_Thread_Create(
-		  PIOS_TCP_RxTask, "pios_udp_rx", PIOS_THREAD_STACK_SIZE_MIN, udp_dev, PIOS_THREAD_PRIO_NORMAL);
+  /* Receive through the reactor */
+  if (PIOS_REACTOR_Add(udp_dev->socket, PIOS_UDP_Readable, pios_udp_num_devices-1)) {
+    printf("Can't watch UDP socket\n");
+    return -1;
+  }
 
   printf("udp dev %i - socket %i opened - result %i\n",pios_udp_num_devices-1,udp_dev->socket,res);
 
@@ -135,6 +135,11 @@ typedef void (*UAVObjEventCallback)(UAVObjEvent* ev, void* cb_ctx,
  */
 typedef void (*UAVObjInitializeCallback)(UAVObjHandle obj_handle, uint16_t instId);
 
+/**
+ * Callback used to report the result (0 or -1) of each object in a batch save.
+ */
+typedef void (*UAVObjSaveBatchCallback)(void *ctx, uint16_t idx, int32_t rc);
+
 /**
  * Event manager statistics
  */
@@ -165,6 +170,8 @@ bool UAVObjIsSettings(UAVObjHandle obj);
 int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t* dataIn);
 int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t* dataOut);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
+int32_t UAVObjSaveBatch(uint16_t num_objs, const uint32_t *obj_ids,
+		const uint16_t *inst_ids, UAVObjSaveBatchCallback cb, void *ctx);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id);
 #if defined(PIOS_INCLUDE_SDCARD)
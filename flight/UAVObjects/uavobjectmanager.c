@@ -725,6 +725,43 @@ unlock_exit:
 static uint8_t uavobj_save_trampoline[256] __attribute__((aligned(4)));
 #endif	/* PIOS_INCLUDE_FASTHEAP */
 
+/**
+ * Get a pointer to the data of an object instance that is suitable for
+ * handing to the filesystem, copying it through the trampoline if needed.
+ * @param[in] obj The object handle.
+ * @param[in] instId The instance ID
+ * @return pointer to the data or NULL if the instance does not exist
+ */
+static uint8_t *uavobj_get_save_data(UAVObjHandle obj_handle, uint16_t instId)
+{
+	uint8_t *data;
+
+	if (UAVObjIsMetaobject(obj_handle)) {
+		if (instId != 0)
+			return NULL;
+
+		data = (uint8_t *) MetaDataPtr((struct UAVOMeta *)obj_handle);
+	} else {
+		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+
+		if (instEntry == NULL)
+			return NULL;
+
+		data = InstanceData(instEntry);
+	}
+
+	if (data == NULL)
+		return NULL;
+
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	memcpy(uavobj_save_trampoline, data, UAVObjGetNumBytes(obj_handle));
+
+	data = uavobj_save_trampoline;
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
+	return data;
+}
+
 /**
  * Save the data of the specified object to the file system (SD card).
  * If the object contains multiple instances, all of them will be saved.
@@ -739,65 +776,97 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0)
-			return -1;
+	uint8_t *data = uavobj_get_save_data(obj_handle, instId);
 
-		// Save the object to the filesystem
-		int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			MetaDataPtr((struct UAVOMeta *)obj_handle),
-			UAVObjGetNumBytes(obj_handle));
-
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					uavobj_save_trampoline,
-					UAVObjGetNumBytes(obj_handle));
-#else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					(uint8_t*) MetaDataPtr((struct UAVOMeta *)obj_handle),
-					UAVObjGetNumBytes(obj_handle));
-#endif  /* PIOS_INCLUDE_FASTHEAP */
+	if (data == NULL)
+		return -1;
 
-		if (rc != 0)
-			return -1;
-	} else {
-		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
+	// Save the object to the filesystem
+	int32_t rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
+				UAVObjGetID(obj_handle),
+				instId,
+				data,
+				UAVObjGetNumBytes(obj_handle));
 
-		if (instEntry == NULL)
-			return -1;
+	if (rc != 0)
+		return -1;
 
-		if (InstanceData(instEntry) == NULL)
-			return -1;
+	return 0;
+}
 
-		// Save the object to the filesystem
-		int32_t rc;
-#if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			InstanceData(instEntry),
-			UAVObjGetNumBytes(obj_handle));
-
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					uavobj_save_trampoline,
-					UAVObjGetNumBytes(obj_handle));
-#else /* PIOS_INCLUDE_FASTHEAP */
-		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
-					UAVObjGetID(obj_handle),
-					instId,
-					InstanceData(instEntry),
-					UAVObjGetNumBytes(obj_handle));
-#endif  /* PIOS_INCLUDE_FASTHEAP */
+/**
+ * Context of a batch save in progress
+ */
+struct uavobj_save_batch {
+	const uint32_t *obj_ids;
+	const uint16_t *inst_ids;
+	UAVObjSaveBatchCallback cb;
+	void *ctx;
+};
 
-		if (rc != 0)
-			return -1;
+static bool uavobj_save_batch_source(void *ctx, uint16_t idx,
+		uint32_t *obj_id, uint16_t *obj_inst_id,
+		uint8_t **obj_data, uint16_t *obj_size)
+{
+	struct uavobj_save_batch *batch = (struct uavobj_save_batch *) ctx;
+
+	UAVObjHandle obj_handle = UAVObjGetByID(batch->obj_ids[idx]);
+
+	if (obj_handle == NULL)
+		return false;
+
+	*obj_data = uavobj_get_save_data(obj_handle, batch->inst_ids[idx]);
+
+	if (*obj_data == NULL)
+		return false;
+
+	*obj_id = batch->obj_ids[idx];
+	*obj_inst_id = batch->inst_ids[idx];
+	*obj_size = UAVObjGetNumBytes(obj_handle);
+
+	return true;
+}
+
+static void uavobj_save_batch_done(void *ctx, uint16_t idx, int32_t rc)
+{
+	struct uavobj_save_batch *batch = (struct uavobj_save_batch *) ctx;
+
+	if (batch->cb)
+		batch->cb(batch->ctx, idx, (rc == 0) ? 0 : -1);
+}
+
+/**
+ * Save several object instances to the file system in one transaction.
+ * @param[in] num_objs Number of objects to save
+ * @param[in] obj_ids Object IDs of the objects to save
+ * @param[in] inst_ids Instance IDs of the objects to save
+ * @param[in] cb Called after each object is processed with 0 or -1, may be NULL
+ * @param[in] ctx Context handed to the callback
+ * @return 0 if all objects were saved or -1 if any failed
+ */
+int32_t UAVObjSaveBatch(uint16_t num_objs, const uint32_t *obj_ids,
+		const uint16_t *inst_ids, UAVObjSaveBatchCallback cb, void *ctx)
+{
+	struct uavobj_save_batch batch = {
+		.obj_ids = obj_ids,
+		.inst_ids = inst_ids,
+		.cb = cb,
+		.ctx = ctx,
+	};
+
+	int32_t rc = PIOS_FLASHFS_ObjSaveBatch(pios_uavo_settings_fs_id,
+			num_objs, uavobj_save_batch_source,
+			uavobj_save_batch_done, &batch);
+
+	if (rc == -1 || rc == -2) {
+		/* The batch never started, so nothing was reported */
+		for (uint16_t i = 0; cb && i < num_objs; i++)
+			cb(ctx, i, -1);
 	}
 
+	if (rc != 0)
+		return -1;
+
 	return 0;
 }
 
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsCore Tau Labs Core components
+ * @{
+ * @addtogroup UAVTalk UAVTalk implementation
+ * @{
+ *
+ * @file       uavtalk_framing.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      UAVTalk wire format, without the UAVObject manager
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVTALK_FRAMING_H
+#define UAVTALK_FRAMING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//! Minimal UAVTalk header without an instance field
+typedef struct {
+	uint8_t sync;
+	uint8_t type;
+	uint16_t size;
+	uint32_t objId;
+} uavtalk_min_header;
+#define UAVTALK_MIN_HEADER_LENGTH       sizeof(uavtalk_min_header)
+
+//! Full UAVTalk header with an instance and timestamp field
+typedef struct {
+	uint8_t sync;
+	uint8_t type;
+	uint16_t size;
+	uint32_t objId;
+	uint16_t instId;
+	uint16_t timestamp;
+} uavtalk_max_header;
+#define UAVTALK_MAX_HEADER_LENGTH       sizeof(uavtalk_max_header)
+
+typedef uint8_t uavtalk_checksum;
+#define UAVTALK_CHECKSUM_LENGTH         sizeof(uavtalk_checksum)
+
+//! Little endian header fields, for code that reads the bytes directly
+#define UAVTALK_SIZE_OFFSET    offsetof(uavtalk_max_header, size)
+#define UAVTALK_OBJID_OFFSET   offsetof(uavtalk_max_header, objId)
+#define UAVTALK_INSTID_OFFSET  offsetof(uavtalk_max_header, instId)
+
+#define UAVTALK_SYNC_VAL       0x3C
+#define UAVTALK_TYPE_MASK      0x78
+#define UAVTALK_TYPE_VER       0x20
+#define UAVTALK_TIMESTAMPED    0x80
+#define UAVTALK_TYPE_OBJ       (UAVTALK_TYPE_VER | 0x00)
+#define UAVTALK_TYPE_OBJ_REQ   (UAVTALK_TYPE_VER | 0x01)
+#define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
+#define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
+#define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
+#define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
+
+#endif /* UAVTALK_FRAMING_H */
+
+/**
+ * @}
+ * @}
+ */
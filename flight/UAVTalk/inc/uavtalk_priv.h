@@ -34,31 +34,10 @@
 #include "uavobjectsinit.h"
 #include "pios_semaphore.h"
 #include "pios_mutex.h"
+#include "uavtalk_framing.h"
 
 // Private types and constants
 
-//! Minimal UAVTalk header without an instance field
-typedef struct {
-	uint8_t sync;
-	uint8_t type;
-	uint16_t size;
-	uint32_t objId;
-} uavtalk_min_header;
-#define UAVTALK_MIN_HEADER_LENGTH       sizeof(uavtalk_min_header)
-
-//! Full UAVTalk header with an instance and timestamp field
-typedef struct {
-	uint8_t sync;
-	uint8_t type;
-	uint16_t size;
-	uint32_t objId;
-	uint16_t instId;
-	uint16_t timestamp;
-} uavtalk_max_header;
-#define UAVTALK_MAX_HEADER_LENGTH       sizeof(uavtalk_max_header)
-
-typedef uint8_t uavtalk_checksum;
-#define UAVTALK_CHECKSUM_LENGTH         sizeof(uavtalk_checksum)
 #define UAVTALK_MAX_PAYLOAD_LENGTH      (UAVOBJECTS_LARGEST + 1)
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
@@ -99,18 +78,6 @@ typedef struct {
 #define UAVTALK_CANARI         0xCA
 #define UAVTALK_WAITFOREVER     -1
 #define UAVTALK_NOWAIT          0
-#define UAVTALK_SYNC_VAL       0x3C
-#define UAVTALK_TYPE_MASK      0x78
-#define UAVTALK_TYPE_VER       0x20
-#define UAVTALK_TIMESTAMPED    0x80
-#define UAVTALK_TYPE_OBJ       (UAVTALK_TYPE_VER | 0x00)
-#define UAVTALK_TYPE_OBJ_REQ   (UAVTALK_TYPE_VER | 0x01)
-#define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
-#define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
-#define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
-#define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
-#define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
-
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
 	variable = (UAVTalkConnectionData*) handle; \
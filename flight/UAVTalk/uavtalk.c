@@ -42,6 +42,7 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static int32_t packSingleObject(UAVObjHandle obj, uint16_t instId, uint8_t type, uint8_t *buf, int32_t maxLen);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
@@ -647,6 +648,91 @@ int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle)
 	return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
 }
 
+/**
+ * Receive a complete UAVTalk frame that has been found in the stream by other
+ * means, e.g. a relay that only frames its input.  The frame's checksum must
+ * already have been checked; its length is checked against the object here
+ * and it is then unpacked, acked, etc. straight from where it is.
+ * \param[in] connectionHandle UAVTalkConnection to be used
+ * \param[in] frame The frame, from the sync byte to the checksum
+ * \param[in] len Length of the frame
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkReceiveFrame(UAVTalkConnection connectionHandle, uint8_t *frame, uint16_t len)
+{
+	UAVTalkConnectionData *connection;
+
+	CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+	connection->stats.rxBytes += len;
+
+	if (len < UAVTALK_MIN_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH) {
+		connection->stats.rxErrors++;
+		return -1;
+	}
+
+	uint8_t type = frame[1];
+	uint32_t objId = frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t) frame[7] << 24);
+	UAVObjHandle obj = UAVObjGetByID(objId);
+	bool hasInstId = type != UAVTALK_TYPE_NACK && obj && !UAVObjIsSingleInstance(obj);
+	uint16_t headerLength = UAVTALK_MIN_HEADER_LENGTH + (hasInstId ? 2 : 0);
+	uint16_t instId = 0;
+	int32_t length;
+
+	// Determine data length, as UAVTalkProcessInputStreamQuiet does
+	if (type == UAVTALK_TYPE_OBJ_REQ || type == UAVTALK_TYPE_ACK || type == UAVTALK_TYPE_NACK) {
+		length = 0;
+	} else if (obj) {
+		length = UAVObjGetNumBytes(obj);
+
+		if (type & UAVTALK_TIMESTAMPED) {
+			headerLength += 2;
+		}
+	} else {
+		length = len - UAVTALK_CHECKSUM_LENGTH - headerLength;
+	}
+
+	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH ||
+			headerLength + length + UAVTALK_CHECKSUM_LENGTH != len) {
+		connection->stats.rxErrors++;
+		return -1;
+	}
+
+	if (hasInstId) {
+		instId = frame[8] | (frame[9] << 8);
+	}
+
+	connection->stats.rxObjectBytes += length;
+	connection->stats.rxObjects++;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = receiveObject(connection, type, objId, instId, &frame[headerLength], length);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Get the receive buffer of a connection.  It holds the longest packet and
+ * is only used by UAVTalkProcessInputStream and friends, so a connection
+ * whose input is framed elsewhere and passed to UAVTalkReceiveFrame can
+ * lend it out as a receive window.
+ * \param[in] connectionHandle UAVTalkConnection to be used
+ * \param[out] size Size of the buffer
+ * \return the buffer, NULL on error
+ */
+uint8_t *UAVTalkGetRxBuffer(UAVTalkConnection connectionHandle, uint16_t *size)
+{
+	UAVTalkConnectionData *connection;
+
+	CHECKCONHANDLE(connectionHandle, connection, return NULL);
+
+	*size = UAVTALK_MAX_PACKET_LENGTH;
+
+	return connection->rxBuffer;
+}
+
 /**
  * Get the object ID of the current packet.
  * \param[in] connectionHandle UAVTalkConnection to be used
@@ -785,6 +871,21 @@ int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId)
 	return ret;
 }
 
+/**
+ * Pack an object update into a caller supplied buffer, so that several
+ * can be sent back to back with one UAVTalkSendBuf.
+ * \param[in] obj Object handle to pack
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \param[out] buf Where the packet is built
+ * \param[in] maxLen Space available at buf
+ * \return length of the packet
+ * \return -1 Failure, or it doesn't fit
+ */
+int32_t UAVTalkPackObject(UAVObjHandle obj, uint16_t instId, uint8_t *buf, uint16_t maxLen)
+{
+	return packSingleObject(obj, instId, UAVTALK_TYPE_OBJ, buf, maxLen);
+}
+
 /**
  * Send a buffer containing a UAVTalk message through the telemetry link.
  * This function locks the connection prior to sending.
@@ -955,46 +1056,27 @@ static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, u
 }
 
 /**
- * Send an object through the telemetry link.
- * \param[in] connection UAVTalkConnection to be used
- * \param[in] obj Object handle to send
- * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES, use sendObject() instead)
+ * Build the packet for one object instance.
+ * \param[in] obj Object handle to pack
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
  * \param[in] type Transaction type
- * \return 0 Success
- * \return -1 Failure
+ * \param[out] buf Where the packet is built
+ * \param[in] maxLen Space available at buf
+ * \return length of the packet including the checksum
+ * \return -1 Failure, or it doesn't fit
  */
-static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type)
+static int32_t packSingleObject(UAVObjHandle obj, uint16_t instId, uint8_t type, uint8_t *buf, int32_t maxLen)
 {
 	int32_t length;
 	int32_t dataOffset;
 	uint32_t objId;
+	bool singleInstance = UAVObjIsSingleInstance(obj);
 
-	if (!connection->outStream) return -1;
+	// Size everything up before touching buf, callers pack into the tail
+	// of a batch and maxLen may not even cover the header
+	dataOffset = singleInstance ? 8 : 10;
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-
-	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj)) {
-		dataOffset = 8;
-	} else {
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
-	}
-
-	// Add timestamp when the transaction type is appropriate
 	if (type & UAVTALK_TIMESTAMPED) {
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
 
@@ -1006,32 +1088,80 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	}
 
 	// Check length
-	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH) {
+	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH ||
+			dataOffset + length + (int32_t) UAVTALK_CHECKSUM_LENGTH > maxLen) {
 		return -1;
 	}
 
+	// Setup type and object id fields
+	objId = UAVObjGetID(obj);
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = type;
+	// data length inserted here below
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+
+	// Setup instance ID if one is required
+	if (!singleInstance) {
+		buf[8] = (uint8_t)(instId & 0xFF);
+		buf[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED) {
+		uint32_t time = PIOS_Thread_Systime();
+		buf[dataOffset - 2] = (uint8_t)(time & 0xFF);
+		buf[dataOffset - 1] = (uint8_t)((time >> 8) & 0xFF);
+	}
+
 	// Copy data (if any)
 	if (length > 0) {
-		if (UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0) {
+		if (UAVObjPack(obj, instId, &buf[dataOffset]) < 0) {
 			return -1;
 		}
 	}
 
 	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+	buf[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	buf[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
 
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	buf[dataOffset+length] = PIOS_CRC_updateCRC(0, buf, dataOffset+length);
+
+	return dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+}
+
+/**
+ * Send an object through the telemetry link.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES, use sendObject() instead)
+ * \param[in] type Transaction type
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type)
+{
+	if (!connection->outStream) return -1;
+
+	int32_t tx_msg_len = packSingleObject(obj, instId, type,
+			connection->txBuffer, UAVTALK_MAX_PACKET_LENGTH);
+
+	if (tx_msg_len < 0) {
+		return -1;
+	}
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
 	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
 
 	if (rc == tx_msg_len) {
 		// Update stats
 		++connection->stats.txObjects;
 		connection->stats.txBytes += tx_msg_len;
-		connection->stats.txObjectBytes += length;
+		if (type != UAVTALK_TYPE_OBJ_REQ && type != UAVTALK_TYPE_ACK) {
+			connection->stats.txObjectBytes += UAVObjGetNumBytes(obj);
+		}
 	}
 
 	// Done
@@ -49,6 +49,9 @@ enum bl_commands {
 	BL_MSG_STATUS_REQ,
 	BL_MSG_STATUS_REP,
 	BL_MSG_WIPE_PARTITION,
+	BL_MSG_SECTOR_CRC_REQ,
+	BL_MSG_SECTOR_CRC_REP,
+	BL_MSG_WRITE_RANGE_START,
 
 	BL_MSG_WRITE_START = 0x27,
 };
@@ -102,6 +105,8 @@ struct bl_messages {
 #define BL_CAP_EXTENSION_MAGIC 0x3456
 			uint16_t cap_extension_magic;
 			uint32_t partition_sizes[10];
+#define BL_CAP_FLAG_SECTOR_CRC 0x01	/* answers SECTOR_CRC_REQ */
+			uint8_t cap_flags;
 #endif	/* BL_INCLUDE_CAP_EXTENSIONS */
 		} cap_rep_specific;
 
@@ -154,6 +159,32 @@ struct bl_messages {
 			enum dfu_partition_label label;
 		} wipe_partition;
 
+		/* Extensions for delta uploads */
+		struct msg_sector_crc_req {
+			enum dfu_partition_label label;
+			uint16_t first_sector;
+		} sector_crc_req;
+
+#define SECTOR_CRCS_PER_PACKET 6
+		struct msg_sector_crc_rep {
+			enum dfu_partition_label label;
+			uint16_t first_sector;
+			uint16_t num_sectors;		/* in the whole partition */
+			uint8_t sectors_in_packet;
+			uint32_t first_sector_offset;
+			struct {
+				uint32_t length;	/* clipped to the writable size */
+				uint32_t crc;
+			} sectors[SECTOR_CRCS_PER_PACKET];
+		} sector_crc_rep;
+
+		struct msg_write_range_start {
+			enum dfu_partition_label label;
+			uint32_t offset;	/* must be sector aligned */
+			uint32_t length;	/* must be a multiple of 4 */
+			uint32_t expected_crc;
+		} write_range_start;
+
 		uint8_t pad[62];
 	} __attribute__((aligned(1)))v;
 } __attribute__((packed));
@@ -78,7 +78,7 @@ bool bl_xfer_crc_ok_p(const struct xfer_state * xfer)
 
 	uint32_t actual_crc = bl_compute_partition_crc(xfer->partition_id,
 						xfer->original_partition_offset,
-						xfer->partition_size);
+						xfer->crc_length);
 
 	return (actual_crc == xfer->crc);
 }
@@ -242,6 +242,8 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 		return false;
 	}
 
+	xfer->crc_length = xfer->partition_size;
+
 	/* Figure out if we need to erase the *selected* partition before writing to it */
 	if (partition_needs_erase) {
 		PIOS_FLASH_start_transaction(xfer->partition_id);
@@ -340,6 +342,172 @@ bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition)
 	return true;
 }
 
+/**
+ * @brief Find a partition that can be written sector by sector
+ * @param[in] label partition label from the host
+ * @param[out] partition_id flash partition backing the label
+ * @param[out] writable_size bytes the host may write, which excludes the
+ * firmware descriptor for the firmware partition
+ * @return true if the partition exists and supports range writes
+ */
+static bool bl_xfer_find_range_partition(uint8_t label, uintptr_t *partition_id, uint32_t *writable_size)
+{
+	const struct pios_board_info * bdinfo = &pios_board_info_blob;
+	enum pios_flash_partition_labels flash_label;
+	uint32_t reserved = 0;
+
+	switch (label) {
+#ifdef F1_UPGRADER
+	case DFU_PARTITION_BL:
+		flash_label = FLASH_PARTITION_LABEL_BL;
+		reserved    = bdinfo->desc_size;
+		break;
+#endif
+	case DFU_PARTITION_FW:
+		flash_label = FLASH_PARTITION_LABEL_FW;
+		reserved    = bdinfo->desc_size;
+		break;
+	case DFU_PARTITION_SETTINGS:
+		flash_label = FLASH_PARTITION_LABEL_SETTINGS;
+		break;
+	case DFU_PARTITION_AUTOTUNE:
+		flash_label = FLASH_PARTITION_LABEL_AUTOTUNE;
+		break;
+	case DFU_PARTITION_LOG:
+		flash_label = FLASH_PARTITION_LABEL_LOG;
+		break;
+	default:
+		return false;
+	}
+
+	if (PIOS_FLASH_find_partition_id(flash_label, partition_id) != 0)
+		return false;
+
+	if (PIOS_FLASH_get_partition_size(*partition_id, writable_size) != 0)
+		return false;
+
+	*writable_size -= reserved;
+
+	return true;
+}
+
+bool bl_xfer_send_sector_crcs(const struct msg_sector_crc_req *sector_crc_req)
+{
+	uintptr_t partition_id;
+	uint32_t writable_size;
+
+	if (!bl_xfer_find_range_partition(sector_crc_req->label, &partition_id, &writable_size))
+		return false;
+
+	uint16_t first_sector = BE16_TO_CPU(sector_crc_req->first_sector);
+
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_SECTOR_CRC_REP,
+		.v.sector_crc_rep = {
+			.label        = sector_crc_req->label,
+			.first_sector = sector_crc_req->first_sector,
+		},
+	};
+
+	/*
+	 * Walk every sector that holds writable data.  Only the ones the host
+	 * asked for get a CRC, the rest are just counted so the host knows
+	 * when to stop asking.
+	 */
+	uint16_t sector = 0;
+	uint32_t offset;
+	uint32_t size;
+	uint8_t n = 0;
+
+	while ((PIOS_FLASH_get_sector_info(partition_id, sector, &offset, &size) == 0) &&
+			(offset < writable_size)) {
+		if ((sector >= first_sector) && (n < SECTOR_CRCS_PER_PACKET)) {
+			uint32_t length = MIN(size, writable_size - offset);
+
+			if (n == 0)
+				msg.v.sector_crc_rep.first_sector_offset = CPU_TO_BE32(offset);
+
+			msg.v.sector_crc_rep.sectors[n].length = CPU_TO_BE32(length);
+			msg.v.sector_crc_rep.sectors[n].crc    =
+				CPU_TO_BE32(bl_compute_partition_crc(partition_id, offset, length));
+			n++;
+		}
+
+		sector++;
+	}
+
+	msg.v.sector_crc_rep.num_sectors       = CPU_TO_BE16(sector);
+	msg.v.sector_crc_rep.sectors_in_packet = n;
+
+	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+
+	return true;
+}
+
+bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_write_range_start *write_range_start)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	uint32_t writable_size;
+
+	if (!bl_xfer_find_range_partition(write_range_start->label, &xfer->partition_id, &writable_size))
+		return false;
+
+	uint32_t offset = BE32_TO_CPU(write_range_start->offset);
+	uint32_t length = BE32_TO_CPU(write_range_start->length);
+
+	if ((length == 0) || (length % sizeof(uint32_t)) ||
+			(offset > writable_size) || (length > writable_size - offset))
+		return false;
+
+	/*
+	 * Find the sectors covering the range.  The range has to start on a
+	 * sector boundary, but may end part way into a sector, in which case
+	 * the whole of that sector is erased.  For the firmware partition that
+	 * includes the descriptor, which the host writes again afterwards.
+	 */
+	uint32_t erase_start = 0;
+	uint32_t erase_end   = 0;
+	bool aligned = false;
+
+	uint32_t sector_offset;
+	uint32_t sector_size;
+
+	for (uint16_t sector = 0;
+			PIOS_FLASH_get_sector_info(xfer->partition_id, sector, &sector_offset, &sector_size) == 0;
+			sector++) {
+		if (sector_offset == offset) {
+			erase_start = sector_offset;
+			aligned = true;
+		}
+
+		if (aligned && (sector_offset < offset + length))
+			erase_end = sector_offset + sector_size;
+	}
+
+	if (!aligned)
+		return false;
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+	int32_t ret = PIOS_FLASH_erase_range(xfer->partition_id, erase_start, erase_end - erase_start);
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+	if (ret != 0)
+		return false;
+
+	xfer->partition_size            = writable_size;
+	xfer->original_partition_offset = offset;
+	xfer->current_partition_offset  = offset;
+	xfer->check_crc                 = true;
+	xfer->crc                       = BE32_TO_CPU(write_range_start->expected_crc);
+	xfer->crc_length                = length;
+	xfer->bytes_to_xfer             = length;
+	xfer->next_packet_number        = 0;
+	xfer->in_progress               = true;
+
+	return true;
+}
+
 bool bl_xfer_send_capabilities_self(void)
 {
 	/* Return capabilities of the specific device */
@@ -366,6 +534,7 @@ bool bl_xfer_send_capabilities_self(void)
 #if defined(BL_INCLUDE_CAP_EXTENSIONS)
 	/* Fill in capabilities extensions */
 	msg.v.cap_rep_specific.cap_extension_magic = BL_CAP_EXTENSION_MAGIC;
+	msg.v.cap_rep_specific.cap_flags = BL_CAP_FLAG_SECTOR_CRC;
 
 	uintptr_t partition_id;
 	uint32_t partition_size;
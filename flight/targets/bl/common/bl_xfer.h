@@ -43,6 +43,7 @@ struct xfer_state {
 	uint32_t next_packet_number;
 	bool     check_crc;
 	uint32_t crc;
+	uint32_t crc_length;
 
 	uint32_t bytes_to_xfer;
 };
@@ -54,6 +55,8 @@ extern bool bl_xfer_send_next_read_packet(struct xfer_state * xfer);
 extern bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start);
 extern bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont);
 extern bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition);
+extern bool bl_xfer_send_sector_crcs(const struct msg_sector_crc_req *sector_crc_req);
+extern bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_write_range_start *write_range_start);
 extern bool bl_xfer_send_capabilities_self(void);
 
 #endif	/* BL_XFER_H_ */
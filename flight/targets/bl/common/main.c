@@ -662,9 +662,21 @@ static void process_packet_rx(struct bl_fsm_context * context, const struct bl_m
 		bl_xfer_wipe_partition(&(msg->v.wipe_partition));
 		break;
 
+	case BL_MSG_SECTOR_CRC_REQ:
+		bl_xfer_send_sector_crcs(&(msg->v.sector_crc_req));
+		break;
+	case BL_MSG_WRITE_RANGE_START:
+		if (bl_xfer_write_range_start(&context->xfer, &(msg->v.write_range_start))) {
+			bl_fsm_inject_event(context, BL_EVENT_WRITE_START);
+		} else {
+			/* Failed to start the write */
+		}
+		break;
+
 	case BL_MSG_CAP_REP:
 	case BL_MSG_STATUS_REP:
 	case BL_MSG_READ_CONT:
+	case BL_MSG_SECTOR_CRC_REP:
 		/* We've received a *reply* packet when we expected a request. */
 		break;
 	case BL_MSG_RESERVED:
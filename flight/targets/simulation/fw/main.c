@@ -74,6 +74,8 @@ int main(int argc, char *argv[]) {
 	g_argc = argc;
 	g_argv = argv;
 
+	PIOS_SYS_EarlyArgs(argc, argv);
+
 	/* NOTE: Do NOT modify the following start-up sequence */
 	PIOS_heap_initialize_blocks();
 
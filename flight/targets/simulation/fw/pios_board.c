@@ -55,7 +55,7 @@
 void Stack_Change() {
 }
 
-const struct pios_tcp_cfg pios_tcp_telem_cfg = {
+struct pios_tcp_cfg pios_tcp_telem_cfg = {
   .ip = "0.0.0.0",
   .port = 9000,
 };
@@ -133,6 +133,11 @@ void PIOS_Board_Init(void) {
 	HwSparkyInitialize();
 	HwSimulationInitialize();
 
+	/* Lets several simulators run side by side */
+	if (PIOS_SYS_GetTelemetryPort()) {
+		pios_tcp_telem_cfg.port = PIOS_SYS_GetTelemetryPort();
+	}
+
 	uintptr_t pios_tcp_telem_rf_id;
 	if (PIOS_TCP_Init(&pios_tcp_telem_rf_id, &pios_tcp_telem_cfg)) {
 		PIOS_Assert(0);
@@ -99,6 +99,7 @@
 #define PIOS_INCLUDE_BMM150
 #define PIOS_INCLUDE_BMX055
 #define PIOS_INCLUDE_FLYINGPIO
+#define PIOS_INCLUDE_MPU
 #endif
 
 #endif /* PIOS_CONFIG_POSIX_H */
@@ -0,0 +1,377 @@
+/**
+ ******************************************************************************
+ * @file       bl_emulator.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Just enough of bl_emulator.c to build the bootloader transfer code
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * Runs the real bootloader transfer code (bl_xfer.c) on top of the real
+ * flash partition layer, backed by a RAM flash chip, and speaks the
+ * bootloader message protocol over a socket.  The command dispatch below
+ * mirrors process_packet_rx() in the bootloader's main.c.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pios.h"
+#include "pios_com_msg.h"
+#include "pios_board_info.h"
+#include "pios_flash_priv.h"
+
+#include "bl_messages.h"
+#include "bl_xfer.h"
+
+#include "bl_emulator.h"
+
+uint8_t bl_emu_flash[BL_EMU_FLASH_SIZE];
+
+uint32_t bl_emu_erase_count[BL_EMU_NUM_SECTORS];
+uint32_t bl_emu_bytes_written;
+uint32_t bl_emu_packets_received;
+
+const struct pios_board_info pios_board_info_blob = {
+	.magic      = PIOS_BOARD_INFO_BLOB_MAGIC,
+	.board_type = 0x7f,
+	.board_rev  = 1,
+	.bl_rev     = 1,
+	.hw_type    = 0,
+	.fw_base    = 0x08000000 + BL_EMU_FW_OFFSET,
+	.fw_size    = BL_EMU_FW_SIZE,
+	.desc_base  = 0x08000000 + BL_EMU_FW_OFFSET + BL_EMU_FW_SIZE,
+	.desc_size  = BL_EMU_DESC_SIZE,
+};
+
+/*
+ * Software model of the STM32 CRC unit: CRC-32 with polynomial 0x04C11DB7
+ * over 32-bit words, MSB first, no reflection or final xor.
+ */
+static uint32_t crc_dr;
+
+void CRC_ResetDR(void)
+{
+	crc_dr = 0xFFFFFFFF;
+}
+
+uint32_t CRC_CalcBlockCRC(uint32_t pBuffer[], uint32_t BufferLength)
+{
+	for (uint32_t i = 0; i < BufferLength; i++) {
+		crc_dr ^= pBuffer[i];
+
+		for (int bit = 0; bit < 32; bit++) {
+			if (crc_dr & 0x80000000)
+				crc_dr = (crc_dr << 1) ^ 0x04C11DB7;
+			else
+				crc_dr <<= 1;
+		}
+	}
+
+	return crc_dr;
+}
+
+uint32_t CRC_GetCRC(void)
+{
+	return crc_dr;
+}
+
+/*
+ * RAM flash chip
+ */
+static const struct pios_flash_sector_range emu_flash_sectors[] = {
+	{
+		.base_sector = 0,
+		.last_sector = 3,
+		.sector_size = FLASH_SECTOR_16KB,
+	},
+	{
+		.base_sector = 4,
+		.last_sector = 4,
+		.sector_size = FLASH_SECTOR_64KB,
+	},
+	{
+		.base_sector = 5,
+		.last_sector = 6,
+		.sector_size = FLASH_SECTOR_128KB,
+	},
+	{
+		.base_sector = 7,
+		.last_sector = 14,
+		.sector_size = FLASH_SECTOR_4KB,
+	},
+};
+
+static int32_t emu_flash_start_transaction(uintptr_t chip_id)
+{
+	return 0;
+}
+
+static int32_t emu_flash_end_transaction(uintptr_t chip_id)
+{
+	return 0;
+}
+
+static int32_t emu_flash_erase_sector(uintptr_t chip_id, uint32_t chip_sector, uint32_t chip_offset)
+{
+	for (uint8_t i = 0; i < NELEMENTS(emu_flash_sectors); i++) {
+		const struct pios_flash_sector_range *block = &emu_flash_sectors[i];
+
+		if ((chip_sector >= block->base_sector) && (chip_sector <= block->last_sector)) {
+			memset(&bl_emu_flash[chip_offset], 0xFF, block->sector_size);
+			bl_emu_erase_count[chip_sector]++;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+static int32_t emu_flash_write_data(uintptr_t chip_id, uint32_t chip_offset, const uint8_t *data, uint16_t len)
+{
+	if (chip_offset + len > sizeof(bl_emu_flash))
+		return -1;
+
+	/* Like NOR flash, programming can only clear bits */
+	for (uint16_t i = 0; i < len; i++)
+		bl_emu_flash[chip_offset + i] &= data[i];
+
+	bl_emu_bytes_written += len;
+
+	return 0;
+}
+
+static int32_t emu_flash_read_data(uintptr_t chip_id, uint32_t chip_offset, uint8_t *data, uint16_t len)
+{
+	if (chip_offset + len > sizeof(bl_emu_flash))
+		return -1;
+
+	memcpy(data, &bl_emu_flash[chip_offset], len);
+
+	return 0;
+}
+
+static const struct pios_flash_driver emu_flash_driver = {
+	.start_transaction = emu_flash_start_transaction,
+	.end_transaction   = emu_flash_end_transaction,
+	.erase_sector      = emu_flash_erase_sector,
+	.write_data        = emu_flash_write_data,
+	.read_data         = emu_flash_read_data,
+};
+
+static uintptr_t emu_flash_id;
+static const struct pios_flash_chip emu_flash_chip = {
+	.driver        = &emu_flash_driver,
+	.chip_id       = &emu_flash_id,
+	.page_size     = 256,
+	.sector_blocks = emu_flash_sectors,
+	.num_blocks    = NELEMENTS(emu_flash_sectors),
+};
+
+static const struct pios_flash_partition emu_partition_table[] = {
+	{
+		.label        = FLASH_PARTITION_LABEL_BL,
+		.chip_desc    = &emu_flash_chip,
+		.first_sector = 0,
+		.last_sector  = 1,
+		.chip_offset  = 0,
+		.size         = (1 - 0 + 1) * FLASH_SECTOR_16KB,
+	},
+	{
+		.label        = FLASH_PARTITION_LABEL_FW,
+		.chip_desc    = &emu_flash_chip,
+		.first_sector = 2,
+		.last_sector  = 6,
+		.chip_offset  = BL_EMU_FW_OFFSET,
+		.size         = BL_EMU_FW_PART_SIZE,
+	},
+	{
+		.label        = FLASH_PARTITION_LABEL_SETTINGS,
+		.chip_desc    = &emu_flash_chip,
+		.first_sector = 7,
+		.last_sector  = 14,
+		.chip_offset  = BL_EMU_SETTINGS_OFFSET,
+		.size         = BL_EMU_SETTINGS_SIZE,
+	},
+};
+
+/*
+ * Link to the host
+ */
+static int host_fd = -1;
+
+int32_t PIOS_COM_MSG_Send(uint32_t com_id, const uint8_t *msg, uint16_t msg_len)
+{
+	if (write(host_fd, msg, msg_len) != msg_len)
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Command dispatch.  The state reported to the host uses the legacy DFU
+ * state numbering, like the real bootloader does.
+ */
+enum emu_state {
+	EMU_DFU_IDLE             = 0,
+	EMU_DFU_WRITING          = 1,
+	EMU_DFU_LAST_OP_SUCCESS  = 5,
+	EMU_DFU_LAST_OP_FAILED   = 8,
+};
+
+static enum emu_state state;
+static struct xfer_state xfer;
+
+static void emu_send_status(void)
+{
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_STATUS_REP,
+		.v.status_rep = {
+			.current_state = state,
+		},
+	};
+
+	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+}
+
+static void emu_start_write(bool started)
+{
+	if (!started)
+		return;
+
+	/* Writes may only start from an idle bootloader */
+	if ((state == EMU_DFU_IDLE) || (state == EMU_DFU_LAST_OP_SUCCESS))
+		state = EMU_DFU_WRITING;
+}
+
+static void emu_process_packet(const struct bl_messages *msg)
+{
+	uint8_t command = msg->flags_command & BL_MSG_COMMAND_MASK;
+
+	switch (command) {
+	case BL_MSG_CAP_REQ:
+		if (msg->v.cap_req.device_number == 1)
+			bl_xfer_send_capabilities_self();
+		break;
+	case BL_MSG_ENTER_DFU:
+	case BL_MSG_OP_ABORT:
+		xfer.in_progress = false;
+		state = EMU_DFU_IDLE;
+		break;
+	case BL_MSG_WRITE_START:
+		emu_start_write(bl_xfer_write_start(&xfer, &(msg->v.xfer_start)));
+		break;
+	case BL_MSG_WRITE_RANGE_START:
+		emu_start_write(bl_xfer_write_range_start(&xfer, &(msg->v.write_range_start)));
+		break;
+	case BL_MSG_WRITE_CONT:
+		if (state == EMU_DFU_WRITING) {
+			if (!bl_xfer_write_cont(&xfer, &(msg->v.xfer_cont)))
+				state = EMU_DFU_LAST_OP_FAILED;
+		}
+		break;
+	case BL_MSG_OP_END:
+		if ((state == EMU_DFU_WRITING) && bl_xfer_completed_p(&xfer)) {
+			if (bl_xfer_crc_ok_p(&xfer))
+				state = EMU_DFU_LAST_OP_SUCCESS;
+			else
+				state = EMU_DFU_LAST_OP_FAILED;
+		}
+		break;
+	case BL_MSG_READ_START:
+		if (bl_xfer_read_start(&xfer, &(msg->v.xfer_start))) {
+			while (!bl_xfer_completed_p(&xfer) &&
+					bl_xfer_send_next_read_packet(&xfer))
+				;
+		}
+		break;
+	case BL_MSG_STATUS_REQ:
+		emu_send_status();
+		break;
+	case BL_MSG_WIPE_PARTITION:
+		bl_xfer_wipe_partition(&(msg->v.wipe_partition));
+		break;
+	case BL_MSG_SECTOR_CRC_REQ:
+		bl_xfer_send_sector_crcs(&(msg->v.sector_crc_req));
+		break;
+	default:
+		/* Ignore replies and unknown commands, like the bootloader */
+		break;
+	}
+}
+
+void bl_emulator_reset_counters(void)
+{
+	memset(bl_emu_erase_count, 0, sizeof(bl_emu_erase_count));
+	bl_emu_bytes_written = 0;
+	bl_emu_packets_received = 0;
+}
+
+uint32_t bl_emulator_total_erases(void)
+{
+	uint32_t total = 0;
+
+	for (uint8_t i = 0; i < BL_EMU_NUM_SECTORS; i++)
+		total += bl_emu_erase_count[i];
+
+	return total;
+}
+
+void bl_emulator_init(void)
+{
+	memset(bl_emu_flash, 0xFF, sizeof(bl_emu_flash));
+	memset(&xfer, 0, sizeof(xfer));
+	state = EMU_DFU_IDLE;
+
+	bl_emulator_reset_counters();
+
+	PIOS_FLASH_register_partition_table(emu_partition_table, NELEMENTS(emu_partition_table));
+}
+
+/**
+ * @brief Serve bootloader requests until the host hangs up
+ * @param[in] fd message oriented socket (e.g. SOCK_SEQPACKET) to the host
+ */
+void bl_emulator_serve(int fd)
+{
+	host_fd = fd;
+
+	struct bl_messages msg;
+
+	while (1) {
+		memset(&msg, 0, sizeof(msg));
+
+		if (read(fd, &msg, sizeof(msg)) <= 0)
+			break;
+
+		bl_emu_packets_received++;
+
+		emu_process_packet(&msg);
+	}
+
+	host_fd = -1;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * @file       bl_emulator.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Just enough of bl_emulator.h to build the bootloader transfer code
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef BL_EMULATOR_H
+#define BL_EMULATOR_H
+
+#include <stdint.h>
+
+/*
+ * Layout of the emulated chip, mimicking the mixed sector sizes of an F4:
+ *   sectors 0-1   16KB  bootloader
+ *   sectors 2-3   16KB  firmware
+ *   sector  4     64KB  firmware
+ *   sectors 5-6  128KB  firmware (descriptor at the very end)
+ *   sectors 7-14   4KB  settings
+ */
+#define BL_EMU_NUM_SECTORS      15
+#define BL_EMU_FLASH_SIZE       (416 * 1024)
+
+#define BL_EMU_FW_OFFSET        (32 * 1024)
+#define BL_EMU_FW_PART_SIZE     (352 * 1024)
+#define BL_EMU_DESC_SIZE        100
+#define BL_EMU_FW_SIZE          (BL_EMU_FW_PART_SIZE - BL_EMU_DESC_SIZE)
+
+#define BL_EMU_SETTINGS_OFFSET  (384 * 1024)
+#define BL_EMU_SETTINGS_SIZE    (32 * 1024)
+
+/* Contents of the emulated flash chip */
+extern uint8_t bl_emu_flash[BL_EMU_FLASH_SIZE];
+
+/* Accounting, so tests can tell how much work an upload did */
+extern uint32_t bl_emu_erase_count[BL_EMU_NUM_SECTORS];
+extern uint32_t bl_emu_bytes_written;
+extern uint32_t bl_emu_packets_received;
+
+void bl_emulator_init(void);
+void bl_emulator_reset_counters(void);
+uint32_t bl_emulator_total_erases(void);
+void bl_emulator_serve(int fd);
+
+#endif /* BL_EMULATOR_H */
+
+/**
+ * @}
+ * @}
+ */
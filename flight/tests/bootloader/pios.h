@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file       pios.h
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Just enough of pios.h to build the bootloader transfer code
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <pios_flash.h>
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+/* The emulator has a single link to the host */
+#define PIOS_COM_TELEM_USB 0
+
+/* Software model of the STM32 CRC unit, see bl_emulator.c */
+void CRC_ResetDR(void);
+uint32_t CRC_CalcBlockCRC(uint32_t pBuffer[], uint32_t BufferLength);
+uint32_t CRC_GetCRC(void);
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+#define CPU_TO_BE16(x) ( (((x) & 0xff00) >> 8) | \
+                         (((x) & 0x00ff) << 8) )
+#define CPU_TO_BE32(x) ( (((x) & 0xff000000) >> 24) | \
+                         (((x) & 0x00ff0000) >>  8) | \
+                         (((x) & 0x0000ff00) <<  8) | \
+                         (((x) & 0x000000ff) << 24) )
+
+#define BE16_TO_CPU(x) CPU_TO_BE16(x)
+#define BE32_TO_CPU(x) CPU_TO_BE32(x)
+
+#endif /* PIOS_H */
+
+/**
+ * @}
+ * @}
+ */
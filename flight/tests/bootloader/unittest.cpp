@@ -0,0 +1,480 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Just enough of unittest.cpp to build the bootloader transfer code
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+#include <poll.h>		/* poll */
+#include <sys/socket.h>		/* socketpair */
+#include <unistd.h>		/* read, write */
+
+#include <thread>
+#include <vector>
+
+extern "C" {
+
+#include "bl_messages.h"	/* struct bl_messages */
+#include "bl_emulator.h"	/* bl_emulator_* */
+
+}
+
+#define BE16(x) __builtin_bswap16(x)
+#define BE32(x) __builtin_bswap32(x)
+
+/* Legacy DFU states reported in status replies */
+#define DFU_IDLE            0
+#define DFU_WRITING         1
+#define DFU_LAST_OP_SUCCESS 5
+#define DFU_LAST_OP_FAILED  8
+
+struct sector {
+	uint32_t offset;
+	uint32_t length;
+	uint32_t crc;
+};
+
+/* Same CRC as the GCS computes, independent from the emulated CRC unit */
+static uint32_t stm32_crc(const uint8_t *data, uint32_t len)
+{
+	static const uint32_t table[16] = {
+		0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9,
+		0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+		0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61,
+		0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+	};
+
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (uint32_t i = 0; i < len; i += 4) {
+		crc ^= data[i] | (data[i + 1] << 8) | (data[i + 2] << 16) |
+			((uint32_t)data[i + 3] << 24);
+
+		for (int n = 0; n < 8; n++)
+			crc = (crc << 4) ^ table[crc >> 28];
+	}
+
+	return crc;
+}
+
+/* Drives the emulated bootloader over a socket, like the GCS does over USB */
+class BootloaderDelta : public testing::Test {
+protected:
+	virtual void SetUp() {
+		bl_emulator_init();
+
+		int sv[2];
+		ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv));
+
+		host_fd = sv[0];
+		emu_fd = sv[1];
+		emu = std::thread(bl_emulator_serve, emu_fd);
+	}
+
+	virtual void TearDown() {
+		shutdown(host_fd, SHUT_RDWR);
+		emu.join();
+
+		close(host_fd);
+		close(emu_fd);
+	}
+
+	void send(struct bl_messages *msg) {
+		ASSERT_EQ((ssize_t)sizeof(*msg), write(host_fd, msg, sizeof(*msg)));
+	}
+
+	bool receive(struct bl_messages *msg) {
+		struct pollfd pfd = { host_fd, POLLIN, 0 };
+
+		if (poll(&pfd, 1, 1000) != 1)
+			return false;
+
+		return read(host_fd, msg, sizeof(*msg)) == sizeof(*msg);
+	}
+
+	uint8_t status() {
+		struct bl_messages msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_STATUS_REQ;
+		send(&msg);
+
+		if (!receive(&msg) || (msg.flags_command != BL_MSG_STATUS_REP))
+			return 0xff;
+
+		return msg.v.status_rep.current_state;
+	}
+
+	bool sector_crcs(enum dfu_partition_label label, std::vector<struct sector> *sectors) {
+		sectors->clear();
+
+		uint16_t num_sectors = 1;
+
+		while (sectors->size() < num_sectors) {
+			struct bl_messages msg;
+			memset(&msg, 0, sizeof(msg));
+			msg.flags_command = BL_MSG_SECTOR_CRC_REQ;
+			msg.v.sector_crc_req.label = label;
+			msg.v.sector_crc_req.first_sector = BE16((uint16_t)sectors->size());
+			send(&msg);
+
+			if (!receive(&msg) || (msg.flags_command != BL_MSG_SECTOR_CRC_REP))
+				return false;
+
+			if (BE16(msg.v.sector_crc_rep.first_sector) != sectors->size())
+				return false;
+
+			num_sectors = BE16(msg.v.sector_crc_rep.num_sectors);
+
+			uint32_t offset = BE32(msg.v.sector_crc_rep.first_sector_offset);
+			for (int i = 0; i < msg.v.sector_crc_rep.sectors_in_packet; i++) {
+				struct sector s = {
+					offset,
+					BE32(msg.v.sector_crc_rep.sectors[i].length),
+					BE32(msg.v.sector_crc_rep.sectors[i].crc),
+				};
+				sectors->push_back(s);
+				offset += s.length;
+			}
+
+			if (msg.v.sector_crc_rep.sectors_in_packet == 0)
+				return false;
+		}
+
+		return true;
+	}
+
+	void send_data(const uint8_t *data, uint32_t len) {
+		struct bl_messages msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_WRITE_CONT;
+
+		for (uint32_t packet = 0; packet * XFER_BYTES_PER_PACKET < len; packet++) {
+			msg.v.xfer_cont.current_packet_number = BE32(packet);
+
+			/* Words go over the wire big endian */
+			for (uint32_t i = 0; i < XFER_BYTES_PER_PACKET; i += 4) {
+				uint32_t pos = packet * XFER_BYTES_PER_PACKET + i;
+
+				for (int b = 0; b < 4; b++)
+					msg.v.xfer_cont.data[i + b] = (pos < len) ? data[pos + 3 - b] : 0xff;
+			}
+
+			send(&msg);
+		}
+	}
+
+	uint8_t write_full(enum dfu_partition_label label, const std::vector<uint8_t> &image, uint32_t crc_size) {
+		std::vector<uint8_t> padded(image);
+		padded.resize(crc_size, 0xff);
+
+		uint32_t packets = (image.size() + XFER_BYTES_PER_PACKET - 1) / XFER_BYTES_PER_PACKET;
+		uint32_t last = image.size() - (packets - 1) * XFER_BYTES_PER_PACKET;
+
+		struct bl_messages msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_WRITE_START;
+		msg.v.xfer_start.packets_in_transfer = BE32(packets);
+		msg.v.xfer_start.label = label;
+		msg.v.xfer_start.words_in_last_packet = last / 4;
+		msg.v.xfer_start.expected_crc = BE32(stm32_crc(padded.data(), padded.size()));
+		send(&msg);
+
+		send_data(image.data(), image.size());
+
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_OP_END;
+		send(&msg);
+
+		return status();
+	}
+
+	uint8_t write_range(enum dfu_partition_label label, uint32_t offset, const uint8_t *data, uint32_t len, uint32_t crc) {
+		struct bl_messages msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_WRITE_RANGE_START;
+		msg.v.write_range_start.label = label;
+		msg.v.write_range_start.offset = BE32(offset);
+		msg.v.write_range_start.length = BE32(len);
+		msg.v.write_range_start.expected_crc = BE32(crc);
+		send(&msg);
+
+		uint8_t state = status();
+		if (state != DFU_WRITING)
+			return state;
+
+		send_data(data, len);
+
+		memset(&msg, 0, sizeof(msg));
+		msg.flags_command = BL_MSG_OP_END;
+		send(&msg);
+
+		return status();
+	}
+
+	/* Same algorithm as DFUObject::UploadPartitionDelta() in the GCS */
+	bool write_delta(enum dfu_partition_label label, const std::vector<uint8_t> &image, int *num_ranges) {
+		std::vector<struct sector> sectors;
+		if (!sector_crcs(label, &sectors))
+			return false;
+
+		const struct sector &last = sectors.back();
+		std::vector<uint8_t> padded(image);
+		padded.resize(last.offset + last.length, 0xff);
+
+		std::vector<bool> changed(sectors.size());
+		for (size_t i = 0; i < sectors.size(); i++) {
+			changed[i] = stm32_crc(&padded[sectors[i].offset], sectors[i].length) != sectors[i].crc;
+
+			if ((label == DFU_PARTITION_FW) && (i == sectors.size() - 1))
+				changed[i] = true;
+		}
+
+		*num_ranges = 0;
+
+		for (size_t i = 0; i < sectors.size(); ) {
+			if (!changed[i]) {
+				i++;
+				continue;
+			}
+
+			uint32_t offset = sectors[i].offset;
+			uint32_t length = 0;
+			while ((i < sectors.size()) && changed[i])
+				length += sectors[i++].length;
+
+			uint32_t crc = stm32_crc(&padded[offset], length);
+			if (write_range(label, offset, &padded[offset], length, crc) != DFU_LAST_OP_SUCCESS)
+				return false;
+
+			(*num_ranges)++;
+		}
+
+		return true;
+	}
+
+	std::vector<uint8_t> make_image(uint32_t size, uint32_t seed) {
+		std::vector<uint8_t> image(size);
+
+		for (uint32_t i = 0; i < size; i++) {
+			seed = seed * 1103515245 + 12345;
+			image[i] = seed >> 16;
+		}
+
+		return image;
+	}
+
+	bool fw_matches(const std::vector<uint8_t> &image) {
+		if (memcmp(&bl_emu_flash[BL_EMU_FW_OFFSET], image.data(), image.size()))
+			return false;
+
+		for (uint32_t i = image.size(); i < BL_EMU_FW_SIZE; i++) {
+			if (bl_emu_flash[BL_EMU_FW_OFFSET + i] != 0xff)
+				return false;
+		}
+
+		return true;
+	}
+
+	int host_fd;
+	int emu_fd;
+	std::thread emu;
+};
+
+TEST_F(BootloaderDelta, CapabilitiesAdvertiseSectorCRCs) {
+	struct bl_messages msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.flags_command = BL_MSG_CAP_REQ;
+	msg.v.cap_req.device_number = 1;
+	send(&msg);
+
+	ASSERT_TRUE(receive(&msg));
+	ASSERT_EQ(BL_MSG_CAP_REP, msg.flags_command);
+	EXPECT_EQ(BL_CAP_EXTENSION_MAGIC, msg.v.cap_rep_specific.cap_extension_magic);
+	EXPECT_TRUE(msg.v.cap_rep_specific.cap_flags & BL_CAP_FLAG_SECTOR_CRC);
+}
+
+TEST_F(BootloaderDelta, SectorCRCsCoverWritableFirmware) {
+	std::vector<uint8_t> image = make_image(200 * 1024, 1);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_FW, image, BL_EMU_FW_SIZE));
+
+	std::vector<struct sector> sectors;
+	ASSERT_TRUE(sector_crcs(DFU_PARTITION_FW, &sectors));
+
+	/* 16K 16K 64K 128K 128K, with the descriptor carved off the end */
+	ASSERT_EQ(5U, sectors.size());
+	EXPECT_EQ(0U, sectors[0].offset);
+	EXPECT_EQ(16U * 1024, sectors[1].offset);
+	EXPECT_EQ(64U * 1024, sectors[2].length);
+	EXPECT_EQ(224U * 1024, sectors[4].offset);
+	EXPECT_EQ(128U * 1024 - BL_EMU_DESC_SIZE, sectors[4].length);
+
+	for (size_t i = 0; i < sectors.size(); i++) {
+		EXPECT_EQ(stm32_crc(&bl_emu_flash[BL_EMU_FW_OFFSET + sectors[i].offset], sectors[i].length),
+				sectors[i].crc) << "sector " << i;
+	}
+}
+
+TEST_F(BootloaderDelta, ManySectorsSpanSeveralReplies) {
+	std::vector<struct sector> sectors;
+	ASSERT_TRUE(sector_crcs(DFU_PARTITION_SETTINGS, &sectors));
+
+	ASSERT_EQ(8U, sectors.size());
+	for (size_t i = 0; i < sectors.size(); i++) {
+		EXPECT_EQ(i * 4096, sectors[i].offset);
+		EXPECT_EQ(4096U, sectors[i].length);
+		EXPECT_EQ(stm32_crc(&bl_emu_flash[BL_EMU_SETTINGS_OFFSET + sectors[i].offset], 4096),
+				sectors[i].crc);
+	}
+}
+
+TEST_F(BootloaderDelta, UnchangedFirmwareOnlyRewritesDescriptorSector) {
+	std::vector<uint8_t> image = make_image(300 * 1024, 2);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_FW, image, BL_EMU_FW_SIZE));
+
+	/* A full upload erases every firmware sector */
+	EXPECT_EQ(5U, bl_emulator_total_erases());
+
+	/* The uploader writes the descriptor afterwards */
+	std::vector<uint8_t> desc = make_image(BL_EMU_DESC_SIZE, 3);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_DESC, desc, 0));
+
+	bl_emulator_reset_counters();
+
+	int ranges;
+	ASSERT_TRUE(write_delta(DFU_PARTITION_FW, image, &ranges));
+	EXPECT_EQ(1, ranges);
+	EXPECT_EQ(1U, bl_emulator_total_erases());
+	EXPECT_EQ(1U, bl_emu_erase_count[6]);
+	EXPECT_TRUE(fw_matches(image));
+
+	/* The descriptor sector was erased, so a new descriptor can go in */
+	desc = make_image(BL_EMU_DESC_SIZE, 4);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_DESC, desc, 0));
+	EXPECT_EQ(0, memcmp(&bl_emu_flash[BL_EMU_FW_OFFSET + BL_EMU_FW_SIZE], desc.data(), desc.size()));
+}
+
+TEST_F(BootloaderDelta, OnlyChangedSectorsAreWritten) {
+	std::vector<uint8_t> image = make_image(300 * 1024, 5);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_FW, image, BL_EMU_FW_SIZE));
+
+	bl_emulator_reset_counters();
+
+	/* Touch one byte in the 64K sector */
+	image[40 * 1024] ^= 0x55;
+
+	int ranges;
+	ASSERT_TRUE(write_delta(DFU_PARTITION_FW, image, &ranges));
+	EXPECT_EQ(2, ranges);
+	EXPECT_EQ(2U, bl_emulator_total_erases());
+	EXPECT_EQ(1U, bl_emu_erase_count[4]);
+	EXPECT_EQ(1U, bl_emu_erase_count[6]);
+	EXPECT_EQ(64U * 1024 + 128 * 1024 - BL_EMU_DESC_SIZE, bl_emu_bytes_written);
+	EXPECT_TRUE(fw_matches(image));
+}
+
+TEST_F(BootloaderDelta, AdjacentChangedSectorsAreMerged) {
+	std::vector<uint8_t> image = make_image(100 * 1024, 6);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_FW, image, BL_EMU_FW_SIZE));
+
+	bl_emulator_reset_counters();
+
+	/* Grow the image into the first 128K sector, and change sector 0 */
+	image = make_image(160 * 1024, 6);
+	image[0] ^= 0x01;
+
+	int ranges;
+	ASSERT_TRUE(write_delta(DFU_PARTITION_FW, image, &ranges));
+
+	/* Sector 0, then sectors 3..4 of the partition as one range */
+	EXPECT_EQ(2, ranges);
+	EXPECT_EQ(1U, bl_emu_erase_count[2]);
+	EXPECT_EQ(0U, bl_emu_erase_count[3]);
+	EXPECT_EQ(0U, bl_emu_erase_count[4]);
+	EXPECT_EQ(1U, bl_emu_erase_count[5]);
+	EXPECT_EQ(1U, bl_emu_erase_count[6]);
+	EXPECT_TRUE(fw_matches(image));
+}
+
+TEST_F(BootloaderDelta, UnchangedSettingsAreNotTouched) {
+	std::vector<uint8_t> image = make_image(10 * 1024, 7);
+	ASSERT_EQ(DFU_LAST_OP_SUCCESS, write_full(DFU_PARTITION_SETTINGS, image, BL_EMU_SETTINGS_SIZE));
+
+	bl_emulator_reset_counters();
+
+	int ranges;
+	ASSERT_TRUE(write_delta(DFU_PARTITION_SETTINGS, image, &ranges));
+	EXPECT_EQ(0, ranges);
+	EXPECT_EQ(0U, bl_emulator_total_erases());
+	EXPECT_EQ(0U, bl_emu_bytes_written);
+
+	/* Shrinking the image only needs the sectors it vacated erased */
+	image.resize(5 * 1024);
+	ASSERT_TRUE(write_delta(DFU_PARTITION_SETTINGS, image, &ranges));
+	EXPECT_EQ(1, ranges);
+	EXPECT_EQ(2U, bl_emulator_total_erases());
+	EXPECT_EQ(0, memcmp(&bl_emu_flash[BL_EMU_SETTINGS_OFFSET], image.data(), image.size()));
+	EXPECT_EQ(0xff, bl_emu_flash[BL_EMU_SETTINGS_OFFSET + image.size()]);
+}
+
+TEST_F(BootloaderDelta, MisalignedRangeIsRejected) {
+	std::vector<uint8_t> data(1024, 0);
+
+	EXPECT_EQ(DFU_IDLE, write_range(DFU_PARTITION_FW, 1024, data.data(), data.size(),
+				stm32_crc(data.data(), data.size())));
+	EXPECT_EQ(0U, bl_emulator_total_erases());
+}
+
+TEST_F(BootloaderDelta, RangePastWritableSizeIsRejected) {
+	std::vector<uint8_t> data(128 * 1024, 0);
+
+	/* Would overwrite the descriptor */
+	EXPECT_EQ(DFU_IDLE, write_range(DFU_PARTITION_FW, 224 * 1024, data.data(), data.size(),
+				stm32_crc(data.data(), data.size())));
+	EXPECT_EQ(0U, bl_emulator_total_erases());
+
+	/* Descriptor isn't sector based */
+	EXPECT_EQ(DFU_IDLE, write_range(DFU_PARTITION_DESC, 0, data.data(), 4,
+				stm32_crc(data.data(), 4)));
+}
+
+TEST_F(BootloaderDelta, RangeWithBadCRCFails) {
+	std::vector<uint8_t> data(16 * 1024, 0x5a);
+
+	EXPECT_EQ(DFU_LAST_OP_FAILED, write_range(DFU_PARTITION_FW, 0, data.data(), data.size(),
+				stm32_crc(data.data(), data.size()) ^ 1));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -104,3 +104,180 @@ TEST_F(EncodeDecode, Recover) {
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+extern "C" {
+
+#include <reedsolomon.h>
+
+}
+
+#include <time.h>
+
+// Test fixture for the reentrant codec, cross-checked against rscode.
+class ReedSolomon : public testing::Test {
+protected:
+  virtual void SetUp() {
+    initialize_ecc();
+    ASSERT_EQ(0, rs_init(&rs, RS_ECC_NPARITY));
+    srand(42);
+  }
+
+  virtual void TearDown() {
+  }
+
+  void random_packet(unsigned char *p, int len) {
+    for (int i = 0; i < len; i++)
+      p[i] = rand() & 0xff;
+  }
+
+  struct rs_codec rs;
+};
+
+TEST_F(ReedSolomon, BadInit) {
+  struct rs_codec bad;
+  EXPECT_EQ(-1, rs_init(&bad, 0));
+  EXPECT_EQ(-1, rs_init(&bad, RS_MAX_PARITY + 1));
+};
+
+TEST_F(ReedSolomon, CorrectEncode) {
+  unsigned char p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  rs_encode(&rs, p, 6, p + 6);
+  EXPECT_EQ(0x1f, p[6]);
+  EXPECT_EQ(0xa3, p[7]);
+  EXPECT_EQ(0x9a, p[8]);
+  EXPECT_EQ(0x3b, p[9]);
+  EXPECT_EQ(0, rs_decode(&rs, p, 10));
+};
+
+TEST_F(ReedSolomon, MatchesRscode) {
+  unsigned char p[RS_MAX_CODEWORD];
+  unsigned char p2[RS_MAX_CODEWORD];
+
+  for (int trial = 0; trial < 500; trial++) {
+    int len = 1 + rand() % (RS_MAX_CODEWORD - RS_ECC_NPARITY);
+
+    random_packet(p, len);
+    memcpy(p2, p, len);
+
+    encode_data(p, len, p);
+    rs_encode(&rs, p2, len, p2 + len);
+
+    for (int i = 0; i < len + RS_ECC_NPARITY; i++)
+      ASSERT_EQ(p[i], p2[i]);
+  }
+};
+
+TEST_F(ReedSolomon, BadLength) {
+  unsigned char p[RS_MAX_CODEWORD + 1] = {};
+  EXPECT_EQ(-1, rs_decode(&rs, p, RS_ECC_NPARITY));
+  EXPECT_EQ(-1, rs_decode(&rs, p, RS_MAX_CODEWORD + 1));
+};
+
+TEST_F(ReedSolomon, RecoverErrors) {
+  unsigned char p[RS_MAX_CODEWORD];
+  unsigned char p2[RS_MAX_CODEWORD];
+
+  for (int trial = 0; trial < 2000; trial++) {
+    int len = 1 + rand() % (RS_MAX_CODEWORD - RS_ECC_NPARITY);
+    int cw_len = len + RS_ECC_NPARITY;
+    int nerr = 1 + trial % (RS_ECC_NPARITY / 2);
+
+    random_packet(p, len);
+    rs_encode(&rs, p, len, p + len);
+    memcpy(p2, p, cw_len);
+
+    int pos[RS_ECC_NPARITY / 2];
+    for (int i = 0; i < nerr; i++) {
+      bool dup;
+      do {
+        pos[i] = rand() % cw_len;
+        dup = false;
+        for (int j = 0; j < i; j++)
+          dup |= pos[j] == pos[i];
+      } while (dup);
+
+      p2[pos[i]] ^= 1 + rand() % 255;
+    }
+
+    ASSERT_EQ(nerr, rs_decode(&rs, p2, cw_len));
+
+    for (int i = 0; i < cw_len; i++)
+      ASSERT_EQ(p[i], p2[i]);
+  }
+};
+
+TEST_F(ReedSolomon, RejectsUncorrectable) {
+  unsigned char p[64];
+  unsigned char p2[64];
+  int rejected = 0;
+
+  // Three errors exceed the capacity of four parity bytes.  The decoder
+  // either says so or lands on a different valid codeword; it must never
+  // claim success while leaving the buffer inconsistent.
+  for (int trial = 0; trial < 1000; trial++) {
+    random_packet(p, 60);
+    rs_encode(&rs, p, 60, p + 60);
+    memcpy(p2, p, sizeof(p2));
+
+    p2[3] ^= 0x11;
+    p2[30] ^= 0x22;
+    p2[61] ^= 0x33;
+
+    int ret = rs_decode(&rs, p2, sizeof(p2));
+    if (ret < 0) {
+      rejected++;
+    } else {
+      EXPECT_EQ(0, rs_decode(&rs, p2, sizeof(p2)));
+    }
+  }
+
+  EXPECT_GT(rejected, 900);
+};
+
+static double bench_seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Not a pass/fail test; reports decode throughput for both codecs on the
+// radio's typical packet size with one corrupted packet in eight.
+TEST_F(ReedSolomon, Benchmark) {
+  const int npackets = 256;
+  const int len = 64;
+  const int iterations = 40;
+  static unsigned char clean[npackets][len + RS_ECC_NPARITY];
+  static unsigned char work[npackets][len + RS_ECC_NPARITY];
+
+  for (int i = 0; i < npackets; i++) {
+    random_packet(clean[i], len);
+    rs_encode(&rs, clean[i], len, clean[i] + len);
+    if ((i % 8) == 0)
+      clean[i][rand() % (len + RS_ECC_NPARITY)] ^= 0x5a;
+  }
+
+  double start = bench_seconds();
+  for (int it = 0; it < iterations; it++) {
+    memcpy(work, clean, sizeof(work));
+    for (int i = 0; i < npackets; i++) {
+      decode_data(work[i], len + RS_ECC_NPARITY);
+      if (check_syndrome() != 0)
+        correct_errors_erasures(work[i], len + RS_ECC_NPARITY, 0, 0);
+    }
+  }
+  double old_time = bench_seconds() - start;
+
+  start = bench_seconds();
+  for (int it = 0; it < iterations; it++) {
+    memcpy(work, clean, sizeof(work));
+    for (int i = 0; i < npackets; i++)
+      rs_decode(&rs, work[i], len + RS_ECC_NPARITY);
+  }
+  double new_time = bench_seconds() - start;
+
+  fprintf(stdout, "rscode:      %.0f packets/s\n",
+      npackets * iterations / old_time);
+  fprintf(stdout, "reedsolomon: %.0f packets/s\n",
+      npackets * iterations / new_time);
+};
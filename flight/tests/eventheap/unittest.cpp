@@ -0,0 +1,320 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the periodic event heap
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "eventheap.h"
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+  return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+  free(buf);
+}
+
+}
+
+#define NUM_EVENTS 4000
+
+struct test_event {
+  struct eventheap_entry sched;
+  uint32_t fired;
+  uint32_t first;
+  uint32_t last;
+  uint32_t max_late;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class EventHeap : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1234);
+    ASSERT_EQ(0, eventheap_init(&heap, 0));
+    memset(events, 0, sizeof(events));
+  }
+
+  virtual void TearDown() {
+    free(heap.nodes);
+  }
+
+  // Heap order and back pointers
+  void checkHeap() {
+    for (uint16_t i = 0; i < heap.num; i++) {
+      ASSERT_EQ(i, heap.nodes[i]->pos);
+      ASSERT_NE(0, heap.nodes[i]->period);
+
+      if (i > 0) {
+        ASSERT_GE((int32_t) (heap.nodes[i]->deadline -
+              heap.nodes[(i - 1) / 2]->deadline), 0);
+      }
+    }
+  }
+
+  // Fire everything due at now, recording how late each one was
+  uint32_t tick(uint32_t now) {
+    struct eventheap_entry *entry;
+    uint32_t fired = 0;
+
+    while ((entry = eventheap_next_due(&heap, now)) != NULL) {
+      struct test_event *ev = (struct test_event *) entry;
+
+      // The deadline has already moved on; work out the one that fired
+      uint32_t due = ev->sched.deadline - ev->sched.period;
+      uint32_t late = now - due;
+
+      if (ev->fired == 0) {
+        ev->first = due;
+      }
+      if (late > ev->max_late) {
+        ev->max_late = late;
+      }
+
+      ev->last = due;
+      ev->fired++;
+      fired++;
+    }
+
+    return fired;
+  }
+
+  struct eventheap heap;
+  struct test_event events[NUM_EVENTS];
+};
+
+TEST_F(EventHeap, Empty) {
+  uint32_t deadline;
+
+  EXPECT_FALSE(eventheap_peek(&heap, &deadline));
+  EXPECT_EQ(NULL, eventheap_next_due(&heap, 0));
+  EXPECT_EQ(NULL, eventheap_next_due(&heap, 0x80000000));
+};
+
+TEST_F(EventHeap, OrderedByDeadline) {
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched, 1000,
+          rand() % 500));
+  }
+
+  checkHeap();
+
+  uint32_t deadline;
+  uint32_t prev = 0;
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(eventheap_peek(&heap, &deadline));
+    EXPECT_GE(deadline, prev);
+    prev = deadline;
+
+    struct eventheap_entry *entry = eventheap_next_due(&heap, deadline);
+    ASSERT_TRUE(entry != NULL);
+    EXPECT_EQ(deadline + 1000, entry->deadline);
+  }
+
+  // Everything moved on by a period
+  ASSERT_TRUE(eventheap_peek(&heap, &deadline));
+  EXPECT_GE(deadline, 1000u);
+};
+
+TEST_F(EventHeap, UpdateAndRemove) {
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched,
+          1 + rand() % 1000, rand() % 1000));
+  }
+
+  // Random reschedules and removals, checking the heap each time
+  for (int i = 0; i < 20000; i++) {
+    struct test_event *ev = &events[rand() % NUM_EVENTS];
+    uint16_t period = (rand() % 4) ? 1 + rand() % 1000 : 0;
+
+    ASSERT_EQ(0, eventheap_schedule(&heap, &ev->sched, period,
+          rand() % 1000));
+
+    if (i % 1000 == 0) {
+      checkHeap();
+    }
+  }
+
+  checkHeap();
+
+  uint16_t scheduled = 0;
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    if (events[i].sched.period) {
+      scheduled++;
+    }
+  }
+
+  EXPECT_EQ(scheduled, heap.num);
+};
+
+TEST_F(EventHeap, NoDriftOrJitter) {
+  const uint32_t duration = 20000;
+
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched,
+          5 + rand() % 1000, rand() % 1000));
+  }
+
+  // Ticking every ms, everything fires exactly on time
+  for (uint32_t now = 0; now < duration; now++) {
+    tick(now);
+  }
+
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    struct test_event *ev = &events[i];
+
+    EXPECT_EQ(0u, ev->max_late);
+    EXPECT_EQ((ev->last - ev->first) / ev->sched.period + 1, ev->fired);
+    EXPECT_EQ(0u, (ev->last - ev->first) % ev->sched.period);
+    EXPECT_GT(ev->sched.period + ev->last, duration - 1);
+  }
+};
+
+TEST_F(EventHeap, LateTicksKeepPhase) {
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched,
+          5 + rand() % 1000, rand() % 1000));
+  }
+
+  uint32_t start[NUM_EVENTS];
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    start[i] = events[i].sched.deadline;
+  }
+
+  // Irregular wakeups, sometimes a long way late
+  uint32_t now = 0;
+  while (now < 30000) {
+    now += 1 + rand() % ((rand() % 50) ? 20 : 3000);
+    tick(now);
+  }
+
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    struct test_event *ev = &events[i];
+
+    // Each firing is a whole number of periods from the first deadline,
+    // and no firing is more than one tick's gap late
+    EXPECT_EQ(0u, (ev->sched.deadline - start[i]) % ev->sched.period);
+    EXPECT_GT(ev->sched.deadline, now);
+    EXPECT_LE(ev->sched.deadline, now + ev->sched.period);
+    EXPECT_LT(ev->max_late, 3000u);
+  }
+};
+
+TEST_F(EventHeap, WrapsAround) {
+  const uint32_t start = 0xFFFFF000;
+
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched,
+          10 + i, start + i));
+  }
+
+  for (uint32_t t = 0; t < 20000; t++) {
+    tick(start + t);
+  }
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(0u, events[i].max_late);
+    EXPECT_EQ((20000u - i - 1) / (10 + i) + 1, events[i].fired);
+  }
+};
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+TEST_F(EventHeap, TickCost) {
+  const uint32_t duration = 10000;
+
+  for (int i = 0; i < NUM_EVENTS; i++) {
+    ASSERT_EQ(0, eventheap_schedule(&heap, &events[i].sched,
+          100 + rand() % 1000, rand() % 1000));
+  }
+
+  uint32_t fired = 0;
+
+  double start = now_ns();
+  for (uint32_t now = 0; now < duration; now++) {
+    fired += tick(now);
+  }
+  double per_tick = (now_ns() - start) / duration;
+  double per_event = (now_ns() - start) / fired;
+
+  // What visiting every event on every tick costs, as the list walk did
+  volatile uint32_t sink = 0;
+
+  start = now_ns();
+  for (uint32_t now = 0; now < 1000; now++) {
+    for (int i = 0; i < NUM_EVENTS; i++) {
+      if ((int32_t) (events[i].sched.deadline - now) <= 0) {
+        sink++;
+      }
+    }
+  }
+  double walk = (now_ns() - start) / 1000;
+
+  // A wakeup with nothing due only looks at the root
+  uint32_t deadline;
+  ASSERT_TRUE(eventheap_peek(&heap, &deadline));
+
+  start = now_ns();
+  for (int i = 0; i < 100000; i++) {
+    sink += eventheap_next_due(&heap, deadline - 1) != NULL;
+  }
+  double idle = (now_ns() - start) / 100000;
+
+  printf("%u events: %.0f ns per tick, %.0f ns per event fired, "
+      "%.0f ns idle, %.0f ns to walk them all\n",
+      NUM_EVENTS, per_tick, per_event, idle, walk);
+
+  // Firing is logarithmic in the number of events, not linear
+  EXPECT_LT(per_event * 10, walk);
+  EXPECT_LT(idle * 100, walk);
+};
+
+/**
+ * @}
+ * @}
+ */
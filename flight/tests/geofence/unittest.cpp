@@ -0,0 +1,302 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the polygon geofence index
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* fabs */
+#include <time.h>		/* clock_gettime */
+
+extern "C" {
+
+#include "geofence_index.h"
+
+}
+
+// Reference implementation: every edge of every polygon, in double
+struct ref_polygon {
+  int n;
+  double north[GEOFENCE_INDEX_MAX_EDGES];
+  double east[GEOFENCE_INDEX_MAX_EDGES];
+};
+
+static bool ref_inside(const struct ref_polygon *p, double n, double e)
+{
+  bool inside = false;
+
+  for (int i = 0, j = p->n - 1; i < p->n; j = i++) {
+    if ((p->east[i] > e) != (p->east[j] > e)) {
+      double cross_n = p->north[i] + (e - p->east[i]) *
+        (p->north[j] - p->north[i]) / (p->east[j] - p->east[i]);
+      if (n < cross_n) {
+        inside = !inside;
+      }
+    }
+  }
+
+  return inside;
+}
+
+static double ref_distance(const struct ref_polygon *p, double n, double e)
+{
+  double best = INFINITY;
+
+  for (int i = 0, j = p->n - 1; i < p->n; j = i++) {
+    double dn = p->north[i] - p->north[j];
+    double de = p->east[i] - p->east[j];
+    double len2 = dn * dn + de * de;
+    double t = len2 > 0 ? ((n - p->north[j]) * dn + (e - p->east[j]) * de) / len2 : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    double rn = n - (p->north[j] + t * dn);
+    double re = e - (p->east[j] + t * de);
+    best = fmin(best, sqrt(rn * rn + re * re));
+  }
+
+  return best;
+}
+
+static double frand(double lo, double hi)
+{
+  return lo + (hi - lo) * (rand() / (double) RAND_MAX);
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class GeofenceIndex : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1234);
+    geofence_index_clear(&idx);
+    num_ref = 0;
+  }
+
+  virtual void TearDown() {
+  }
+
+  int32_t addPolygon(const float *north, const float *east, uint8_t n, bool exclusion) {
+    int32_t ret = geofence_index_add_polygon(&idx, north, east, n, exclusion);
+
+    if (ret == 0) {
+      ref[num_ref].n = n;
+      for (int i = 0; i < n; i++) {
+        ref[num_ref].north[i] = north[i];
+        ref[num_ref].east[i] = east[i];
+      }
+      num_ref++;
+    }
+
+    return ret;
+  }
+
+  // A concave star around (cn, ce), which exercises edges in every direction
+  int32_t addStar(float cn, float ce, float r_in, float r_out, uint8_t n, bool exclusion) {
+    float north[GEOFENCE_INDEX_MAX_EDGES], east[GEOFENCE_INDEX_MAX_EDGES];
+
+    for (int i = 0; i < n; i++) {
+      float r = (i % 2) ? r_in : r_out;
+      float a = 2 * M_PI * i / n + 0.1f;
+      north[i] = cn + r * cosf(a);
+      east[i] = ce + r * sinf(a);
+    }
+
+    return addPolygon(north, east, n, exclusion);
+  }
+
+  // Compare against the reference at random points, skipping any so
+  // close to an edge that float and double may legitimately disagree
+  void checkRandom(int points, double lo, double hi) {
+    for (int i = 0; i < points; i++) {
+      double n = frand(lo, hi), e = frand(lo, hi);
+
+      uint8_t expected = 0;
+      double dist = INFINITY;
+
+      for (int p = 0; p < num_ref; p++) {
+        if (ref_inside(&ref[p], n, e)) {
+          expected |= 1 << p;
+        }
+        dist = fmin(dist, ref_distance(&ref[p], n, e));
+      }
+
+      if (dist > 1e-3) {
+        ASSERT_EQ(expected, geofence_index_inside(&idx, n, e))
+          << "at " << n << ", " << e;
+      }
+
+      EXPECT_NEAR(fmin(dist, idx.margin), geofence_index_distance(&idx, n, e), 1e-3)
+        << "at " << n << ", " << e;
+    }
+  }
+
+  struct geofence_index idx;
+  struct ref_polygon ref[GEOFENCE_INDEX_MAX_POLYGONS];
+  int num_ref;
+};
+
+TEST_F(GeofenceIndex, Empty) {
+  geofence_index_build(&idx, 20);
+
+  EXPECT_EQ(GEOFENCE_INDEX_CLEAR, geofence_index_check(&idx, 0, 0));
+  EXPECT_EQ(GEOFENCE_INDEX_CLEAR, geofence_index_check(&idx, 1e6, -1e6));
+  EXPECT_EQ(0, geofence_index_inside(&idx, 0, 0));
+};
+
+TEST_F(GeofenceIndex, RejectsBadPolygons) {
+  const float north[] = { 0, 100, 100 };
+  const float east[] = { 0, 0, 100 };
+
+  EXPECT_EQ(-1, addPolygon(north, east, 2, false));
+
+  for (int i = 0; i < GEOFENCE_INDEX_MAX_POLYGONS; i++) {
+    EXPECT_EQ(0, addPolygon(north, east, 3, false));
+  }
+
+  EXPECT_EQ(-1, addPolygon(north, east, 3, false));
+};
+
+TEST_F(GeofenceIndex, InclusionSquare) {
+  const float north[] = { -100, -100, 100, 100 };
+  const float east[] = { -100, 100, 100, -100 };
+
+  ASSERT_EQ(0, addPolygon(north, east, 4, false));
+  geofence_index_build(&idx, 20);
+  EXPECT_TRUE(idx.gridded);
+
+  EXPECT_EQ(GEOFENCE_INDEX_CLEAR, geofence_index_check(&idx, 0, 0));
+  EXPECT_EQ(GEOFENCE_INDEX_CLEAR, geofence_index_check(&idx, 79, -79));
+  EXPECT_EQ(GEOFENCE_INDEX_NEAR, geofence_index_check(&idx, 90, 0));
+  EXPECT_EQ(GEOFENCE_INDEX_NEAR, geofence_index_check(&idx, 0, -95));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, 101, 0));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, 0, 150));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, 1e6, 1e6));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, NAN, 0));
+
+  EXPECT_NEAR(10, geofence_index_distance(&idx, 90, 0), 1e-4);
+  EXPECT_NEAR(20, geofence_index_distance(&idx, 0, 0), 1e-4);
+};
+
+TEST_F(GeofenceIndex, ExclusionInsideInclusion) {
+  const float north[] = { -500, -500, 500, 500 };
+  const float east[] = { -500, 500, 500, -500 };
+
+  ASSERT_EQ(0, addPolygon(north, east, 4, false));
+  ASSERT_EQ(0, addStar(200, 200, 50, 100, 10, true));
+  geofence_index_build(&idx, 10);
+
+  EXPECT_EQ(GEOFENCE_INDEX_CLEAR, geofence_index_check(&idx, 0, 0));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, 200, 200));
+  EXPECT_EQ(GEOFENCE_INDEX_VIOLATION, geofence_index_check(&idx, 600, 0));
+  EXPECT_EQ(0x3, geofence_index_inside(&idx, 200, 200));
+  EXPECT_EQ(0x1, geofence_index_inside(&idx, -200, -200));
+
+  checkRandom(20000, -700, 700);
+};
+
+TEST_F(GeofenceIndex, MatchesBruteForce) {
+  // Overlapping concave polygons of both kinds, filling the index
+  for (int p = 0; p < GEOFENCE_INDEX_MAX_POLYGONS; p++) {
+    ASSERT_EQ(0, addStar(frand(-400, 400), frand(-400, 400),
+          frand(50, 150), frand(200, 400), 16, p % 2));
+  }
+
+  for (float margin = 0; margin <= 40; margin += 20) {
+    geofence_index_build(&idx, margin);
+    EXPECT_TRUE(idx.gridded);
+
+    checkRandom(50000, -1000, 1000);
+  }
+};
+
+TEST_F(GeofenceIndex, FallbackWithoutGrid) {
+  for (int p = 0; p < GEOFENCE_INDEX_MAX_POLYGONS; p++) {
+    ASSERT_EQ(0, addStar(frand(-400, 400), frand(-400, 400),
+          frand(50, 150), frand(200, 400), 16, p % 2));
+  }
+
+  // A margin this wide puts every edge in every cell
+  geofence_index_build(&idx, 5000);
+  EXPECT_FALSE(idx.gridded);
+
+  checkRandom(5000, -1000, 1000);
+};
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+TEST_F(GeofenceIndex, CheckCost) {
+  for (int p = 0; p < GEOFENCE_INDEX_MAX_POLYGONS; p++) {
+    ASSERT_EQ(0, addStar(frand(-400, 400), frand(-400, 400),
+          frand(50, 150), frand(200, 400), 16, p % 2));
+  }
+
+  geofence_index_build(&idx, 20);
+  ASSERT_TRUE(idx.gridded);
+
+  // Edges a query looks at, averaged over the cells
+  double per_cell = idx.cell_start[GEOFENCE_INDEX_CELLS] / (double) GEOFENCE_INDEX_CELLS;
+  printf("%d edges, %.1f per cell on average\n", idx.num_edges, per_cell);
+  EXPECT_LT(per_cell, idx.num_edges / 8.0);
+
+  const int points = 200000;
+  float *pts = (float *) malloc(2 * points * sizeof(float));
+  for (int i = 0; i < 2 * points; i++) {
+    pts[i] = frand(-800, 800);
+  }
+
+  volatile int sink = 0;
+
+  double start = now_ns();
+  for (int i = 0; i < points; i++) {
+    sink += geofence_index_check(&idx, pts[2 * i], pts[2 * i + 1]);
+  }
+  double gridded = (now_ns() - start) / points;
+
+  idx.gridded = false;
+
+  start = now_ns();
+  for (int i = 0; i < points; i++) {
+    sink += geofence_index_check(&idx, pts[2 * i], pts[2 * i + 1]);
+  }
+  double brute = (now_ns() - start) / points;
+
+  free(pts);
+
+  printf("check: %.0f ns indexed, %.0f ns brute force\n", gridded, brute);
+  EXPECT_LT(gridded * 3, brute);
+};
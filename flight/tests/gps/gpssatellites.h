@@ -0,0 +1,19 @@
+/* The parts of the generated header the GPS parsers use */
+#ifndef GPSSATELLITES_H
+#define GPSSATELLITES_H
+
+#include <stdint.h>
+
+#define GPSSATELLITES_PRN_NUMELEM 30
+
+typedef struct {
+	int16_t Azimuth[30];
+	uint8_t SatsInView;
+	uint8_t PRN[30];
+	int8_t Elevation[30];
+	int8_t SNR[30];
+} GPSSatellitesData;
+
+int32_t GPSSatellitesSet(const GPSSatellitesData *dataIn);
+
+#endif /* GPSSATELLITES_H */
@@ -0,0 +1,16 @@
+/* The parts of the generated header the GPS parsers use */
+#ifndef GPSVELOCITY_H
+#define GPSVELOCITY_H
+
+#include <stdint.h>
+
+typedef struct {
+	float North;
+	float East;
+	float Down;
+	float Accuracy;
+} GPSVelocityData;
+
+int32_t GPSVelocitySet(const GPSVelocityData *dataIn);
+
+#endif /* GPSVELOCITY_H */
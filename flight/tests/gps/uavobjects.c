@@ -0,0 +1,87 @@
+/* Stand-ins for the UAVOs the GPS parsers update, recording what's set */
+
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gpstime.h"
+#include "gpssatellites.h"
+#include "ubloxinfo.h"
+
+#include <string.h>
+
+GPSPositionData gpsposition_last;
+uint32_t gpsposition_sets;
+
+GPSVelocityData gpsvelocity_last;
+uint32_t gpsvelocity_sets;
+
+GPSTimeData gpstime_last;
+uint32_t gpstime_sets;
+
+GPSSatellitesData gpssatellites_last;
+uint32_t gpssatellites_sets;
+
+UBloxInfoData ubloxinfo_last;
+
+void uavobjects_reset(void)
+{
+	memset(&gpsposition_last, 0, sizeof(gpsposition_last));
+	gpsposition_sets = 0;
+	memset(&gpsvelocity_last, 0, sizeof(gpsvelocity_last));
+	gpsvelocity_sets = 0;
+	memset(&gpstime_last, 0, sizeof(gpstime_last));
+	gpstime_sets = 0;
+	memset(&gpssatellites_last, 0, sizeof(gpssatellites_last));
+	gpssatellites_sets = 0;
+	memset(&ubloxinfo_last, 0, sizeof(ubloxinfo_last));
+}
+
+int32_t GPSPositionSet(const GPSPositionData *dataIn)
+{
+	gpsposition_last = *dataIn;
+	gpsposition_sets++;
+	return 0;
+}
+
+int32_t GPSVelocitySet(const GPSVelocityData *dataIn)
+{
+	gpsvelocity_last = *dataIn;
+	gpsvelocity_sets++;
+	return 0;
+}
+
+int32_t GPSTimeGet(GPSTimeData *dataOut)
+{
+	*dataOut = gpstime_last;
+	return 0;
+}
+
+int32_t GPSTimeSet(const GPSTimeData *dataIn)
+{
+	gpstime_last = *dataIn;
+	gpstime_sets++;
+	return 0;
+}
+
+int32_t GPSSatellitesSet(const GPSSatellitesData *dataIn)
+{
+	gpssatellites_last = *dataIn;
+	gpssatellites_sets++;
+	return 0;
+}
+
+int32_t UBloxInfoGet(UBloxInfoData *dataOut)
+{
+	*dataOut = ubloxinfo_last;
+	return 0;
+}
+
+int32_t UBloxInfoSet(const UBloxInfoData *dataIn)
+{
+	ubloxinfo_last = *dataIn;
+	return 0;
+}
+
+void UBloxInfoParseErrorsSet(uint32_t *NewParseErrors)
+{
+	ubloxinfo_last.ParseErrors = *NewParseErrors;
+}
@@ -0,0 +1,17 @@
+/* The parts of the generated header the GPS parsers use */
+#ifndef UBLOXINFO_H
+#define UBLOXINFO_H
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t swVersion;
+	uint32_t ParseErrors;
+	uint16_t hwVersion;
+} UBloxInfoData;
+
+int32_t UBloxInfoGet(UBloxInfoData *dataOut);
+int32_t UBloxInfoSet(const UBloxInfoData *dataIn);
+void UBloxInfoParseErrorsSet(uint32_t *NewParseErrors);
+
+#endif /* UBLOXINFO_H */
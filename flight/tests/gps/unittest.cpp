@@ -0,0 +1,681 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test and benchmark for the UBX and NMEA stream parsers
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+#include <vector>
+
+extern "C" {
+
+#include "pios.h"
+#include "GPS.h"
+#include "NMEA.h"
+
+/* UBX.h has a member named class, so can't be included from C++ */
+int parse_ubx_stream(uint8_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+int parse_ubx_buffer(const uint8_t *, uint16_t, char *, GPSPositionData *, struct GPS_RX_STATS *);
+
+void uavobjects_reset(void);
+
+extern GPSPositionData gpsposition_last;
+extern uint32_t gpsposition_sets;
+extern uint32_t gpsvelocity_sets;
+extern uint32_t gpstime_sets;
+extern GPSSatellitesData gpssatellites_last;
+extern uint32_t gpssatellites_sets;
+
+}
+
+typedef std::vector<uint8_t> stream_t;
+
+/* Big enough for a struct UBXPacket, suitably aligned */
+static uint32_t rx_words[256];
+static char *rx_buffer = (char *) rx_words;
+
+/* The UBX parser drops any message older than the last one it saw, so
+ * every stream generated carries on in time from the one before */
+static uint32_t next_tow = 100000;
+
+/* Put little endian values, as UBX has them */
+static void put8(stream_t &out, uint8_t v)
+{
+  out.push_back(v);
+}
+
+static void put16(stream_t &out, uint16_t v)
+{
+  out.push_back(v & 0xff);
+  out.push_back(v >> 8);
+}
+
+static void put32(stream_t &out, uint32_t v)
+{
+  put16(out, v & 0xffff);
+  put16(out, v >> 16);
+}
+
+static void ubx_frame(stream_t &out, uint8_t cls, uint8_t id, const stream_t &payload)
+{
+  stream_t body;
+
+  put8(body, cls);
+  put8(body, id);
+  put16(body, payload.size());
+  body.insert(body.end(), payload.begin(), payload.end());
+
+  uint8_t ck_a = 0, ck_b = 0;
+
+  for (size_t i = 0; i < body.size(); i++) {
+    ck_a += body[i];
+    ck_b += ck_a;
+  }
+
+  put8(out, 0xb5);
+  put8(out, 0x62);
+  out.insert(out.end(), body.begin(), body.end());
+  put8(out, ck_a);
+  put8(out, ck_b);
+}
+
+/* What epoch k reports */
+static int32_t epoch_lat(uint32_t k)
+{
+  return 473977000 + 7 * k;
+}
+
+static int32_t epoch_lon(uint32_t k)
+{
+  return 85456000 + 11 * k;
+}
+
+static int32_t epoch_hmsl_mm(uint32_t k)
+{
+  return 450000 + 10 * k;
+}
+
+#define UBX_MSGS_PER_EPOCH 6
+
+/* The navigation solution a u-blox 6 sends each epoch, and SVINFO once a
+ * second */
+static void ubx_epoch(stream_t &out, uint32_t tow, uint32_t k, bool svinfo)
+{
+  stream_t p;
+
+  /* NAV-SOL first, as it sets the fix the others depend on */
+  put32(p, tow);
+  put32(p, 0);                  /* fTOW */
+  put16(p, 1890);               /* week */
+  put8(p, 0x03);                /* 3D fix */
+  put8(p, 0x0d);                /* fix ok, week and TOW set */
+  put32(p, 428000000);          /* ECEF, cm */
+  put32(p, 64000000);
+  put32(p, 467000000);
+  put32(p, 180);                /* pAcc */
+  put32(p, 1);
+  put32(p, -2);
+  put32(p, 3);
+  put32(p, 40);                 /* sAcc */
+  put16(p, 120);                /* pDOP */
+  put8(p, 0);
+  put8(p, 12);                  /* numSV */
+  put32(p, 0);
+  ubx_frame(out, 0x01, 0x06, p);
+
+  p.clear();
+  put32(p, tow);
+  put32(p, epoch_lon(k));
+  put32(p, epoch_lat(k));
+  put32(p, epoch_hmsl_mm(k) + 47000);
+  put32(p, epoch_hmsl_mm(k));
+  put32(p, 1500);
+  put32(p, 2500);
+  ubx_frame(out, 0x01, 0x02, p);
+
+  p.clear();
+  put32(p, tow);
+  put8(p, 0x03);
+  put8(p, 0x0d);
+  put8(p, 0);
+  put8(p, 0);
+  put32(p, 30000);              /* ttff */
+  put32(p, tow);                /* msss */
+  ubx_frame(out, 0x01, 0x03, p);
+
+  p.clear();
+  put32(p, tow);
+  put32(p, 120 + k % 7);        /* velN, cm/s */
+  put32(p, -35);
+  put32(p, 4);
+  put32(p, 126);
+  put32(p, 125);
+  put32(p, 1600000 + 100 * k);  /* heading */
+  put32(p, 40);
+  put32(p, 50000);
+  ubx_frame(out, 0x01, 0x12, p);
+
+  p.clear();
+  put32(p, tow);
+  put16(p, 180);                /* g, p, t, v, h, n, eDOP */
+  put16(p, 120);
+  put16(p, 100);
+  put16(p, 150);
+  put16(p, 90);
+  put16(p, 60);
+  put16(p, 70);
+  ubx_frame(out, 0x01, 0x04, p);
+
+  p.clear();
+  put32(p, tow);
+  put32(p, 30);                 /* tAcc */
+  put32(p, 0);                  /* nano */
+  put16(p, 2016);
+  put8(p, 6);
+  put8(p, 12);
+  put8(p, (tow / 3600000) % 24);
+  put8(p, (tow / 60000) % 60);
+  put8(p, (tow / 1000) % 60);
+  put8(p, 0x07);
+  ubx_frame(out, 0x01, 0x21, p);
+
+  if (svinfo) {
+    p.clear();
+    put32(p, tow);
+    put8(p, 16);                /* numCh */
+    put8(p, 0x04);
+    put16(p, 0);
+
+    for (uint8_t ch = 0; ch < 16; ch++) {
+      put8(p, ch);
+      put8(p, ch * 2 + 1);      /* svid */
+      put8(p, ch < 12 ? 0x0d : 0x04);
+      put8(p, 7);
+      put8(p, ch < 14 ? 30 + ch : 0);
+      put8(p, 10 + ch * 5);
+      put16(p, ch * 22);
+      put32(p, 0);
+    }
+
+    ubx_frame(out, 0x01, 0x30, p);
+  }
+}
+
+/* seconds of UBX at the given solution rate */
+static stream_t ubx_stream(uint32_t seconds, uint32_t rate_hz)
+{
+  stream_t out;
+  uint32_t epochs = seconds * rate_hz;
+
+  for (uint32_t k = 0; k < epochs; k++) {
+    ubx_epoch(out, next_tow, k, (k % rate_hz) == 0);
+    next_tow += 1000 / rate_hz;
+  }
+
+  return out;
+}
+
+static void nmea_sentence(stream_t &out, const char *body)
+{
+  uint8_t checksum = 0;
+
+  for (const char *c = body; *c; c++) {
+    checksum ^= *c;
+  }
+
+  char sentence[128];
+  int len = snprintf(sentence, sizeof(sentence), "$%s*%02X\r\n", body, checksum);
+
+  out.insert(out.end(), sentence, sentence + len);
+}
+
+#define NMEA_MSGS_PER_EPOCH 4
+
+/* GGA, GSA, RMC and VTG each epoch, and a set of three GSVs once a second */
+static void nmea_epoch(stream_t &out, uint32_t ms, uint32_t k, bool gsv)
+{
+  char body[100];
+
+  unsigned hh = (ms / 3600000) % 24;
+  unsigned mm = (ms / 60000) % 60;
+  float ss = (ms % 60000) / 1000.0f;
+  float lat_min = 23.8620f + 0.0001f * (k % 1000);
+  float lon_min = 7.1234f + 0.0001f * (k % 1000);
+
+  snprintf(body, sizeof(body),
+      "GPGGA,%02u%02u%05.2f,47%07.4f,N,008%07.4f,E,1,12,0.9,%.1f,M,47.3,M,,",
+      hh, mm, ss, lat_min, lon_min, 450.0f + 0.1f * (k % 100));
+  nmea_sentence(out, body);
+
+  nmea_sentence(out, "GPGSA,A,3,01,03,05,07,09,11,13,15,17,19,21,23,1.2,0.9,1.5");
+
+  snprintf(body, sizeof(body),
+      "GPRMC,%02u%02u%05.2f,A,47%07.4f,N,008%07.4f,E,2.43,%.2f,120616,,,A",
+      hh, mm, ss, lat_min, lon_min, (k % 360) * 1.0f);
+  nmea_sentence(out, body);
+
+  snprintf(body, sizeof(body), "GPVTG,%.2f,T,,M,2.43,N,4.50,K,A",
+      (k % 360) * 1.0f);
+  nmea_sentence(out, body);
+
+  if (gsv) {
+    for (unsigned i = 1; i <= 3; i++) {
+      unsigned prn = i * 8;
+
+      snprintf(body, sizeof(body),
+          "GPGSV,3,%u,12,%02u,45,120,38,%02u,30,200,35,%02u,60,45,41,%02u,12,310,22",
+          i, prn, prn + 1, prn + 2, prn + 3);
+      nmea_sentence(out, body);
+    }
+  }
+}
+
+static stream_t nmea_stream(uint32_t seconds, uint32_t rate_hz)
+{
+  stream_t out;
+  uint32_t epochs = seconds * rate_hz;
+  uint32_t ms = 43200000;
+
+  for (uint32_t k = 0; k < epochs; k++) {
+    nmea_epoch(out, ms, k, (k % rate_hz) == 0);
+    ms += 1000 / rate_hz;
+  }
+
+  return out;
+}
+
+static double now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+enum protocol {
+  UBX,
+  NMEA,
+};
+
+/* What a run of a parser over a stream left behind */
+struct replay {
+  struct GPS_RX_STATS stats;
+  GPSPositionData position;
+  uint32_t position_sets;
+  uint32_t velocity_sets;
+  uint32_t time_sets;
+  uint32_t satellites_sets;
+  uint32_t completions;
+  double ns;
+};
+
+class GPSParserTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+  }
+
+  void start(struct replay *r) {
+    memset(r, 0, sizeof(*r));
+    uavobjects_reset();
+  }
+
+  void finish(struct replay *r) {
+    r->position = gpsposition_last;
+    r->position_sets = gpsposition_sets;
+    r->velocity_sets = gpsvelocity_sets;
+    r->time_sets = gpstime_sets;
+    r->satellites_sets = gpssatellites_sets;
+  }
+
+  /* One byte at a time, as the GPS task did */
+  struct replay bytewise(enum protocol proto, const stream_t &s) {
+    struct replay r;
+    GPSPositionData gps;
+
+    start(&r);
+    memset(&gps, 0, sizeof(gps));
+
+    double t0 = now_ns();
+
+    for (size_t i = 0; i < s.size(); i++) {
+      int res;
+
+      if (proto == UBX) {
+        res = parse_ubx_stream(s[i], rx_buffer, &gps, &r.stats);
+      } else {
+        res = parse_nmea_stream(s[i], rx_buffer, &gps, &r.stats);
+      }
+
+      if (res == PARSER_COMPLETE) {
+        r.completions++;
+      }
+    }
+
+    r.ns = now_ns() - t0;
+
+    finish(&r);
+
+    return r;
+  }
+
+  /* In chunks of up to max_chunk bytes; random sizes if asked */
+  struct replay buffered(enum protocol proto, const stream_t &s,
+      size_t max_chunk, bool random_sizes) {
+    struct replay r;
+    GPSPositionData gps;
+
+    start(&r);
+    memset(&gps, 0, sizeof(gps));
+
+    double t0 = now_ns();
+
+    for (size_t i = 0; i < s.size(); ) {
+      size_t len = random_sizes ? 1 + rand() % max_chunk : max_chunk;
+
+      if (len > s.size() - i) {
+        len = s.size() - i;
+      }
+
+      int res;
+
+      if (proto == UBX) {
+        res = parse_ubx_buffer(&s[i], len, rx_buffer, &gps, &r.stats);
+      } else {
+        res = parse_nmea_buffer(&s[i], len, rx_buffer, &gps, &r.stats);
+      }
+
+      if (res == PARSER_COMPLETE) {
+        r.completions++;
+      }
+
+      i += len;
+    }
+
+    r.ns = now_ns() - t0;
+
+    finish(&r);
+
+    return r;
+  }
+
+  void expect_same(const struct replay &a, const struct replay &b) {
+    EXPECT_EQ(a.stats.gpsRxReceived, b.stats.gpsRxReceived);
+    EXPECT_EQ(a.stats.gpsRxChkSumError, b.stats.gpsRxChkSumError);
+    EXPECT_EQ(a.stats.gpsRxOverflow, b.stats.gpsRxOverflow);
+    EXPECT_EQ(a.stats.gpsRxParserError, b.stats.gpsRxParserError);
+    EXPECT_EQ(a.position_sets, b.position_sets);
+    EXPECT_EQ(a.velocity_sets, b.velocity_sets);
+    EXPECT_EQ(a.time_sets, b.time_sets);
+    EXPECT_EQ(a.satellites_sets, b.satellites_sets);
+    EXPECT_EQ(0, memcmp(&a.position, &b.position, sizeof(a.position)));
+  }
+};
+
+TEST_F(GPSParserTest, UBXBufferMatchesBytewise) {
+  const uint32_t seconds = 5, rate = 10, epochs = seconds * rate;
+
+  struct replay ref = bytewise(UBX, ubx_stream(seconds, rate));
+
+  EXPECT_EQ(epochs * UBX_MSGS_PER_EPOCH + seconds, ref.stats.gpsRxReceived);
+  EXPECT_EQ(0u, ref.stats.gpsRxChkSumError);
+  EXPECT_EQ(epochs, ref.position_sets);
+  EXPECT_EQ(epochs, ref.velocity_sets);
+  EXPECT_EQ(epochs, ref.time_sets);
+  EXPECT_EQ(seconds, ref.satellites_sets);
+
+  EXPECT_EQ(epoch_lat(epochs - 1), ref.position.Latitude);
+  EXPECT_EQ(epoch_lon(epochs - 1), ref.position.Longitude);
+  EXPECT_FLOAT_EQ(epoch_hmsl_mm(epochs - 1) * 0.001f, ref.position.Altitude);
+  EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, ref.position.Status);
+  EXPECT_EQ(12, ref.position.Satellites);
+
+  const size_t chunks[] = { 1, 2, 7, 32, 64, 1000 };
+
+  for (size_t i = 0; i < NELEMENTS(chunks); i++) {
+    struct replay r = buffered(UBX, ubx_stream(seconds, rate), chunks[i], true);
+
+    SCOPED_TRACE(chunks[i]);
+    expect_same(ref, r);
+  }
+
+  /* All of it in one go */
+  stream_t s = ubx_stream(seconds, rate);
+  struct replay whole = buffered(UBX, s, s.size(), false);
+
+  expect_same(ref, whole);
+  EXPECT_EQ(1u, whole.completions);
+}
+
+TEST_F(GPSParserTest, NMEABufferMatchesBytewise) {
+  const uint32_t seconds = 5, rate = 10, epochs = seconds * rate;
+  stream_t s = nmea_stream(seconds, rate);
+
+  struct replay ref = bytewise(NMEA, s);
+
+  EXPECT_EQ(epochs * NMEA_MSGS_PER_EPOCH + 3 * seconds, ref.stats.gpsRxReceived);
+  EXPECT_EQ(0u, ref.stats.gpsRxChkSumError);
+  EXPECT_EQ(0u, ref.stats.gpsRxParserError);
+  EXPECT_EQ(epochs, ref.position_sets);
+  EXPECT_EQ(seconds, ref.satellites_sets);
+
+  EXPECT_NEAR(47.3977, ref.position.Latitude * 1e-7, 1e-3);
+  EXPECT_NEAR(8.1187, ref.position.Longitude * 1e-7, 1e-3);
+  EXPECT_EQ(GPSPOSITION_STATUS_FIX3D, ref.position.Status);
+  EXPECT_EQ(8, gpssatellites_last.PRN[0]);
+
+  const size_t chunks[] = { 1, 2, 7, 32, 64, 1000 };
+
+  for (size_t i = 0; i < NELEMENTS(chunks); i++) {
+    struct replay r = buffered(NMEA, s, chunks[i], true);
+
+    SCOPED_TRACE(chunks[i]);
+    expect_same(ref, r);
+  }
+}
+
+TEST_F(GPSParserTest, UBXCorruptedStream) {
+  const uint32_t rate = 10;
+
+  /* Flip a bit in every 7th message, and put junk between epochs */
+  stream_t damaged[2];
+  uint32_t flipped = 0, total = 0;
+
+  for (int run = 0; run < 2; run++) {
+    stream_t &out = damaged[run];
+    uint32_t msg = 0;
+
+    for (uint32_t k = 0; k < 50; k++) {
+      stream_t epoch;
+
+      ubx_epoch(epoch, next_tow, k, (k % rate) == 0);
+      next_tow += 1000 / rate;
+
+      /* Walk the frames: sync, class, id, length, payload, checksum */
+      for (size_t i = 0; i < epoch.size(); ) {
+        uint16_t len = epoch[i + 4] | (epoch[i + 5] << 8);
+
+        if (run == 0) {
+          total++;
+        }
+
+        if ((++msg % 7) == 0) {
+          epoch[i + 6 + len / 2] ^= 0x10;
+
+          if (run == 0) {
+            flipped++;
+          }
+        }
+
+        i += 8 + len;
+      }
+
+      out.insert(out.end(), epoch.begin(), epoch.end());
+
+      for (int j = rand() % 20; j > 0; j--) {
+        out.push_back(rand() % 0xb0);
+      }
+    }
+  }
+
+  struct replay ref = bytewise(UBX, damaged[0]);
+  struct replay r = buffered(UBX, damaged[1], 32, false);
+
+  EXPECT_EQ(flipped, ref.stats.gpsRxChkSumError);
+  EXPECT_EQ(total - flipped, ref.stats.gpsRxReceived);
+  expect_same(ref, r);
+}
+
+TEST_F(GPSParserTest, UBXResyncsAfterDroppedBytes) {
+  const uint32_t rate = 25;
+  stream_t s;
+
+  for (uint32_t k = 0; k < 100; k++) {
+    stream_t epoch;
+
+    ubx_epoch(epoch, next_tow, k, (k % rate) == 0);
+    next_tow += 1000 / rate;
+
+    /* Lose a few bytes from a third of the epochs, as an overrun
+     * UART would */
+    if (k < 90 && (k % 3) == 0) {
+      size_t at = rand() % epoch.size();
+      size_t n = 1 + rand() % 8;
+
+      epoch.erase(epoch.begin() + at,
+          epoch.begin() + (at + n < epoch.size() ? at + n : epoch.size()));
+    }
+
+    /* A stray sync byte right before a frame */
+    if (k == 95) {
+      s.push_back(0xb5);
+    }
+
+    s.insert(s.end(), epoch.begin(), epoch.end());
+  }
+
+  struct replay r = buffered(UBX, s, 32, true);
+
+  EXPECT_LT(0, r.stats.gpsRxChkSumError + r.stats.gpsRxOverflow);
+
+  /* The last ten epochs are clean and all get through */
+  EXPECT_EQ(epoch_lat(99), r.position.Latitude);
+  EXPECT_LE(10u * UBX_MSGS_PER_EPOCH, r.stats.gpsRxReceived);
+  EXPECT_LE(10u, r.position_sets);
+}
+
+TEST_F(GPSParserTest, NMEACorruptedStream) {
+  const uint32_t rate = 10;
+  stream_t s;
+  uint32_t bad = 0, overlong = 0, total = 0;
+
+  for (uint32_t k = 0; k < 50; k++) {
+    stream_t epoch;
+
+    nmea_epoch(epoch, 43200000 + k * 100, k, (k % rate) == 0);
+
+    /* Damage the first sentence of every 5th epoch */
+    if ((k % 5) == 2) {
+      epoch[10] ^= 0x01;
+      bad++;
+    }
+
+    /* Something that never ends, ahead of every 11th */
+    if ((k % 11) == 3) {
+      s.push_back('$');
+      for (int j = 0; j < 150; j++) {
+        s.push_back('A' + j % 26);
+      }
+      overlong++;
+    }
+
+    for (size_t i = 0; i < epoch.size(); i++) {
+      if (epoch[i] == '$') {
+        total++;
+      }
+    }
+
+    s.insert(s.end(), epoch.begin(), epoch.end());
+
+    /* Line noise between epochs, without a '$' */
+    for (int j = rand() % 10; j > 0; j--) {
+      s.push_back('%' + rand() % 64);
+    }
+  }
+
+  struct replay ref = bytewise(NMEA, s);
+  struct replay r = buffered(NMEA, s, 32, true);
+
+  EXPECT_EQ(bad, ref.stats.gpsRxChkSumError);
+  EXPECT_EQ(overlong, ref.stats.gpsRxOverflow);
+  EXPECT_EQ(total - bad, ref.stats.gpsRxReceived);
+  expect_same(ref, r);
+}
+
+/* Replay a minute at 10 and 25 Hz solution rates through each parser, fed
+ * as the GPS task does */
+TEST_F(GPSParserTest, ReplayThroughput) {
+  const uint32_t seconds = 60;
+  const uint32_t rates[] = { 10, 25 };
+
+  for (size_t i = 0; i < NELEMENTS(rates); i++) {
+    for (int proto = UBX; proto <= NMEA; proto++) {
+      stream_t s;
+
+      s = (proto == UBX) ? ubx_stream(seconds, rates[i]) : nmea_stream(seconds, rates[i]);
+      struct replay a = bytewise((enum protocol) proto, s);
+
+      s = (proto == UBX) ? ubx_stream(seconds, rates[i]) : nmea_stream(seconds, rates[i]);
+      struct replay b = buffered((enum protocol) proto, s, 32, false);
+
+      expect_same(a, b);
+
+      double msgs = a.stats.gpsRxReceived;
+
+      printf("%-4s %2u Hz, %7zu bytes, %5.0f msgs: "
+          "bytewise %6.1f MB/s %5.0f ns/msg, buffered %6.1f MB/s %5.0f ns/msg\n",
+          proto == UBX ? "UBX" : "NMEA", rates[i], s.size(), msgs,
+          s.size() / a.ns * 1e3, a.ns / msgs,
+          s.size() / b.ns * 1e3, b.ns / msgs);
+    }
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -2,6 +2,7 @@
 #include <stdio.h>		/* fopen/fread/fwrite/fseek */
 #include <assert.h>		/* assert */
 #include <string.h>		/* memset */
+#include <unistd.h>		/* usleep */
 
 #include <stdbool.h>
 #include "pios_heap.h"
@@ -17,6 +18,7 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	uint32_t reads;
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -42,6 +44,7 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 
 	flash_dev->cfg = cfg;
 	flash_dev->transaction_in_progress = false;
+	flash_dev->reads = 0;
 
 	flash_dev->flash_file = fopen ("theflash.bin", "r+");
 	if (flash_dev->flash_file == NULL) {
@@ -68,6 +71,14 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 	PIOS_free(flash_dev);
 }
 
+/* Number of read_data calls since init */
+uint32_t PIOS_Flash_Posix_GetReadCount(uintptr_t chip_id)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	return flash_dev->reads;
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -116,6 +127,10 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	assert (s == flash_dev->cfg->size_of_sector);
 
+	if (flash_dev->cfg->erase_delay_us) {
+		usleep(flash_dev->cfg->erase_delay_us);
+	}
+
 	return 0;
 }
 
@@ -137,6 +152,10 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert (s == len);
 
+	if (flash_dev->cfg->program_delay_us) {
+		usleep(flash_dev->cfg->program_delay_us);
+	}
+
 	return 0;
 }
 
@@ -158,6 +177,8 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 
 	assert (s == len);
 
+	flash_dev->reads++;
+
 	return 0;
 }
 
@@ -333,6 +333,145 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+struct batch_entry {
+  uint32_t obj_id;
+  uint16_t obj_inst_id;
+  uint8_t *obj_data;
+  uint16_t obj_size;
+  int32_t rc;
+};
+
+struct batch_ctx {
+  struct batch_entry *entries;
+  uint16_t num_done;
+};
+
+static bool batch_source(void *ctx, uint16_t idx, uint32_t *obj_id, uint16_t *obj_inst_id, uint8_t **obj_data, uint16_t *obj_size)
+{
+  struct batch_ctx *batch = (struct batch_ctx *)ctx;
+  struct batch_entry *entry = &batch->entries[idx];
+
+  if (entry->obj_id == 0) {
+    return false;
+  }
+
+  *obj_id = entry->obj_id;
+  *obj_inst_id = entry->obj_inst_id;
+  *obj_data = entry->obj_data;
+  *obj_size = entry->obj_size;
+  return true;
+}
+
+static void batch_done(void *ctx, uint16_t idx, int32_t rc)
+{
+  struct batch_ctx *batch = (struct batch_ctx *)ctx;
+
+  /* Results are reported in order, exactly once per object */
+  EXPECT_EQ(batch->num_done, idx);
+  batch->entries[idx].rc = rc;
+  batch->num_done++;
+}
+
+TEST_F(LogfsTestCooked, BadIdSaveBatch) {
+  struct batch_entry entries[] = {
+    { OBJ1_ID, 0, obj1, sizeof(obj1), 1 },
+  };
+  struct batch_ctx batch = { entries, 0 };
+
+  EXPECT_EQ(-1, PIOS_FLASHFS_ObjSaveBatch(fs_id + 1, 1, batch_source, batch_done, &batch));
+  EXPECT_EQ(0, batch.num_done);
+}
+
+TEST_F(LogfsTestCooked, WriteBatchVerify) {
+  struct batch_entry entries[] = {
+    { OBJ1_ID, 0, obj1, sizeof(obj1), 1 },
+    { OBJ1_ID, 123, obj1_alt, sizeof(obj1_alt), 1 },
+    { OBJ2_ID, 0, obj2, sizeof(obj2), 1 },
+    { OBJ3_ID, 0, obj3, sizeof(obj3), 1 },
+  };
+  struct batch_ctx batch = { entries, 0 };
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, 4, batch_source, batch_done, &batch));
+  EXPECT_EQ(4, batch.num_done);
+
+  for (uint32_t i = 0; i < 4; i++) {
+    EXPECT_EQ(0, entries[i].rc);
+  }
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 123, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  memset(obj2_check, 0, sizeof(obj2_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+  unsigned char obj3_check[OBJ3_SIZE];
+  memset(obj3_check, 0, sizeof(obj3_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+  EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+}
+
+TEST_F(LogfsTestCooked, WriteBatchPartialFailure) {
+  /* The second entry is skipped and the third doesn't fit in a slot */
+  struct batch_entry entries[] = {
+    { OBJ1_ID, 0, obj1, sizeof(obj1), 1 },
+    { 0, 0, NULL, 0, 1 },
+    { OBJ4_ID, 0, obj4, sizeof(obj4), 1 },
+    { OBJ2_ID, 0, obj2, sizeof(obj2), 1 },
+  };
+  struct batch_ctx batch = { entries, 0 };
+
+  EXPECT_EQ(-8, PIOS_FLASHFS_ObjSaveBatch(fs_id, 4, batch_source, batch_done, &batch));
+  EXPECT_EQ(4, batch.num_done);
+
+  EXPECT_EQ(0, entries[0].rc);
+  EXPECT_EQ(-1, entries[1].rc);
+  EXPECT_EQ(-1, entries[2].rc);
+  EXPECT_EQ(0, entries[3].rc);
+
+  /* Objects around the failures are still saved */
+  unsigned char obj2_check[OBJ2_SIZE];
+  memset(obj2_check, 0, sizeof(obj2_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+}
+
+TEST_F(LogfsTestCooked, WriteBatchGarbageCollect) {
+  /* Fill up most of the filesystem with multiple instances of obj1 */
+  uint16_t num_slots = (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size) - 1;
+  for (uint32_t i = 0; i < num_slots; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+  }
+
+  /* Rewriting existing objects within a batch needs gc part way through */
+  struct batch_entry entries[] = {
+    { OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt), 1 },
+    { OBJ1_ID, 1, obj1_alt, sizeof(obj1_alt), 1 },
+    { OBJ1_ID, 2, obj1_alt, sizeof(obj1_alt), 1 },
+  };
+  struct batch_ctx batch = { entries, 0 };
+
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, 3, batch_source, batch_done, &batch));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  for (uint16_t i = 0; i < 3; i++) {
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+  }
+
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 3, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
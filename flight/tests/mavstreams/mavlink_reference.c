@@ -0,0 +1,231 @@
+/**
+ ******************************************************************************
+ * @file       mavlink_reference.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Mavlink library glue for the mavstreams test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "mavstreams.h"
+#include "mavlink.h"
+
+static uint32_t parse_errors;
+
+/**
+ * Frame the messages the bridge sends for a stream, as the bridge does,
+ * with payloads that change from one call to the next.
+ * \return bytes written, 0 for a stream the bridge doesn't send
+ */
+uint16_t bridge_pack_stream(struct mavstreams *sched, uint8_t stream, uint8_t *buf)
+{
+	static uint32_t n;
+	uint16_t len = 0;
+
+	n++;
+
+	switch (stream) {
+	case MAV_DATA_STREAM_EXTENDED_STATUS: {
+		mavlink_sys_status_t sys_status = {
+			.load = n % 1000,
+			.voltage_battery = 12600,
+			.battery_remaining = 80,
+		};
+		len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_SYS_STATUS,
+				&sys_status, MAVLINK_MSG_ID_SYS_STATUS_LEN);
+		break;
+	}
+	case MAV_DATA_STREAM_RC_CHANNELS: {
+		mavlink_rc_channels_raw_t rc_channels_raw = {
+			.time_boot_ms = n,
+			.chan1_raw = 1500,
+			.chan3_raw = 1000 + n % 1000,
+			.rssi = 200,
+		};
+		len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_RC_CHANNELS_RAW,
+				&rc_channels_raw, MAVLINK_MSG_ID_RC_CHANNELS_RAW_LEN);
+		break;
+	}
+	case MAV_DATA_STREAM_POSITION: {
+		mavlink_gps_raw_int_t gps_raw_int = {
+			.time_usec = (uint64_t)n * 1000,
+			.fix_type = 3,
+			.lat = 473977420 + n,
+			.lon = 85455940,
+			.satellites_visible = 9,
+		};
+		mavlink_gps_global_origin_t gps_global_origin = {
+			.latitude = 473977420,
+			.longitude = 85455940,
+			.altitude = 488000,
+		};
+		len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_GPS_RAW_INT,
+				&gps_raw_int, MAVLINK_MSG_ID_GPS_RAW_INT_LEN);
+		len += mavstreams_frame(sched, buf + len, MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN,
+				&gps_global_origin, MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN_LEN);
+		break;
+	}
+	case MAV_DATA_STREAM_EXTRA1: {
+		mavlink_attitude_t attitude = {
+			.time_boot_ms = n,
+			.roll = 0.1f,
+			.pitch = -0.2f,
+			.yaw = n * 0.001f,
+		};
+		len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_ATTITUDE,
+				&attitude, MAVLINK_MSG_ID_ATTITUDE_LEN);
+		break;
+	}
+	case MAV_DATA_STREAM_EXTRA2: {
+		mavlink_vfr_hud_t vfr_hud = {
+			.groundspeed = 12.5f,
+			.heading = n % 360,
+			.throttle = 55,
+			.alt = 488.0f,
+		};
+		mavlink_heartbeat_t heartbeat = {
+			.type = MAV_TYPE_GENERIC,
+			.autopilot = MAV_AUTOPILOT_GENERIC,
+			.base_mode = MAV_MODE_FLAG_SAFETY_ARMED,
+			.custom_mode = 2,
+			.mavlink_version = MAVLINK_VERSION,
+		};
+		len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_VFR_HUD,
+				&vfr_hud, MAVLINK_MSG_ID_VFR_HUD_LEN);
+		len += mavstreams_frame(sched, buf + len, MAVLINK_MSG_ID_HEARTBEAT,
+				&heartbeat, MAVLINK_MSG_ID_HEARTBEAT_LEN);
+		break;
+	}
+	}
+
+	return len;
+}
+
+/**
+ * Message ids the bridge sends for a stream, in order; up to two.
+ * \return number of messages
+ */
+int bridge_stream_msgids(uint8_t stream, uint8_t *msgids)
+{
+	switch (stream) {
+	case MAV_DATA_STREAM_EXTENDED_STATUS:
+		msgids[0] = MAVLINK_MSG_ID_SYS_STATUS;
+		return 1;
+	case MAV_DATA_STREAM_RC_CHANNELS:
+		msgids[0] = MAVLINK_MSG_ID_RC_CHANNELS_RAW;
+		return 1;
+	case MAV_DATA_STREAM_POSITION:
+		msgids[0] = MAVLINK_MSG_ID_GPS_RAW_INT;
+		msgids[1] = MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN;
+		return 2;
+	case MAV_DATA_STREAM_EXTRA1:
+		msgids[0] = MAVLINK_MSG_ID_ATTITUDE;
+		return 1;
+	case MAV_DATA_STREAM_EXTRA2:
+		msgids[0] = MAVLINK_MSG_ID_VFR_HUD;
+		msgids[1] = MAVLINK_MSG_ID_HEARTBEAT;
+		return 2;
+	}
+
+	return 0;
+}
+
+/**
+ * Feed a byte to the Mavlink library's own parser.
+ * \return true when it completes a frame with a good checksum
+ */
+bool reference_parse_char(uint8_t c, uint8_t *msgid, uint8_t *seq)
+{
+	mavlink_message_t msg;
+	mavlink_status_t status;
+
+	uint8_t got = mavlink_parse_char(MAVLINK_COMM_0, c, &msg, &status);
+
+	parse_errors += status.packet_rx_drop_count;
+
+	if (got) {
+		*msgid = msg.msgid;
+		*seq = msg.seq;
+	}
+
+	return got;
+}
+
+uint32_t reference_parse_errors(void)
+{
+	return parse_errors;
+}
+
+/**
+ * Frame an attitude and a heartbeat with the library's own packers.
+ * \return bytes written
+ */
+uint16_t reference_pack(uint8_t seq, uint8_t *buf)
+{
+	mavlink_message_t msg;
+	uint16_t len;
+
+	mavlink_get_channel_status(MAVLINK_COMM_0)->current_tx_seq = seq;
+
+	mavlink_msg_attitude_pack(MAVSTREAMS_SYSTEM_ID, MAVSTREAMS_COMPONENT_ID,
+			&msg, 1234, 0.1f, -0.2f, 3.0f, 0, 0, 0);
+	len = mavlink_msg_to_send_buffer(buf, &msg);
+
+	mavlink_msg_heartbeat_pack(MAVSTREAMS_SYSTEM_ID, MAVSTREAMS_COMPONENT_ID,
+			&msg, MAV_TYPE_GENERIC, MAV_AUTOPILOT_GENERIC,
+			MAV_MODE_FLAG_SAFETY_ARMED, 2, 0);
+	len += mavlink_msg_to_send_buffer(buf + len, &msg);
+
+	return len;
+}
+
+/**
+ * Frame the same two messages as reference_pack with mavstreams_frame.
+ * \return bytes written
+ */
+uint16_t mavstreams_pack(struct mavstreams *sched, uint8_t *buf)
+{
+	mavlink_attitude_t attitude = {
+		.time_boot_ms = 1234,
+		.roll = 0.1f,
+		.pitch = -0.2f,
+		.yaw = 3.0f,
+	};
+	mavlink_heartbeat_t heartbeat = {
+		.type = MAV_TYPE_GENERIC,
+		.autopilot = MAV_AUTOPILOT_GENERIC,
+		.base_mode = MAV_MODE_FLAG_SAFETY_ARMED,
+		.custom_mode = 2,
+		.mavlink_version = MAVLINK_VERSION,
+	};
+	uint16_t len;
+
+	len = mavstreams_frame(sched, buf, MAVLINK_MSG_ID_ATTITUDE,
+			&attitude, MAVLINK_MSG_ID_ATTITUDE_LEN);
+	len += mavstreams_frame(sched, buf + len, MAVLINK_MSG_ID_HEARTBEAT,
+			&heartbeat, MAVLINK_MSG_ID_HEARTBEAT_LEN);
+
+	return len;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,252 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the Mavlink bridge stream schedule
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+#include <vector>
+
+extern "C" {
+
+#include "mavstreams.h"
+
+uint16_t bridge_pack_stream(struct mavstreams *sched, uint8_t stream, uint8_t *buf);
+int bridge_stream_msgids(uint8_t stream, uint8_t *msgids);
+bool reference_parse_char(uint8_t c, uint8_t *msgid, uint8_t *seq);
+uint32_t reference_parse_errors(void);
+uint16_t reference_pack(uint8_t seq, uint8_t *buf);
+uint16_t mavstreams_pack(struct mavstreams *sched, uint8_t *buf);
+
+}
+
+/* MAV_DATA_STREAM values of the streams the bridge sends */
+#define STREAM_EXTENDED_STATUS 2
+#define STREAM_RC_CHANNELS     3
+#define STREAM_POSITION        6
+#define STREAM_EXTRA1          10
+#define STREAM_EXTRA2          11
+#define NUM_STREAMS            12
+
+/* mav_rates from UAVOMavlinkBridge.c, in Hz */
+static const uint8_t mav_rates[NUM_STREAMS] = {
+  0, 2, 2, 5, 0, 0, 2, 0, 0, 0, 10, 2,
+};
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class MavStreams : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(msg_count, 0, sizeof(msg_count));
+    wakeups = 0;
+    messages = 0;
+    seq_errors = 0;
+    cpu_ns = 0;
+    out.clear();
+  }
+
+  /* Run the bridge's loop against a simulated clock, then decode what it
+   * sent with the Mavlink library's parser */
+  void run(const uint8_t *rates, uint32_t bandwidth, uint32_t duration) {
+    uint8_t buf[128];
+    uint32_t now = 0;
+
+    mavstreams_init(&sched, rates, NUM_STREAMS, bandwidth, now);
+
+    double start = now_ns();
+    while (now < duration) {
+      uint16_t due;
+
+      while ((due = mavstreams_next_due(&sched, now)) != 0) {
+        for (int i = 0; i < NUM_STREAMS; i++) {
+          if (due & (1 << i)) {
+            uint16_t len = bridge_pack_stream(&sched, i, buf);
+            out.insert(out.end(), buf, buf + len);
+            mavstreams_sent(&sched, len);
+          }
+        }
+      }
+
+      now += mavstreams_wait(&sched, now);
+      wakeups++;
+    }
+    cpu_ns = now_ns() - start;
+
+    uint32_t errors = reference_parse_errors();
+    uint8_t msgid, seq, last_seq = 0;
+
+    for (size_t i = 0; i < out.size(); i++) {
+      if (reference_parse_char(out[i], &msgid, &seq)) {
+        if (messages > 0 && seq != (uint8_t) (last_seq + 1)) {
+          seq_errors++;
+        }
+        last_seq = seq;
+        msg_count[msgid]++;
+        messages++;
+      }
+    }
+
+    parse_errors = reference_parse_errors() - errors;
+  }
+
+  /* Times a stream was sent, going by its first message */
+  uint32_t stream_count(uint8_t stream) {
+    uint8_t msgids[2];
+
+    if (bridge_stream_msgids(stream, msgids) == 0) {
+      return 0;
+    }
+
+    return msg_count[msgids[0]];
+  }
+
+  struct mavstreams sched;
+  std::vector<uint8_t> out;
+  uint32_t msg_count[256];
+  uint32_t wakeups;
+  uint32_t messages;
+  uint32_t seq_errors;
+  uint32_t parse_errors;
+  double cpu_ns;
+};
+
+TEST_F(MavStreams, FrameMatchesLibrary) {
+  uint8_t ours[128], theirs[128];
+
+  mavstreams_init(&sched, mav_rates, NUM_STREAMS, 0, 0);
+  sched.seq = 250;
+
+  uint16_t len = mavstreams_pack(&sched, ours);
+  ASSERT_EQ(len, reference_pack(250, theirs));
+  EXPECT_EQ(0, memcmp(ours, theirs, len));
+  EXPECT_EQ(252, sched.seq);
+};
+
+TEST_F(MavStreams, StreamsShareBuckets) {
+  mavstreams_init(&sched, mav_rates, NUM_STREAMS, 0, 0);
+
+  // 2 Hz, 5 Hz and 10 Hz
+  ASSERT_EQ(3, sched.num_buckets);
+  EXPECT_EQ(500, sched.buckets[0].period);
+  EXPECT_EQ((1 << 1) | (1 << STREAM_EXTENDED_STATUS) |
+      (1 << STREAM_POSITION) | (1 << STREAM_EXTRA2), sched.buckets[0].streams);
+  EXPECT_EQ(200, sched.buckets[1].period);
+  EXPECT_EQ(1 << STREAM_RC_CHANNELS, sched.buckets[1].streams);
+  EXPECT_EQ(100, sched.buckets[2].period);
+  EXPECT_EQ(1 << STREAM_EXTRA1, sched.buckets[2].streams);
+};
+
+TEST_F(MavStreams, AchievesRequestedRates) {
+  // 57600 baud
+  run(mav_rates, 5760, 60000);
+
+  EXPECT_EQ(0u, parse_errors);
+  EXPECT_EQ(0u, seq_errors);
+
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    uint8_t msgids[2];
+    int num = bridge_stream_msgids(i, msgids);
+
+    for (int j = 0; j < num; j++) {
+      EXPECT_EQ(mav_rates[i] * 60u, msg_count[msgids[j]]) << "stream " << i;
+    }
+  }
+
+  // Woken only when a bucket is due, no more often than the fastest
+  EXPECT_LE(wakeups, 600u);
+
+  printf("%u messages, %u bytes: %.0f ns per message, %.0f ns per wakeup\n",
+      messages, (unsigned) out.size(), cpu_ns / messages, cpu_ns / wakeups);
+
+  // Well under 0.1% of a core on the host for a minute of streams
+  EXPECT_LT(cpu_ns, 60e9 * 0.001);
+};
+
+TEST_F(MavStreams, ThrottledToBandwidth) {
+  uint8_t rates[NUM_STREAMS] = { 0 };
+  const uint32_t bandwidth = 960;    // 9600 baud
+
+  rates[STREAM_EXTENDED_STATUS] = 20;
+  rates[STREAM_RC_CHANNELS] = 25;
+  rates[STREAM_POSITION] = 40;
+  rates[STREAM_EXTRA1] = 50;
+  rates[STREAM_EXTRA2] = 100;
+
+  run(rates, bandwidth, 60000);
+
+  EXPECT_EQ(0u, parse_errors);
+  EXPECT_EQ(0u, seq_errors);
+
+  // The link is kept busy but never overrun: the initial 100 ms of credit
+  // and one stream of overdraft are all that it may go over by
+  EXPECT_LE(out.size(), bandwidth * 60 + bandwidth / 10 + 58);
+  EXPECT_GE(out.size(), bandwidth * 60 * 95 / 100);
+
+  // Every stream slows down, none is starved
+  for (int i = 0; i < NUM_STREAMS; i++) {
+    if (rates[i]) {
+      uint32_t count = stream_count(i);
+
+      printf("stream %2d: %3u Hz requested, %5.1f Hz achieved\n",
+          i, rates[i], count / 60.0);
+      EXPECT_LT(count, rates[i] * 60u);
+      EXPECT_GE(count, 60u) << "stream " << i;
+    }
+  }
+};
+
+TEST_F(MavStreams, IdleLinkIsNotThrottled) {
+  uint8_t rates[NUM_STREAMS] = { 0 };
+
+  rates[STREAM_EXTRA1] = 50;
+
+  // 36 bytes at 50 Hz is 1800 bytes/s, a 19200 baud link carries 1920
+  run(rates, 1920, 10000);
+
+  EXPECT_EQ(500u, stream_count(STREAM_EXTRA1));
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,28 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { while (1) ; }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#include <pios_heap.h>
+#include <pios_delay.h>
+#include <pios_spi.h>
+#include <pios_sensors.h>
+#include <pios_mpu.h>
+
+/* Would be from pios_exti.h, which needs the STM32 headers */
+struct pios_exti_cfg;
+int32_t PIOS_EXTI_Init(const struct pios_exti_cfg *cfg);
+void PIOS_EXTI_DeInit(const struct pios_exti_cfg *cfg);
+
+#endif /* PIOS_H */
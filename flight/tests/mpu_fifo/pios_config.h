@@ -0,0 +1,2 @@
+#define PIOS_INCLUDE_MPU
+#define PIOS_INCLUDE_SPI
@@ -0,0 +1,5 @@
+#include "pios_thread.h"
+
+#define TASKINFO_RUNNING_IMU 0
+
+int32_t TaskMonitorAdd(int task, struct pios_thread *handlep);
@@ -0,0 +1,573 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the MPU driver's FIFO mode, against the posix model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memcpy */
+#include <stdint.h>		/* uint*_t */
+#include <math.h>		/* lroundf */
+#include <setjmp.h>		/* setjmp */
+#include <time.h>		/* clock_gettime */
+
+#include <vector>
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+#include "pios_queue.h"
+#include "pios_mpu_priv.h"
+#include "pios_mpu_model.h"
+#include "physical_constants.h"
+
+}
+
+// The driver's task runs on a virtual clock.  Each time it blocks, time
+// moves on, the queues are emptied as the sensors task would, and after
+// the requested number of wakeups the task is abandoned with longjmp.
+
+struct pios_queue {
+  size_t length;
+  size_t item_size;
+  size_t pending;
+  uint32_t dropped;
+  std::vector<std::vector<uint8_t> > items;
+};
+
+static struct pios_mpu_model model;
+
+static uint32_t now_us;
+static uint32_t stall_us;
+static uint32_t irq_period_us;
+
+static uint32_t wakeups_left;
+static uint32_t wakeups;
+static jmp_buf task_stopped;
+
+static void (*task_fn)(void *);
+
+static struct pios_queue *accel_queue;
+static struct pios_queue *gyro_queue;
+
+static void task_blocks()
+{
+  if (accel_queue) {
+    accel_queue->pending = 0;
+  }
+  if (gyro_queue) {
+    gyro_queue->pending = 0;
+  }
+
+  if (wakeups_left-- == 0) {
+    longjmp(task_stopped, 1);
+  }
+
+  wakeups++;
+}
+
+extern "C" {
+
+void *PIOS_malloc(size_t size)
+{
+  return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+  free(buf);
+}
+
+struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
+{
+  struct pios_queue *q = new pios_queue;
+
+  q->length = queue_length;
+  q->item_size = item_size;
+  q->pending = 0;
+  q->dropped = 0;
+
+  return q;
+}
+
+void PIOS_Queue_Delete(struct pios_queue *queuep)
+{
+  delete queuep;
+}
+
+bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
+{
+  (void) timeout_ms;
+
+  if (queuep->pending >= queuep->length) {
+    queuep->dropped++;
+    return false;
+  }
+
+  const uint8_t *p = (const uint8_t *) itemp;
+  queuep->items.push_back(std::vector<uint8_t>(p, p + queuep->item_size));
+  queuep->pending++;
+
+  return true;
+}
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+  return (struct pios_semaphore *) malloc(sizeof(struct pios_semaphore));
+}
+
+// Interrupt driven: each take is the next data ready interrupt
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+  (void) sema;
+  (void) timeout_ms;
+
+  task_blocks();
+  now_us += irq_period_us;
+
+  return true;
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+  (void) sema;
+  (void) woken;
+
+  return true;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep,
+    size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+  (void) namep;
+  (void) stack_bytes;
+  (void) argp;
+  (void) prio;
+
+  task_fn = fp;
+
+  return (struct pios_thread *) &task_fn;
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+  return now_us / 1000;
+}
+
+void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms)
+{
+  task_blocks();
+
+  *previous_ms += increment_ms;
+
+  // Already late returns straight away, as with vTaskDelayUntil
+  if ((int32_t) (*previous_ms * 1000 - now_us) > 0) {
+    now_us = *previous_ms * 1000;
+  }
+
+  // Something else hogged the processor
+  now_us += stall_us;
+  stall_us = 0;
+}
+
+int32_t PIOS_DELAY_WaitmS(uint32_t mS)
+{
+  now_us += mS * 1000;
+  return 0;
+}
+
+uint32_t PIOS_DELAY_GetuS()
+{
+  return now_us;
+}
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+  return now_us;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+  return now_us - raw;
+}
+
+int32_t PIOS_EXTI_Init(const struct pios_exti_cfg *cfg)
+{
+  (void) cfg;
+  return 0;
+}
+
+void PIOS_EXTI_DeInit(const struct pios_exti_cfg *cfg)
+{
+  (void) cfg;
+}
+
+int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue)
+{
+  if (type == PIOS_SENSOR_ACCEL) {
+    accel_queue = queue;
+  } else if (type == PIOS_SENSOR_GYRO) {
+    gyro_queue = queue;
+  }
+
+  return 0;
+}
+
+void PIOS_SENSORS_SetMaxGyro(int32_t rate)
+{
+  (void) rate;
+}
+
+void PIOS_SENSORS_SetSampleRate(enum pios_sensor_type type, uint32_t sample_rate)
+{
+  (void) type;
+  (void) sample_rate;
+}
+
+int32_t TaskMonitorAdd(int task, struct pios_thread *handlep)
+{
+  (void) task;
+  (void) handlep;
+  return 0;
+}
+
+// SPI, straight into the model as the simulator's posix SPI does
+int32_t PIOS_SPI_ClaimBus(uint32_t spi_id)
+{
+  (void) spi_id;
+  return 0;
+}
+
+int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
+{
+  (void) spi_id;
+  return 0;
+}
+
+int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, uint32_t speed)
+{
+  (void) spi_id;
+  return speed;
+}
+
+int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, bool pin_value)
+{
+  (void) spi_id;
+  (void) slave_id;
+
+  if (!pin_value) {
+    PIOS_MPU_Model_SetTime(&model, now_us);
+  }
+
+  PIOS_MPU_Model_Select(&model, !pin_value);
+
+  return 0;
+}
+
+int32_t PIOS_SPI_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer,
+    uint8_t *receive_buffer, uint16_t len)
+{
+  (void) spi_id;
+
+  for (uint16_t i = 0; i < len; i++) {
+    uint8_t b = PIOS_MPU_Model_Transfer(&model, send_buffer ? send_buffer[i] : 0xff);
+
+    if (receive_buffer) {
+      receive_buffer[i] = b;
+    }
+  }
+
+  return 0;
+}
+
+uint8_t PIOS_SPI_TransferByte(uint32_t spi_id, uint8_t b)
+{
+  uint8_t ret;
+
+  PIOS_SPI_TransferBlock(spi_id, &b, &ret, 1);
+
+  return ret;
+}
+
+}
+
+// Every sample is numbered through the gyro X axis, so gaps and misaligned
+// frames show up; the rest is constant
+#define INDEX_WRAP 30000
+#define RAW_ACCEL_Z 4096
+#define RAW_TEMP -3912
+
+static void numbered_sample(void *ctx, uint32_t index,
+    int16_t accel[3], int16_t *temp, int16_t gyro[3])
+{
+  (void) ctx;
+
+  accel[0] = 0;
+  accel[1] = 0;
+  accel[2] = RAW_ACCEL_Z;
+  *temp = RAW_TEMP;
+  gyro[0] = index % INDEX_WRAP;
+  gyro[1] = 0;
+  gyro[2] = 0;
+}
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class MpuFifo : public testing::Test {
+protected:
+  virtual void SetUp() {
+    now_us = 1000000;
+    stall_us = 0;
+    irq_period_us = 1000;
+    wakeups = 0;
+    task_fn = NULL;
+    accel_queue = NULL;
+    gyro_queue = NULL;
+
+    PIOS_MPU_Model_Init(&model, 0x68);
+    PIOS_MPU_Model_SetSampleFn(&model, numbered_sample, NULL);
+  }
+
+  virtual void TearDown() {
+  }
+
+  int32_t start(uint8_t fifo_burst) {
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.default_samplerate = 1000;
+    cfg.orientation = PIOS_MPU_TOP_0DEG;
+    cfg.skip_startup_irq_check = true;
+    cfg.fifo_burst = fifo_burst;
+
+    pios_mpu_dev_t dev = NULL;
+
+    return PIOS_MPU_SPI_Init(&dev, 1, 0, &cfg);
+  }
+
+  // Let the task wake this many times
+  void run(uint32_t count) {
+    ASSERT_TRUE(task_fn != NULL);
+
+    wakeups_left = count;
+
+    if (!setjmp(task_stopped)) {
+      task_fn(NULL);
+    }
+  }
+
+  // Check every gyro sample since the last call follows on from the one
+  // before, bar the gaps allowed; returns the number checked
+  uint32_t checkSamples(uint32_t allowed_gaps = 0) {
+    uint32_t gaps = 0;
+
+    for (size_t i = checked; i < gyro_queue->items.size(); i++) {
+      struct pios_sensor_gyro_data gyro;
+      struct pios_sensor_accel_data accel;
+
+      memcpy(&gyro, &gyro_queue->items[i][0], sizeof(gyro));
+      memcpy(&accel, &accel_queue->items[i][0], sizeof(accel));
+
+      // TOP_0DEG swaps X and Y, and negates Z
+      long index = lroundf(gyro.y * 32.8f);
+
+      EXPECT_NEAR(-RAW_ACCEL_Z * GRAVITY / 4096.0f, accel.z, 1e-3) << "sample " << i;
+      EXPECT_NEAR(25.0f, gyro.temperature, 1e-3) << "sample " << i;
+      EXPECT_EQ(0, gyro.x);
+      EXPECT_EQ(0, accel.x);
+
+      if (have_last && index != (last_index + 1) % INDEX_WRAP) {
+        gaps++;
+      }
+
+      last_index = index;
+      have_last = true;
+    }
+
+    uint32_t n = gyro_queue->items.size() - checked;
+    checked = gyro_queue->items.size();
+
+    EXPECT_EQ(accel_queue->items.size(), gyro_queue->items.size());
+    EXPECT_LE(gaps, allowed_gaps);
+
+    return n;
+  }
+
+  struct pios_mpu_cfg cfg;
+  size_t checked = 0;
+  long last_index = 0;
+  bool have_last = false;
+};
+
+TEST_F(MpuFifo, ConfiguresFifo) {
+  ASSERT_EQ(0, start(4));
+
+  EXPECT_EQ(PIOS_MPU60X0, PIOS_MPU_GetType());
+  EXPECT_EQ(0, model.regs[PIOS_MPU_SMPLRT_DIV_REG]);
+  EXPECT_EQ(PIOS_MPU_INTEN_OVERFLOW, model.regs[PIOS_MPU_INT_EN_REG]);
+  EXPECT_EQ(0xF8, model.regs[PIOS_MPU_FIFO_EN_REG]);
+
+  // The FIFO itself starts with the task
+  run(1);
+  EXPECT_TRUE(model.regs[PIOS_MPU_USER_CTRL_REG] & PIOS_MPU_USERCTL_FIFO_EN);
+};
+
+TEST_F(MpuFifo, DeliversEverySampleInOrder) {
+  ASSERT_EQ(0, start(4));
+
+  // One second
+  run(250);
+
+  struct pios_mpu_fifo_stats stats;
+  PIOS_MPU_GetFIFOStats(&stats);
+
+  EXPECT_NEAR(1000, checkSamples(), 4);
+  EXPECT_EQ(stats.samples, gyro_queue->items.size());
+  EXPECT_NEAR(250, stats.bursts, 1);
+  EXPECT_EQ(0u, stats.overflows);
+  EXPECT_EQ(0u, stats.dropped);
+  EXPECT_EQ(0u, model.fifo_overflows);
+  EXPECT_EQ(0u, gyro_queue->dropped);
+
+  // The newest sample was taken within the last period
+  EXPECT_LE(now_us - stats.last_sample_us, 1000u);
+};
+
+TEST_F(MpuFifo, CatchesUpAfterRunningLate) {
+  ASSERT_EQ(0, start(4));
+
+  run(50);
+  checkSamples();
+
+  // Late enough to leave more in the FIFO than one read takes, but not
+  // so late that it overflows
+  stall_us = 20000;
+  run(50);
+
+  struct pios_mpu_fifo_stats stats;
+  PIOS_MPU_GetFIFOStats(&stats);
+
+  checkSamples();
+  EXPECT_EQ(0u, stats.overflows);
+  EXPECT_EQ(0u, stats.dropped);
+  EXPECT_EQ(0u, gyro_queue->dropped);
+  EXPECT_LE(now_us - stats.last_sample_us, 1000u);
+};
+
+TEST_F(MpuFifo, RecoversFromOverflow) {
+  ASSERT_EQ(0, start(4));
+
+  run(50);
+  checkSamples();
+
+  // The FIFO holds 36 samples, so this loses about 100
+  stall_us = 100000;
+  run(50);
+
+  struct pios_mpu_fifo_stats stats;
+  PIOS_MPU_GetFIFOStats(&stats);
+
+  EXPECT_GT(model.fifo_overflows, 0u);
+  EXPECT_EQ(1u, stats.overflows);
+  EXPECT_NEAR(100, stats.dropped, 5);
+
+  // One gap where the samples were lost, and nothing misaligned
+  uint32_t after = checkSamples(1);
+  EXPECT_GT(after, 50u);
+
+  // Back to normal
+  run(50);
+  checkSamples();
+
+  PIOS_MPU_GetFIFOStats(&stats);
+  EXPECT_EQ(1u, stats.overflows);
+  EXPECT_LE(now_us - stats.last_sample_us, 1000u);
+};
+
+TEST_F(MpuFifo, InterruptDriven) {
+  ASSERT_EQ(0, start(0));
+
+  EXPECT_EQ(PIOS_MPU_INTEN_DATA_RDY, model.regs[PIOS_MPU_INT_EN_REG]);
+
+  run(1000);
+  EXPECT_EQ(1000u, checkSamples());
+
+  struct pios_mpu_fifo_stats stats;
+  PIOS_MPU_GetFIFOStats(&stats);
+  EXPECT_EQ(0u, stats.samples);
+};
+
+TEST_F(MpuFifo, PerSampleCost) {
+  const uint32_t samples = 40000;
+
+  ASSERT_EQ(0, start(0));
+  uint32_t selects = model.selects;
+
+  double start_ns = now_ns();
+  run(samples);
+  double irq_ns = (now_ns() - start_ns) / samples;
+
+  uint32_t irq_n = checkSamples();
+  double irq_txn = (model.selects - selects) / (double) irq_n;
+  double irq_wake = wakeups / (double) irq_n;
+
+  SetUp();
+  checked = 0;
+  have_last = false;
+
+  ASSERT_EQ(0, start(8));
+  selects = model.selects;
+
+  start_ns = now_ns();
+  run(samples / 8);
+  double fifo_ns = (now_ns() - start_ns) / samples;
+
+  uint32_t fifo_n = checkSamples();
+  double fifo_txn = (model.selects - selects) / (double) fifo_n;
+  double fifo_wake = wakeups / (double) fifo_n;
+
+  printf("per sample: %.0f ns, %.2f transfers, %.2f wakeups interrupt driven\n",
+      irq_ns, irq_txn, irq_wake);
+  printf("            %.0f ns, %.2f transfers, %.2f wakeups from the FIFO\n",
+      fifo_ns, fifo_txn, fifo_wake);
+
+  EXPECT_NEAR(samples, fifo_n, 8);
+  EXPECT_LT(fifo_txn * 2, irq_txn);
+  EXPECT_LT(fifo_wake * 4, irq_wake);
+};
@@ -0,0 +1,17 @@
+/* The parts of the generated header the OSD utilities use */
+#ifndef GPSPOSITION_H
+#define GPSPOSITION_H
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+	float GeoidSeparation;
+} GPSPositionData;
+
+static inline int32_t GPSPositionGet(GPSPositionData *dataOut) { memset(dataOut, 0, sizeof(*dataOut)); return 0; }
+
+#endif /* GPSPOSITION_H */
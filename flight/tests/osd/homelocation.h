@@ -0,0 +1,16 @@
+/* The parts of the generated header the OSD utilities use */
+#ifndef HOMELOCATION_H
+#define HOMELOCATION_H
+
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+	int32_t Latitude;
+	int32_t Longitude;
+	float Altitude;
+} HomeLocationData;
+
+static inline int32_t HomeLocationGet(HomeLocationData *dataOut) { memset(dataOut, 0, sizeof(*dataOut)); return 0; }
+
+#endif /* HOMELOCATION_H */
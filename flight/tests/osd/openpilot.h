@@ -0,0 +1 @@
+#include "pios.h"
@@ -0,0 +1 @@
+#define PIOS_VIDEO_BITS_PER_PIXEL 2
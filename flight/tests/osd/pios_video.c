@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ * @file       pios_video.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Host stand-in for the video driver's double-buffered framebuffer
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_video.h"
+
+static const struct pios_video_type_boundary pios_video_type_boundary_ntsc = {
+	.graphics_right  = 351,
+	.graphics_bottom = 239,
+};
+
+static const struct pios_video_type_boundary pios_video_type_boundary_pal = {
+	.graphics_right  = 359,
+	.graphics_bottom = 265,
+};
+
+const struct pios_video_type_boundary *pios_video_type_boundary_act = &pios_video_type_boundary_pal;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+static uint8_t buffer0_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer0_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1_level[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1_mask[BUFFER_HEIGHT * BUFFER_WIDTH];
+
+uint8_t *draw_buffer_level;
+uint8_t *draw_buffer_mask;
+uint8_t *disp_buffer_level;
+uint8_t *disp_buffer_mask;
+#else
+static uint8_t buffer0[BUFFER_HEIGHT * BUFFER_WIDTH];
+static uint8_t buffer1[BUFFER_HEIGHT * BUFFER_WIDTH];
+
+uint8_t *draw_buffer;
+uint8_t *disp_buffer;
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+
+/**
+ * Zero both buffers and make buffer 0 the draw buffer, as PIOS_Video_Init does.
+ */
+void video_reset(enum pios_video_system system)
+{
+	if (system == PIOS_VIDEO_SYSTEM_NTSC)
+		pios_video_type_boundary_act = &pios_video_type_boundary_ntsc;
+	else
+		pios_video_type_boundary_act = &pios_video_type_boundary_pal;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	draw_buffer_level = buffer0_level;
+	draw_buffer_mask  = buffer0_mask;
+	disp_buffer_level = buffer1_level;
+	disp_buffer_mask  = buffer1_mask;
+	memset(buffer0_level, 0, sizeof(buffer0_level));
+	memset(buffer0_mask, 0, sizeof(buffer0_mask));
+	memset(buffer1_level, 0, sizeof(buffer1_level));
+	memset(buffer1_mask, 0, sizeof(buffer1_mask));
+#else
+	draw_buffer = buffer0;
+	disp_buffer = buffer1;
+	memset(buffer0, 0, sizeof(buffer0));
+	memset(buffer1, 0, sizeof(buffer1));
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/**
+ * What the vsync interrupt does every field.
+ */
+void video_swap_buffers(void)
+{
+	uint8_t *tmp;
+
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	SWAP_BUFFS(tmp, disp_buffer_mask, draw_buffer_mask);
+	SWAP_BUFFS(tmp, disp_buffer_level, draw_buffer_level);
+#else
+	SWAP_BUFFS(tmp, disp_buffer, draw_buffer);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/**
+ * Set every byte of the draw buffer to a value.
+ */
+void video_fill_draw_buffer(uint8_t value)
+{
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+	memset(draw_buffer_level, value, BUFFER_HEIGHT * BUFFER_WIDTH);
+	memset(draw_buffer_mask, value, BUFFER_HEIGHT * BUFFER_WIDTH);
+#else
+	memset(draw_buffer, value, BUFFER_HEIGHT * BUFFER_WIDTH);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+}
+
+/**
+ * Count the bytes of the draw buffer holding a value.
+ */
+int video_count_draw_buffer(uint8_t value)
+{
+	int count = 0;
+
+	for (int i = 0; i < BUFFER_HEIGHT * BUFFER_WIDTH; i++) {
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+		count += (draw_buffer_level[i] == value) + (draw_buffer_mask[i] == value);
+#else
+		count += (draw_buffer[i] == value);
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+	}
+
+	return count;
+}
+
+/**
+ * Convert the draw buffer to one grey byte per pixel, as stored in the
+ * golden images: transparent is mid grey, black is 0, white is 255.
+ *
+ * @param[out] grey GRAPHICS_WIDTH_REAL * BUFFER_HEIGHT bytes
+ */
+void video_draw_buffer_to_grey(uint8_t *grey)
+{
+	static const uint8_t levels[4] = { 128, 0, 64, 255 };
+
+	for (int y = 0; y < BUFFER_HEIGHT; y++) {
+		for (int x = 0; x < GRAPHICS_WIDTH_REAL; x++) {
+			int pixel;
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+			int addr = y * BUFFER_WIDTH + x / 8;
+			int shift = 7 - (x & 7);
+			pixel = ((draw_buffer_level[addr] >> shift) & 1) << 1 |
+				((draw_buffer_mask[addr] >> shift) & 1);
+#else
+			int addr = y * BUFFER_WIDTH + x / 4;
+			int shift = 6 - 2 * (x & 3);
+			pixel = (draw_buffer[addr] >> shift) & 3;
+#endif /* defined(PIOS_VIDEO_SPLITBUFFER) */
+			*grey++ = levels[pixel];
+		}
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,40 @@
+/* The framebuffer geometry from the STM32F4 video driver header */
+#ifndef PIOS_VIDEO_H
+#define PIOS_VIDEO_H
+
+#include <stdint.h>
+
+struct pios_video_type_boundary {
+	uint16_t graphics_right;
+	uint16_t graphics_bottom;
+};
+
+enum pios_video_system {
+	PIOS_VIDEO_SYSTEM_NONE,
+	PIOS_VIDEO_SYSTEM_PAL,
+	PIOS_VIDEO_SYSTEM_NTSC,
+};
+
+extern const struct pios_video_type_boundary *pios_video_type_boundary_act;
+#define GRAPHICS_LEFT        0
+#define GRAPHICS_TOP         0
+#define GRAPHICS_RIGHT       pios_video_type_boundary_act->graphics_right
+#define GRAPHICS_BOTTOM      pios_video_type_boundary_act->graphics_bottom
+
+#define GRAPHICS_X_MIDDLE	((GRAPHICS_RIGHT + 1) / 2)
+#define GRAPHICS_Y_MIDDLE	((GRAPHICS_BOTTOM + 1) / 2)
+
+#define GRAPHICS_WIDTH_REAL  376
+#define GRAPHICS_HEIGHT_REAL 266
+#if defined(PIOS_VIDEO_SPLITBUFFER)
+#define BUFFER_WIDTH         (GRAPHICS_WIDTH_REAL / 8  + 1)
+#define BUFFER_HEIGHT        (GRAPHICS_HEIGHT_REAL)
+#else
+#define BUFFER_WIDTH_TMP     (GRAPHICS_WIDTH_REAL / (8 / PIOS_VIDEO_BITS_PER_PIXEL))
+#define BUFFER_WIDTH (BUFFER_WIDTH_TMP + BUFFER_WIDTH_TMP % 4)
+#define BUFFER_HEIGHT        (GRAPHICS_HEIGHT_REAL)
+#endif /* PIOS_VIDEO_SPLITBUFFER */
+
+#define SWAP_BUFFS(tmp, a, b) { tmp = a; a = b; b = tmp; }
+
+#endif /* PIOS_VIDEO_H */
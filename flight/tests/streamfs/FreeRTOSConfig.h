@@ -0,0 +1,2 @@
+/* Only what pios_thread.h wants; the RTOS is pthreads, see pios_rtos_posix.c */
+#define configMINIMAL_STACK_SIZE 128
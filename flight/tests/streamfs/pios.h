@@ -0,0 +1,26 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { abort(); }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#include <pios_heap.h>
+#include <pios_irq.h>
+#include <pios_delay.h>
+#include <pios_flash.h>
+#include <pios_com.h>
+
+#endif /* PIOS_H */
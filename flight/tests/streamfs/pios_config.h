@@ -0,0 +1,3 @@
+#define PIOS_INCLUDE_FLASH
+#define PIOS_INCLUDE_COM
+#define PIOS_INCLUDE_FREERTOS
@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ * @file       pios_rtos_posix.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Heap, threads, mutexes and semaphores on pthreads
+ *
+ * Enough for streamfs and PIOS_COM to run their real concurrency in a
+ * unit test.  Semaphores are binary, and created given, as on FreeRTOS.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_mutex.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+struct posix_semaphore {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	bool given;
+};
+
+static void deadline_after(struct timespec *ts, uint32_t timeout_ms)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+
+	ts->tv_sec += timeout_ms / 1000;
+	ts->tv_nsec += (timeout_ms % 1000) * 1000000;
+
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+/* Heap */
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+	free(buf);
+}
+
+bool PIOS_IRQ_InISR(void)
+{
+	return false;
+}
+
+/* Mutexes */
+
+struct pios_mutex *PIOS_Mutex_Create(void)
+{
+	struct pios_mutex *mtx = PIOS_malloc(sizeof(*mtx));
+	pthread_mutex_t *handle = PIOS_malloc(sizeof(*handle));
+
+	if (!mtx || !handle) {
+		return NULL;
+	}
+
+	pthread_mutex_init(handle, NULL);
+	mtx->mtx_handle = (uintptr_t) handle;
+
+	return mtx;
+}
+
+bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
+{
+	pthread_mutex_t *handle = (pthread_mutex_t *) mtx->mtx_handle;
+
+	if (timeout_ms == PIOS_MUTEX_TIMEOUT_MAX) {
+		return pthread_mutex_lock(handle) == 0;
+	}
+
+	if (timeout_ms == 0) {
+		return pthread_mutex_trylock(handle) == 0;
+	}
+
+	struct timespec deadline;
+	deadline_after(&deadline, timeout_ms);
+
+	return pthread_mutex_timedlock(handle, &deadline) == 0;
+}
+
+bool PIOS_Mutex_Unlock(struct pios_mutex *mtx)
+{
+	pthread_mutex_t *handle = (pthread_mutex_t *) mtx->mtx_handle;
+
+	return pthread_mutex_unlock(handle) == 0;
+}
+
+/* Semaphores */
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	struct pios_semaphore *sema = PIOS_malloc(sizeof(*sema));
+	struct posix_semaphore *handle = PIOS_malloc(sizeof(*handle));
+
+	if (!sema || !handle) {
+		return NULL;
+	}
+
+	pthread_mutex_init(&handle->lock, NULL);
+	pthread_cond_init(&handle->cond, NULL);
+	handle->given = true;
+
+	sema->sema_handle = (uintptr_t) handle;
+
+	return sema;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	struct posix_semaphore *handle = (struct posix_semaphore *) sema->sema_handle;
+	struct timespec deadline;
+	int rc = 0;
+
+	deadline_after(&deadline, timeout_ms);
+
+	pthread_mutex_lock(&handle->lock);
+
+	while (!handle->given && rc != ETIMEDOUT) {
+		if (timeout_ms == PIOS_SEMAPHORE_TIMEOUT_MAX) {
+			pthread_cond_wait(&handle->cond, &handle->lock);
+		} else {
+			rc = pthread_cond_timedwait(&handle->cond, &handle->lock,
+					&deadline);
+		}
+	}
+
+	bool taken = handle->given;
+	handle->given = false;
+
+	pthread_mutex_unlock(&handle->lock);
+
+	return taken;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	struct posix_semaphore *handle = (struct posix_semaphore *) sema->sema_handle;
+
+	pthread_mutex_lock(&handle->lock);
+
+	bool was_given = handle->given;
+	handle->given = true;
+	pthread_cond_signal(&handle->cond);
+
+	pthread_mutex_unlock(&handle->lock);
+
+	return !was_given;
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+	return PIOS_Semaphore_Give(sema);
+}
+
+/* Threads */
+
+struct thread_start {
+	void (*fp)(void *);
+	void *argp;
+};
+
+static void *thread_trampoline(void *arg)
+{
+	struct thread_start start = *(struct thread_start *) arg;
+
+	PIOS_free(arg);
+	start.fp(start.argp);
+
+	return NULL;
+}
+
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep,
+		size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	struct pios_thread *thread = PIOS_malloc(sizeof(*thread));
+	struct thread_start *start = PIOS_malloc(sizeof(*start));
+	pthread_t handle;
+
+	if (!thread || !start) {
+		return NULL;
+	}
+
+	start->fp = fp;
+	start->argp = argp;
+
+	if (pthread_create(&handle, NULL, thread_trampoline, start) != 0) {
+		return NULL;
+	}
+
+	pthread_detach(handle);
+	thread->task_handle = (uintptr_t) handle;
+
+	return thread;
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return PIOS_DELAY_GetRaw() / 1000;
+}
+
+void PIOS_Thread_Sleep(uint32_t time_ms)
+{
+	usleep(time_ms * 1000);
+}
+
+/**
+ * @}
+ * @}
+ */
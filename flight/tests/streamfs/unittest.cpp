@@ -0,0 +1,438 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for streamfs writing through PIOS_COM
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* malloc */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+#include <unistd.h>		/* usleep, unlink */
+
+extern "C" {
+
+#include "pios.h"
+#include "pios_com_priv.h"	/* PIOS_COM_Init */
+
+#include "pios_flash_priv.h"	/* struct pios_flash_partition */
+
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+
+#include "pios_flash_posix_priv.h"
+
+extern uintptr_t pios_posix_flash_id;
+extern struct pios_flash_posix_cfg flash_config;
+
+#include "pios_streamfs.h"
+#include "pios_streamfs_priv.h"
+
+extern const struct streamfs_cfg streamfs_config;
+
+}
+
+/* What the Logging module gives its COM buffer */
+#define LOG_BUF_LEN 768
+
+/* Bytes of data an arena holds, less the footer */
+#define ARENA_DATA (0x10000 - 14)
+
+static uint8_t pattern(uint32_t i)
+{
+  return i ^ (i >> 8) ^ (i >> 16);
+}
+
+class StreamfsTest : public testing::Test {
+protected:
+  virtual void SetUp() {
+    /* create an empty, appropriately sized flash */
+    FILE * theflash = fopen("theflash.bin", "w");
+    uint8_t sector[flash_config.size_of_sector];
+    memset(sector, 0xFF, sizeof(sector));
+    for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++) {
+      fwrite(sector, sizeof(sector), 1, theflash);
+    }
+    fclose(theflash);
+
+    flash_config.erase_delay_us = 0;
+    flash_config.program_delay_us = 0;
+
+    ASSERT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config));
+    PIOS_FLASH_register_partition_table(pios_flash_partition_table, pios_flash_partition_table_size);
+
+    uintptr_t fs_id;
+    ASSERT_EQ(0, PIOS_STREAMFS_Init(&fs_id, &streamfs_config, FLASH_PARTITION_LABEL_LOG));
+    ASSERT_EQ(0, PIOS_COM_Init(&com_id, &pios_streamfs_com_driver, fs_id, 0, LOG_BUF_LEN));
+  }
+
+  virtual void TearDown() {
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+    unlink("theflash.bin");
+  }
+
+  /* Blocking sends of the pattern, pausing between chunks */
+  void send_pattern(uint32_t total, uint16_t chunk, uint32_t pause_us) {
+    uint8_t buf[chunk];
+
+    for (uint32_t sent = 0; sent < total; sent += chunk) {
+      uint16_t len = (total - sent < chunk) ? total - sent : chunk;
+
+      for (uint16_t i = 0; i < len; i++) {
+        buf[i] = pattern(sent + i);
+      }
+
+      ASSERT_EQ(len, PIOS_COM_SendBuffer(com_id, buf, len));
+
+      if (pause_us) {
+        usleep(pause_us);
+      }
+    }
+  }
+
+  /* Read all of the given file */
+  uint32_t read_file(int32_t file_id, uint8_t *data, uint32_t max) {
+    uint32_t total = 0;
+
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(com_id, file_id));
+
+    while (total < max) {
+      uint32_t len = (max - total < 128) ? max - total : 128;
+      int32_t got = PIOS_STREAMFS_Read(com_id, &data[total], len);
+
+      EXPECT_LE(0, got);
+      if (got <= 0) {
+        break;
+      }
+
+      total += got;
+    }
+
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+    return total;
+  }
+
+  void expect_pattern(int32_t file_id, uint32_t len) {
+    uint8_t *data = (uint8_t *) malloc(len + 256);
+
+    EXPECT_EQ(len, read_file(file_id, data, len + 256));
+
+    for (uint32_t i = 0; i < len; i++) {
+      if (data[i] != pattern(i)) {
+        ADD_FAILURE() << "file " << file_id << " differs at " << i;
+        break;
+      }
+    }
+
+    free(data);
+  }
+
+  uint32_t flash_reads() {
+    return PIOS_Flash_Posix_GetReadCount(pios_posix_flash_id);
+  }
+
+  struct pios_streamfs_stats stats() {
+    struct pios_streamfs_stats s;
+
+    EXPECT_EQ(0, PIOS_STREAMFS_GetStats(com_id, &s));
+
+    return s;
+  }
+
+  uintptr_t com_id;
+};
+
+TEST_F(StreamfsTest, CloseFlushesPartialPage) {
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+  send_pattern(100, 100, 0);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_MaxFileId(com_id));
+
+  struct pios_streamfs_stats s = stats();
+  EXPECT_EQ(100u, s.bytes_written);
+  EXPECT_EQ(1u, s.pages_written);
+  EXPECT_EQ(0u, s.bytes_dropped);
+
+  expect_pattern(0, 100);
+}
+
+TEST_F(StreamfsTest, StreamAcrossArenas) {
+  flash_config.erase_delay_us = 5000;
+  flash_config.program_delay_us = 100;
+
+  /* Three arena boundaries, and not halfway into the fourth */
+  const uint32_t total = 3 * ARENA_DATA + ARENA_DATA / 4;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+  send_pattern(total, 128, 500);
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  struct pios_streamfs_stats s = stats();
+  EXPECT_EQ(total, s.bytes_written);
+  EXPECT_EQ(0u, s.bytes_dropped);
+  EXPECT_EQ(3u, s.erases_ahead);
+  EXPECT_EQ(0u, s.erases_inline);
+
+  expect_pattern(0, total);
+}
+
+TEST_F(StreamfsTest, EraseDoesNotStallSender) {
+  /* Too long for the page buffers alone, short enough for them plus an
+   * empty COM buffer at this rate */
+  flash_config.erase_delay_us = 10000;
+  flash_config.program_delay_us = 200;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+  /* Non-blocking, as the Logging module sends; 64 bytes a ms */
+  const uint32_t total = ARENA_DATA + ARENA_DATA / 4;
+  uint32_t dropped = 0;
+  uint8_t buf[64];
+
+  for (uint32_t sent = 0; sent < total; sent += sizeof(buf)) {
+    for (uint32_t i = 0; i < sizeof(buf); i++) {
+      buf[i] = pattern(sent + i);
+    }
+
+    if (PIOS_COM_SendBufferNonBlocking(com_id, buf, sizeof(buf)) < 0) {
+      dropped += sizeof(buf);
+    }
+
+    usleep(1000);
+  }
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  EXPECT_EQ(0u, dropped);
+
+  struct pios_streamfs_stats s = stats();
+  EXPECT_EQ(0u, s.bytes_dropped);
+  EXPECT_EQ(1u, s.erases_ahead);
+  EXPECT_EQ(0u, s.erases_inline);
+  EXPECT_LE(200u, s.write_latency_max_us);
+  EXPECT_LE(s.write_latency_avg_us, s.write_latency_max_us);
+
+  expect_pattern(0, (total + 63) & ~63u);
+}
+
+TEST_F(StreamfsTest, OverloadIsAccountedFor) {
+  /* 256 KB/s at best */
+  flash_config.program_delay_us = 1000;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+
+  /* Numbered records, sent as fast as possible */
+  const uint32_t num_records = 2000;
+  uint32_t accepted = 0;
+
+  for (uint32_t seq = 0; seq < num_records; seq++) {
+    uint32_t record[16];
+
+    for (uint32_t i = 0; i < NELEMENTS(record); i++) {
+      record[i] = seq;
+    }
+
+    if (PIOS_COM_SendBufferNonBlocking(com_id, (uint8_t *) record, sizeof(record)) > 0) {
+      accepted++;
+    }
+  }
+
+  EXPECT_GT(num_records, accepted);
+
+  /* Let it catch up, so closing has nothing to drop */
+  for (int i = 0; i < 100 && stats().bytes_written < accepted * 64; i++) {
+    usleep(10000);
+  }
+
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  struct pios_streamfs_stats s = stats();
+  EXPECT_EQ(accepted * 64, s.bytes_written);
+  EXPECT_EQ(0u, s.bytes_dropped);
+  EXPECT_LE(1000u, s.write_latency_max_us);
+
+  /* Every accepted record is there, whole and in order */
+  uint32_t *data = (uint32_t *) malloc(num_records * 64);
+  uint32_t len = read_file(0, (uint8_t *) data, num_records * 64);
+
+  ASSERT_EQ(accepted * 64, len);
+
+  int64_t last_seq = -1;
+
+  for (uint32_t r = 0; r < accepted; r++) {
+    uint32_t *record = &data[r * 16];
+
+    for (uint32_t i = 1; i < 16; i++) {
+      ASSERT_EQ(record[0], record[i]) << "record " << r;
+    }
+
+    ASSERT_LT(last_seq, record[0]);
+    last_seq = record[0];
+  }
+
+  free(data);
+}
+
+TEST_F(StreamfsTest, DataWithNoFileOpenIsDropped) {
+  uint8_t buf[500];
+
+  memset(buf, 0x55, sizeof(buf));
+
+  EXPECT_EQ(500, PIOS_COM_SendBuffer(com_id, buf, sizeof(buf)));
+
+  for (int i = 0; i < 100 && stats().bytes_dropped < sizeof(buf); i++) {
+    usleep(10000);
+  }
+
+  struct pios_streamfs_stats s = stats();
+  EXPECT_EQ(500u, s.bytes_dropped);
+  EXPECT_EQ(0u, s.bytes_written);
+}
+
+TEST_F(StreamfsTest, NextFileStartsInErasedArena) {
+  flash_config.erase_delay_us = 1000;
+
+  /* Far enough to erase the next arena ahead */
+  const uint32_t total = ARENA_DATA * 3 / 4;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(total, 256, 200);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  EXPECT_EQ(1u, stats().erases_ahead);
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(1000, 100, 0);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  EXPECT_EQ(0, PIOS_STREAMFS_MinFileId(com_id));
+  EXPECT_EQ(1, PIOS_STREAMFS_MaxFileId(com_id));
+
+  expect_pattern(0, total);
+  expect_pattern(1, 1000);
+}
+
+TEST_F(StreamfsTest, LookupsDoNotReadFlash) {
+  for (int i = 0; i < 3; i++) {
+    ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+    send_pattern(1000, 100, 0);
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+  }
+
+  uint32_t before = flash_reads();
+
+  EXPECT_EQ(0, PIOS_STREAMFS_MinFileId(com_id));
+  EXPECT_EQ(2, PIOS_STREAMFS_MaxFileId(com_id));
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(0, PIOS_STREAMFS_OpenRead(com_id, i));
+    EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+  }
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  EXPECT_EQ(before, flash_reads());
+
+  /* Reading touches only the data: 128 bytes at a time */
+  expect_pattern(1, 1000);
+
+  EXPECT_EQ(before + 8, flash_reads());
+}
+
+TEST_F(StreamfsTest, InitReadsEachFooterOnce) {
+  const uint32_t total = 2 * ARENA_DATA + 1000;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(total, 128, 0);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(1000, 100, 0);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  /* Mount it again, as after a reboot */
+  uint32_t before = flash_reads();
+
+  uintptr_t fs_id;
+  ASSERT_EQ(0, PIOS_STREAMFS_Init(&fs_id, &streamfs_config, FLASH_PARTITION_LABEL_LOG));
+  ASSERT_EQ(0, PIOS_COM_Init(&com_id, &pios_streamfs_com_driver, fs_id, 0, LOG_BUF_LEN));
+
+  EXPECT_EQ(before + 16, flash_reads());
+
+  EXPECT_EQ(0, PIOS_STREAMFS_MinFileId(com_id));
+  EXPECT_EQ(1, PIOS_STREAMFS_MaxFileId(com_id));
+
+  expect_pattern(0, total);
+  expect_pattern(1, 1000);
+}
+
+TEST_F(StreamfsTest, OldFileEndsWhereNewerOneBegins) {
+  /* Fill every arena, so moving on erases the first */
+  const uint32_t total = 16 * ARENA_DATA;
+
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(total, 128, 0);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  /* Goes where the start of file 0 was */
+  ASSERT_EQ(0, PIOS_STREAMFS_OpenWrite(com_id));
+  send_pattern(1000, 100, 0);
+  EXPECT_EQ(0, PIOS_STREAMFS_Close(com_id));
+
+  expect_pattern(1, 1000);
+
+  /* What's left of file 0 is its last 15 arenas, and nothing of file 1 */
+  const uint32_t left = 15 * ARENA_DATA;
+  uint8_t *data = (uint8_t *) malloc(left + 256);
+
+  ASSERT_EQ(left, read_file(0, data, left + 256));
+
+  for (uint32_t i = 0; i < left; i++) {
+    if (data[i] != pattern(ARENA_DATA + i)) {
+      ADD_FAILURE() << "differs at " << i;
+      break;
+    }
+  }
+
+  free(data);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,2 @@
+#include "pios.h"
+#include "uavobjectmanager.h"
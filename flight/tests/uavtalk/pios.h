@@ -0,0 +1,24 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pios_crc.h"
+#include "pios_heap.h"
+#include "pios_mutex.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+#define NELEMENTS(x) (sizeof(x) / sizeof(*(x)))
+
+/* Would be from pios_debug.h but that file pulls on way too many dependencies */
+#define PIOS_Assert(x) if (!(x)) { abort(); }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#endif /* PIOS_H */
@@ -0,0 +1 @@
+/* Nothing to select, UAVTalk only needs the stand-ins in uavobjects.c */
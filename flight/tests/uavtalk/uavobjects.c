@@ -0,0 +1,103 @@
+/* Stand-ins for the UAVO manager and the OS pieces UAVTalk uses */
+
+#include "openpilot.h"
+
+/* Objects are just their size and instance count, the payload is a pattern */
+struct UAVOBase {
+	uint32_t id;
+	uint32_t num_bytes;
+	bool single_instance;
+};
+
+struct UAVOBase uavobjects[] = {
+	{ 0x10000000, 20, true },
+	{ 0x20000000, 20, false },
+	{ 0x30000000, 100, true },
+};
+
+UAVObjHandle UAVObjGetByID(uint32_t id)
+{
+	for (unsigned int i = 0; i < NELEMENTS(uavobjects); i++) {
+		if (uavobjects[i].id == id)
+			return &uavobjects[i];
+	}
+
+	return NULL;
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj)
+{
+	return obj->id;
+}
+
+uint32_t UAVObjGetNumBytes(UAVObjHandle obj)
+{
+	return obj->num_bytes;
+}
+
+uint16_t UAVObjGetNumInstances(UAVObjHandle obj)
+{
+	return obj->single_instance ? 1 : 4;
+}
+
+bool UAVObjIsSingleInstance(UAVObjHandle obj)
+{
+	return obj->single_instance;
+}
+
+int32_t UAVObjPack(UAVObjHandle obj, uint16_t instId, uint8_t *dataOut)
+{
+	memset(dataOut, 0x55, obj->num_bytes);
+	return 0;
+}
+
+int32_t UAVObjUnpack(UAVObjHandle obj, uint16_t instId, const uint8_t *dataIn)
+{
+	return 0;
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return 1234;
+}
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+/* Single threaded, so locks and semaphores never block */
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
+{
+	return malloc(1);
+}
+
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
+{
+	return true;
+}
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	return malloc(1);
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	return false;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	return true;
+}
@@ -0,0 +1,7 @@
+/* The part of the generated header UAVTalk uses */
+#ifndef UAVOBJECTSINIT_H
+#define UAVOBJECTSINIT_H
+
+#define UAVOBJECTS_LARGEST 255
+
+#endif /* UAVOBJECTSINIT_H */
@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for packing UAVTalk objects into a shared batch
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdint.h>		/* uint*_t */
+#include <string.h>		/* memset */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavtalk.h"
+
+}
+
+/* Same as the telemetry module */
+#define TX_BATCH_LEN 128
+
+/* Bytes past the batch that must never change */
+#define GUARD_LEN 32
+#define GUARD_BYTE 0xA5
+
+#define SINGLE_OBJID 0x10000000
+#define MULTI_OBJID  0x20000000
+#define LARGE_OBJID  0x30000000
+
+class UAVTalkPack : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(batch, GUARD_BYTE, sizeof(batch));
+  }
+
+  bool guard_intact(int from) {
+    for (unsigned int i = from; i < sizeof(batch); i++) {
+      if (batch[i] != GUARD_BYTE) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  uint8_t batch[TX_BATCH_LEN + GUARD_LEN];
+};
+
+TEST_F(UAVTalkPack, PacketThatExactlyFits) {
+  UAVObjHandle obj = UAVObjGetByID(SINGLE_OBJID);
+  int32_t len = 8 + 20 + 1;
+
+  ASSERT_EQ(len, UAVTalkPackObject(obj, 0, batch, len));
+  EXPECT_EQ(0x3C, batch[0]);
+  EXPECT_EQ(len - 1, batch[2] | (batch[3] << 8));
+  EXPECT_EQ(PIOS_CRC_updateCRC(0, batch, len - 1), batch[len - 1]);
+  EXPECT_TRUE(guard_intact(len));
+}
+
+TEST_F(UAVTalkPack, NothingWrittenWhenItDoesNotFit) {
+  UAVObjHandle single = UAVObjGetByID(SINGLE_OBJID);
+  UAVObjHandle multi = UAVObjGetByID(MULTI_OBJID);
+
+  /* Includes room for less than the header */
+  for (int max_len = 0; max_len < 8 + 20 + 1; max_len++) {
+    EXPECT_EQ(-1, UAVTalkPackObject(single, 0, batch, max_len));
+    ASSERT_TRUE(guard_intact(0)) << "max_len " << max_len;
+  }
+
+  for (int max_len = 0; max_len < 10 + 20 + 1; max_len++) {
+    EXPECT_EQ(-1, UAVTalkPackObject(multi, 2, batch, max_len));
+    ASSERT_TRUE(guard_intact(0)) << "max_len " << max_len;
+  }
+}
+
+TEST_F(UAVTalkPack, BatchTailIsNeverOverrun) {
+  UAVObjHandle objs[] = {
+    UAVObjGetByID(SINGLE_OBJID),
+    UAVObjGetByID(MULTI_OBJID),
+    UAVObjGetByID(LARGE_OBJID),
+  };
+
+  /* Fill the batch the way the telemetry module does, then try every
+   * object at every fill level up to the end */
+  for (int fill = TX_BATCH_LEN - 40; fill <= TX_BATCH_LEN; fill++) {
+    for (unsigned int i = 0; i < NELEMENTS(objs); i++) {
+      memset(batch, GUARD_BYTE, sizeof(batch));
+
+      int32_t len = UAVTalkPackObject(objs[i], 1, batch + fill,
+          TX_BATCH_LEN - fill);
+
+      if (len < 0) {
+        EXPECT_TRUE(guard_intact(0)) << "fill " << fill << " object " << i;
+      } else {
+        EXPECT_LE(fill + len, TX_BATCH_LEN);
+        EXPECT_TRUE(guard_intact(fill + len)) << "fill " << fill << " object " << i;
+      }
+
+      EXPECT_TRUE(guard_intact(TX_BATCH_LEN));
+    }
+  }
+}
@@ -0,0 +1,320 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test for the UAVTalk relay scanner of the radio bridge
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand_r */
+#include <string.h>		/* memcpy */
+#include <stdint.h>		/* uint*_t */
+#include <time.h>		/* clock_gettime */
+
+#include <algorithm>
+#include <vector>
+
+extern "C" {
+
+#include "uavtalkscan.h"
+#include "pios_crc.h"
+
+}
+
+/* About UAVTALK_MAX_PACKET_LENGTH on the modem */
+#define WINDOW_SIZE 300
+
+/* Object the bridge unpacks itself rather than relaying */
+#define LOCAL_OBJID 0x2AA2D7FA
+
+/* What a flight controller sends the modem: object, payload size, whether it
+ * is multi-instance, and rate */
+static const struct recorded_object {
+  uint32_t objid;
+  uint16_t size;
+  bool multi;
+  uint8_t rate;
+} recorded_objects[] = {
+  { 0x33DAD5E6, 28, false, 50 },    // attitude
+  { 0xE9DC5F25, 24, false, 50 },    // gyros
+  { 0x6A5A1D2F, 16, false, 25 },    // accels
+  { 0x5DB2F6DA, 12, false, 10 },    // position
+  { 0xA5E7FE0B, 44, false, 5 },     // GPS
+  { 0x9E5D7FE3, 20, true, 10 },     // per-battery-cell
+  { LOCAL_OBJID, 38, false, 5 },    // RFM22BReceiver
+  { 0xD1E2B1B6, 10, false, 2 },     // flight status
+  { 0x7BD3F2A1, 26, false, 1 },     // system stats
+  { 0x0C4B3A21, 250, false, 1 },    // a large settings object
+};
+
+/**
+ * Build one frame of an object, as UAVTalk on the flight controller would.
+ */
+static void pack_frame(std::vector<uint8_t> &out, const recorded_object &obj,
+    uint16_t instid, unsigned int *seed)
+{
+  size_t start = out.size();
+  uint16_t size = 8 + (obj.multi ? 2 : 0) + obj.size;
+
+  out.push_back(0x3C);
+  out.push_back(0x20);
+  out.push_back(size & 0xff);
+  out.push_back(size >> 8);
+  for (int i = 0; i < 4; i++) {
+    out.push_back(obj.objid >> (8 * i));
+  }
+  if (obj.multi) {
+    out.push_back(instid & 0xff);
+    out.push_back(instid >> 8);
+  }
+  for (int i = 0; i < obj.size; i++) {
+    out.push_back(rand_r(seed));
+  }
+
+  out.push_back(PIOS_CRC_updateCRC(0, &out[start], size));
+}
+
+/**
+ * A recording of the telemetry stream into the modem: every object at its
+ * rate for a number of seconds, in order of sending.
+ *
+ * \param[out] frames Where each frame starts, if wanted
+ */
+static std::vector<uint8_t> record(int seconds, std::vector<size_t> *frames)
+{
+  std::vector<uint8_t> out;
+  unsigned int seed = 1;
+  const int num = sizeof(recorded_objects) / sizeof(recorded_objects[0]);
+
+  for (int ms = 0; ms < seconds * 1000; ms++) {
+    for (int i = 0; i < num; i++) {
+      const recorded_object &obj = recorded_objects[i];
+
+      if (ms % (1000 / obj.rate) == 0) {
+        if (frames) {
+          frames->push_back(out.size());
+        }
+        pack_frame(out, obj, ms / 100 % 4, &seed);
+      }
+    }
+  }
+
+  return out;
+}
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVTalkScan : public testing::Test {
+protected:
+  virtual void SetUp() {
+    uavtalk_scan_init(&scan, window, sizeof(window));
+    relayed.clear();
+    received.clear();
+  }
+
+  /* What the bridge's rx task does: receive into the window as much as
+   * the port has, up to max_read, then relay or unpack each frame.
+   * Reads cycle through the sizes given. */
+  void bridge(const std::vector<uint8_t> &in, const uint16_t *reads,
+      int num_reads) {
+    size_t pos = 0;
+
+    for (int r = 0; pos < in.size(); r++) {
+      uint16_t space;
+      uint8_t *buf = uavtalk_scan_space(&scan, &space);
+
+      ASSERT_GT(space, 0);
+
+      uint16_t len = reads[r % num_reads];
+      if (len > space) {
+        len = space;
+      }
+      if (len > in.size() - pos) {
+        len = in.size() - pos;
+      }
+
+      memcpy(buf, &in[pos], len);
+      pos += len;
+      uavtalk_scan_received(&scan, len);
+
+      uint8_t *frame;
+      uint16_t frame_len;
+
+      while ((frame_len = uavtalk_scan_next(&scan, &frame)) != 0) {
+        if (uavtalk_frame_objid(frame) == LOCAL_OBJID) {
+          received.push_back(frame_len);
+        } else {
+          relayed.insert(relayed.end(), frame, frame + frame_len);
+        }
+      }
+    }
+  }
+
+  struct uavtalk_scan scan;
+  uint8_t window[WINDOW_SIZE];
+  std::vector<uint8_t> relayed;
+  std::vector<uint16_t> received;
+};
+
+TEST_F(UAVTalkScan, FrameFields) {
+  std::vector<uint8_t> frame;
+  unsigned int seed = 1;
+  const recorded_object obj = { 0x12345678, 4, true, 1 };
+
+  pack_frame(frame, obj, 0xBEEF, &seed);
+
+  EXPECT_EQ(0x12345678u, uavtalk_frame_objid(&frame[0]));
+  EXPECT_EQ(0xBEEF, uavtalk_frame_instid(&frame[0], frame.size()));
+
+  // Too short to hold an instance id
+  EXPECT_EQ(0, uavtalk_frame_instid(&frame[0], 10));
+};
+
+TEST_F(UAVTalkScan, RelaysEveryFrameUnchanged) {
+  std::vector<size_t> frames;
+  std::vector<uint8_t> in = record(10, &frames);
+  std::vector<uint8_t> expected;
+  uint32_t local = 0;
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    size_t end = (i + 1 < frames.size()) ? frames[i + 1] : in.size();
+
+    if (uavtalk_frame_objid(&in[frames[i]]) == LOCAL_OBJID) {
+      local++;
+    } else {
+      expected.insert(expected.end(), in.begin() + frames[i], in.begin() + end);
+    }
+  }
+
+  // Byte at a time, odd sizes, a radio packet, whole windows
+  const uint16_t read_sizes[] = { 1, 7, 32, WINDOW_SIZE };
+
+  for (unsigned int i = 0; i < sizeof(read_sizes) / sizeof(read_sizes[0]); i++) {
+    SetUp();
+    bridge(in, &read_sizes[i], 1);
+
+    EXPECT_TRUE(expected == relayed) << read_sizes[i] << " byte reads";
+    EXPECT_EQ(local, received.size());
+    EXPECT_EQ(frames.size(), scan.rx_frames);
+    EXPECT_EQ(in.size(), scan.rx_bytes);
+    EXPECT_EQ(0u, scan.rx_errors);
+  }
+};
+
+TEST_F(UAVTalkScan, SkipsNoiseAndCorruptFrames) {
+  std::vector<size_t> frames;
+  std::vector<uint8_t> clean = record(5, &frames);
+  std::vector<uint8_t> in, expected;
+  unsigned int seed = 2;
+  uint32_t corrupted = 0;
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    size_t end = (i + 1 < frames.size()) ? frames[i + 1] : clean.size();
+    std::vector<uint8_t> frame(clean.begin() + frames[i], clean.begin() + end);
+
+    // Line noise between frames, now and then with a stray sync byte
+    if (i % 5 == 0) {
+      int noise = rand_r(&seed) % 20;
+      for (int j = 0; j < noise; j++) {
+        in.push_back((j == 0) ? 0x3C : rand_r(&seed));
+      }
+    }
+
+    if (i % 17 == 0) {
+      // A bit flipped past the header; the checksum must catch it
+      frame[8 + rand_r(&seed) % (frame.size() - 8)] ^= 1 << (rand_r(&seed) % 8);
+      corrupted++;
+    } else if (uavtalk_frame_objid(&frame[0]) != LOCAL_OBJID) {
+      expected.insert(expected.end(), frame.begin(), frame.end());
+    }
+
+    in.insert(in.end(), frame.begin(), frame.end());
+  }
+
+  const uint16_t reads[] = { 32, 5, 61, 1, 300 };
+  bridge(in, reads, sizeof(reads) / sizeof(reads[0]));
+
+  EXPECT_TRUE(expected == relayed);
+  EXPECT_GE(scan.rx_errors, corrupted);
+  EXPECT_EQ(in.size(), scan.rx_bytes);
+};
+
+TEST_F(UAVTalkScan, OversizedFrameIsSkipped) {
+  std::vector<uint8_t> in;
+  unsigned int seed = 3;
+  const recorded_object big = { 0x11111111, WINDOW_SIZE, false, 1 };
+  const recorded_object small = { 0x22222222, 4, false, 1 };
+
+  pack_frame(in, big, 0, &seed);
+  size_t start = in.size();
+  pack_frame(in, small, 0, &seed);
+
+  const uint16_t reads[] = { 64 };
+  bridge(in, reads, 1);
+
+  // The big frame can't be held whole, so it's scanned past
+  ASSERT_EQ(in.size() - start, relayed.size());
+  EXPECT_TRUE(std::equal(relayed.begin(), relayed.end(), in.begin() + start));
+};
+
+TEST_F(UAVTalkScan, Throughput) {
+  std::vector<uint8_t> in = record(60, NULL);
+  const uint16_t reads[] = { 32, WINDOW_SIZE };
+
+  for (int i = 0; i < 2; i++) {
+    SetUp();
+
+    double start = now_ns();
+    bridge(in, &reads[i], 1);
+    double ns = now_ns() - start;
+
+    double mbytes_per_s = in.size() / ns * 1e3;
+
+    printf("%u bytes, %u frames in %u byte reads: %.1f MB/s\n",
+        (unsigned) in.size(), scan.rx_frames, reads[i], mbytes_per_s);
+
+    // Way past what a 250 kbit/s radio or a 115200 baud port can bring in
+    EXPECT_GT(mbytes_per_s, 2.0);
+  }
+
+  EXPECT_EQ(0u, scan.rx_errors);
+};
+
+/**
+ * @}
+ * @}
+ */
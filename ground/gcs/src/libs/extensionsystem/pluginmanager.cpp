@@ -37,6 +37,7 @@
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
 #include <QtDebug>
@@ -143,6 +144,10 @@ enum { debugLeaks = 0 };
     determine the type of an object.
     If there are more than one object of the given type in
     the object pool, this method will choose an arbitrary one of them.
+    The result, including a failed lookup, is cached per type until the
+    next addObject() or removeObject(), so repeated calls are cheap.
+    Components added to an Aggregation::Aggregate that is already in the
+    pool are only seen after the next change to the pool.
 
     \sa addObject()
 */
@@ -235,6 +240,32 @@ QList<QObject *> PluginManager::allObjects() const
     return d->allObjects;
 }
 
+/*!
+    \fn bool PluginManager::cachedObject(const char *type, void **result) const
+    \internal
+    Called with the pool read locked.
+*/
+bool PluginManager::cachedObject(const char *type, void **result) const
+{
+    QMutexLocker lock(&m_cacheLock);
+    QHash<const char *, void *>::const_iterator it = m_objectCache.constFind(type);
+    if (it == m_objectCache.constEnd())
+        return false;
+    *result = it.value();
+    return true;
+}
+
+/*!
+    \fn void PluginManager::cacheObject(const char *type, void *result) const
+    \internal
+    Called with the pool read locked, so the pool can't change underneath.
+*/
+void PluginManager::cacheObject(const char *type, void *result) const
+{
+    QMutexLocker lock(&m_cacheLock);
+    m_objectCache.insert(type, result);
+}
+
 /*!
     \fn void PluginManager::loadPlugins()
     Tries to load all the plugins that were previously found when
@@ -511,6 +542,7 @@ void PluginManagerPrivate::addObject(QObject *obj)
             qDebug() << "PluginManagerPrivate::addObject" << obj << obj->objectName();
 
         allObjects.append(obj);
+        q->m_objectCache.clear();
     }
     emit q->objectAdded(obj);
 }
@@ -537,6 +569,7 @@ void PluginManagerPrivate::removeObject(QObject *obj)
     emit q->aboutToRemoveObject(obj);
     QWriteLocker lock(&(q->m_lock));
     allObjects.removeAll(obj);
+    q->m_objectCache.clear();
 }
 
 /*!
@@ -565,11 +598,47 @@ void PluginManagerPrivate::loadPlugins()
     while (it.hasPrevious()) {
         loadPlugin(it.previous(), PluginSpec::Running);
     }
+    reportStartupTimes(queue);
     emit q->pluginsChanged();
     q->m_allPluginsLoaded=true;
     emit q->pluginsLoadEnded();
 }
 
+static bool slowerStartup(const QPair<qint64, QString> &one, const QPair<qint64, QString> &two)
+{
+    return one.first > two.first;
+}
+
+/*!
+    \fn void PluginManagerPrivate::reportStartupTimes(const QList<PluginSpec *> &queue) const
+    \internal
+    Logs how long each plugin took to load, initialize() and
+    extensionsInitialized(), slowest first.
+*/
+void PluginManagerPrivate::reportStartupTimes(const QList<PluginSpec *> &queue) const
+{
+    QList<QPair<qint64, QString> > lines;
+    qint64 total = 0;
+
+    foreach (PluginSpec *spec, queue) {
+        const StartupTimes t = startupTimes.value(spec);
+        const qint64 sum = t.load + t.initialize + t.extensions;
+        total += sum;
+        lines.append(qMakePair(sum, QString("%1 %2 ms (load %3, initialize %4, extensionsInitialized %5)")
+                               .arg(spec->name(), -24)
+                               .arg(sum / 1000.0, 7, 'f', 1)
+                               .arg(t.load / 1000.0, 0, 'f', 1)
+                               .arg(t.initialize / 1000.0, 0, 'f', 1)
+                               .arg(t.extensions / 1000.0, 0, 'f', 1)));
+    }
+
+    qSort(lines.begin(), lines.end(), slowerStartup);
+
+    qDebug() << "Plugin startup took" << total / 1000 << "ms";
+    for (int i = 0; i < lines.size(); i++)
+        qDebug().noquote() << "  " << lines.at(i).second;
+}
+
 /*!
     \fn void PluginManagerPrivate::loadQueue()
     \internal
@@ -636,8 +705,11 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
 {
     if (spec->hasError())
         return;
+    QElapsedTimer timer;
     if (destState == PluginSpec::Running) {
+        timer.start();
         spec->d->initializeExtensions();
+        startupTimes[spec].extensions = timer.nsecsElapsed() / 1000;
         return;
     } else if (destState == PluginSpec::Deleted) {
         spec->d->kill();
@@ -652,11 +724,14 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
             return;
         }
     }
-    if (destState == PluginSpec::Loaded)
+    timer.start();
+    if (destState == PluginSpec::Loaded) {
         spec->d->loadLibrary();
-    else if (destState == PluginSpec::Initialized)
+        startupTimes[spec].load = timer.nsecsElapsed() / 1000;
+    } else if (destState == PluginSpec::Initialized) {
         spec->d->initializePlugin();
-    else if (destState == PluginSpec::Stopped)
+        startupTimes[spec].initialize = timer.nsecsElapsed() / 1000;
+    } else if (destState == PluginSpec::Stopped)
         spec->d->stop();
 }
 
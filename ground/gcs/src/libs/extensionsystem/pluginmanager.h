@@ -37,6 +37,10 @@
 #include <QtCore/QObject>
 #include <QtCore/QStringList>
 #include <QtCore/QReadWriteLock>
+#include <QtCore/QMutex>
+#include <QtCore/QHash>
+
+#include <typeinfo>
 
 QT_BEGIN_NAMESPACE
 class QTextStream;
@@ -82,12 +86,17 @@ public:
     template <typename T> T *getObject() const
     {
         QReadLocker lock(&m_lock);
+        const char *type = typeid(T).name();
+        void *cached;
+        if (cachedObject(type, &cached))
+            return static_cast<T *>(cached);
         QList<QObject *> all = allObjects();
         T *result = 0;
         foreach (QObject *obj, all) {
             if ((result = Aggregation::query<T>(obj)) != 0)
                 break;
         }
+        cacheObject(type, result);
         return result;
     }
 
@@ -122,9 +131,15 @@ private slots:
     void startTests();
 
 private:
+    bool cachedObject(const char *type, void **result) const;
+    void cacheObject(const char *type, void *result) const;
+
     Internal::PluginManagerPrivate *d;
     static PluginManager *m_instance;
     mutable QReadWriteLock m_lock;
+    // Keyed by typeid name; a type seen through two names just gets two entries
+    mutable QMutex m_cacheLock;
+    mutable QHash<const char *, void *> m_objectCache;
     bool m_allPluginsLoaded;
 
     friend class Internal::PluginManagerPrivate;
@@ -31,6 +31,7 @@
 
 #include "pluginspec.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
@@ -69,6 +70,15 @@ public:
 
     QStringList arguments;
 
+    // Wall time spent in each startup phase of a plugin, in microseconds
+    struct StartupTimes {
+        StartupTimes() : load(0), initialize(0), extensions(0) {}
+        qint64 load;
+        qint64 initialize;
+        qint64 extensions;
+    };
+    QHash<PluginSpec *, StartupTimes> startupTimes;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
@@ -84,6 +94,7 @@ private:
             QList<PluginSpec *> &queue,
             QList<PluginSpec *> &circularityCheckQueue);
     void stopAll();
+    void reportStartupTimes(const QList<PluginSpec *> &queue) const;
 };
 
 } // namespace Internal
@@ -47,6 +47,7 @@ private slots:
     void cleanup();
     void addRemoveObjects();
     void getObject();
+    void getObjectCached();
     void getObjects();
     void plugins();
     void circularPlugins();
@@ -165,6 +166,26 @@ void tst_PluginManager::getObject()
     delete object11;
 }
 
+void tst_PluginManager::getObjectCached()
+{
+    MyClass1 *object1 = new MyClass1;
+    MyClass11 *object11 = new MyClass11;
+    m_pm->addObject(object1);
+    QCOMPARE(m_pm->getObject<MyClass1>(), object1);
+    QCOMPARE(m_pm->getObject<MyClass1>(), object1);
+    QCOMPARE(m_pm->getObject<MyClass11>(), (MyClass11*)0);
+    m_pm->addObject(object11);
+    QCOMPARE(m_pm->getObject<MyClass11>(), object11);
+    QCOMPARE(m_pm->getObject<MyClass1>(), object1);
+    m_pm->removeObject(object1);
+    QCOMPARE(m_pm->getObject<MyClass1>(), qobject_cast<MyClass1*>(object11));
+    m_pm->removeObject(object11);
+    QCOMPARE(m_pm->getObject<MyClass1>(), (MyClass1*)0);
+    QCOMPARE(m_pm->getObject<MyClass11>(), (MyClass11*)0);
+    delete object1;
+    delete object11;
+}
+
 void tst_PluginManager::getObjects()
 {
     MyClass1 *object1 = new MyClass1;
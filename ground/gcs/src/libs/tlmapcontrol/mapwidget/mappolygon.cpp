@@ -0,0 +1,103 @@
+/**
+******************************************************************************
+*
+* @file       mappolygon.cpp
+* @author     dRonin, http://dronin.org Copyright (C) 2016
+* @brief      A graphicsItem representing a closed polygon of map coordinates
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "mappolygon.h"
+#include <QPainter>
+
+namespace mapcontrol
+{
+MapPolygon::MapPolygon(const QVector<internals::PointLatLng> &vertices, MapGraphicItem *map, QColor color, bool filled) :
+    QGraphicsPolygonItem(map), my_map(map), myVertices(vertices),
+    myColor(color), myFilled(filled), myClosed(true)
+{
+    this->setZValue(7);
+    refreshLocations();
+    connect(map, SIGNAL(childRefreshPosition()), this, SLOT(refreshLocations()));
+    connect(map, SIGNAL(childSetOpacity(qreal)), this, SLOT(setOpacitySlot(qreal)));
+}
+
+int MapPolygon::type() const
+{
+    // Enable the use of qgraphicsitem_cast with this item.
+    return Type;
+}
+
+void MapPolygon::setVertices(const QVector<internals::PointLatLng> &vertices)
+{
+    myVertices = vertices;
+    refreshLocations();
+}
+
+void MapPolygon::setClosed(bool closed)
+{
+    myClosed = closed;
+    update();
+}
+
+void MapPolygon::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    QPen myPen = pen();
+    myPen.setColor(myColor);
+    myPen.setWidth(2);
+    painter->setPen(myPen);
+
+    if (!myClosed) {
+        painter->drawPolyline(polygon());
+        return;
+    }
+
+    if (myFilled) {
+        QColor fill = myColor;
+        fill.setAlpha(60);
+        painter->setBrush(fill);
+    } else {
+        painter->setBrush(Qt::NoBrush);
+    }
+
+    painter->drawPolygon(polygon());
+}
+
+void MapPolygon::refreshLocations()
+{
+    QPolygonF local;
+
+    foreach (const internals::PointLatLng &vertex, myVertices) {
+        core::Point p = my_map->FromLatLngToLocal(vertex);
+        local << QPointF(p.X(), p.Y());
+    }
+
+    setPolygon(local);
+}
+
+void MapPolygon::setOpacitySlot(qreal opacity)
+{
+    setOpacity(opacity);
+}
+
+}
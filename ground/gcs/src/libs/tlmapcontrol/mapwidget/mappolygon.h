@@ -0,0 +1,65 @@
+/**
+******************************************************************************
+*
+* @file       mappolygon.h
+* @author     dRonin, http://dronin.org Copyright (C) 2016
+* @brief      A graphicsItem representing a closed polygon of map coordinates
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef MAPPOLYGON_H
+#define MAPPOLYGON_H
+
+#include "mapgraphicitem.h"
+#include "../core/corecommon.h"
+#include <QGraphicsPolygonItem>
+#include <QVector>
+
+namespace mapcontrol
+{
+
+class TLMAPWIDGET_EXPORT MapPolygon : public QObject, public QGraphicsPolygonItem
+{
+    Q_OBJECT
+    Q_INTERFACES(QGraphicsItem)
+public:
+    enum { Type = UserType + 10 };
+    MapPolygon(const QVector<internals::PointLatLng> &vertices, MapGraphicItem *map, QColor color=Qt::red, bool filled=false);
+    int type() const;
+    QVector<internals::PointLatLng> vertices() const
+        { return myVertices; }
+    void setVertices(const QVector<internals::PointLatLng> &vertices);
+    //! An open polygon is drawn as a polyline, e.g. while it is being entered
+    void setClosed(bool closed);
+private:
+    MapGraphicItem *my_map;
+    QVector<internals::PointLatLng> myVertices;
+    QColor myColor;
+    bool myFilled;
+    bool myClosed;
+protected:
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+public slots:
+    void refreshLocations();
+    void setOpacitySlot(qreal opacity);
+};
+}
+
+#endif // MAPPOLYGON_H
@@ -177,6 +177,13 @@ namespace mapcontrol
         return ret;
     }
 
+    MapPolygon *TLMapWidget::PolygonCreate(const QVector<internals::PointLatLng> &vertices, QColor color, bool filled)
+    {
+        MapPolygon* ret= new MapPolygon(vertices,map,color,filled);
+        ret->setOpacity(overlayOpacity);
+        return ret;
+    }
+
     void TLMapWidget::SetShowUAV(const bool &value)
     {
         if(value && UAV==0)
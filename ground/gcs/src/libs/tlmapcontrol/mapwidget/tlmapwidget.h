@@ -43,6 +43,7 @@
 #include "mapripper.h"
 #include "mapline.h"
 #include "mapcircle.h"
+#include "mappolygon.h"
 #include "waypointcurve.h"
 #include "waypointitem.h"
 #include "../core/corecommon.h"
@@ -378,6 +379,8 @@ namespace mapcontrol
         MapCircle *WPCircleCreate(WayPointItem *center, WayPointItem *radius,bool clockwise,QColor color);
         //! Create a circle around home with the radius specifed by the distance to another waypoint
         MapCircle *WPCircleCreate(HomeItem *center, WayPointItem *radius,bool clockwise,QColor color);
+        //! Create an outline through a list of coordinates, optionally shaded inside
+        MapPolygon *PolygonCreate(const QVector<internals::PointLatLng> &vertices, QColor color, bool filled);
 
         void deleteAllOverlays();
         void WPSetVisibleAll(bool value);
@@ -16,6 +16,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/traillineitem.cpp \
     mapwidget/mapline.cpp \
     mapwidget/mapcircle.cpp \
+    mapwidget/mappolygon.cpp \
     mapwidget/waypointcurve.cpp \
     mapwidget/tlmapwidget.cpp \
     core/pureimagecache.cpp \
@@ -68,6 +69,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/traillineitem.h \
     mapwidget/mapline.h \
     mapwidget/mapcircle.h \
+    mapwidget/mappolygon.h \
     mapwidget/waypointcurve.h \
     mapwidget/tlmapwidget.h \
     core/size.h \
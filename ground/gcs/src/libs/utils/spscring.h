@@ -0,0 +1,139 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spscring.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @brief Lock-free single producer, single consumer byte ring, for handing
+ *        data between an I/O thread and its consumer
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstring>
+#include <cstddef>
+
+namespace Utils {
+
+/**
+*   Byte FIFO that one thread may write to while another reads from it,
+*   without either of them taking a lock.  The capacity must be a power of
+*   two.  Head and tail run freely and are only masked on access, so the
+*   full capacity is usable.
+*/
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+        : m_buf(new char[capacity]),
+          m_mask(capacity - 1),
+          m_head(0),
+          m_tail(0)
+    {
+    }
+
+    ~SpscRing() { delete[] m_buf; }
+
+    size_t capacity() const { return m_mask + 1; }
+
+    /** Bytes that can be read; safe from either thread */
+    size_t available() const
+    {
+        return m_head.load(std::memory_order_acquire) -
+                m_tail.load(std::memory_order_acquire);
+    }
+
+    /** Bytes that can be written; safe from either thread */
+    size_t space() const { return capacity() - available(); }
+
+    /** Producer only: append up to size bytes, returns the number taken */
+    size_t write(const char *data, size_t size)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        size_t tail = m_tail.load(std::memory_order_acquire);
+
+        size_t n = capacity() - (head - tail);
+        if (size < n)
+            n = size;
+
+        size_t off = head & m_mask;
+        size_t first = capacity() - off;
+        if (first > n)
+            first = n;
+
+        memcpy(m_buf + off, data, first);
+        memcpy(m_buf, data + first, n - first);
+
+        m_head.store(head + n, std::memory_order_release);
+
+        return n;
+    }
+
+    /** Consumer only: copy without consuming, returns the number copied */
+    size_t peek(char *data, size_t size) const
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        size_t head = m_head.load(std::memory_order_acquire);
+
+        size_t n = head - tail;
+        if (size < n)
+            n = size;
+
+        size_t off = tail & m_mask;
+        size_t first = capacity() - off;
+        if (first > n)
+            first = n;
+
+        memcpy(data, m_buf + off, first);
+        memcpy(data + first, m_buf, n - first);
+
+        return n;
+    }
+
+    /** Consumer only: drop bytes previously returned by peek() */
+    void consume(size_t size)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + size,
+                std::memory_order_release);
+    }
+
+    /** Consumer only: remove up to size bytes, returns the number read */
+    size_t read(char *data, size_t size)
+    {
+        size_t n = peek(data, size);
+
+        consume(n);
+
+        return n;
+    }
+
+private:
+    SpscRing(const SpscRing &);
+    SpscRing &operator=(const SpscRing &);
+
+    char *m_buf;
+    const size_t m_mask;
+
+    std::atomic<size_t> m_head;     /**< Written only by the producer */
+    std::atomic<size_t> m_tail;     /**< Written only by the consumer */
+};
+
+} // namespace Utils
+
+#endif // SPSCRING_H
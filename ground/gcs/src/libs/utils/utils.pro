@@ -57,7 +57,8 @@ HEADERS += utils_global.h \
     homelocationutil.h \
     mytabbedstackwidget.h \
     mytabwidget.h \
-    svgimageprovider.h
+    svgimageprovider.h \
+    spscring.h
 
 
 HEADERS += xmlconfig.h
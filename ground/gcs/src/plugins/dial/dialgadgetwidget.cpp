@@ -84,6 +84,8 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
     if (obj3 != NULL)
         disconnect(obj3,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(updateNeedle3(UAVObject*)));
 
+    handle1 = handle2 = handle3 = UAVObjectFieldHandle();
+
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
@@ -105,6 +107,8 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                 field1=  nfield1;
                 haveSubField1 = false;
             }
+            handle1 = UAVObjectFieldHandle::resolve(obj1, field1,
+                                                   haveSubField1 ? subfield1 : QString());
         } else {
             qDebug() << "Error: Object is unknown (" << object1 << ").";
         }
@@ -128,6 +132,8 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                 field2=  nfield2;
                 haveSubField2 = false;
             }
+            handle2 = UAVObjectFieldHandle::resolve(obj2, field2,
+                                                   haveSubField2 ? subfield2 : QString());
         } else {
             qDebug() << "Error: Object is unknown (" << object2 << ").";
         }
@@ -151,6 +157,8 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                 field3=  nfield3;
                 haveSubField3 = false;
             }
+            handle3 = UAVObjectFieldHandle::resolve(obj3, field3,
+                                                   haveSubField3 ? subfield3 : QString());
         } else {
             qDebug() << "Error: Object is unknown (" << object3 << ").";
         }
@@ -162,14 +170,8 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
   */
 void DialGadgetWidget::updateNeedle1(UAVObject *object1) {
     // Double check that the field exists:
-    double value;
-    UAVObjectField* field = object1->getField(field1);
-    if (field) {
-        if(haveSubField1){
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield1, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    if (handle1.matches(object1)) {
+        double value = handle1.toDouble(object1);
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -184,14 +186,8 @@ void DialGadgetWidget::updateNeedle1(UAVObject *object1) {
   \brief Called by the UAVObject which got updated
   */
 void DialGadgetWidget::updateNeedle2(UAVObject *object2) {
-    double value;
-    UAVObjectField* field = object2->getField(field2);
-    if (field) {
-        if(haveSubField2){
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield2, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    if (handle2.matches(object2)) {
+        double value = handle2.toDouble(object2);
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -206,14 +202,8 @@ void DialGadgetWidget::updateNeedle2(UAVObject *object2) {
   \brief Called by the UAVObject which got updated
   */
 void DialGadgetWidget::updateNeedle3(UAVObject *object3) {
-    double value;
-    UAVObjectField* field = object3->getField(field3);
-    if (field) {
-        if(haveSubField3){
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield3, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else
-            value = field->getDouble();
+    if (handle3.matches(object3)) {
+        double value = handle3.toDouble(object3);
         if (value != value) {
             qDebug() << "Dial widget: encountered NaN !!";
             return;
@@ -33,6 +33,7 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
+#include "uavobjectfieldhandle.h"
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
@@ -143,6 +144,10 @@ private:
    QString field3;
    QString subfield3;
    bool haveSubField3;
+   // Resolved once on connection, so updates don't look fields up by name
+   UAVObjectFieldHandle handle1;
+   UAVObjectFieldHandle handle2;
+   UAVObjectFieldHandle handle3;
 
    // Rotation timer
    QTimer dialTimer;
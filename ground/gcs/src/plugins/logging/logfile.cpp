@@ -33,8 +33,26 @@
 
 #include <coreplugin/coreconstants.h>
 
+namespace {
+
+// Enough for several seconds of telemetry, so a 10x replay can be fed in
+// one go per timer tick
+const size_t REPLAY_BUFFER_SIZE = 1024 * 1024;
+const int REPLAY_INTERVAL_MS = 10;
+const qint64 RECORD_HEADER_SIZE = sizeof(quint32) + sizeof(qint64);
+
+}
+
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
+    replayBuffer(REPLAY_BUFFER_SIZE),
+    lastTimeStamp(0),
+    lastPlayTime(0),
+    lastPlayTimeOffset(0),
+    playbackSpeed(1),
+    maxSpeed(false),
+    logData(NULL),
+    logSize(0),
     timestampBufferIdx(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
@@ -74,13 +92,7 @@ bool LogFile::open(OpenMode mode) {
      */
     if(mode==QIODevice::WriteOnly)
     {
-        QString gitHash = QString::fromLatin1(Core::Constants::GCS_REVISION_STR);
-        // UAVOSHA1_STR looks something like: "{ 0xbd,0xfc,0x47,0x16,0x59,0xb9,0x08,0x18,0x1c,0x82,0x5e,0x3f,0xe1,0x1a,0x77,0x7f,0x4e,0x06,0xea,0x7c }"
-        // This string needs to be reduced to just the hex letters, so in the example we need: bdfc471659b908181c825e3fe11a777f4e06ea7c
-        QString uavoHash = QString::fromLatin1(Core::Constants::UAVOSHA1_STR).replace("\"{ ", "").replace(" }\"", "").replace(",", "").replace("0x", "");
-        QTextStream out(&file);
-
-        out << "dRonin git hash:\n" <<  gitHash << "\n" << uavoHash << "\n##\n";
+        file.write(fileHeader());
     }
     else if(mode == QIODevice::ReadOnly)
     {
@@ -119,6 +131,14 @@ bool LogFile::open(OpenMode mode) {
 
             //Since we could not find the file separator, we need to return to the beginning of the file
             file.seek(0);
+        } else if (file.peek(4) == "DRLZ") {
+            // Written by the raw stream recorder with compression on
+            if (!inflateBlocks()) {
+                QMessageBox msgBox;
+                msgBox.setText("Corrupted file.");
+                msgBox.setInformativeText("GCS could not decompress the log. GCS will play what it could recover.");
+                msgBox.exec();
+            }
         }
 
     }
@@ -135,12 +155,75 @@ bool LogFile::open(OpenMode mode) {
     return true;
 }
 
+/**
+ * The text header at the start of every log file, followed by the
+ * separator after which the timestamped packets begin.
+ */
+QByteArray LogFile::fileHeader()
+{
+    QString gitHash = QString::fromLatin1(Core::Constants::GCS_REVISION_STR);
+    // UAVOSHA1_STR looks something like: "{ 0xbd,0xfc,0x47,0x16,0x59,0xb9,0x08,0x18,0x1c,0x82,0x5e,0x3f,0xe1,0x1a,0x77,0x7f,0x4e,0x06,0xea,0x7c }"
+    // This string needs to be reduced to just the hex letters, so in the example we need: bdfc471659b908181c825e3fe11a777f4e06ea7c
+    QString uavoHash = QString::fromLatin1(Core::Constants::UAVOSHA1_STR).replace("\"{ ", "").replace(" }\"", "").replace(",", "").replace("0x", "");
+
+    return QString("dRonin git hash:\n%1\n%2\n##\n").arg(gitHash).arg(uavoHash).toLatin1();
+}
+
+/**
+ * Decompress a block compressed body into a temporary file and replay
+ * from that instead, so the rest of the replay code sees a plain log.
+ * Each block is "DRLZ", first timestamp, raw size, compressed size (all
+ * u32) and the qCompress()ed records; the block index that follows the
+ * last block is not needed for a linear replay.
+ * @return false if a block was truncated or would not decompress
+ */
+bool LogFile::inflateBlocks()
+{
+    bool ok = true;
+
+    inflated.reset(new QTemporaryFile());
+    if (!inflated->open())
+        return false;
+
+    while (file.read(4) == "DRLZ") {
+        quint32 hdr[3];
+
+        if (file.read((char *) hdr, sizeof(hdr)) != sizeof(hdr)) {
+            ok = false;
+            break;
+        }
+
+        QByteArray block = qUncompress(file.read(hdr[2]));
+        if (block.size() != (int) hdr[1]) {
+            ok = false;
+            break;
+        }
+
+        inflated->write(block);
+    }
+
+    inflated->flush();
+
+    file.close();
+    file.setFileName(inflated->fileName());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return ok;
+}
+
 void LogFile::close()
 {
     emit aboutToClose();
 
     if (timer.isActive())
         timer.stop();
+
+    if (logData && logCopy.isEmpty())
+        file.unmap(const_cast<uchar *>(logData));
+    logData = NULL;
+    logCopy.clear();
+
     file.close();
     QIODevice::close();
 }
@@ -162,77 +245,94 @@ qint64 LogFile::writeData(const char * data, qint64 dataSize) {
 }
 
 qint64 LogFile::readData(char * data, qint64 maxSize) {
-    QMutexLocker locker(&mutex);
-    qint64 toRead = qMin(maxSize,(qint64)dataBuffer.size());
-    memcpy(data,dataBuffer.data(),toRead);
-    dataBuffer.remove(0,toRead);
-    return toRead;
+    return replayBuffer.read(data, maxSize);
 }
 
 qint64 LogFile::bytesAvailable() const
 {
-    return dataBuffer.size();
+    return replayBuffer.available() + QIODevice::bytesAvailable();
 }
 
+/**
+ * Feed every packet that is due into the replay buffer.  Packets are
+ * copied straight out of the mapped log; if the reader hasn't made room
+ * for the next one it is left for the next tick rather than dropped.
+ */
 void LogFile::timerFired()
 {
-    qint64 dataSize;
+    int time = myTime.elapsed();
+    lastPlayTime += (time - lastPlayTimeOffset) * playbackSpeed;
+    lastPlayTimeOffset = time;
 
-    if(file.bytesAvailable() > 4)
-    {
+    bool fed = false;
 
-        int time;
-        time = myTime.elapsed();
+    while (timestampBufferIdx < (quint32) timestampBuffer.size()) {
+        quint32 due = timestampBuffer[timestampBufferIdx] - firstTimestamp;
 
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+        if (!maxSpeed && due > lastPlayTime)
+            break;
 
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
+        const uchar *record = logData + timestampPos[timestampBufferIdx];
+        qint64 dataSize;
+        memcpy(&dataSize, record + sizeof(quint32), sizeof(dataSize));
 
-            file.read((char *) &dataSize, sizeof(dataSize));
+        if (replayBuffer.space() < (size_t) dataSize)
+            break;
 
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+        replayBuffer.write((const char *) record + RECORD_HEADER_SIZE, dataSize);
+        fed = true;
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+        lastTimeStamp = timestampBuffer[timestampBufferIdx];
+        timestampBufferIdx++;
 
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+        // Keeps the clock continuous if max speed is turned off again
+        if (maxSpeed)
+            lastPlayTime = due;
+    }
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+    if (fed)
+        emit readyRead();
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+    if (timestampBufferIdx >= (quint32) timestampBuffer.size() && !replayBuffer.available())
+        stopReplay();
+}
 
+/**
+ * Map the body of the log so the replay can index straight into it,
+ * falling back to reading it all into memory.
+ */
+bool LogFile::mapLog()
+{
+    // A previous replay's mapping or copy
+    if (logData && logCopy.isEmpty())
+        file.unmap(const_cast<uchar *>(logData));
+    logData = NULL;
+    logCopy.clear();
+
+    logSize = file.size();
+    logData = file.map(0, logSize);
+
+    if (!logData) {
+        qint64 pos = file.pos();
+
+        file.seek(0);
+        logCopy = file.readAll();
+        file.seek(pos);
+
+        if (logCopy.size() != logSize) {
+            logCopy.clear();
+            return false;
         }
-    } else {
-        stopReplay();
+
+        logData = (const uchar *) logCopy.constData();
     }
 
+    return true;
 }
 
 bool LogFile::startReplay() {
-    dataBuffer.clear();
+    // Drop anything left from a previous replay
+    replayBuffer.consume(replayBuffer.available());
     myTime.restart();
     lastPlayTimeOffset = 0;
     lastPlayTime = 0;
@@ -241,29 +341,40 @@ bool LogFile::startReplay() {
     //Read all log timestamps into array
     timestampBuffer.clear(); //Save beginning of log for later use
     timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
     timestampBufferIdx = 0;
     lastTimeStamp = 0;
 
-    while (!file.atEnd()){
-        qint64 dataSize;
+    if (!mapLog()) {
+        QMessageBox msgBox;
+        msgBox.setText("Unreadable logfile.");
+        msgBox.setInformativeText("The log could not be read into memory.");
+        msgBox.exec();
 
-        //Get time stamp position
-        timestampPos.append(file.pos());
+        stopReplay();
+        return false;
+    }
+
+    qint64 pos = file.pos();
+
+    while (pos + RECORD_HEADER_SIZE <= logSize) {
+        qint64 dataSize;
 
         //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
+        memcpy(&lastTimeStamp, logData + pos, sizeof(lastTimeStamp));
+        memcpy(&dataSize, logData + pos + sizeof(lastTimeStamp), sizeof(dataSize));
 
         //Check if dataSize sync bytes are correct.
         //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
+        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0 || dataSize < 1){
+            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos + sizeof(lastTimeStamp) + sizeof(dataSize),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
+            pos++;
             continue;
         }
 
+        // Truncated last packet
+        if (pos + RECORD_HEADER_SIZE + dataSize > logSize)
+            break;
+
         //Check if timestamps are sequential.
         if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
             QMessageBox msgBox;
@@ -274,9 +385,10 @@ bool LogFile::startReplay() {
             qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
         }
 
+        timestampPos.append(pos);
         timestampBuffer.append(lastTimeStamp);
 
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
+        pos += RECORD_HEADER_SIZE + dataSize;
     }
 
     //Check if any timestamps were successfully read
@@ -290,14 +402,10 @@ bool LogFile::startReplay() {
         return false;
     }
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
     lastTimeStamp = timestampBuffer[0];
     firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
 
-    timer.setInterval(10);
+    timer.setInterval(maxSpeed ? 0 : REPLAY_INTERVAL_MS);
     timer.start();
     emit replayStarted();
     return true;
@@ -326,17 +434,32 @@ void LogFile::resumeReplay()
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
-    }
+    quint32 target = val * 1000;
+    quint32 tmpIdx = 0;
+
+    while (tmpIdx + 1 < (quint32) timestampBuffer.size() &&
+           timestampBuffer[tmpIdx] - firstTimestamp < target)
+        tmpIdx++;
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    lastTimeStamp = timestampBuffer.value(tmpIdx);
+    timestampBufferIdx = tmpIdx;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime = lastTimeStamp - firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
 }
 
+/**
+ * @brief LogFile::setReplayMaxSpeed, ignores the timestamps and feeds
+ * packets as fast as the reader takes them, for batch analysis
+ * @param enable, true for max speed, false to go back to the playback speed
+ */
+void LogFile::setReplayMaxSpeed(bool enable)
+{
+    maxSpeed = enable;
+    lastPlayTimeOffset = myTime.elapsed();
+
+    timer.setInterval(maxSpeed ? 0 : REPLAY_INTERVAL_MS);
+}
+
@@ -34,7 +34,10 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QTemporaryFile>
+#include <QScopedPointer>
 #include "uavobjectmanager.h"
+#include <utils/spscring.h>
 #include <math.h>
 
 class LogFile : public QIODevice
@@ -53,9 +56,12 @@ public:
     bool startReplay();
     bool stopReplay();
 
+    static QByteArray fileHeader();
+
 public slots:
     void setReplaySpeed(double val) { playbackSpeed = val; qDebug() << "New playback speed: " << playbackSpeed; }
     void setReplayTime(double val);
+    void setReplayMaxSpeed(bool enable);
     void pauseReplay();
     void resumeReplay();
 
@@ -68,23 +74,29 @@ signals:
     void replayFinished();
 
 protected:
-    QByteArray dataBuffer;
+    Utils::SpscRing replayBuffer;   /**< Packets fed to the reader */
     QTimer timer;
     QTime myTime;
     QFile file;
     quint32 lastTimeStamp;
-    quint32 lastPlayTime;
-    QMutex mutex;
+    double lastPlayTime;            /**< Log time played so far, ms after the first packet */
 
 
     int lastPlayTimeOffset;
     double playbackSpeed;
+    bool maxSpeed;
 
 private:
+    bool inflateBlocks();
+    bool mapLog();
+
+    QScopedPointer<QTemporaryFile> inflated;
+    const uchar *logData;           /**< Whole log, mapped or copied into logCopy */
+    qint64 logSize;
+    QByteArray logCopy;
     QList<quint32> timestampBuffer;
     QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
-    quint32 lastTimeStampPos;
+    quint32 timestampBufferIdx;     /**< Next packet to feed */
     quint32 firstTimestamp;
 };
 
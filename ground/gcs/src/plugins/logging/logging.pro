@@ -10,7 +10,8 @@ HEADERS += loggingplugin.h \
     logginggadget.h \
     logginggadgetfactory.h \
     loggingdevice.h \
-    flightlogdownload.h
+    flightlogdownload.h \
+    rawstreamrecorder.h
 #    logginggadgetconfiguration.h
 #   logginggadgetoptionspage.h
 
@@ -20,7 +21,8 @@ SOURCES += loggingplugin.cpp \
     logginggadget.cpp \
     logginggadgetfactory.cpp \
     loggingdevice.cpp \
-    flightlogdownload.cpp
+    flightlogdownload.cpp \
+    rawstreamrecorder.cpp
 #    logginggadgetconfiguration.cpp \
 #    logginggadgetoptionspage.cpp
 OTHER_FILES += LoggingGadget.pluginspec \
@@ -57,6 +57,7 @@ void LoggingGadgetWidget::setPlugin(LoggingPlugin * p)
     connect(m_logging->playButton,SIGNAL(clicked()),p->getLogfile(),SLOT(resumeReplay()));
     connect(m_logging->pauseButton,SIGNAL(clicked()),p->getLogfile(),SLOT(pauseReplay()));
     connect(m_logging->playbackSpeedSpinBox,SIGNAL(valueChanged(double)),p->getLogfile(),SLOT(setReplaySpeed(double)));
+    connect(m_logging->maxSpeedCheckBox,SIGNAL(toggled(bool)),p->getLogfile(),SLOT(setReplayMaxSpeed(bool)));
     connect(m_logging->jumpToTimeSpinBox,SIGNAL(valueChanged(double)),p->getLogfile(),SLOT(setReplayTime(double)));
 
     void pauseReplay();
@@ -46,6 +46,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <QKeySequence>
 #include "uavobjectmanager.h"
+#include "uavtalk/telemetrymanager.h"
 
 
 LoggingConnection::LoggingConnection()
@@ -321,6 +322,9 @@ LoggingPlugin::~LoggingPlugin()
     if (loggingThread)
         delete loggingThread;
 
+    if (rawRecorder)
+        delete rawRecorder;
+
     // Don't delete it, the plugin manager will do it:
     //delete logConnection;
 }
@@ -334,7 +338,7 @@ bool LoggingPlugin::initialize(const QStringList& args, QString *errMsg)
     Q_UNUSED(errMsg);
 
     loggingThread = NULL;
-
+    rawRecorder = NULL;
 
     // Add Menu entry
     Core::ActionManager* am = Core::ICore::instance()->actionManager();
@@ -354,6 +358,16 @@ bool LoggingPlugin::initialize(const QStringList& args, QString *errMsg)
 
     connect(cmdLogging->action(), SIGNAL(triggered(bool)), this, SLOT(toggleLogging()));
 
+    // Command to record the raw received stream
+    cmdRawLogging = am->registerAction(new QAction(this),
+                                            "LoggingPlugin.RawLogging",
+                                            QList<int>() <<
+                                            Core::Constants::C_GLOBAL_ID);
+    cmdRawLogging->setDefaultKeySequence(QKeySequence("Ctrl+Shift+L"));
+    cmdRawLogging->action()->setText("Start raw telemetry recording...");
+    ac->addAction(cmdRawLogging, "Logging");
+    connect(cmdRawLogging->action(), SIGNAL(triggered(bool)), this, SLOT(toggleRawLogging()));
+
     // Command to downlaod log
     cmdDownload = am->registerAction(new QAction(this),
                                             "LoggingPlugin.Download",
@@ -400,13 +414,39 @@ void LoggingPlugin::toggleLogging()
         cmdLogging->action()->setText(tr("Stop logging"));
 
     }
-    else if(state == LOGGING)
+    else if(state == LOGGING && loggingThread)
     {
         stopLogging();
         cmdLogging->action()->setText(tr("Start logging..."));
     }
 }
 
+/**
+  * The action that is triggered by the raw recording menu item.  Rather
+  * than re-sending every object update, this records the received
+  * telemetry stream as is, optionally compressed.
+  */
+void LoggingPlugin::toggleRawLogging()
+{
+    if(state == IDLE)
+    {
+        QString filter;
+        QString fileName = QFileDialog::getSaveFileName(NULL, tr("Start Raw Recording"),
+                                    QDir::homePath() + QDir::separator() + tr("dRonin-%0.drlog").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss")),
+                                    tr("dRonin Log (*.drlog);;Compressed dRonin Log (*.drlog)"), &filter);
+        if (fileName.isEmpty())
+            return;
+
+        startRawLogging(fileName, filter.startsWith(tr("Compressed")));
+        cmdRawLogging->action()->setText(tr("Stop raw telemetry recording"));
+    }
+    else if(state == LOGGING && rawRecorder)
+    {
+        stopLogging();
+        cmdRawLogging->action()->setText(tr("Start raw telemetry recording..."));
+    }
+}
+
 
 /**
   * Starts the logging thread to a certain file
@@ -432,10 +472,51 @@ void LoggingPlugin::startLogging(QString file)
 }
 
 /**
-  * Send the stop logging signal to the LoggingThread
+  * Starts recording the raw telemetry stream to a file
+  */
+void LoggingPlugin::startRawLogging(QString file, bool compress)
+{
+    qDebug() << "Recording raw telemetry to " << file;
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
+
+    if (rawRecorder)
+        delete rawRecorder;
+    rawRecorder = new RawStreamRecorder();
+    if(telMngr && rawRecorder->openFile(file, compress))
+    {
+        connect(rawRecorder,SIGNAL(finished()),this,SLOT(loggingStopped()));
+        state = LOGGING;
+        rawRecorder->start();
+        telMngr->setTap(rawRecorder);
+        emit stateChanged("LOGGING");
+    } else {
+        delete rawRecorder;
+        rawRecorder = NULL;
+
+        QErrorMessage err;
+        err.showMessage("Unable to open file for logging");
+        err.exec();
+    }
+}
+
+/**
+  * Send the stop logging signal to the LoggingThread, or detach the
+  * raw recorder and let it flush
   */
 void LoggingPlugin::stopLogging()
 {
+    if (rawRecorder) {
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
+        if (telMngr)
+            telMngr->setTap(NULL);
+
+        rawRecorder->stopRecording();
+        return;
+    }
+
     emit stopLoggingSignal();
     disconnect( this,SIGNAL(stopLoggingSignal()),0,0);
 }
@@ -454,6 +535,12 @@ void LoggingPlugin::loggingStopped()
 
     delete loggingThread;
     loggingThread = NULL;
+
+    if (rawRecorder) {
+        rawRecorder->wait();
+        delete rawRecorder;
+        rawRecorder = NULL;
+    }
 }
 
 /**
@@ -487,13 +574,19 @@ void LoggingPlugin::shutdown()
     if (state == LOGGING) {
         stopLogging();
 
-        loggingThread->wait();
+        if (loggingThread)
+            loggingThread->wait();
     }
 
     if (loggingThread != NULL) {
         delete loggingThread;
         loggingThread = NULL;
     }
+
+    if (rawRecorder != NULL) {
+        delete rawRecorder;
+        rawRecorder = NULL;
+    }
 }
 
 /**
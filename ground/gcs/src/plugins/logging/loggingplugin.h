@@ -37,6 +37,7 @@
 #include "loggingdevice.h"
 #include <uavtalk/uavtalk.h>
 #include <logfile.h>
+#include "rawstreamrecorder.h"
 
 #include <QThread>
 #include <QQueue>
@@ -138,6 +139,7 @@ signals:
 protected:
     enum {IDLE, LOGGING, REPLAY} state;
     LoggingThread * loggingThread;
+    RawStreamRecorder * rawRecorder;
 
     // These are used for replay, logging in its own thread
     LoggingConnection* logConnection;
@@ -145,7 +147,9 @@ protected:
 private slots:
     void downloadLog();
     void toggleLogging();
+    void toggleRawLogging();
     void startLogging(QString file);
+    void startRawLogging(QString file, bool compress);
     void stopLogging();
     void loggingStopped();
     void replayStarted();
@@ -154,6 +158,7 @@ private slots:
 private:
     LoggingGadgetFactory *mf;
     Core::Command* cmdLogging;
+    Core::Command* cmdRawLogging;
     Core::Command* cmdDownload;
 
 };
@@ -0,0 +1,263 @@
+/**
+ ******************************************************************************
+ * @file       rawstreamrecorder.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ * @brief Records the received telemetry stream as it comes off the link
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "rawstreamrecorder.h"
+#include "logfile.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+
+const size_t RING_SIZE = 4 * 1024 * 1024;
+const size_t WAKE_THRESHOLD = 16 * 1024;
+const int BLOCK_SIZE = 64 * 1024;
+const unsigned long WAKE_INTERVAL_MS = 100;
+
+// UAVTalk framing, see UAVTalk::processInputByte()
+const quint8 SYNC_VAL = 0x3C;
+const quint8 TYPE_MASK = 0xF8;
+const quint8 TYPE_VER = 0x20;
+const int MIN_HEADER_LENGTH = 8;
+const int MAX_LENGTH = 10 + 256;
+const int CHECKSUM_LENGTH = 1;
+
+}
+
+RawStreamRecorder::RawStreamRecorder(QObject *parent) :
+    QThread(parent),
+    ring(RING_SIZE),
+    dropped(0),
+    stopping(0),
+    compress(false),
+    streamPos(0),
+    blockTimestamp(0)
+{
+}
+
+RawStreamRecorder::~RawStreamRecorder()
+{
+    stopRecording();
+    wait();
+}
+
+/**
+ * @brief Create the log file and write its header
+ * @param fileName File to write
+ * @param compress Write the records as compressed blocks
+ * @return false if the file could not be created
+ */
+bool RawStreamRecorder::openFile(const QString &fileName, bool compress)
+{
+    file.setFileName(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    this->compress = compress;
+    file.write(LogFile::fileHeader());
+    block.reserve(BLOCK_SIZE + MAX_LENGTH + 12);
+
+    clock.start();
+
+    return true;
+}
+
+/**
+ * Called for every chunk read from the link.  Never blocks: if the ring
+ * can't take the whole chunk it is dropped.
+ */
+void RawStreamRecorder::received(const char *data, qint64 size)
+{
+    quint32 hdr[2] = { (quint32) clock.elapsed(), (quint32) size };
+
+    if (ring.space() < sizeof(hdr) + size) {
+        dropped += size;
+        return;
+    }
+
+    ring.write((const char *) hdr, sizeof(hdr));
+    ring.write(data, size);
+
+    if (ring.available() >= WAKE_THRESHOLD)
+        wake.wakeOne();
+}
+
+/**
+ * Ask the writer to flush what it has and close the file.  Chunks the tap
+ * delivers after this are not recorded.
+ */
+void RawStreamRecorder::stopRecording()
+{
+    stopping.store(1);
+    wake.wakeOne();
+}
+
+void RawStreamRecorder::run()
+{
+    while (!stopping.load()) {
+        wakeLock.lock();
+        wake.wait(&wakeLock, WAKE_INTERVAL_MS);
+        wakeLock.unlock();
+
+        drain();
+    }
+
+    drain();
+    flushBlock();
+
+    if (compress)
+        writeIndex();
+
+    file.close();
+
+    if (dropped.load())
+        qDebug() << "Raw recording dropped" << dropped.load() << "bytes";
+}
+
+/**
+ * Take every complete chunk out of the ring and split it into packets
+ */
+void RawStreamRecorder::drain()
+{
+    quint32 hdr[2];
+
+    while (ring.peek((char *) hdr, sizeof(hdr)) == sizeof(hdr)) {
+        // The producer writes the header before the data
+        if (ring.available() < sizeof(hdr) + hdr[1])
+            break;
+
+        ring.consume(sizeof(hdr));
+
+        int pos = stream.size();
+        stream.resize(pos + hdr[1]);
+        ring.read(stream.data() + pos, hdr[1]);
+
+        splitFrames(hdr[0]);
+    }
+
+    // Compact once per drain rather than once per packet
+    if (streamPos > 0) {
+        stream.remove(0, streamPos);
+        streamPos = 0;
+    }
+}
+
+/**
+ * Write out every complete packet in the stream, stamped with the receive
+ * time of the chunk that completed it.  Bytes that can't start a packet
+ * are skipped one at a time, as the UAVTalk parser does.  The CRC is left
+ * for the replaying parser to check.
+ */
+void RawStreamRecorder::splitFrames(quint32 timestamp)
+{
+    while (stream.size() - streamPos >= MIN_HEADER_LENGTH) {
+        const quint8 *p = (const quint8 *) stream.constData() + streamPos;
+
+        if (p[0] != SYNC_VAL || (p[1] & TYPE_MASK) != TYPE_VER) {
+            streamPos++;
+            continue;
+        }
+
+        int length = p[2] | (p[3] << 8);
+        if (length < MIN_HEADER_LENGTH || length > MAX_LENGTH) {
+            streamPos++;
+            continue;
+        }
+
+        if (stream.size() - streamPos < length + CHECKSUM_LENGTH)
+            break;
+
+        writeRecord(timestamp, (const char *) p, length + CHECKSUM_LENGTH);
+        streamPos += length + CHECKSUM_LENGTH;
+    }
+}
+
+/**
+ * Append a record in the LogFile format: u32 timestamp, i64 size, packet
+ */
+void RawStreamRecorder::writeRecord(quint32 timestamp, const char *frame, int size)
+{
+    qint64 dataSize = size;
+
+    if (block.isEmpty())
+        blockTimestamp = timestamp;
+
+    block.append((const char *) &timestamp, sizeof(timestamp));
+    block.append((const char *) &dataSize, sizeof(dataSize));
+    block.append(frame, size);
+
+    if (block.size() >= BLOCK_SIZE)
+        flushBlock();
+}
+
+void RawStreamRecorder::flushBlock()
+{
+    if (block.isEmpty())
+        return;
+
+    if (compress) {
+        BlockIndex entry = { (quint64) file.pos(), blockTimestamp };
+        index.append(entry);
+
+        QByteArray packed = qCompress(block);
+        quint32 hdr[3] = { blockTimestamp, (quint32) block.size(), (quint32) packed.size() };
+
+        file.write("DRLZ", 4);
+        file.write((const char *) hdr, sizeof(hdr));
+        file.write(packed);
+    } else {
+        file.write(block);
+    }
+
+    // Keeps the allocation
+    block.resize(0);
+}
+
+/**
+ * Trailer of a compressed log: "DRLI", u32 count, count times u64 block
+ * offset and u32 first timestamp, then the u64 offset of "DRLI" itself so
+ * a reader can seek from the end of the file.
+ */
+void RawStreamRecorder::writeIndex()
+{
+    quint64 indexPos = file.pos();
+    quint32 count = index.size();
+
+    file.write("DRLI", 4);
+    file.write((const char *) &count, sizeof(count));
+
+    foreach (const BlockIndex &entry, index) {
+        file.write((const char *) &entry.offset, sizeof(entry.offset));
+        file.write((const char *) &entry.firstTimestamp, sizeof(entry.firstTimestamp));
+    }
+
+    file.write((const char *) &indexPos, sizeof(indexPos));
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,112 @@
+/**
+ ******************************************************************************
+ * @file       rawstreamrecorder.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ * @brief Records the received telemetry stream as it comes off the link
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef RAWSTREAMRECORDER_H
+#define RAWSTREAMRECORDER_H
+
+#include <QThread>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QAtomicInt>
+
+#include <uavtalk/uavtalk.h>
+#include <utils/spscring.h>
+
+#include <atomic>
+
+/**
+*   Taps the bytes UAVTalk receives and writes them to a .drlog file.
+*
+*   The tap runs on the thread that reads the link and only stamps each
+*   chunk with its receive time and copies it into a lock-free ring.  A
+*   writer thread drains the ring, splits the stream back into UAVTalk
+*   packets and writes them as ordinary log records in large blocks, so
+*   recording costs the telemetry path a memcpy instead of a
+*   re-serialization and three file writes per object.  If the writer
+*   falls behind, the ring fills up and further chunks are dropped and
+*   counted rather than blocking the link.
+*
+*   With compression on, the records after the header are grouped into
+*   qCompress()ed blocks followed by a block index; LogFile and the python
+*   FileTelemetry inflate these transparently.
+*/
+class RawStreamRecorder : public QThread, public UAVTalkTap
+{
+    Q_OBJECT
+public:
+    explicit RawStreamRecorder(QObject *parent = 0);
+    ~RawStreamRecorder();
+
+    bool openFile(const QString &fileName, bool compress);
+
+    void received(const char *data, qint64 size);
+
+    quint64 droppedBytes() const { return dropped.load(); }
+
+public slots:
+    void stopRecording();
+
+protected:
+    void run();
+
+private:
+    struct BlockIndex {
+        quint64 offset;
+        quint32 firstTimestamp;
+    };
+
+    void drain();
+    void splitFrames(quint32 timestamp);
+    void writeRecord(quint32 timestamp, const char *frame, int size);
+    void flushBlock();
+    void writeIndex();
+
+    Utils::SpscRing ring;
+    std::atomic<quint64> dropped;
+    QAtomicInt stopping;
+    QMutex wakeLock;
+    QWaitCondition wake;
+    QElapsedTimer clock;
+
+    // Only touched by the writer thread once it is running
+    QFile file;
+    bool compress;
+    QByteArray stream;          /**< Received bytes not yet split into packets */
+    int streamPos;              /**< Start of the unsplit bytes in stream */
+    QByteArray block;
+    quint32 blockTimestamp;
+    QVector<BlockIndex> index;
+};
+
+#endif // RAWSTREAMRECORDER_H
+
+/**
+ * @}
+ * @}
+ */
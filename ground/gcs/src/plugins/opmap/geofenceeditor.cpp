@@ -0,0 +1,254 @@
+/**
+ ******************************************************************************
+ * @file       geofenceeditor.cpp
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup OPMapPlugin Tau Labs Map Plugin
+ * @{
+ * @brief Draws and edits the polygon geofences on the map
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#include "geofenceeditor.h"
+
+#include <QPolygonF>
+
+#include "uavobjectmanager.h"
+#include "uavobjectutilmanager.h"
+#include "geofencepolygon.h"
+#include "utils/coordinateconversions.h"
+
+GeofenceEditor::GeofenceEditor(QObject *parent, TLMapWidget *map, UAVObjectManager *objMngr,
+                               UAVObjectUtilManager *utilMngr) :
+    QObject(parent), myMap(map), objManager(objMngr), utilManager(utilMngr), sending(false)
+{
+}
+
+/**
+ * @brief GeofenceEditor::getHome Fences are stored relative to home
+ * @return false if there is no home location to convert with
+ */
+bool GeofenceEditor::getHome(double homeLLA[3])
+{
+    bool set;
+
+    if (!utilManager || utilManager->getHomeLocation(set, homeLLA) < 0)
+        return false;
+
+    return set;
+}
+
+void GeofenceEditor::drawFence(Fence &fence)
+{
+    if (fence.item)
+        fence.item->deleteLater();
+
+    fence.item = myMap->PolygonCreate(fence.vertices,
+                                      fence.exclusion ? Qt::red : Qt::green,
+                                      fence.exclusion);
+}
+
+bool GeofenceEditor::addVertex(internals::PointLatLng coord)
+{
+    if (pending.size() >= (int) GeoFencePolygon::NORTH_NUMELEM || isFull())
+        return false;
+
+    pending.append(coord);
+
+    if (!pendingItem) {
+        pendingItem = myMap->PolygonCreate(pending, Qt::yellow, false);
+        pendingItem->setClosed(false);
+    } else {
+        pendingItem->setVertices(pending);
+    }
+
+    return true;
+}
+
+bool GeofenceEditor::finishPolygon(bool exclusion)
+{
+    if (pending.size() < 3 || isFull())
+        return false;
+
+    Fence fence;
+    fence.exclusion = exclusion;
+    fence.vertices = pending;
+    drawFence(fence);
+    fences.append(fence);
+
+    cancelPolygon();
+
+    return true;
+}
+
+void GeofenceEditor::cancelPolygon()
+{
+    pending.clear();
+
+    if (pendingItem)
+        pendingItem->deleteLater();
+}
+
+bool GeofenceEditor::removePolygonAt(internals::PointLatLng coord)
+{
+    // Compare in degrees; fine for telling which polygon was clicked
+    QPointF p(coord.Lng(), coord.Lat());
+
+    for (int i = fences.size() - 1; i >= 0; i--) {
+        QPolygonF poly;
+        foreach (const internals::PointLatLng &v, fences[i].vertices)
+            poly << QPointF(v.Lng(), v.Lat());
+
+        if (poly.containsPoint(p, Qt::OddEvenFill)) {
+            if (fences[i].item)
+                fences[i].item->deleteLater();
+            fences.removeAt(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GeofenceEditor::clear()
+{
+    cancelPolygon();
+
+    foreach (const Fence &fence, fences) {
+        if (fence.item)
+            fence.item->deleteLater();
+    }
+
+    fences.clear();
+}
+
+/**
+ * @brief GeofenceEditor::sendToBoard Every instance is written, unused ones
+ * as Disabled, so polygons deleted here are removed from the board too
+ * @return false if there is no home location or an instance is missing
+ */
+bool GeofenceEditor::sendToBoard()
+{
+    double homeLLA[3];
+
+    if (!getHome(homeLLA))
+        return false;
+
+    sending = true;
+
+    for (int i = 0; i < MAX_POLYGONS; i++) {
+        GeoFencePolygon *obj = GeoFencePolygon::GetInstance(objManager, i);
+
+        if (!obj) {
+            obj = new GeoFencePolygon;
+            obj->initialize(i, obj->getMetaObject());
+            objManager->registerObject(obj);
+        }
+
+        GeoFencePolygon::DataFields data = obj->getData();
+
+        data.Type = GeoFencePolygon::TYPE_DISABLED;
+        data.Vertices = 0;
+
+        if (i < fences.size()) {
+            const Fence &fence = fences.at(i);
+
+            data.Type = fence.exclusion ? GeoFencePolygon::TYPE_EXCLUSION :
+                                          GeoFencePolygon::TYPE_INCLUSION;
+            data.Vertices = fence.vertices.size();
+
+            for (int v = 0; v < fence.vertices.size(); v++) {
+                double LLA[3] = { fence.vertices[v].Lat(), fence.vertices[v].Lng(), homeLLA[2] };
+                double NED[3];
+
+                Utils::CoordinateConversions().LLA2NED_HomeLLA(LLA, homeLLA, NED);
+                data.North[v] = NED[0];
+                data.East[v] = NED[1];
+            }
+        }
+
+        obj->setData(data);
+        obj->updated();
+        utilManager->saveObjectToFlash(obj);
+    }
+
+    sending = false;
+
+    return true;
+}
+
+void GeofenceEditor::loadFromBoard()
+{
+    double homeLLA[3];
+
+    if (!getHome(homeLLA))
+        return;
+
+    clear();
+
+    int instances = GeoFencePolygon::getNumInstances(objManager);
+
+    for (int i = 0; i < instances; i++) {
+        GeoFencePolygon *obj = GeoFencePolygon::GetInstance(objManager, i);
+        if (!obj)
+            continue;
+
+        connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(polygonUpdated(UAVObject *)),
+                Qt::UniqueConnection);
+
+        GeoFencePolygon::DataFields data = obj->getData();
+
+        if (data.Type == GeoFencePolygon::TYPE_DISABLED || data.Vertices < 3 ||
+                data.Vertices > GeoFencePolygon::NORTH_NUMELEM)
+            continue;
+
+        Fence fence;
+        fence.exclusion = (data.Type == GeoFencePolygon::TYPE_EXCLUSION);
+
+        for (int v = 0; v < data.Vertices; v++) {
+            double NED[3] = { data.North[v], data.East[v], 0 };
+            double LLA[3];
+
+            Utils::CoordinateConversions().NED2LLA_HomeLLA(homeLLA, NED, LLA);
+            fence.vertices.append(internals::PointLatLng(LLA[0], LLA[1]));
+        }
+
+        drawFence(fence);
+        fences.append(fence);
+    }
+}
+
+void GeofenceEditor::polygonUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    // Our own writes would otherwise redraw mid-send
+    if (!sending && pending.isEmpty())
+        loadFromBoard();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ * @file       geofenceeditor.h
+ *
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup OPMapPlugin Tau Labs Map Plugin
+ * @{
+ * @brief Draws and edits the polygon geofences on the map
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Additional note on redistribution: The copyright and license notices above
+ * must be maintained in each individual source file that is a derivative work
+ * of this source file; otherwise redistribution is prohibited.
+ */
+
+#ifndef GEOFENCEEDITOR_H
+#define GEOFENCEEDITOR_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include "tlmapcontrol/tlmapcontrol.h"
+
+class UAVObject;
+class UAVObjectManager;
+class UAVObjectUtilManager;
+
+using namespace mapcontrol;
+
+/**
+ * @brief The GeofenceEditor class keeps the map overlays and the
+ * GeoFencePolygon instances in step.  Polygons are entered a vertex at a
+ * time and only reach the board, as NED offsets from home, when sent.
+ */
+class GeofenceEditor : public QObject
+{
+    Q_OBJECT
+public:
+    //! Instances the flight side creates, see GEOFENCE_INDEX_MAX_POLYGONS
+    static const int MAX_POLYGONS = 8;
+
+    GeofenceEditor(QObject *parent, TLMapWidget *map, UAVObjectManager *objMngr,
+                   UAVObjectUtilManager *utilMngr);
+
+    //! Append a vertex to the polygon being entered
+    bool addVertex(internals::PointLatLng coord);
+    int pendingVertices() const { return pending.size(); }
+    //! Close the polygon being entered as an inclusion or exclusion zone
+    bool finishPolygon(bool exclusion);
+    void cancelPolygon();
+
+    //! Remove the fence containing coord, if any
+    bool removePolygonAt(internals::PointLatLng coord);
+    bool isEmpty() const { return fences.isEmpty(); }
+    bool isFull() const { return fences.size() >= MAX_POLYGONS; }
+    void clear();
+
+    //! Write every instance and save them to flash
+    bool sendToBoard();
+
+public slots:
+    //! Replace the drawn fences with what the board holds
+    void loadFromBoard();
+
+private slots:
+    void polygonUpdated(UAVObject *obj);
+
+private:
+    struct Fence {
+        bool exclusion;
+        QVector<internals::PointLatLng> vertices;
+        QPointer<MapPolygon> item;
+    };
+
+    bool getHome(double homeLLA[3]);
+    void drawFence(Fence &fence);
+
+    TLMapWidget *myMap;
+    UAVObjectManager *objManager;
+    UAVObjectUtilManager *utilManager;
+
+    QList<Fence> fences;
+    QVector<internals::PointLatLng> pending;
+    QPointer<MapPolygon> pendingItem;
+    bool sending;
+};
+
+#endif // GEOFENCEEDITOR_H
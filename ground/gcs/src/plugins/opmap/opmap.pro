@@ -19,7 +19,8 @@ HEADERS += opmapplugin.h \
     opmap_zoom_slider_widget.h \
     opmap_statusbar_widget.h \
     modelmapproxy.h \
-    homeeditor.h
+    homeeditor.h \
+    geofenceeditor.h
 
 SOURCES += opmapplugin.cpp \
     opmapgadgetwidget.cpp \
@@ -30,7 +31,8 @@ SOURCES += opmapplugin.cpp \
     opmap_zoom_slider_widget.cpp \
     opmap_statusbar_widget.cpp \
     modelmapproxy.cpp \
-    homeeditor.cpp
+    homeeditor.cpp \
+    geofenceeditor.cpp
 
 OTHER_FILES += OPMapGadget.pluginspec \
     OPMapGadget.json
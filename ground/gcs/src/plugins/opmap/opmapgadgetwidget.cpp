@@ -62,6 +62,7 @@
 #include "positionactual.h"
 #include "velocityactual.h"
 #include "windvelocityactual.h"
+#include "geofencepolygon.h"
 
 #include "../pathplanner/pathplannergadgetwidget.h"
 #include "../pathplanner/waypointdialog.h"
@@ -236,6 +237,7 @@ OPMapGadgetWidget::OPMapGadgetWidget(QWidget *parent) : QWidget(parent)
     selectionModel =  pm->getObject<QItemSelectionModel>();
     Q_ASSERT(selectionModel);
     mapProxy = new ModelMapProxy(this, m_map, model, selectionModel);
+    geofenceEditor = new GeofenceEditor(this, m_map, uavo_mgr, uavo_util_mgr);
 
     magicWayPoint=m_map->magicWPCreate();
     magicWayPoint->setVisible(false);
@@ -281,6 +283,9 @@ OPMapGadgetWidget::OPMapGadgetWidget(QWidget *parent) : QWidget(parent)
         }
     }
 
+    // Show any fences the board already has
+    geofenceEditor->loadFromBoard();
+
 
 
     // **************
@@ -525,6 +530,29 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
             if (m_map->WPPresent())
                 contextMenu.addAction(clearWayPointsAct);	// we have waypoints
 
+            contextMenu.addSeparator()->setText(tr("Geofence"));
+
+            addFenceVertexAct->setEnabled(!geofenceEditor->isFull());
+            contextMenu.addAction(addFenceVertexAct);
+
+            if (geofenceEditor->pendingVertices() > 0)
+            {	// a polygon is being entered
+                finishInclusionFenceAct->setEnabled(geofenceEditor->pendingVertices() >= 3);
+                finishExclusionFenceAct->setEnabled(geofenceEditor->pendingVertices() >= 3);
+                contextMenu.addAction(finishInclusionFenceAct);
+                contextMenu.addAction(finishExclusionFenceAct);
+                contextMenu.addAction(cancelFenceAct);
+            }
+
+            if (!geofenceEditor->isEmpty())
+            {
+                contextMenu.addAction(deleteFenceAct);
+                contextMenu.addAction(clearFenceAct);
+            }
+
+            sendFenceAct->setEnabled(m_telemetry_connected);
+            contextMenu.addAction(sendFenceAct);
+
             break;
 
         case MagicWaypoint_MapMode:
@@ -881,6 +909,8 @@ void OPMapGadgetWidget::onTelemetryConnect()
         if(m_map->UAV->GetMapFollowType()!=UAVMapFollowType::None)
             m_map->SetCurrentPosition(m_home_position.coord);         // set the map position
     }
+
+    geofenceEditor->loadFromBoard();
     // ***********************
 }
 
@@ -1389,6 +1419,37 @@ void OPMapGadgetWidget::createActions()
     clearWayPointsAct->setStatusTip(tr("Clear waypoints"));
     connect(clearWayPointsAct, SIGNAL(triggered()), this, SLOT(onClearWayPointsAct_triggered()));
 
+    addFenceVertexAct = new QAction(tr("Add fence &vertex"), this);
+    addFenceVertexAct->setStatusTip(tr("Add a vertex to the geofence polygon being entered"));
+    connect(addFenceVertexAct, SIGNAL(triggered()), this, SLOT(onAddFenceVertexAct_triggered()));
+
+    finishFenceActGroup = new QActionGroup(this);
+    connect(finishFenceActGroup, SIGNAL(triggered(QAction *)), this, SLOT(onFinishFenceAct_triggered(QAction *)));
+
+    finishInclusionFenceAct = new QAction(tr("Close as &inclusion zone"), finishFenceActGroup);
+    finishInclusionFenceAct->setStatusTip(tr("The vehicle must stay inside this polygon"));
+    finishInclusionFenceAct->setData(false);
+
+    finishExclusionFenceAct = new QAction(tr("Close as e&xclusion zone"), finishFenceActGroup);
+    finishExclusionFenceAct->setStatusTip(tr("The vehicle must stay outside this polygon"));
+    finishExclusionFenceAct->setData(true);
+
+    cancelFenceAct = new QAction(tr("Cancel fence polygon"), this);
+    cancelFenceAct->setStatusTip(tr("Discard the geofence polygon being entered"));
+    connect(cancelFenceAct, SIGNAL(triggered()), this, SLOT(onCancelFenceAct_triggered()));
+
+    deleteFenceAct = new QAction(tr("Delete fence polygon"), this);
+    deleteFenceAct->setStatusTip(tr("Delete the geofence polygon under the mouse"));
+    connect(deleteFenceAct, SIGNAL(triggered()), this, SLOT(onDeleteFenceAct_triggered()));
+
+    clearFenceAct = new QAction(tr("Clear geofence"), this);
+    clearFenceAct->setStatusTip(tr("Delete all geofence polygons"));
+    connect(clearFenceAct, SIGNAL(triggered()), this, SLOT(onClearFenceAct_triggered()));
+
+    sendFenceAct = new QAction(tr("&Send geofence to board"), this);
+    sendFenceAct->setStatusTip(tr("Send the geofence polygons to the board and save them"));
+    connect(sendFenceAct, SIGNAL(triggered()), this, SLOT(onSendFenceAct_triggered()));
+
     overlayOpacityActGroup = new QActionGroup(this);
     connect(overlayOpacityActGroup, SIGNAL(triggered(QAction *)), this, SLOT(onOverlayOpacityActGroup_triggered(QAction *)));
     overlayOpacityAct.clear();
@@ -1913,6 +1974,52 @@ void OPMapGadgetWidget::onClearWayPointsAct_triggered()
 
  }
 
+void OPMapGadgetWidget::onAddFenceVertexAct_triggered()
+{
+    if (!m_widget || !m_map)
+        return;
+
+    if (!geofenceEditor->addVertex(m_context_menu_lat_lon))
+        QMessageBox::warning(this, tr("Geofence"),
+                             tr("A fence polygon can have at most %1 vertices.")
+                             .arg(GeoFencePolygon::NORTH_NUMELEM));
+}
+
+void OPMapGadgetWidget::onFinishFenceAct_triggered(QAction *action)
+{
+    geofenceEditor->finishPolygon(action->data().toBool());
+}
+
+void OPMapGadgetWidget::onCancelFenceAct_triggered()
+{
+    geofenceEditor->cancelPolygon();
+}
+
+void OPMapGadgetWidget::onDeleteFenceAct_triggered()
+{
+    geofenceEditor->removePolygonAt(m_context_menu_lat_lon);
+}
+
+void OPMapGadgetWidget::onClearFenceAct_triggered()
+{
+    QMessageBox msgBox;
+    msgBox.setText(tr("Are you sure you want to clear the geofence?"));
+    msgBox.setInformativeText(tr("The board keeps its fence until the geofence is sent."));
+    msgBox.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+
+    if (msgBox.exec() == QMessageBox::No)
+        return;
+
+    geofenceEditor->clear();
+}
+
+void OPMapGadgetWidget::onSendFenceAct_triggered()
+{
+    if (!geofenceEditor->sendToBoard())
+        QMessageBox::warning(this, tr("Geofence"),
+                             tr("The geofence is stored relative to home, so a home location must be set first."));
+}
+
 
 void OPMapGadgetWidget::onHomeMagicWaypointAct_triggered()
 {
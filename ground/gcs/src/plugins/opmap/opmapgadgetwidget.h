@@ -64,6 +64,7 @@
 #include "../pathplanner/flightdatamodel.h"
 
 #include "homeeditor.h"
+#include "geofenceeditor.h"
 
 // ******************************************************
 
@@ -210,6 +211,13 @@ private slots:
     void onDeleteWayPointAct_triggered();
     void onClearWayPointsAct_triggered();
 
+    void onAddFenceVertexAct_triggered();
+    void onFinishFenceAct_triggered(QAction *action);
+    void onCancelFenceAct_triggered();
+    void onDeleteFenceAct_triggered();
+    void onClearFenceAct_triggered();
+    void onSendFenceAct_triggered();
+
     void onMapModeActGroup_triggered(QAction *action);
     void onZoomActGroup_triggered(QAction *action);
     void onHomeMagicWaypointAct_triggered();
@@ -279,6 +287,15 @@ private:
     QAction *deleteWayPointAct;
     QAction *clearWayPointsAct;
 
+    QAction *addFenceVertexAct;
+    QActionGroup *finishFenceActGroup;
+    QAction *finishInclusionFenceAct;
+    QAction *finishExclusionFenceAct;
+    QAction *cancelFenceAct;
+    QAction *deleteFenceAct;
+    QAction *clearFenceAct;
+    QAction *sendFenceAct;
+
     QAction *homeMagicWaypointAct;
 
     QAction *showSafeAreaAct;
@@ -330,6 +347,7 @@ private:
     QPointer<FlightDataModel> model;
     QPointer<QDialog> pathPlannerDialog;
     QPointer<ModelMapProxy> mapProxy;
+    QPointer<GeofenceEditor> geofenceEditor;
     QPointer<QItemSelectionModel> selectionModel;
 };
 
@@ -0,0 +1,164 @@
+/**
+ ******************************************************************************
+ *
+ * @file       hidapi_loopback.c
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup RawHIDPlugin Raw HID Plugin
+ * @{
+ * @brief Stand-in for hidapi where every report written to a device comes
+ *        back as an input report, for benchmarking the HID I/O path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../hidapi/hidapi.h"
+
+/* Reports buffered in "the device", roughly what the OS queues for hidraw */
+#define LOOPBACK_DEPTH 64
+#define LOOPBACK_REPORT_SIZE 64
+
+struct hid_device_ {
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+
+	unsigned char reports[LOOPBACK_DEPTH][LOOPBACK_REPORT_SIZE];
+	size_t lengths[LOOPBACK_DEPTH];
+	unsigned int head;
+	unsigned int tail;
+};
+
+int HID_API_EXPORT hid_init(void)
+{
+	return 0;
+}
+
+int HID_API_EXPORT hid_exit(void)
+{
+	return 0;
+}
+
+hid_device * HID_API_EXPORT hid_open_path(const char *path)
+{
+	(void) path;
+
+	hid_device *dev = calloc(1, sizeof(*dev));
+
+	if (!dev)
+		return NULL;
+
+	pthread_mutex_init(&dev->lock, NULL);
+	pthread_cond_init(&dev->changed, NULL);
+
+	return dev;
+}
+
+void HID_API_EXPORT hid_close(hid_device *dev)
+{
+	pthread_cond_destroy(&dev->changed);
+	pthread_mutex_destroy(&dev->lock);
+	free(dev);
+}
+
+static void deadline_after(struct timespec *ts, int milliseconds)
+{
+	clock_gettime(CLOCK_REALTIME, ts);
+
+	ts->tv_sec += milliseconds / 1000;
+	ts->tv_nsec += (milliseconds % 1000) * 1000000L;
+
+	if (ts->tv_nsec >= 1000000000L) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000L;
+	}
+}
+
+int HID_API_EXPORT hid_write(hid_device *dev, const unsigned char *data,
+		size_t length)
+{
+	if (length > LOOPBACK_REPORT_SIZE)
+		length = LOOPBACK_REPORT_SIZE;
+
+	pthread_mutex_lock(&dev->lock);
+
+	while (dev->head - dev->tail == LOOPBACK_DEPTH)
+		pthread_cond_wait(&dev->changed, &dev->lock);
+
+	unsigned int slot = dev->head % LOOPBACK_DEPTH;
+
+	memcpy(dev->reports[slot], data, length);
+	dev->lengths[slot] = length;
+	dev->head++;
+
+	pthread_cond_broadcast(&dev->changed);
+	pthread_mutex_unlock(&dev->lock);
+
+	return length;
+}
+
+int HID_API_EXPORT hid_read_timeout(hid_device *dev, unsigned char *data,
+		size_t length, int milliseconds)
+{
+	struct timespec deadline;
+
+	if (milliseconds > 0)
+		deadline_after(&deadline, milliseconds);
+
+	pthread_mutex_lock(&dev->lock);
+
+	while (dev->head == dev->tail) {
+		if (milliseconds == 0) {
+			pthread_mutex_unlock(&dev->lock);
+			return 0;
+		} else if (milliseconds < 0) {
+			pthread_cond_wait(&dev->changed, &dev->lock);
+		} else if (pthread_cond_timedwait(&dev->changed, &dev->lock,
+					&deadline) == ETIMEDOUT) {
+			pthread_mutex_unlock(&dev->lock);
+			return 0;
+		}
+	}
+
+	unsigned int slot = dev->tail % LOOPBACK_DEPTH;
+
+	if (length > dev->lengths[slot])
+		length = dev->lengths[slot];
+
+	memcpy(data, dev->reports[slot], length);
+	dev->tail++;
+
+	pthread_cond_broadcast(&dev->changed);
+	pthread_mutex_unlock(&dev->lock);
+
+	return length;
+}
+
+int HID_API_EXPORT hid_read(hid_device *dev, unsigned char *data, size_t length)
+{
+	return hid_read_timeout(dev, data, length, -1);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,448 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rawhidbench.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup RawHIDPlugin Raw HID Plugin
+ * @{
+ * @brief Throughput and latency of the HID I/O path against a loopback
+ *        device.  Compares the batched ring path used by RawHID with the
+ *        previous one-report-per-wakeup, mutex-and-QByteArray scheme.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../rawhidbatch.h"
+#include <utils/spscring.h>
+
+typedef std::chrono::steady_clock Clock;
+
+static const int READ_TIMEOUT = 200;
+static const int BATCH = 64;
+
+/**
+*   Common harness: a producer writes messages through the transmit path,
+*   the loopback device echoes them, and a consumer that is woken by the
+*   receive path's "readyRead" reads them back.  Each message starts with
+*   its send time so the consumer can compute latency.
+*/
+class Path
+{
+public:
+    virtual ~Path() {}
+
+    virtual void start(hid_device *dev) = 0;
+    virtual void stop() = 0;
+
+    //! Producer side of the QIODevice
+    virtual void write(const char *data, int size) = 0;
+
+    //! Consumer side of the QIODevice
+    virtual int read(char *data, int size) = 0;
+
+    //! Block until readyRead would have been delivered
+    void waitReadyRead()
+    {
+        std::unique_lock<std::mutex> lock(m_signalMtx);
+
+        while (!m_signalled && m_running)
+            m_signal.wait(lock);
+
+        m_signalled = false;
+    }
+
+    void stopConsumer()
+    {
+        std::lock_guard<std::mutex> lock(m_signalMtx);
+
+        m_running = false;
+        m_signal.notify_one();
+    }
+
+    std::atomic<long> signals{0};
+
+protected:
+    void emitReadyRead()
+    {
+        signals++;
+
+        std::lock_guard<std::mutex> lock(m_signalMtx);
+
+        m_signalled = true;
+        m_signal.notify_one();
+    }
+
+    std::mutex m_signalMtx;
+    std::condition_variable m_signal;
+    bool m_signalled = false;
+    bool m_running = true;
+};
+
+//! One report per read wakeup, one signal per report, locked QByteArray-style
+//! buffers, idle write thread polling with a timed wait
+class LegacyPath : public Path
+{
+public:
+    void start(hid_device *dev) override
+    {
+        m_dev = dev;
+        m_reader = std::thread([this] { readLoop(); });
+        m_writer = std::thread([this] { writeLoop(); });
+    }
+
+    void stop() override
+    {
+        m_stop = true;
+        m_newData.notify_one();
+        m_reader.join();
+        m_writer.join();
+    }
+
+    void write(const char *data, int size) override
+    {
+        std::lock_guard<std::mutex> lock(m_writeMtx);
+
+        m_writeBuf.append(data, size);
+        m_newData.notify_one();
+    }
+
+    int read(char *data, int size) override
+    {
+        std::lock_guard<std::mutex> lock(m_readMtx);
+
+        size = std::min<int>(size, m_readBuf.size());
+        memcpy(data, m_readBuf.data(), size);
+        m_readBuf.erase(0, size);
+
+        return size;
+    }
+
+private:
+    void readLoop()
+    {
+        while (!m_stop) {
+            unsigned char buffer[RAWHID_REPORT_SIZE];
+
+            int ret = hid_read_timeout(m_dev, buffer, sizeof(buffer),
+                                       READ_TIMEOUT);
+
+            if (ret > 0) {
+                std::lock_guard<std::mutex> lock(m_readMtx);
+
+                m_readBuf.append((char *) &buffer[2], buffer[1]);
+                emitReadyRead();
+            }
+        }
+    }
+
+    void writeLoop()
+    {
+        while (!m_stop) {
+            unsigned char buffer[RAWHID_REPORT_SIZE] = {0};
+            int size;
+
+            {
+                std::unique_lock<std::mutex> lock(m_writeMtx);
+
+                while (m_writeBuf.empty()) {
+                    m_newData.wait_for(lock, std::chrono::milliseconds(200));
+                    if (m_stop)
+                        return;
+                }
+
+                size = std::min<int>(RAWHID_REPORT_PAYLOAD, m_writeBuf.size());
+                memcpy(&buffer[2], m_writeBuf.data(), size);
+                buffer[1] = size;
+                buffer[0] = 2;
+            }
+
+            if (hid_write(m_dev, buffer, sizeof(buffer)) > 0) {
+                std::lock_guard<std::mutex> lock(m_writeMtx);
+                m_writeBuf.erase(0, size);
+            }
+        }
+    }
+
+    hid_device *m_dev;
+    std::thread m_reader, m_writer;
+    std::atomic<bool> m_stop{false};
+
+    std::mutex m_readMtx;
+    std::string m_readBuf;
+
+    std::mutex m_writeMtx;
+    std::condition_variable m_newData;
+    std::string m_writeBuf;
+};
+
+//! The path RawHID uses now: batched reads into a lock-free ring with one
+//! signal per batch, and an event driven batched writer
+class BatchedPath : public Path
+{
+public:
+    BatchedPath() : m_readRing(1 << 18), m_writeRing(1 << 16) {}
+
+    void start(hid_device *dev) override
+    {
+        m_dev = dev;
+        m_reader = std::thread([this] { readLoop(); });
+        m_writer = std::thread([this] { writeLoop(); });
+    }
+
+    void stop() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_writeMtx);
+            m_stop = true;
+            m_newData.notify_one();
+            m_space.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_readSpaceMtx);
+            m_readSpace.notify_one();
+        }
+
+        m_reader.join();
+        m_writer.join();
+    }
+
+    void write(const char *data, int size) override
+    {
+        std::unique_lock<std::mutex> lock(m_writeMtx);
+        int written = 0;
+
+        while (!m_stop) {
+            written += m_writeRing.write(data + written, size - written);
+            m_newData.notify_one();
+
+            if (written == size)
+                break;
+
+            m_space.wait(lock);
+        }
+    }
+
+    int read(char *data, int size) override
+    {
+        m_pending.store(false);
+
+        bool wasFull = m_readRing.space() < (size_t) RAWHID_REPORT_PAYLOAD;
+
+        size = m_readRing.read(data, size);
+
+        if (wasFull && size) {
+            std::lock_guard<std::mutex> lock(m_readSpaceMtx);
+            m_readSpace.notify_one();
+        }
+
+        return size;
+    }
+
+private:
+    void readLoop()
+    {
+        while (!m_stop) {
+            int ret = rawhid_read_batch(m_dev, &m_readRing, READ_TIMEOUT,
+                                        BATCH);
+
+            if (ret > 0) {
+                if (!m_pending.exchange(true))
+                    emitReadyRead();
+            } else if (ret == 0) {
+                std::unique_lock<std::mutex> lock(m_readSpaceMtx);
+
+                while (!m_stop && m_readRing.space() <
+                       (size_t) RAWHID_REPORT_PAYLOAD)
+                    m_readSpace.wait(lock);
+            }
+        }
+    }
+
+    void writeLoop()
+    {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(m_writeMtx);
+
+                while (!m_stop && m_writeRing.available() == 0)
+                    m_newData.wait(lock);
+
+                if (m_stop)
+                    return;
+            }
+
+            if (rawhid_write_batch(m_dev, &m_writeRing, BATCH) > 0) {
+                std::lock_guard<std::mutex> lock(m_writeMtx);
+                m_space.notify_all();
+            }
+        }
+    }
+
+    hid_device *m_dev;
+    std::thread m_reader, m_writer;
+    std::atomic<bool> m_stop{false};
+
+    Utils::SpscRing m_readRing;
+    std::atomic<bool> m_pending{false};
+    std::mutex m_readSpaceMtx;
+    std::condition_variable m_readSpace;
+
+    Utils::SpscRing m_writeRing;
+    std::mutex m_writeMtx;
+    std::condition_variable m_newData;
+    std::condition_variable m_space;
+};
+
+struct Result {
+    double mbytesPerSec;
+    double p50us;
+    double p99us;
+    long signals;
+};
+
+/**
+ * Push total bytes through the path as messages of msgSize bytes and read
+ * them back, verifying the contents.
+ */
+static Result run(Path *path, size_t total, int msgSize, int gapUs)
+{
+    hid_init();
+    hid_device *dev = hid_open_path("loopback");
+
+    path->start(dev);
+
+    std::vector<double> latencies;
+    std::atomic<bool> ok{true};
+
+    Clock::time_point begin = Clock::now();
+
+    std::thread consumer([&] {
+        std::vector<char> buf(1 << 16);
+        std::string pending;
+        size_t received = 0;
+
+        while (received < total) {
+            path->waitReadyRead();
+
+            int n;
+            while ((n = path->read(buf.data(), buf.size())) > 0)
+                pending.append(buf.data(), n);
+
+            while (pending.size() >= (size_t) msgSize) {
+                Clock::rep sent;
+                memcpy(&sent, pending.data(), sizeof(sent));
+
+                for (int i = sizeof(sent); i < msgSize; i++) {
+                    if (pending[i] != (char) (received + i))
+                        ok = false;
+                }
+
+                latencies.push_back((Clock::now().time_since_epoch().count()
+                                     - sent) / 1000.0);
+
+                pending.erase(0, msgSize);
+                received += msgSize;
+            }
+        }
+    });
+
+    std::vector<char> msg(msgSize);
+
+    for (size_t sent = 0; sent < total; sent += msgSize) {
+        Clock::rep now = Clock::now().time_since_epoch().count();
+
+        memcpy(msg.data(), &now, sizeof(now));
+        for (int i = sizeof(now); i < msgSize; i++)
+            msg[i] = (char) (sent + i);
+
+        path->write(msg.data(), msgSize);
+
+        if (gapUs)
+            std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+    }
+
+    consumer.join();
+
+    double secs = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    path->stopConsumer();
+    path->stop();
+    hid_close(dev);
+
+    if (!ok)
+        fprintf(stderr, "data mismatch!\n");
+
+    std::sort(latencies.begin(), latencies.end());
+
+    Result r;
+    r.mbytesPerSec = total / secs / 1e6;
+    r.p50us = latencies[latencies.size() / 2];
+    r.p99us = latencies[latencies.size() * 99 / 100];
+    r.signals = path->signals;
+
+    return r;
+}
+
+static void report(const char *name, const Result &r)
+{
+    printf("  %-8s %8.2f MB/s  latency p50 %8.1f us  p99 %8.1f us  "
+           "%ld readyRead\n", name, r.mbytesPerSec, r.p50us, r.p99us,
+           r.signals);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total = 2 << 20;
+
+    if (argc > 1)
+        total = strtoul(argv[1], NULL, 0);
+
+    printf("Bulk transfer, %zu bytes in 256 byte messages\n", total);
+    {
+        LegacyPath legacy;
+        report("legacy", run(&legacy, total, 256, 0));
+        BatchedPath batched;
+        report("batched", run(&batched, total, 256, 0));
+    }
+
+    printf("Telemetry-like stream, 2000 x 40 byte messages every 500us\n");
+    {
+        LegacyPath legacy;
+        report("legacy", run(&legacy, 2000 * 40, 40, 500));
+        BatchedPath batched;
+        report("batched", run(&batched, 2000 * 40, 40, 500));
+    }
+
+    return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
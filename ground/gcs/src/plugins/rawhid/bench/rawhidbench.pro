@@ -0,0 +1,17 @@
+# Throughput/latency benchmark for the RawHID I/O path.  Not part of the
+# GCS build; run qmake on this file directly and run ./rawhidbench.
+# The loopback hidapi stand-in replaces the platform hidapi so no device
+# is needed.
+TEMPLATE = app
+TARGET = rawhidbench
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+INCLUDEPATH += ../../../libs
+HEADERS += ../rawhidbatch.h \
+    ../../../libs/utils/spscring.h \
+    ../hidapi/hidapi.h
+SOURCES += rawhidbench.cpp \
+    ../rawhidbatch.cpp \
+    hidapi_loopback.c
+unix:LIBS += -lpthread
@@ -30,24 +30,38 @@
 #include "rawhid.h"
 
 #include "rawhid_const.h"
+#include "rawhidbatch.h"
+#include <utils/spscring.h>
 #include "coreplugin/connectionmanager.h"
 #include <extensionsystem/pluginmanager.h>
 #include <QtGlobal>
 #include <QList>
 #include <QMutexLocker>
 #include <QWaitCondition>
+#include <QAtomicInt>
 
 class IConnection;
 
 //timeout value used when we want to return directly without waiting
 static const int READ_TIMEOUT = 200;
-static const int READ_SIZE = 64;
 
-static const int WRITE_TIMEOUT = 1000;
-static const int WRITE_SIZE = 64;
+//max reports drained from the OS per wakeup before signalling the reader
+static const int READ_BATCH = 64;
+
+//bytes buffered between the read thread and the QIODevice consumer
+static const int READ_RING_SIZE = 1 << 18;
+
+//max reports sent per pass before accounting for them with bytesWritten
+static const int WRITE_BATCH = 64;
+
+//bytes buffered between the QIODevice producer and the write thread
+static const int WRITE_RING_SIZE = 1 << 16;
 
 static const int WRITE_RETRIES = 3;
 
+//delay before retrying a failed write
+static const int WRITE_RETRY_DELAY = 100;
+
 
 
 
@@ -68,23 +82,29 @@ public:
     /** return the bytes buffered */
     qint64 getBytesAvailable();
 
-    void stop() { m_running = false; }
+    void stop();
 
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-    a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
+    /** Filled by this thread, drained by the QIODevice without locking */
+    Utils::SpscRing m_readRing;
 
-    /** A mutex to protect read buffer */
-    QMutex m_readBufMtx;
+    /** Set while a readyRead is outstanding so each batch of reports costs
+    at most one signal */
+    QAtomicInt m_readyReadPending;
+
+    /** Only used to sleep while the ring is full */
+    QMutex m_spaceMtx;
+
+    /** Signalled by the consumer when it frees up ring space */
+    QWaitCondition m_spaceAvailable;
 
     RawHID *m_hid;
 
     hid_device *m_handle;
 
-    bool m_running;
+    volatile bool m_running;
 };
 
 
@@ -110,27 +130,31 @@ public:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-    a circular buffer but it's good enough and very simple */
-    QByteArray m_writeBuffer;
+    /** Filled by the QIODevice, drained by this thread without locking */
+    Utils::SpscRing m_writeRing;
 
-    /** A mutex to protect read buffer */
+    /** Only used to sleep and wake up the threads */
     QMutex m_writeBufMtx;
 
-    /** Synchronize task with data arival */
+    /** Synchronize task with data arrival */
     QWaitCondition m_newDataToWrite;
 
+    /** Lets the retry back-off return promptly when stopped */
+    QWaitCondition m_retryDelay;
+
     RawHID *m_hid;
 
     hid_device *m_handle;
 
-    bool m_running;
+    volatile bool m_running;
 };
 
 // *********************************************************************************
 
 RawHIDReadThread::RawHIDReadThread(RawHID *hid)
-    : m_hid(hid),
+    : m_readRing(READ_RING_SIZE),
+      m_readyReadPending(0),
+      m_hid(hid),
       m_handle(hid->m_handle),
       m_running(true)
 {
@@ -138,7 +162,7 @@ RawHIDReadThread::RawHIDReadThread(RawHID *hid)
 
 RawHIDReadThread::~RawHIDReadThread()
 {
-    m_running = false;
+    stop();
     //wait for the thread to terminate
     if(wait(10000) == false)
         qWarning() << "Cannot terminate RawHIDReadThread";
@@ -148,28 +172,23 @@ void RawHIDReadThread::run()
 {
     while(m_running)
     {
-        //here we use a temporary buffer so we don't need to lock
-        //the mutex while we are reading from the device
-
-        // Want to read in regular chunks that match the packet size the device
-        // is using.  In this case it is 64 bytes (the interrupt packet limit)
-        // although it would be nice if the device had a different report to
-        // configure this
-        unsigned char buffer[READ_SIZE] = {0};
-
-        int ret = hid_read_timeout(m_hid->m_handle, buffer, READ_SIZE, READ_TIMEOUT);
+        // Wait for a report, then take everything else the OS has queued
+        // in the same pass so a burst costs one wakeup of the consumer.
+        int ret = rawhid_read_batch(m_handle, &m_readRing, READ_TIMEOUT,
+                                    READ_BATCH);
 
         if(ret > 0) //read some data
         {
-            QMutexLocker lock(&m_readBufMtx);
-            // Note: Preprocess the USB packets in this OS independent code
-            // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append((char *) &buffer[2], buffer[1]);
-
-            emit m_hid->readyRead();
+            if (!m_readyReadPending.fetchAndStoreOrdered(1))
+                emit m_hid->readyRead();
         }
-        else if(ret == 0) //nothing read
+        else if(ret == 0) //nothing read, or no room to put it
         {
+            QMutexLocker lock(&m_spaceMtx);
+
+            while (m_running &&
+                   m_readRing.space() < (size_t) RAWHID_REPORT_PAYLOAD)
+                m_spaceAvailable.wait(&m_spaceMtx);
         }
         else // < 0 => error
         {
@@ -179,28 +198,43 @@ void RawHIDReadThread::run()
     }
 }
 
+//! Tell the thread to stop and make sure it wakes up immediately
+void RawHIDReadThread::stop()
+{
+    QMutexLocker lock(&m_spaceMtx);
+
+    m_running = false;
+    m_spaceAvailable.wakeOne();
+}
+
 int RawHIDReadThread::getReadData(char *data, int size)
 {
-    QMutexLocker lock(&m_readBufMtx);
+    // Clear before reading so data arriving after this point signals again
+    m_readyReadPending.storeRelease(0);
 
-    size = qMin(size, m_readBuffer.size());
+    size = m_readRing.read(data, size);
 
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
+    // The reader only sleeps after checking for space under the mutex, so
+    // checking again under it here can't miss that it has gone to sleep.
+    if (size) {
+        QMutexLocker lock(&m_spaceMtx);
+        if (m_readRing.space() >= (size_t) RAWHID_REPORT_PAYLOAD)
+            m_spaceAvailable.wakeAll();
+    }
 
     return size;
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
-    QMutexLocker lock(&m_readBufMtx);
-    return m_readBuffer.size();
+    return m_readRing.available();
 }
 
 // *********************************************************************************
 
 RawHIDWriteThread::RawHIDWriteThread(RawHID *hid)
-    : m_hid(hid),
+    : m_writeRing(WRITE_RING_SIZE),
+      m_hid(hid),
       m_handle(hid->m_handle),
       m_running(true)
 {
@@ -208,7 +242,7 @@ RawHIDWriteThread::RawHIDWriteThread(RawHID *hid)
 
 RawHIDWriteThread::~RawHIDWriteThread()
 {
-    m_running = false;
+    stop();
     //wait for the thread to terminate
     if(wait(10000) == false)
         qWarning() << "Cannot terminate RawHIDWriteThread";
@@ -219,47 +253,26 @@ void RawHIDWriteThread::run()
     int retry = 0;
     while(m_running)
     {
-        unsigned char buffer[WRITE_SIZE] = {0};
-        int size;
-
         {
             QMutexLocker lock(&m_writeBufMtx);
-            size = qMin(WRITE_SIZE-2, m_writeBuffer.size());
-            while(size <= 0)
-            {
-                //wait on new data to write condition, the timeout
-                //enable the thread to shutdown properly
-                m_newDataToWrite.wait(&m_writeBufMtx, 200);
-                if(!m_running)
-                    return;
 
-                size = m_writeBuffer.size();
-            }
+            //sleep until there is data or we are stopped; both wake
+            //the condition so there is no need to poll
+            while(m_running && m_writeRing.available() == 0)
+                m_newDataToWrite.wait(&m_writeBufMtx);
 
-            //NOTE: data size is limited to 2 bytes less than the
-            //usb packet size (64 bytes for interrupt) to make room
-            //for the reportID and valid data length
-            size = qMin(WRITE_SIZE-2, m_writeBuffer.size());
-            memcpy(&buffer[2], m_writeBuffer.constData(), size);
-            buffer[1] = size; //valid data length
-            buffer[0] = 2;    //reportID
+            if(!m_running)
+                return;
         }
 
-        // must hold lock through the send to know how much was sent
-        int ret = hid_write(m_hid->m_handle, buffer, WRITE_SIZE);
+        //send everything queued, data is only consumed once the device
+        //accepted it
+        int ret = rawhid_write_batch(m_handle, &m_writeRing, WRITE_BATCH);
 
         if(ret > 0)
         {
-            //only remove the size actually written to the device            
-            QMutexLocker lock(&m_writeBufMtx);
-            m_writeBuffer.remove(0, size);
-
-            emit m_hid->bytesWritten(ret - 2);
-        }
-        else if(ret == -110) // timeout
-        {
-            // timeout occured
-            RAW_HID_QXTLOG_DEBUG("Send Timeout: No data written to device.");
+            retry = 0;
+            emit m_hid->bytesWritten(ret);
         }
         else if(ret < 0) // < 0 => error
         {
@@ -272,7 +285,10 @@ void RawHIDWriteThread::run()
             }
             else
             {
-                this->msleep(100);
+                //back off, but still return promptly when stopped
+                QMutexLocker lock(&m_writeBufMtx);
+                if(m_running)
+                    m_retryDelay.wait(&m_writeBufMtx, WRITE_RETRY_DELAY);
             }
         }
         else
@@ -285,23 +301,34 @@ void RawHIDWriteThread::run()
 //! Tell the thread to stop and make sure it wakes up immediately
 void RawHIDWriteThread::stop()
 {
+    QMutexLocker lock(&m_writeBufMtx);
+
     m_running = false;
     m_newDataToWrite.wakeOne();
+    m_retryDelay.wakeAll();
 }
 
 int RawHIDWriteThread::pushDataToWrite(const char *data, int size)
 {
-    QMutexLocker lock(&m_writeBufMtx);
+    if (!m_running)
+        return 0;
 
-    m_writeBuffer.append(data, size);
-    m_newDataToWrite.wakeOne(); //signal that new data arrived
+    //never wait here, this runs on the caller's (usually the GUI) thread;
+    //when the ring is full the write is short and the caller retries
+    //once bytesWritten reports the device caught up
+    int written = m_writeRing.write(data, size);
 
-    return size;
+    if (written > 0) {
+        QMutexLocker lock(&m_writeBufMtx);
+        m_newDataToWrite.wakeOne(); //signal that new data arrived
+    }
+
+    return written;
 }
 
 qint64 RawHIDWriteThread::getBytesToWrite()
 {
-    return m_writeBuffer.size();
+    return m_writeRing.available();
 }
 
 // *********************************************************************************
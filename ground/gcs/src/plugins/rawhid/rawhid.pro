@@ -5,6 +5,7 @@ include(rawhid_dependencies.pri)
 HEADERS += rawhid_global.h \
     rawhidplugin.h \
     rawhid.h \
+    rawhidbatch.h \
     hidapi/hidapi.h \
     rawhid_const.h \
     usbmonitor.h \
@@ -12,6 +13,7 @@ HEADERS += rawhid_global.h \
     usbdevice.h
 SOURCES += rawhidplugin.cpp \
     rawhid.cpp \
+    rawhidbatch.cpp \
     usbsignalfilter.cpp \
     usbdevice.cpp \
     usbmonitor.cpp
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rawhidbatch.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup RawHIDPlugin Raw HID Plugin
+ * @{
+ * @brief Moves whole batches of HID reports between a device and byte rings
+ *
+ * Kept free of Qt so the same code can be exercised by the loopback
+ * benchmark in bench/.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "rawhidbatch.h"
+
+/**
+ * Append the payload of one received report to the ring.
+ * @return number of payload bytes
+ */
+static int push_report(Utils::SpscRing *ring, const unsigned char *report, int len)
+{
+    if (len < 2)
+        return 0;
+
+    // First byte is report ID, second byte is the number of valid bytes
+    int valid = report[1];
+
+    if (valid > len - 2)
+        valid = len - 2;
+
+    return ring->write((const char *) &report[2], valid);
+}
+
+/**
+ * Wait up to timeout_ms for a report, then drain every report the OS
+ * already has queued without waiting again.  Stops early rather than
+ * overflow the ring, so no received data is ever dropped.
+ *
+ * @param[in] handle the device to read from
+ * @param[in] ring ring to append the payloads to
+ * @param[in] timeout_ms how long to wait for the first report
+ * @param[in] max_reports upper bound on reports handled per call
+ * @return number of bytes appended (0 if nothing arrived or no room), or
+ * -1 on a device error with nothing read
+ */
+int rawhid_read_batch(hid_device *handle, Utils::SpscRing *ring, int timeout_ms,
+                      int max_reports)
+{
+    unsigned char report[RAWHID_REPORT_SIZE];
+    int total = 0;
+
+    for (int i = 0; i < max_reports; i++) {
+        if (ring->space() < (size_t) RAWHID_REPORT_PAYLOAD)
+            break;
+
+        int ret = hid_read_timeout(handle, report, sizeof(report),
+                                   i ? 0 : timeout_ms);
+
+        if (ret < 0)
+            return total ? total : -1;
+
+        if (ret == 0)
+            break;
+
+        total += push_report(ring, report, ret);
+    }
+
+    return total;
+}
+
+/**
+ * Send everything queued in the ring, one report per RAWHID_REPORT_PAYLOAD
+ * bytes.  Data is only consumed once the device has accepted it.
+ *
+ * @param[in] handle the device to write to
+ * @param[in] ring ring holding the bytes to send
+ * @param[in] max_reports upper bound on reports sent per call
+ * @return number of payload bytes sent, or -1 on a device error with
+ * nothing sent
+ */
+int rawhid_write_batch(hid_device *handle, Utils::SpscRing *ring, int max_reports)
+{
+    unsigned char report[RAWHID_REPORT_SIZE];
+    int total = 0;
+
+    for (int i = 0; i < max_reports; i++) {
+        int size = ring->peek((char *) &report[2], RAWHID_REPORT_PAYLOAD);
+
+        if (size == 0)
+            break;
+
+        report[0] = 2;      // reportID
+        report[1] = size;   // valid data length
+
+        // Unused tail of the report is sent as zeros
+        memset(&report[2 + size], 0, RAWHID_REPORT_PAYLOAD - size);
+
+        int ret = hid_write(handle, report, sizeof(report));
+
+        if (ret < 0)
+            return total ? total : -1;
+
+        if (ret == 0)
+            break;
+
+        ring->consume(size);
+        total += size;
+    }
+
+    return total;
+}
+
+/**
+ * @}
+ * @}
+ */
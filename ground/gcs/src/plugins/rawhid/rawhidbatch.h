@@ -0,0 +1,50 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rawhidbatch.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup RawHIDPlugin Raw HID Plugin
+ * @{
+ * @brief Moves whole batches of HID reports between a device and byte rings
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef RAWHIDBATCH_H
+#define RAWHIDBATCH_H
+
+#include "hidapi/hidapi.h"
+#include <utils/spscring.h>
+
+//! Size of the interrupt reports exchanged with the flight controller
+static const int RAWHID_REPORT_SIZE = 64;
+
+//! Payload per report: the first two bytes are report ID and valid length
+static const int RAWHID_REPORT_PAYLOAD = RAWHID_REPORT_SIZE - 2;
+
+int rawhid_read_batch(hid_device *handle, Utils::SpscRing *ring, int timeout_ms,
+                      int max_reports);
+
+int rawhid_write_batch(hid_device *handle, Utils::SpscRing *ring, int max_reports);
+
+#endif // RAWHIDBATCH_H
+
+/**
+ * @}
+ * @}
+ */
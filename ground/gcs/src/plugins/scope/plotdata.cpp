@@ -145,23 +145,22 @@ Plot3dData::~Plot3dData()
 
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief fieldHandleFor Match an updated UAVO against the plotted one. The field
+ * is looked up by name the first time the UAVO is seen, after which matching is
+ * by object ID and the value is read without any further lookups.
+ * @param obj UAVO with new data
+ * @return the handle to read the plotted value through, or NULL if obj isn't plotted
  */
-double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
+const UAVObjectFieldHandle *PlotData::fieldHandleFor(UAVObject *obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    if (fieldHandle.matches(obj))
+        return &fieldHandle;
 
-    if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
+    if (fieldHandle.isValid() || uavObjectName != obj->getName())
+        return NULL;
 
-    return value.toDouble();
+    fieldHandle = UAVObjectFieldHandle::resolve(obj, uavFieldName,
+                                                haveSubField ? uavSubFieldName : QString());
+
+    return fieldHandle.isValid() ? &fieldHandle : NULL;
 }
@@ -33,6 +33,7 @@ class ScopeGadgetWidget;
 class ScopeConfig;
 
 #include "uavobject.h"
+#include "uavobjectfieldhandle.h"
 
 #include "qwt/src/qwt_color_map.h"
 #include "qwt/src/qwt_scale_widget.h"
@@ -46,8 +47,6 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
-
     //Setter functions
     void setXMinimum(double val){xMinimum=val;}
     virtual void setXMaximum(double val){xMaximum=val;}
@@ -102,6 +101,9 @@ protected:
     QString uavSubFieldName;
     bool haveSubField;
 
+    const UAVObjectFieldHandle *fieldHandleFor(UAVObject *obj);
+    UAVObjectFieldHandle fieldHandle;
+
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
@@ -84,61 +84,55 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
+    const UAVObjectFieldHandle *field = fieldHandleFor(obj);
+    if (field) {
+        double currentValue = field->toDouble(obj) * pow(10, scalePower);
+
+        //Perform scope math, if necessary
+        if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
+            //Put the new value at the front
+            yDataHistory->append( currentValue );
+
+            // calculate average value
+            meanSum += currentValue;
+            if(yDataHistory->size() > (int)meanSamples) {
+                meanSum -= yDataHistory->first();
+                yDataHistory->pop_front();
+            }
 
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
+            // make sure to correct the sum every meanSamples steps to prevent it
+            // from running away due to floating point rounding errors
+            correctionSum+=currentValue;
+            if (++correctionCount >= (int)meanSamples) {
+                meanSum = correctionSum;
+                correctionSum = 0.0f;
+                correctionCount = 0;
+            }
 
-                double boxcarAvg=meanSum/yDataHistory->size();
+            double boxcarAvg=meanSum/yDataHistory->size();
 
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
+            if ( mathFunction  == "Standard deviation" ){
+                //Calculate square of sample standard deviation, with Bessel's correction
+                double stdSum=0;
+                for (int i=0; i < yDataHistory->size(); i++){
+                    stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
                 }
+                yData->append(sqrt(stdSum));
             }
-            else{
-                yData->append( currentValue );
+            else  {
+                yData->append(boxcarAvg);
             }
+        }
+        else{
+            yData->append( currentValue );
+        }
 
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
+        if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
+            yData->pop_front();
+        } else //...otherwise, add a new y point at position xData
+            xData->insert(xData->size(), xData->size());
 
-            return true;
-        }
+        return true;
     }
 
     return false;
@@ -152,60 +146,56 @@ bool SeriesPlotData::append(UAVObject* obj)
  */
 bool TimeSeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
+    const UAVObjectFieldHandle *field = fieldHandleFor(obj);
+    if (field) {
+        QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
+        double currentValue = field->toDouble(obj) * pow(10, scalePower);
+
+        //Perform scope math, if necessary
+        if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
+            //Put the new value at the back
+            yDataHistory->append( currentValue );
+
+            // calculate average value
+            meanSum += currentValue;
+            if(yDataHistory->size() > (int)meanSamples) {
+                meanSum -= yDataHistory->first();
+                yDataHistory->pop_front();
+            }
+            // make sure to correct the sum every meanSamples steps to prevent it
+            // from running away due to floating point rounding errors
+            correctionSum+=currentValue;
+            if (++correctionCount >= (int)meanSamples) {
+                meanSum = correctionSum;
+                correctionSum = 0.0f;
+                correctionCount = 0;
+            }
 
-                double boxcarAvg=meanSum/yDataHistory->size();
+            double boxcarAvg=meanSum/yDataHistory->size();
 
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
+            if ( mathFunction  == "Standard deviation" ){
+                //Calculate square of sample standard deviation, with Bessel's correction
+                double stdSum=0;
+                for (int i=0; i < yDataHistory->size(); i++){
+                    stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
                 }
+                yData->append(sqrt(stdSum));
             }
-            else{
-                yData->append( currentValue );
+            else  {
+                yData->append(boxcarAvg);
             }
+        }
+        else{
+            yData->append( currentValue );
+        }
 
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
+        double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        xData->append(valueX);
 
-            //Remove stale data
-            removeStaleData();
+        //Remove stale data
+        removeStaleData();
 
-            return true;
-        }
+        return true;
     }
 
     return false;
@@ -145,7 +145,8 @@ bool SpectrogramData::append(UAVObject* multiObj)
     QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
 
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    const UAVObjectFieldHandle *handle = fieldHandleFor(multiObj);
+    if (handle) {
 
         // Only run on UAVOs that have multiple instances
         if (multiObj->isSingleInstance()) {
@@ -164,7 +165,7 @@ bool SpectrogramData::append(UAVObject* multiObj)
         // Get list of object instances
         QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
 
-        uint16_t newWindowWidth = list.size() * list.front()->getField(uavFieldName)->getNumElements();
+        uint16_t newWindowWidth = list.size() * handle->getNumElements();
 
         /* Check if the instance has a samples field as this will override the windowWidth
         *  Field can be used in objects that have dynamic size 
@@ -202,122 +203,116 @@ bool SpectrogramData::append(UAVObject* multiObj)
             qDebug() << "Spectrogram width adjusted to " << windowWidth;
         }
 
-        UAVObjectField* multiField = multiObj->getField(uavFieldName);
-        Q_ASSERT(multiField);
-        if (multiField ) {
-
-            // Get the field of interest
-            foreach (UAVObject *obj, list) {
-                UAVObjectField* field = obj->getField(uavFieldName);
-                int numElements = field->getNumElements();
-
-                double scale = 1;
-                QList<UAVObjectField*> fieldList = obj->getFields();
-                foreach (UAVObjectField* field, fieldList) {
-                    // Check if the instance has a scale field
-                    if(field->getType() == UAVObjectField::FLOAT32 && field->getName() == "scale"){
-                        scale = field->getValue().toDouble();
-                        break;
-                    }
+        // Get the field of interest
+        foreach (UAVObject *obj, list) {
+            int numElements = handle->getNumElements();
 
-                    // Check if data is ordered. If not, just discard everything
-                    if (field->getType() == UAVObjectField::INT16 && field->getName() == "index") {
-                        int currentIndex = field->getValue().toDouble();
-                        if (currentIndex != (lastInstanceIndex + 1)) {
-                            fprintf(stderr, "Out of order index. Got %d expected %d\n", currentIndex, lastInstanceIndex + 1);
-                            plotData.clear();
-                            lastInstanceIndex = -1; // Next index will be 0
-                            return false;
-                        }
-
-                        lastInstanceIndex++;
-                    }
+            double scale = 1;
+            QList<UAVObjectField*> fieldList = obj->getFields();
+            foreach (UAVObjectField* field, fieldList) {
+                // Check if the instance has a scale field
+                if(field->getType() == UAVObjectField::FLOAT32 && field->getName() == "scale"){
+                    scale = field->getValue().toDouble();
+                    break;
                 }
 
-                for (int i = 0; i < numElements; i++) {
-                    double currentValue = field->getValue(i).toDouble() / scale;  // Get the value and scale it
-
-                    //Normally some math would go here, modifying currentValue before appending it to values
-                    // .
-                    // .
-                    // .
+                // Check if data is ordered. If not, just discard everything
+                if (field->getType() == UAVObjectField::INT16 && field->getName() == "index") {
+                    int currentIndex = field->getValue().toDouble();
+                    if (currentIndex != (lastInstanceIndex + 1)) {
+                        fprintf(stderr, "Out of order index. Got %d expected %d\n", currentIndex, lastInstanceIndex + 1);
+                        plotData.clear();
+                        lastInstanceIndex = -1; // Next index will be 0
+                        return false;
+                    }
 
-                    // Last step, assign value to vector
-                    plotData += currentValue;
+                    lastInstanceIndex++;
                 }
+            }
 
-                // Check if we got enough values
-                // The object instance can temporarily have more values than required
-                if (plotData.size() == valuesToProcess ) {
-                    break;
-                }
+            for (int i = 0; i < numElements; i++) {
+                double currentValue = handle->toDouble(obj, i) / scale;  // Get the value and scale it
+
+                //Normally some math would go here, modifying currentValue before appending it to values
+                // .
+                // .
+                // .
+
+                // Last step, assign value to vector
+                plotData += currentValue;
             }
 
-            // If some instances are still missing
-            if (plotData.size() != valuesToProcess) {
-                return false;
+            // Check if we got enough values
+            // The object instance can temporarily have more values than required
+            if (plotData.size() == valuesToProcess ) {
+                break;
             }
+        }
 
-            // Check if the FFT needs to be calculated
-            // Because this function is optional we will calculate the FFT and then
-            // update the original vector. This will allow using the same code
-            // to display the information.
-            if (mathFunction == "FFT") {
+        // If some instances are still missing
+        if (plotData.size() != valuesToProcess) {
+            return false;
+        }
 
-                // Check if the fft_object was already created or needs to be updated
-                // May happen if settings change after the spectrogram was created
-                if (fft_object == NULL || fft_object->get_length() != valuesToProcess) {
-                    if (fft_object != NULL)
-                        delete fft_object;
+        // Check if the FFT needs to be calculated
+        // Because this function is optional we will calculate the FFT and then
+        // update the original vector. This will allow using the same code
+        // to display the information.
+        if (mathFunction == "FFT") {
 
-                    fft_object = new ffft::FFTReal<double>(valuesToProcess);
-                }
+            // Check if the fft_object was already created or needs to be updated
+            // May happen if settings change after the spectrogram was created
+            if (fft_object == NULL || fft_object->get_length() != valuesToProcess) {
+                if (fft_object != NULL)
+                    delete fft_object;
 
-                // Hanning Window
-                for (int i = 0; i < valuesToProcess; i++) {
-                    plotData[i] *= pow(sin(PI*i/(valuesToProcess - 1) ), 2);
-                }
+                fft_object = new ffft::FFTReal<double>(valuesToProcess);
+            }
 
-                QVector<double> fftout(valuesToProcess);
+            // Hanning Window
+            for (int i = 0; i < valuesToProcess; i++) {
+                plotData[i] *= pow(sin(PI*i/(valuesToProcess - 1) ), 2);
+            }
 
-                fft_object->do_fft(&fftout[0], plotData.data()); // Do FFT
-                plotData.clear();  // Clear vector
+            QVector<double> fftout(valuesToProcess);
 
-                // Lets get the magnitude and scale it.
-                // mag = X * sqrt(re^2 + im^2)/n
-                // X (4.2) is chosen so that the magnitude presented is similar to the acceleration registered
-                // although this is not 100% correct, it helps users understanding the spectrogram.
-                for (unsigned int i = 0; i < valuesToProcess/2; i++) {
-                    plotData << 4.2*sqrt(pow(fftout[i], 2) + pow(fftout[valuesToProcess/2 + i], 2)) / valuesToProcess;
-                }
+            fft_object->do_fft(&fftout[0], plotData.data()); // Do FFT
+            plotData.clear();  // Clear vector
+
+            // Lets get the magnitude and scale it.
+            // mag = X * sqrt(re^2 + im^2)/n
+            // X (4.2) is chosen so that the magnitude presented is similar to the acceleration registered
+            // although this is not 100% correct, it helps users understanding the spectrogram.
+            for (unsigned int i = 0; i < valuesToProcess/2; i++) {
+                plotData << 4.2*sqrt(pow(fftout[i], 2) + pow(fftout[valuesToProcess/2 + i], 2)) / valuesToProcess;
             }
-            
-            // Apply autoscale if enabled
-            if (zMaximum == 0) {
+        }
+        
+        // Apply autoscale if enabled
+        if (zMaximum == 0) {
 				for (unsigned int i = 0; i < windowWidth; i++) {
 	                 // See if autoscale is turned on and if the value exceeds the maximum for the scope.
 	                if (plotData[i] > rasterData->interval(Qt::ZAxis).maxValue()){
 	                    // Change scope maximum and color depth
 	                    rasterData->setInterval(Qt::ZAxis, QwtInterval(0, plotData[i]) );
 	                    autoscaleValueUpdated = plotData[i];
-                	}
             	}
+        	}
 
 
-            }
-
-            timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-            while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon) {
-                timeDataHistory->pop_front();
-                zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
-            }
-            
-            *zDataHistory << plotData;
-            plotData.clear();
-            lastInstanceIndex = -1; // Next index will be 0
+        }
 
-            return true;
+        timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
+        while (timeDataHistory->back() - timeDataHistory->front() > timeHorizon) {
+            timeDataHistory->pop_front();
+            zDataHistory->remove(0, fminl(windowWidth, zDataHistory->size()));
         }
+        
+        *zDataHistory << plotData;
+        plotData.clear();
+        lastInstanceIndex = -1; // Next index will be 0
+
+        return true;
     }
 
     return false;
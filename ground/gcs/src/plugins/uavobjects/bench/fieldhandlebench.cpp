@@ -0,0 +1,260 @@
+/**
+ ******************************************************************************
+ *
+ * @file       fieldhandlebench.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Per-sample cost of the scope's field access, by name through
+ *        getField()/getValue() versus through a UAVObjectFieldHandle
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QStringList>
+#include <QVector>
+
+#include <cstdio>
+#include <cstring>
+
+#include "uavobject.h"
+#include "uavobjectfield.h"
+#include "uavobjectfieldhandle.h"
+
+static const int SAMPLES = 200000;
+static const int PACKETS = 64;
+
+/**
+*   Stand-in for a generated object, laid out like Gyros plus a few fields
+*   of the other types so every reader gets exercised.
+*/
+class BenchObject : public UAVObject
+{
+public:
+    static const quint32 NUMBYTES = 4 * 3 + 4 * 3 + 2 + 1 + 1;
+
+    BenchObject(quint32 objID, const QString &name) :
+        UAVObject(objID, true, name)
+    {
+        QList<UAVObjectField *> fields;
+
+        fields.append(new UAVObjectField("x", "deg/s", UAVObjectField::FLOAT32, 1,
+                                         QStringList(), QList<int>()));
+        fields.append(new UAVObjectField("y", "deg/s", UAVObjectField::FLOAT32, 1,
+                                         QStringList(), QList<int>()));
+        fields.append(new UAVObjectField("z", "deg/s", UAVObjectField::FLOAT32, 1,
+                                         QStringList(), QList<int>()));
+        fields.append(new UAVObjectField("Accel", "m/s^2", UAVObjectField::FLOAT32,
+                                         QStringList() << "X" << "Y" << "Z",
+                                         QStringList(), QList<int>()));
+        fields.append(new UAVObjectField("Temperature", "cdeg", UAVObjectField::INT16, 1,
+                                         QStringList(), QList<int>()));
+        fields.append(new UAVObjectField("Status", "", UAVObjectField::ENUM, 1,
+                                         QStringList() << "Ok" << "Warning" << "Error",
+                                         QList<int>() << 0 << 1 << 2));
+        fields.append(new UAVObjectField("Flags", "", UAVObjectField::BITFIELD, 8,
+                                         QStringList(), QList<int>()));
+
+        initializeFields(fields, buf, NUMBYTES);
+
+        MetadataInitialize(mdata);
+    }
+
+    void setMetadata(const Metadata &m) { mdata = m; }
+    Metadata getMetadata() { return mdata; }
+    Metadata getDefaultMetadata() { return mdata; }
+
+private:
+    quint8 buf[NUMBYTES];
+    Metadata mdata;
+};
+
+/** A scope curve: object name, field name and optional element name */
+struct Curve {
+    const char *object;
+    const char *field;
+    const char *element;
+};
+
+static const Curve curves[] = {
+    { "Gyros", "x", 0 },
+    { "Gyros", "y", 0 },
+    { "Gyros", "z", 0 },
+    { "Gyros", "Accel", "Y" },
+    { "Gyros", "Temperature", 0 },
+    { "Gyros", "Status", 0 },
+};
+
+static const int NUM_CURVES = sizeof(curves) / sizeof(curves[0]);
+
+/** What PlotData::valueAsDouble() and its callers used to do */
+static double byName(UAVObject *obj, const QString &objName, const QString &fieldName,
+                     const QString &elementName)
+{
+    if (objName != obj->getName())
+        return 0;
+
+    UAVObjectField *field = obj->getField(fieldName);
+    if (!field)
+        return 0;
+
+    QVariant value;
+
+    if (!elementName.isEmpty()) {
+        int index = field->getElementNames().indexOf(QRegExp(elementName, Qt::CaseSensitive,
+                                                             QRegExp::FixedString));
+        value = field->getValue(index);
+    } else {
+        value = field->getValue();
+    }
+
+    return value.toDouble();
+}
+
+static bool checkHandles(BenchObject *obj)
+{
+    bool ok = true;
+
+    for (int i = 0; i < NUM_CURVES; i++) {
+        UAVObjectFieldHandle h = UAVObjectFieldHandle::resolve(obj, curves[i].field,
+                                                               curves[i].element);
+        UAVObjectField *field = obj->getField(curves[i].field);
+        double expected = byName(obj, curves[i].object, curves[i].field,
+                                 curves[i].element ? curves[i].element : "");
+
+        // Enums used to read as 0 through QVariant::toDouble()
+        if (field->getType() == UAVObjectField::ENUM)
+            expected = field->getOptions().indexOf(field->getValue().toString());
+
+        if (!h.isValid() || !h.matches(obj) || h.toDouble(obj) != expected) {
+            fprintf(stderr, "mismatch on %s.%s: %f vs %f\n", curves[i].object,
+                    curves[i].field, h.toDouble(obj), expected);
+            ok = false;
+        }
+    }
+
+    UAVObjectField *flags = obj->getField("Flags");
+    UAVObjectFieldHandle flagsHandle(flags);
+
+    for (quint32 bit = 0; bit < flags->getNumElements(); bit++) {
+        if (flagsHandle.toDouble(obj, bit) != flags->getValue(bit).toDouble()) {
+            fprintf(stderr, "mismatch on Flags bit %u\n", bit);
+            ok = false;
+        }
+    }
+
+    if (UAVObjectFieldHandle::resolve(obj, "Accel", "W").isValid() ||
+            UAVObjectFieldHandle::resolve(obj, "Nope").isValid()) {
+        fprintf(stderr, "resolved a field that doesn't exist\n");
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    BenchObject gyros(0x1, "Gyros");
+    BenchObject other(0x2, "Accels");
+
+    // Random packets so nothing can be hoisted out of the loops
+    QVector<QByteArray> packets;
+    for (int i = 0; i < PACKETS; i++) {
+        QByteArray p(BenchObject::NUMBYTES, 0);
+        for (int j = 0; j < p.size(); j++)
+            p[j] = qrand();
+        // Keep the enum in range and the floats finite
+        p[BenchObject::NUMBYTES - 2] = i % 3;
+        for (int j = 0; j < 6; j++) {
+            float f = (qrand() % 20000 - 10000) / 10.0f;
+            memcpy(p.data() + 4 * j, &f, sizeof(f));
+        }
+        packets.append(p);
+    }
+
+    gyros.unpack((const quint8 *)packets[0].constData());
+
+    if (!checkHandles(&gyros))
+        return 1;
+
+    QString objNames[NUM_CURVES], fieldNames[NUM_CURVES], elementNames[NUM_CURVES];
+    UAVObjectFieldHandle handles[NUM_CURVES];
+
+    for (int i = 0; i < NUM_CURVES; i++) {
+        objNames[i] = curves[i].object;
+        fieldNames[i] = curves[i].field;
+        elementNames[i] = curves[i].element ? curves[i].element : "";
+        handles[i] = UAVObjectFieldHandle::resolve(&gyros, fieldNames[i], elementNames[i]);
+    }
+
+    // Every curve sees every update of every object, like the scope does
+    QElapsedTimer timer;
+    volatile double sink = 0;
+
+    timer.start();
+    for (int s = 0; s < SAMPLES; s++) {
+        BenchObject *obj = (s & 1) ? &other : &gyros;
+        obj->unpack((const quint8 *)packets[s % PACKETS].constData());
+    }
+    qint64 baseNs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (int s = 0; s < SAMPLES; s++) {
+        BenchObject *obj = (s & 1) ? &other : &gyros;
+        obj->unpack((const quint8 *)packets[s % PACKETS].constData());
+
+        double sum = 0;
+        for (int i = 0; i < NUM_CURVES; i++)
+            sum += byName(obj, objNames[i], fieldNames[i], elementNames[i]);
+        sink = sink + sum;
+    }
+    qint64 nameNs = timer.nsecsElapsed() - baseNs;
+
+    timer.restart();
+    for (int s = 0; s < SAMPLES; s++) {
+        BenchObject *obj = (s & 1) ? &other : &gyros;
+        obj->unpack((const quint8 *)packets[s % PACKETS].constData());
+
+        double sum = 0;
+        for (int i = 0; i < NUM_CURVES; i++)
+            if (handles[i].matches(obj))
+                sum += handles[i].toDouble(obj);
+        sink = sink + sum;
+    }
+    qint64 handleNs = timer.nsecsElapsed() - baseNs;
+
+    double reads = (double)SAMPLES * NUM_CURVES;
+
+    printf("%d updates x %d curves (unpack cost of %.1f ns/update subtracted)\n",
+           SAMPLES, NUM_CURVES, (double)baseNs / SAMPLES);
+    printf("  by name:     %8.1f ns/read\n", nameNs / reads);
+    printf("  field handle:%8.1f ns/read\n", handleNs / reads);
+    printf("  speedup:     %8.1fx\n", handleNs > 0 ? (double)nameNs / handleNs : 0.0);
+
+    return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
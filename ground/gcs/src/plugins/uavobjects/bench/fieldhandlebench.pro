@@ -0,0 +1,17 @@
+# Per-sample cost of reading UAVO field values by name versus through a
+# UAVObjectFieldHandle.  Not part of the GCS build; run qmake on this file
+# directly and run ./fieldhandlebench.
+TEMPLATE = app
+TARGET = fieldhandlebench
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+DEFINES += UAVOBJECTS_LIBRARY
+INCLUDEPATH += ..
+HEADERS += ../uavobject.h \
+    ../uavobjectfield.h \
+    ../uavobjectfieldhandle.h
+SOURCES += fieldhandlebench.cpp \
+    ../uavobject.cpp \
+    ../uavobjectfield.cpp \
+    ../uavobjectfieldhandle.cpp
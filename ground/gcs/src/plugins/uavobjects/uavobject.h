@@ -236,6 +236,8 @@ private slots:
     void fieldUpdated(UAVObjectField* field);
 
 protected:
+    friend class UAVObjectFieldHandle;
+
     quint32 objID;
     quint32 instID;
     bool isSingleInst;
@@ -0,0 +1,126 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldhandle.cpp
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Precompiled, allocation free numeric access to a UAVO field element
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "uavobjectfieldhandle.h"
+#include "uavobjectfield.h"
+
+#include <string.h>
+
+namespace {
+
+// Object data is packed, so every element is read through memcpy
+template <typename T>
+double readElement(const quint8 *base, quint32 index)
+{
+    T val;
+    memcpy(&val, base + sizeof(T) * index, sizeof(T));
+    return val;
+}
+
+double readBit(const quint8 *base, quint32 index)
+{
+    return (base[index / 8] >> (index % 8)) & 1;
+}
+
+double readNothing(const quint8 *, quint32)
+{
+    return 0;
+}
+
+}
+
+UAVObjectFieldHandle::UAVObjectFieldHandle() :
+    m_objId(0), m_offset(0), m_index(0), m_numElements(0), m_read(0)
+{
+}
+
+UAVObjectFieldHandle::UAVObjectFieldHandle(UAVObjectField *field, quint32 index) :
+    m_objId(0), m_offset(0), m_index(index), m_numElements(0), m_read(0)
+{
+    if (!field || !field->getObject() || index >= field->getNumElements())
+        return;
+
+    m_objId = field->getObject()->getObjID();
+    m_offset = field->getDataOffset();
+    m_numElements = field->getNumElements();
+
+    switch (field->getType()) {
+    case UAVObjectField::INT8:
+        m_read = readElement<qint8>;
+        break;
+    case UAVObjectField::INT16:
+        m_read = readElement<qint16>;
+        break;
+    case UAVObjectField::INT32:
+        m_read = readElement<qint32>;
+        break;
+    case UAVObjectField::UINT8:
+    case UAVObjectField::ENUM:
+        m_read = readElement<quint8>;
+        break;
+    case UAVObjectField::UINT16:
+        m_read = readElement<quint16>;
+        break;
+    case UAVObjectField::UINT32:
+        m_read = readElement<quint32>;
+        break;
+    case UAVObjectField::FLOAT32:
+        m_read = readElement<float>;
+        break;
+    case UAVObjectField::BITFIELD:
+        m_read = readBit;
+        break;
+    case UAVObjectField::STRING:
+        m_read = readNothing;
+        break;
+    }
+}
+
+UAVObjectFieldHandle UAVObjectFieldHandle::resolve(UAVObject *obj, const QString &fieldName,
+                                                   const QString &elementName)
+{
+    if (!obj)
+        return UAVObjectFieldHandle();
+
+    UAVObjectField *field = obj->getField(fieldName);
+    if (!field)
+        return UAVObjectFieldHandle();
+
+    if (elementName.isEmpty())
+        return UAVObjectFieldHandle(field);
+
+    int index = field->getElementNames().indexOf(elementName);
+    if (index < 0)
+        return UAVObjectFieldHandle();
+
+    return UAVObjectFieldHandle(field, index);
+}
+
+/**
+ * @}
+ * @}
+ */
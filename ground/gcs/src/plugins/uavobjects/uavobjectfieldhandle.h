@@ -0,0 +1,114 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldhandle.h
+ * @author     dRonin, http://dronin.org Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief Precompiled, allocation free numeric access to a UAVO field element
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef UAVOBJECTFIELDHANDLE_H
+#define UAVOBJECTFIELDHANDLE_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include <QString>
+
+class UAVObjectField;
+
+/**
+*   Resolves an object/field/element triple once, then reads the element
+*   as a number straight out of the object's data buffer.  This avoids the
+*   name lookups and QVariant boxing of UAVObjectField::getValue() on paths
+*   that run for every received sample.
+*
+*   A handle is tied to an object ID and a field layout, not to an object
+*   instance, so the same handle can read any instance of the object.
+*   Enums read as their raw numeric value, strings always read as 0.
+*/
+class UAVOBJECTS_EXPORT UAVObjectFieldHandle
+{
+public:
+    UAVObjectFieldHandle();
+    explicit UAVObjectFieldHandle(UAVObjectField *field, quint32 index = 0);
+
+    /**
+     * @brief Look up a field element by name
+     * @param obj Any instance of the object
+     * @param fieldName Name of the field
+     * @param elementName Name of the element, or empty for the first one
+     * @return the handle, invalid if any of the names do not exist
+     */
+    static UAVObjectFieldHandle resolve(UAVObject *obj, const QString &fieldName,
+                                        const QString &elementName = QString());
+
+    bool isValid() const { return m_read != 0; }
+    quint32 getObjID() const { return m_objId; }
+    quint32 getIndex() const { return m_index; }
+    quint32 getNumElements() const { return m_numElements; }
+
+    /** True if obj is an instance of the object this handle reads */
+    bool matches(const UAVObject *obj) const
+    {
+        return isValid() && obj->objID == m_objId;
+    }
+
+    /** Read the resolved element, the caller must check matches() first */
+    double toDouble(const UAVObject *obj) const
+    {
+        return m_read(obj->data + m_offset, m_index);
+    }
+
+    float toFloat(const UAVObject *obj) const
+    {
+        return (float)toDouble(obj);
+    }
+
+    /**
+     * @brief Read another element of the same field
+     * @param obj Instance to read, must match this handle
+     * @param index Element index
+     * @return the value, or 0 if index is out of range
+     */
+    double toDouble(const UAVObject *obj, quint32 index) const
+    {
+        if (index >= m_numElements)
+            return 0;
+
+        return m_read(obj->data + m_offset, index);
+    }
+
+private:
+    typedef double (*ReadFn)(const quint8 *base, quint32 index);
+
+    quint32 m_objId;
+    quint32 m_offset;       /**< Offset of the field in the object data */
+    quint32 m_index;
+    quint32 m_numElements;
+    ReadFn m_read;
+};
+
+#endif // UAVOBJECTFIELDHANDLE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -57,6 +57,8 @@
 UAVObjectUtilManager::UAVObjectUtilManager()
 {
     saveState = IDLE;
+    saveScheduled = false;
+    batchSupported = true;
     failureTimer.stop();
     failureTimer.setSingleShot(true);
     failureTimer.setInterval(1000);
@@ -115,10 +117,41 @@ void UAVObjectUtilManager::saveObjectToFlash(UAVObject *obj)
     queue.enqueue(obj);
     UAVOBJECTUTIL_QXTLOG_DEBUG(QString("Enqueue object:%0").arg(obj->getName()));
 
-    // If queue length is one, then start sending (call sendNextObject)
-    // Otherwise, do nothing, because we are already sending.
-    if (queue.length()==1)
-        saveNextObject();
+    scheduleSave();
+}
+
+/**
+ * @brief UAVObjectUtilManager::saveObjectsToFlash Add several objects to save in the queue
+ * @param objs
+ *
+ * Same as calling saveObjectToFlash for each object; a saveCompleted signal is emitted
+ * for every one of them.
+ */
+void UAVObjectUtilManager::saveObjectsToFlash(const QList<UAVObject *> &objs)
+{
+    foreach (UAVObject *obj, objs) {
+        queue.enqueue(obj);
+    }
+
+    scheduleSave();
+}
+
+/**
+ * @brief UAVObjectUtilManager::scheduleSave Start processing the save queue
+ *
+ * Processing is deferred to the event loop, so that objects queued back-to-back
+ * by the caller end up in the same ObjectPersistenceBatch request instead of
+ * being saved one round trip at a time.
+ */
+void UAVObjectUtilManager::scheduleSave()
+{
+    // If we are already sending, the queue will be picked up once the
+    // current operation completes.
+    if (saveState != IDLE || saveScheduled)
+        return;
+
+    saveScheduled = true;
+    QTimer::singleShot(0, this, SLOT(saveNextObject()));
 }
 
 
@@ -129,11 +162,22 @@ void UAVObjectUtilManager::saveObjectToFlash(UAVObject *obj)
  */
 void UAVObjectUtilManager::saveNextObject()
 {
+    saveScheduled = false;
+
     if ( queue.isEmpty() ) {
+        // Give batches another chance on the next round of saves
+        batchSupported = true;
         return;
     }
 
-    Q_ASSERT(saveState == IDLE);
+    if (saveState != IDLE) {
+        return;
+    }
+
+    if (batchSupported && queue.length() > 1) {
+        saveNextBatch();
+        return;
+    }
 
     // Get next object from the queue (don't dequeue yet)
     UAVObject* obj = queue.head();
@@ -220,6 +264,18 @@ void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject* obj,
   */
 void UAVObjectUtilManager::objectPersistenceOperationFailed()
 {
+    if (!batch.isEmpty()) {
+        if (saveState == AWAITING_COMPLETED) {
+            // If the board never started on the batch, retry the objects one
+            // at a time; otherwise the unreported ones are lost.
+            bool started = batchReported.contains(true);
+            if (!started)
+                batchSupported = false;
+            finishBatch(!started);
+        }
+        return;
+    }
+
     if (saveState == AWAITING_COMPLETED) {
 
         ObjectPersistence * objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
@@ -278,6 +334,167 @@ void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject * obj)
 }
 
 
+/**
+ * @brief UAVObjectUtilManager::saveNextBatch
+ *
+ * Sends the head of the save queue as a single ObjectPersistenceBatch request.
+ * The board saves all of the objects in one flash transaction and updates the
+ * Result field of the request as it goes, and we emit saveCompleted for each
+ * object as soon as its result comes back.
+ */
+void UAVObjectUtilManager::saveNextBatch()
+{
+    ObjectPersistenceBatch *objectPersistenceBatch = ObjectPersistenceBatch::GetInstance(getObjectManager());
+    Q_ASSERT(objectPersistenceBatch);
+
+    ObjectPersistenceBatch::DataFields data;
+    memset(&data, 0, sizeof(data));
+
+    int numObjects = qMin(queue.length(), (int)ObjectPersistenceBatch::OBJECTID_NUMELEM);
+
+    batch.clear();
+    for (int i = 0; i < numObjects; i++) {
+        UAVObject *obj = queue.at(i);
+        Q_ASSERT(obj);
+        batch.append(obj);
+
+        data.ObjectID[i] = obj->getObjID();
+        data.InstanceID[i] = obj->getInstID();
+        data.Result[i] = ObjectPersistenceBatch::RESULT_PENDING;
+    }
+    batchReported.fill(false, numObjects);
+
+    UAVOBJECTUTIL_QXTLOG_DEBUG(QString("Send batch save request for %0 objects to board").arg(numObjects));
+
+    // Same sequence as for single objects: wait for the ACK of the request, then
+    // for the board to send it back with the results.
+    connect(objectPersistenceBatch, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectPersistenceBatchTransactionCompleted(UAVObject*,bool)), Qt::UniqueConnection);
+    connect(objectPersistenceBatch, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectPersistenceBatchUpdated(UAVObject *)), Qt::UniqueConnection);
+    saveState = AWAITING_ACK;
+
+    data.Operation = ObjectPersistenceBatch::OPERATION_SAVE;
+    data.NumObjects = numObjects;
+    data.Progress = 0;
+    objectPersistenceBatch->setData(data);
+    objectPersistenceBatch->updated();
+}
+
+/**
+ * @brief Process the transactionCompleted message for a batch save request
+ * @param[in] The object just transacted.  Must be ObjectPersistenceBatch
+ * @param[in] success Indicates that the transaction did not time out
+ *
+ * A batch request that isn't acknowledged usually means the board does not
+ * know about batches, so the objects are then saved one at a time instead.
+ */
+void UAVObjectUtilManager::objectPersistenceBatchTransactionCompleted(UAVObject* obj, bool success)
+{
+    Q_ASSERT(obj->getObjID() == ObjectPersistenceBatch::OBJID);
+
+    if (saveState != AWAITING_ACK) {
+        return;
+    }
+
+    if (success) {
+        saveState = AWAITING_COMPLETED;
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(objectPersistenceBatchTransactionCompleted(UAVObject*,bool)));
+        failureTimer.start(2000);
+    } else {
+        UAVOBJECTUTIL_QXTLOG_DEBUG(QString("Batch save request failed, falling back to single saves"));
+        batchSupported = false;
+        finishBatch(true);
+    }
+}
+
+/**
+ * @brief Process progress reported by the board on a batch save request
+ * @param[in] The object just received.  Must be ObjectPersistenceBatch
+ */
+void UAVObjectUtilManager::objectPersistenceBatchUpdated(UAVObject *obj)
+{
+    Q_ASSERT(obj);
+    Q_ASSERT(obj->getObjID() == ObjectPersistenceBatch::OBJID);
+
+    if (saveState != AWAITING_COMPLETED) {
+        return;
+    }
+
+    ObjectPersistenceBatch::DataFields data = ((ObjectPersistenceBatch *)obj)->getData();
+
+    if (data.Operation != ObjectPersistenceBatch::OPERATION_INPROGRESS &&
+            data.Operation != ObjectPersistenceBatch::OPERATION_COMPLETED &&
+            data.Operation != ObjectPersistenceBatch::OPERATION_ERROR) {
+        // Our own request being echoed back
+        return;
+    }
+
+    // Make sure this is about the batch we sent
+    if (data.NumObjects != batch.length()) {
+        return;
+    }
+    for (int i = 0; i < batch.length(); i++) {
+        if (data.ObjectID[i] != batch.at(i)->getObjID()) {
+            return;
+        }
+    }
+
+    // The board is making progress, don't time out on it
+    failureTimer.start(2000);
+
+    for (int i = 0; i < batch.length(); i++) {
+        if (batchReported.at(i) || data.Result[i] == ObjectPersistenceBatch::RESULT_PENDING) {
+            continue;
+        }
+
+        batchReported[i] = true;
+        emit saveCompleted(data.ObjectID[i], data.Result[i] == ObjectPersistenceBatch::RESULT_SAVED);
+    }
+
+    if (data.Operation != ObjectPersistenceBatch::OPERATION_INPROGRESS) {
+        failureTimer.stop();
+        UAVOBJECTUTIL_QXTLOG_DEBUG(QString("[saveObjectToFlash] Batch save finished"));
+        finishBatch(false);
+    }
+}
+
+/**
+ * @brief UAVObjectUtilManager::finishBatch Remove the current batch from the queue
+ * @param allowRetry if true, objects without a result stay in the queue to be
+ * saved again, otherwise they are reported as failed
+ */
+void UAVObjectUtilManager::finishBatch(bool allowRetry)
+{
+    failureTimer.stop();
+
+    ObjectPersistenceBatch *objectPersistenceBatch = ObjectPersistenceBatch::GetInstance(getObjectManager());
+    Q_ASSERT(objectPersistenceBatch);
+    objectPersistenceBatch->disconnect(this);
+
+    QList<UAVObject *> failed;
+    for (int i = 0; i < batch.length(); i++) {
+        UAVObject *obj = batch.at(i);
+
+        if (batchReported.at(i) || !allowRetry) {
+            queue.removeOne(obj);
+        }
+
+        if (!batchReported.at(i) && !allowRetry) {
+            failed.append(obj);
+        }
+    }
+
+    batch.clear();
+    batchReported.clear();
+    saveState = IDLE;
+
+    foreach (UAVObject *obj, failed) {
+        emit saveCompleted(obj->getObjID(), false);
+    }
+
+    saveNextObject();
+}
+
+
 /**
  * @brief UAVObjectUtilManager::readAllNonSettingsMetadata Convenience function for calling
  * readMetadata
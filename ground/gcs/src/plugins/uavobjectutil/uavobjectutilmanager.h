@@ -36,6 +36,7 @@
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "objectpersistence.h"
+#include "objectpersistencebatch.h"
 #include "devicedescriptorstruct.h"
 #include <coreplugin/iboardtype.h>
 #include <QtGlobal>
@@ -70,6 +71,7 @@ public:
     static bool descriptionToStructure(QByteArray desc,deviceDescriptorStruct & struc);
     UAVObjectManager* getObjectManager();
     void saveObjectToFlash(UAVObject *obj);
+    void saveObjectsToFlash(const QList<UAVObject *> &objs);
     QMap<QString, UAVObject::Metadata> readMetadata(metadataSetEnum metadataReadType);
     QMap<QString, UAVObject::Metadata> readAllNonSettingsMetadata();
     bool setMetadata(QMap<QString, UAVObject::Metadata>, metadataSetEnum metadataUpdateType);
@@ -87,16 +89,25 @@ signals:
 private:
     QQueue<UAVObject *> queue;
     enum {IDLE, AWAITING_ACK, AWAITING_COMPLETED} saveState;
-    void saveNextObject();
+    bool saveScheduled;
+    void scheduleSave();
+    void saveNextBatch();
+    void finishBatch(bool allowRetry);
+    QList<UAVObject *> batch;
+    QVector<bool> batchReported;
+    bool batchSupported;
     QTimer failureTimer;
     ExtensionSystem::PluginManager *pm;
     UAVObjectManager *obm;
     QMap<UAVDataObject*, UAVObject::Metadata> metadataSendlist;
     bool metadataSendSuccess;
 private slots:
+    void saveNextObject();
     void objectPersistenceTransactionCompleted(UAVObject* obj, bool success);
     void objectPersistenceUpdated(UAVObject * obj);
     void objectPersistenceOperationFailed();
+    void objectPersistenceBatchTransactionCompleted(UAVObject* obj, bool success);
+    void objectPersistenceBatchUpdated(UAVObject * obj);
     void metadataTransactionCompleted(UAVObject*, bool);
 };
 
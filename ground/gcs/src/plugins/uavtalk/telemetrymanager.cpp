@@ -31,6 +31,8 @@
 #include <coreplugin/icore.h>
 
 TelemetryManager::TelemetryManager() :
+    utalk(NULL),
+    tap(NULL),
     autopilotConnected(false)
 {
     // Get UAVObjectManager instance
@@ -63,6 +65,7 @@ void TelemetryManager::start(QIODevice *dev)
 void TelemetryManager::onStart()
 {
     utalk = new UAVTalk(device, objMngr);
+    utalk->setTap(tap);
     telemetry = new Telemetry(utalk, objMngr);
     telemetryMon = new TelemetryMonitor(objMngr, telemetry, sessions);
     connect(telemetryMon, SIGNAL(connected()), this, SLOT(onConnect()));
@@ -70,6 +73,17 @@ void TelemetryManager::onStart()
 }
 
 
+/**
+ * Install a tap on the received stream of the current and any later link,
+ * or NULL to remove it.
+ */
+void TelemetryManager::setTap(UAVTalkTap *tap)
+{
+    this->tap = tap;
+    if (utalk)
+        utalk->setTap(tap);
+}
+
 void TelemetryManager::stop()
 {
     emit myStop();
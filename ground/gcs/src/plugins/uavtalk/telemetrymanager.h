@@ -50,6 +50,7 @@ public:
     void start(QIODevice *dev);
     void stop();
     bool isConnected();
+    void setTap(UAVTalkTap *tap);
 
 signals:
     void connected();
@@ -66,6 +67,7 @@ private slots:
 private:
     UAVObjectManager* objMngr;
     UAVTalk* utalk;
+    UAVTalkTap* tap;
     Telemetry* telemetry;
     TelemetryMonitor* telemetryMon;
     QIODevice *device;
@@ -74,6 +74,7 @@ const quint8 UAVTalk::crc_table[256] = {
 UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
 {
     io = iodev;
+    tap = NULL;
 
     this->objMngr = objMngr;
 
@@ -127,17 +128,29 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
+    char buf[1024];
+    qint64 len;
 
     if (io && io->isReadable()) {
-        while (io->bytesAvailable() > 0)
+        while (io && (len = io->read(buf, sizeof(buf))) > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            if (tap)
+                tap->received(buf, len);
+
+            for (qint64 i = 0; i < len; i++)
+                processInputByte(buf[i]);
         }
     }
 }
 
+/**
+ * Install a tap that sees the raw received stream, or NULL to remove it.
+ */
+void UAVTalk::setTap(UAVTalkTap *tap)
+{
+    this->tap = tap;
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -44,6 +44,17 @@
 #include "uavtalk_global.h"
 #include <QtNetwork/QUdpSocket>
 
+/**
+ * Receives a copy of every byte read from the link, before it is parsed.
+ * Called on the thread the UAVTalk instance lives in, so it must not block.
+ */
+class UAVTALK_EXPORT UAVTalkTap
+{
+public:
+    virtual ~UAVTalkTap() {}
+    virtual void received(const char *data, qint64 size) = 0;
+};
+
 class UAVTALK_EXPORT UAVTalk: public QObject
 {
     Q_OBJECT
@@ -66,6 +77,7 @@ public:
     bool sendObjectRequest(UAVObject* obj, bool allInstances);
     ComStats getStats();
     void resetStats();
+    void setTap(UAVTalkTap *tap);
 
     bool processInputByte(quint8 rxbyte);
 
@@ -110,6 +122,7 @@ protected:
 
     // Variables
     QPointer<QIODevice> io;
+    UAVTalkTap *tap;
     UAVObjectManager* objMngr;
     quint8 rxBuffer[MAX_PACKET_LENGTH];
     quint8 txBuffer[MAX_PACKET_LENGTH];
@@ -63,6 +63,9 @@ enum bl_commands {
     BL_MSG_STATUS_REQ,
     BL_MSG_STATUS_REP,
     BL_MSG_WIPE_PARTITION,
+    BL_MSG_SECTOR_CRC_REQ,
+    BL_MSG_SECTOR_CRC_REP,
+    BL_MSG_WRITE_RANGE_START,
 
     BL_MSG_WRITE_START = 0x27, // f1 bl masks with 0b11111 so this looks like BL_MSG_WRITE_CONT there
                                // the 6th bit ends up being start flag
@@ -135,6 +138,8 @@ struct msg_capabilities_rep_specific {
 #define BL_CAP_EXTENSION_MAGIC 0x3456
 	uint16_t cap_extension_magic;
 	uint32_t partition_sizes[10];
+#define BL_CAP_FLAG_SECTOR_CRC 0x01	/* answers SECTOR_CRC_REQ */
+	uint8_t cap_flags;
 #endif	/* BL_INCLUDE_CAP_EXTENSIONS */
 };
 
@@ -187,6 +192,34 @@ struct msg_wipe_partition {
 	uint8_t label;
 };
 
+/* Extensions for delta uploads */
+PACK(struct msg_sector_crc_req {
+	uint8_t label;
+	uint16_t first_sector;
+});
+
+struct msg_sector_crc {
+	uint32_t length; /* clipped to the writable size */
+	uint32_t crc;
+};
+
+#define SECTOR_CRCS_PER_PACKET 6
+PACK(struct msg_sector_crc_rep {
+	uint8_t label;
+	uint16_t first_sector;
+	uint16_t num_sectors; /* in the whole partition */
+	uint8_t sectors_in_packet;
+	uint32_t first_sector_offset;
+	struct msg_sector_crc sectors[SECTOR_CRCS_PER_PACKET];
+});
+
+PACK(struct msg_write_range_start {
+	uint8_t label;
+	uint32_t offset; /* must be sector aligned */
+	uint32_t length; /* must be a multiple of 4 */
+	uint32_t expected_crc;
+});
+
 PACK(union msg_contents {
     struct msg_capabilities_req cap_req;
     struct msg_capabilities_rep_all cap_rep_all;
@@ -201,6 +234,9 @@ PACK(union msg_contents {
     struct msg_status_req status_req;
     struct msg_status_rep status_rep;
     struct msg_wipe_partition wipe_partition;
+    struct msg_sector_crc_req sector_crc_req;
+    struct msg_sector_crc_rep sector_crc_rep;
+    struct msg_write_range_start write_range_start;
     uint8_t pad[62];
 });
 
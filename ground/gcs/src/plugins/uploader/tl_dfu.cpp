@@ -45,7 +45,7 @@
 
 using namespace tl_dfu;
 
-DFUObject::DFUObject() : m_hidHandle(NULL)
+DFUObject::DFUObject() : m_hidHandle(NULL), m_sectorCRCs(false)
 {
     qRegisterMetaType<tl_dfu::Status>("TL_DFU::Status");
 }
@@ -107,9 +107,10 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, dfu_partition_label co
   board is ready to accept data following a StartUpload command, and it is erased.
   @param numberOfBytes number of bytes to transfer
   @param data data to transfer
+  @param offset offset of the first byte to transfer within data
   @returns result of the requested operation
   */
-bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray  & data)
+bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray  & data, int offset)
 {
     messagePackets msg = CalculatePadding(numberOfBytes);
     TL_DFU_QXTLOG_DEBUG(QString("Start Uploading:%0 56 byte packets").arg(msg.numberOfPackets));
@@ -124,12 +125,12 @@ bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray  & data)
         if(laspercentage != (int)percentage)
             emit operationProgress("", percentage);
         laspercentage=(int)percentage;
-        if(packetcount == msg.numberOfPackets)
+        if(packetcount == msg.numberOfPackets - 1)
             packetsize = msg.lastPacketCount;
         else
             packetsize = 14;
         message.v.xfer_cont.current_packet_number = ntohl(packetcount);
-        char *pointer = data.data();
+        char *pointer = data.data() + offset;
         pointer = pointer + 4 * 14 * packetcount;
         CopyWords(pointer, (char*)message.v.xfer_cont.data, packetsize *4);
         int result = SendData(message);
@@ -139,6 +140,84 @@ bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray  & data)
     return true;
 }
 
+/**
+  Asks the bootloader for the CRC of every sector of a partition, so that
+  only the sectors that changed need to be erased and written.
+  Only bootloaders that set BL_CAP_FLAG_SECTOR_CRC answer, so check
+  findCapabilities first instead of waiting for a reply that won't come.
+  @param label partition to query
+  @param sectors filled with the offset, writable length and CRC of each sector
+  @returns true if the bootloader supports delta uploads
+  */
+bool DFUObject::RequestSectorCRCs(dfu_partition_label label, QVector<sectorCRC> &sectors)
+{
+    sectors.clear();
+
+    quint16 numSectors = 1;
+
+    while (sectors.size() < numSectors) {
+        bl_messages message;
+        memset(&message, 0, sizeof(message));
+        message.flags_command = BL_MSG_SECTOR_CRC_REQ;
+        message.v.sector_crc_req.label = label;
+        message.v.sector_crc_req.first_sector = ntohs((quint16) sectors.size());
+
+        if (SendData(message) < 1)
+            return false;
+
+        if (ReceiveData(message, 1000) < 1)
+            return false;
+
+        if ((message.flags_command != BL_MSG_SECTOR_CRC_REP) ||
+                (message.v.sector_crc_rep.label != label) ||
+                (ntohs(message.v.sector_crc_rep.first_sector) != sectors.size()))
+            return false;
+
+        numSectors = ntohs(message.v.sector_crc_rep.num_sectors);
+
+        int count = message.v.sector_crc_rep.sectors_in_packet;
+        if ((count == 0) || (count > SECTOR_CRCS_PER_PACKET))
+            return false;
+
+        quint32 offset = ntohl(message.v.sector_crc_rep.first_sector_offset);
+        for (int i = 0; i < count; i++) {
+            sectorCRC sector;
+            sector.offset = offset;
+            sector.length = ntohl(message.v.sector_crc_rep.sectors[i].length);
+            sector.crc = ntohl(message.v.sector_crc_rep.sectors[i].crc);
+            sectors.append(sector);
+
+            offset += sector.length;
+        }
+    }
+
+    TL_DFU_QXTLOG_DEBUG(QString("Got CRCs of %0 sectors").arg(sectors.size()));
+    return true;
+}
+
+/**
+  Tells the board to erase the sectors covering a range of a partition and
+  get ready to write it.  The data follows with UploadData, same as a
+  full upload.
+  @param label partition to write to
+  @param offset offset of the range, must be at the start of a sector
+  @param length number of bytes in the range
+  @param crc crc value of the range
+  @returns result of the requested operation
+  */
+bool DFUObject::StartRangeUpload(dfu_partition_label label, quint32 offset, quint32 length, quint32 crc)
+{
+    bl_messages message;
+    memset(&message, 0, sizeof(message));
+    message.flags_command = BL_MSG_WRITE_RANGE_START;
+    message.v.write_range_start.label = label;
+    message.v.write_range_start.offset = ntohl(offset);
+    message.v.write_range_start.length = ntohl(length);
+    message.v.write_range_start.expected_crc = ntohl(crc);
+
+    return (SendData(message) > 0);
+}
+
 /**
   Downloads the description string for the current device.
   You have to call enterDFU before calling this function.
@@ -394,7 +473,9 @@ device DFUObject::findCapabilities()
 {
     device currentDevice;
     TL_DFU_QXTLOG_DEBUG("FINDDEVICES BEGIN");
+    m_sectorCRCs = false;
     bl_messages message;
+    memset(&message, 0, sizeof(message));
     message.flags_command = BL_MSG_CAP_REQ;
     message.v.cap_req.device_number = 1;
     TL_DFU_QXTLOG_DEBUG(QString("FINDDEVICES SENDING CAPABILITIES REQUEST BUFFER_SIZE:%0").arg(BUF_LEN));
@@ -414,6 +495,10 @@ device DFUObject::findCapabilities()
         currentDevice.CapExt = true;
     else
         currentDevice.CapExt = false;
+    // Older bootloaders leave the flags zero, and never answer the probe
+    currentDevice.SectorCRCs = currentDevice.CapExt &&
+            (message.v.cap_rep_specific.cap_flags & BL_CAP_FLAG_SECTOR_CRC);
+    m_sectorCRCs = currentDevice.SectorCRCs;
     currentDevice.SizeOfDesc = message.v.cap_rep_specific.desc_size;
     currentDevice.ID = ntohs(message.v.cap_rep_specific.device_id);
     message.v.cap_rep_specific.device_number = 1;
@@ -574,6 +659,13 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
         return tl_dfu::abort;
     }
 
+    // Descriptors are too small to be worth it, everything else is only
+    // written where it differs from what is already on the board
+    QVector<sectorCRC> sectors;
+    if (m_sectorCRCs && (partition != DFU_PARTITION_DESC) &&
+            RequestSectorCRCs(partition, sectors))
+        return UploadPartitionDelta(sourceArray, partition, sectors);
+
     quint32 crc = DFUObject::CRCFromQBArray(sourceArray, threadJob.partition_size);
     TL_DFU_QXTLOG_DEBUG( QString("NEW FIRMWARE CRC=%0").arg(crc));
 
@@ -633,6 +725,103 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     return ret.status;
 }
 
+/**
+  Synchronously uploads a partition to the board, erasing and writing only
+  the sectors whose contents differ from the new image
+  @param sourceArray array containing the data to upload, padded to 4 bytes
+  @param partition destination partition
+  @param sectors current sector CRCs, from RequestSectorCRCs
+  @returns status of the board after upload
+  */
+tl_dfu::Status DFUObject::UploadPartitionDelta(QByteArray &sourceArray, dfu_partition_label partition, const QVector<sectorCRC> &sectors)
+{
+    DFUObject::statusReport ret;
+
+    const sectorCRC &last = sectors.last();
+    quint32 writableSize = last.offset + last.length;
+
+    if (writableSize < (quint32)sourceArray.length())
+    {
+        TL_DFU_QXTLOG_DEBUG("ERROR array too big for device");
+        return tl_dfu::abort;
+    }
+
+    // The rest of the partition ends up erased, like after a full upload
+    QByteArray image(sourceArray);
+    image.append(QByteArray(writableSize - image.length(), 255));
+
+    QVector<bool> changed(sectors.size());
+    int numChanged = 0;
+
+    for (int i = 0; i < sectors.size(); i++) {
+        quint32 crc = CRCFromQBArray(image.mid(sectors[i].offset, sectors[i].length), sectors[i].length);
+
+        changed[i] = (crc != sectors[i].crc);
+
+        // The firmware descriptor lives in the last sector and is written
+        // without erasing after the firmware, so that sector must be erased
+        if ((partition == DFU_PARTITION_FW) && (i == sectors.size() - 1))
+            changed[i] = true;
+
+        if (changed[i])
+            numChanged++;
+    }
+
+    TL_DFU_QXTLOG_DEBUG(QString("Delta upload: %0 of %1 sectors changed").arg(numChanged).arg(sectors.size()));
+
+    emit operationProgress(QString(tr("Uploading %0 partition...")).arg(partitionStringFromLabel(partition)), -1);
+
+    for (int i = 0; i < sectors.size(); ) {
+        if (!changed[i]) {
+            i++;
+            continue;
+        }
+
+        // Merge runs of changed sectors into a single write
+        int first = i;
+        quint32 length = 0;
+        while ((i < sectors.size()) && changed[i]) {
+            length += sectors[i].length;
+            i++;
+        }
+
+        quint32 offset = sectors[first].offset;
+        quint32 crc = CRCFromQBArray(image.mid(offset, length), length);
+
+        if (!StartRangeUpload(partition, offset, length, crc)) {
+            ret = StatusRequest();
+            qDebug() << QString("[tl_dfu] StartRangeUpload failed, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+
+        // Doesn't answer until the erase is over
+        ret = StatusRequest();
+        if (ret.status != tl_dfu::uploading) {
+            qDebug() << QString("[tl_dfu] Couldn't start range upload at 0x%1, status: %2")
+                        .arg(offset, 8, 16, QChar('0')).arg(StatusToString(ret.status));
+            return ret.status;
+        }
+
+        if (!UploadData(length, image, offset) || !EndOperation()) {
+            ret = StatusRequest();
+            qDebug() << QString("[tl_dfu] Range upload failed, status: %1, additional: 0x%2")
+                        .arg(StatusToString(ret.status)).arg(ret.additional, 8, 16, QChar('0'));
+            return ret.status;
+        }
+
+        ret = StatusRequest();
+        if (ret.status != tl_dfu::Last_operation_Success) {
+            qDebug() << QString("[tl_dfu] Range upload at 0x%1 failed, status: %2")
+                        .arg(offset, 8, 16, QChar('0')).arg(StatusToString(ret.status));
+            return ret.status;
+        }
+    }
+
+    TL_DFU_QXTLOG_DEBUG("Delta upload succeeded");
+    return tl_dfu::Last_operation_Success;
+}
+
 /**
   Copies one array into another inverting endianess
   @param source source array
@@ -73,6 +73,7 @@ struct device
     QVector<quint32> PartitionSizes;
     int HW_Rev;
     bool CapExt;
+    bool SectorCRCs;
 };
 
 class DFUObject : public QThread
@@ -91,6 +92,12 @@ class DFUObject : public QThread
         tl_dfu::Status status;
     } statusReport;
 
+    typedef struct sectorCRC {
+        quint32 offset;
+        quint32 length;
+        quint32 crc;
+    } sectorCRC;
+
 public:
     static quint32 CRCFromQBArray(QByteArray array, quint32 Size);
     DFUObject();
@@ -120,6 +127,7 @@ signals:
 private:
     bool DownloadPartition(QByteArray *fw, qint32 const & numberOfBytes, const dfu_partition_label &partition);
     tl_dfu::Status UploadPartition(QByteArray &sfile, dfu_partition_label partition);
+    tl_dfu::Status UploadPartitionDelta(QByteArray &sfile, dfu_partition_label partition, const QVector<sectorCRC> &sectors);
 
     // Helper functions:
     QString StatusToString(tl_dfu::Status  const & status);
@@ -138,8 +146,13 @@ private:
     int ReceiveData(bl_messages &data, int timeoutMS = 10000);
     hid_device *m_hidHandle;
 
+    // Whether the last board queried answers RequestSectorCRCs
+    bool m_sectorCRCs;
+
     bool StartUpload(qint32  const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
-    bool UploadData(qint32 const &numberOfPackets, QByteArray  &data);
+    bool UploadData(qint32 const &numberOfPackets, QByteArray  &data, int offset = 0);
+    bool RequestSectorCRCs(dfu_partition_label label, QVector<sectorCRC> &sectors);
+    bool StartRangeUpload(dfu_partition_label label, quint32 offset, quint32 length, quint32 crc);
 
     typedef struct ThreadJobStruc
     {
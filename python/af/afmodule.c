@@ -0,0 +1,224 @@
+/**
+ ******************************************************************************
+ * @file       afmodule.c
+ * @author     dRonin, http://dRonin.org/, Copyright (C) 2016
+ * @brief      Python wrapper around the autotune identification filter, so
+ *             logged flights can be replayed through the flight code.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <Python.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <af_filter.h>
+
+#if PY_MAJOR_VERSION < 3
+#error "The af module needs Python 3"
+#endif
+
+/* Floats per replayed sample: gyro[3], actuator[3], throttle, dT */
+#define AF_SAMPLE_LEN 8
+
+/* Same noise estimator time constant as the flight module */
+#define NOISE_ALPHA 0.9997f
+
+/**
+ * Override filter parameters from a python dict.
+ * @param[in] dict mapping of af_params member names to numbers, or NULL
+ * @param[out] params parameters to update
+ * @return true if successful, false with a python exception set if not
+ */
+static bool parse_params(PyObject *dict, struct af_params *params)
+{
+	static const struct {
+		const char *name;
+		size_t offset;
+	} fields[] = {
+		{ "q_w", offsetof(struct af_params, q_w) },
+		{ "q_ud", offsetof(struct af_params, q_ud) },
+		{ "q_B", offsetof(struct af_params, q_B) },
+		{ "q_tau", offsetof(struct af_params, q_tau) },
+		{ "q_bias", offsetof(struct af_params, q_bias) },
+		{ "s_a", offsetof(struct af_params, s_a) },
+		{ "tau_init", offsetof(struct af_params, tau_init) },
+	};
+
+	*params = af_default_params;
+
+	if (dict == NULL || dict == Py_None)
+		return true;
+
+	if (!PyDict_Check(dict)) {
+		PyErr_SetString(PyExc_TypeError, "params must be a dict");
+		return false;
+	}
+
+	PyObject *key, *value;
+	Py_ssize_t pos = 0;
+
+	while (PyDict_Next(dict, &pos, &key, &value)) {
+		PyObject *key_bytes = PyUnicode_AsUTF8String(key);
+
+		if (key_bytes == NULL)
+			return false;
+
+		const char *name = PyBytes_AsString(key_bytes);
+		bool found = false;
+
+		for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+			if (strcmp(name, fields[i].name))
+				continue;
+
+			double d = PyFloat_AsDouble(value);
+
+			if (d == -1.0 && PyErr_Occurred()) {
+				Py_DECREF(key_bytes);
+				return false;
+			}
+
+			*(float *)((char *)params + fields[i].offset) = d;
+			found = true;
+		}
+
+		if (!found)
+			PyErr_Format(PyExc_KeyError, "unknown parameter %s",
+					name);
+
+		Py_DECREF(key_bytes);
+
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * replay(samples, params=None)
+ *
+ * Runs af_init and then af_predict over every sample, exactly as the
+ * autotune module does in flight.  samples is any contiguous buffer of
+ * native floats, AF_SAMPLE_LEN per measurement.  Returns a dict with the
+ * identified parameters and their variances.
+ */
+static PyObject *replay(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *kwlist[] = { "samples", "params", NULL };
+
+	Py_buffer buf;
+	PyObject *param_dict = NULL;
+	struct af_params params;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|O", kwlist,
+				&buf, &param_dict))
+		return NULL;
+
+	if (!parse_params(param_dict, &params)) {
+		PyBuffer_Release(&buf);
+		return NULL;
+	}
+
+	if (buf.len % (sizeof(float) * AF_SAMPLE_LEN)) {
+		PyBuffer_Release(&buf);
+		PyErr_SetString(PyExc_ValueError,
+				"sample buffer is not a whole number of samples");
+		return NULL;
+	}
+
+	const float *samples = buf.buf;
+	Py_ssize_t num_samples = buf.len / (sizeof(float) * AF_SAMPLE_LEN);
+
+	float X[AF_NUMX];
+	float P[AF_NUMP];
+	float noise[3] = { 0 };
+	double throttle_sum = 0;
+
+	Py_BEGIN_ALLOW_THREADS
+
+	af_init(X, P, &params);
+
+	for (Py_ssize_t n = 0; n < num_samples; n++) {
+		const float *s = samples + n * AF_SAMPLE_LEN;
+		struct at_measurement meas = {
+			.y = { s[0], s[1], s[2] },
+			.u = { s[3], s[4], s[5] },
+		};
+
+		af_predict(X, P, &params, &meas, s[7], s[6]);
+
+		for (int i = 0; i < 3; i++) {
+			noise[i] = NOISE_ALPHA * noise[i] + (1 - NOISE_ALPHA) *
+				(meas.y[i] - X[i]) * (meas.y[i] - X[i]);
+		}
+
+		throttle_sum += s[6];
+	}
+
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&buf);
+
+	return Py_BuildValue(
+		"{s:(fff),s:f,s:(fff),s:(fff),s:(fff),s:f,s:(fff),s:n,s:d}",
+		"beta", X[6], X[7], X[8],
+		"tau", X[9],
+		"bias", X[10], X[11], X[12],
+		"noise", noise[0], noise[1], noise[2],
+		"beta_var", P[11], P[14], P[17],
+		"tau_var", P[27],
+		"bias_var", P[32], P[37], P[42],
+		"predicts", num_samples,
+		"hover_throttle", num_samples ? throttle_sum / num_samples : 0.0);
+}
+
+/**
+ * defaults()
+ *
+ * Returns the filter parameters used in flight as a dict.
+ */
+static PyObject *defaults(PyObject *self, PyObject *args)
+{
+	const struct af_params *p = &af_default_params;
+
+	return Py_BuildValue("{s:f,s:f,s:f,s:f,s:f,s:f,s:f}",
+		"q_w", p->q_w, "q_ud", p->q_ud, "q_B", p->q_B,
+		"q_tau", p->q_tau, "q_bias", p->q_bias, "s_a", p->s_a,
+		"tau_init", p->tau_init);
+}
+
+static PyMethodDef AfMethods[] =
+{
+	{"replay", (PyCFunction) replay, METH_VARARGS | METH_KEYWORDS,
+		"Replay samples through the autotune filter."},
+	{"defaults", defaults, METH_NOARGS,
+		"Filter parameters used in flight."},
+	{NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef afmodule = {
+	PyModuleDef_HEAD_INIT, "af", NULL, -1, AfMethods
+};
+
+PyMODINIT_FUNC
+PyInit_af(void)
+{
+	return PyModule_Create(&afmodule);
+}
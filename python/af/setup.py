@@ -0,0 +1,11 @@
+from distutils.core import setup, Extension
+
+module1 = Extension('af',
+	sources = ['afmodule.c', '../../flight/Modules/Autotune/af_filter.c'],
+	            include_dirs=['../../flight/Modules/Autotune/inc','../../flight/Libraries/math'],
+                    extra_compile_args=['-std=gnu99'],)
+
+setup (name = 'PackageName',
+        version = '1.0',
+        description = 'Autotune filter C module',
+        ext_modules = [module1])
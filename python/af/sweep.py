@@ -0,0 +1,237 @@
+#!/usr/bin/env python
+
+"""
+Replay logged autotune flights through the flight autotune filter, optionally
+sweeping filter settings in parallel across all cores.
+
+Copyright (C) 2016 dRonin, http://dronin.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+"""
+
+import array, itertools, math, multiprocessing, os, sys
+
+import af
+
+# Same clamp as the flight module: never integrate more than 10 samples
+MAX_DT_SAMPLES = 10
+
+class _Segment(object):
+    """ Samples of one tune, plus what is needed to reconstruct dT """
+
+    def __init__(self, time):
+        self.samples = array.array('f')
+        self.cycles = []
+        self.start_time = self.end_time = time
+
+    def append(self, gyro, actuator):
+        self.cycles.append(actuator.SystemIdentCycle)
+        self.end_time = actuator.time
+
+        self.samples.extend([gyro.x, gyro.y, gyro.z, actuator.Roll,
+            actuator.Pitch, actuator.Yaw, actuator.Thrust, 0.0])
+
+    def finish(self):
+        """ Fills in dT the way the flight module does: the number of
+        stabilization cycles between points times the nominal period.  Log
+        timestamps only have millisecond resolution, so the nominal period
+        comes from the whole segment. """
+
+        # The cycle counter wraps at the number of wiggle points, which
+        # the log doesn't record; the largest value seen is close enough.
+        wiggle_points = max(self.cycles) + 1
+
+        self.steps = [1]
+
+        for prev, cycle in zip(self.cycles, self.cycles[1:]):
+            if cycle >= prev:
+                self.steps.append(cycle - prev)
+            else:
+                self.steps.append(cycle + wiggle_points - prev)
+
+        total = sum(self.steps)
+
+        if total:
+            nominal = (self.end_time - self.start_time) / total
+        else:
+            nominal = 0.001
+
+        for i, steps in enumerate(self.steps):
+            if steps == 0 or steps > MAX_DT_SAMPLES:
+                steps = MAX_DT_SAMPLES
+
+            self.samples[i * 8 + 7] = steps * nominal
+
+        return self.samples
+
+def load_log(f_name, githash=None):
+    """ Extracts the autotune segments of a dRonin log.
+
+    Every ActuatorDesired update with a valid SystemIdentCycle is paired
+    with the most recent Gyros update, which is what the flight module
+    does.  Returns a list of segments, one per tune, each an array of
+    floats in the layout af.replay() expects.
+    """
+
+    try:
+        import dronin
+    except ImportError:
+        sys.path.insert(0, os.path.join(os.path.dirname(
+            os.path.abspath(__file__)), '..'))
+        import dronin
+
+    from dronin import telemetry
+
+    with open(f_name, 'rb') as f:
+        # Autodetect GCS-style timestamps, like the command line tools do
+        if githash is None:
+            t = telemetry.FileTelemetry(f, parse_header=True,
+                    gcs_timestamps=None, name=f_name)
+        else:
+            t = telemetry.FileTelemetry(f, parse_header=False,
+                    gcs_timestamps=None, name=f_name, githash=githash)
+
+        segments = []
+        cur = None
+        gyro = None
+
+        for obj in t:
+            if obj.name == 'UAVO_Gyros':
+                gyro = obj
+                continue
+
+            if obj.name != 'UAVO_ActuatorDesired' or gyro is None:
+                continue
+
+            if obj.SystemIdentCycle == 0xffff:
+                # End of actuation
+                if cur is not None:
+                    segments.append(cur.finish())
+                cur = None
+                continue
+
+            if cur is None:
+                cur = _Segment(obj.time)
+
+            cur.append(gyro, obj)
+
+        if cur is not None:
+            segments.append(cur.finish())
+
+    return segments
+
+def _replay_one(job):
+    samples, params = job
+
+    return params, af.replay(samples, params)
+
+def sweep(samples, variants, jobs=None):
+    """ Replays samples once per parameter variant.
+
+    samples: bytes in the af.replay() layout
+    variants: list of dicts of filter parameters to override
+    jobs: number of worker processes, defaults to the number of cores
+
+    Returns a list of (params, result) tuples in the order of variants.
+    """
+
+    work = [ (samples, v) for v in variants ]
+
+    if jobs == 1 or len(work) == 1:
+        return [ _replay_one(w) for w in work ]
+
+    pool = multiprocessing.Pool(processes=jobs)
+
+    try:
+        return pool.map(_replay_one, work)
+    finally:
+        pool.close()
+        pool.join()
+
+def make_variants(grid):
+    """ Cartesian product of {param: [values]} as a list of dicts """
+
+    names = sorted(grid.keys())
+
+    return [ dict(zip(names, vals))
+            for vals in itertools.product(*[grid[n] for n in names]) ]
+
+def confidence(result):
+    """ A single figure of merit: worst relative standard deviation of the
+    identified roll/pitch gains and the time constant.  Smaller is better. """
+
+    rel = [ math.sqrt(max(v, 0.0)) / abs(b)
+            for b, v in zip(result['beta'][0:2], result['beta_var'][0:2]) ]
+
+    rel.append(math.sqrt(max(result['tau_var'], 0.0)) / abs(result['tau']))
+
+    return max(rel)
+
+def format_result(params, result):
+    desc = ' '.join('%s=%g' % (k, params[k]) for k in sorted(params))
+
+    beta = ' '.join('%.2f+-%.2f' % (b, math.sqrt(max(v, 0.0)))
+            for b, v in zip(result['beta'], result['beta_var']))
+
+    return '%-40s beta %s  tau %.1fms  noise %s  conf %.4f' % (
+            desc or '(defaults)', beta,
+            math.exp(result['tau']) * 1000,
+            ' '.join('%.1f' % n for n in result['noise']),
+            confidence(result))
+
+def main(argv):
+    import argparse
+
+    parser = argparse.ArgumentParser(description=
+            "Replay autotune flights from a log through the flight filter")
+
+    parser.add_argument("-g", "--githash",
+            help = "override githash for UAVO XML definitions")
+    parser.add_argument("-j", "--jobs", type=int, default=None,
+            help = "worker processes (default: all cores)")
+    parser.add_argument("-s", "--segment", type=int, default=None,
+            help = "only replay this tune from the log (default: all)")
+
+    defaults = af.defaults()
+
+    for name in sorted(defaults):
+        parser.add_argument("--" + name, default=None,
+                help = "comma separated values to sweep (flight: %g)" %
+                    defaults[name])
+
+    parser.add_argument("log", help = "dRonin log file")
+
+    args = parser.parse_args(argv)
+
+    grid = {}
+
+    for name in defaults:
+        vals = getattr(args, name)
+        if vals is not None:
+            grid[name] = [ float(v) for v in vals.split(',') ]
+
+    variants = make_variants(grid)
+
+    segments = load_log(args.log, args.githash)
+
+    if not segments:
+        print("No autotune data found in %s" % args.log)
+        return 1
+
+    for idx, seg in enumerate(segments):
+        if args.segment is not None and idx != args.segment:
+            continue
+
+        print("Tune %d: %d samples, %d variants" % (idx, len(seg) // 8,
+                len(variants)))
+
+        results = sweep(seg.tobytes(), variants, args.jobs)
+
+        results.sort(key=lambda pr: confidence(pr[1]))
+
+        for params, result in results:
+            print('  ' + format_result(params, result))
+
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,69 @@
+import array, math, unittest
+
+import af
+import sweep
+
+def simulate(beta, tau, seconds=20.0, dt=0.001, throttle=0.5):
+    """ Generates samples from the plant model the filter assumes, driven
+    by the same kind of square wave the stabilization module uses. """
+
+    samples = array.array('f')
+    w = [0.0, 0.0, 0.0]
+    torque = [0.0, 0.0, 0.0]
+
+    for n in range(int(seconds / dt)):
+        phase = (n // 50) % 4
+        u_in = [0.0, 0.0, 0.0]
+        u_in[phase % 3] = 0.1 if phase < 2 else -0.1
+
+        for i in range(3):
+            torque[i] += dt * (4 * throttle * u_in[i] - torque[i]) / math.exp(tau)
+            w[i] += dt * math.exp(beta[i]) * torque[i]
+
+        samples.extend(w + u_in + [throttle, dt])
+
+    return samples.tobytes()
+
+class ReplayTest(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.beta = [9.0, 9.5, 7.5]
+        cls.tau = -3.5
+        cls.samples = simulate(cls.beta, cls.tau)
+
+    def test_defaults(self):
+        self.assertAlmostEqual(af.defaults()['s_a'], 150.0)
+        self.assertAlmostEqual(af.defaults()['tau_init'], -4.0)
+
+    def test_identifies_plant(self):
+        result = af.replay(self.samples)
+
+        self.assertEqual(result['predicts'], len(self.samples) // 32)
+
+        for got, want in zip(result['beta'], self.beta):
+            self.assertLess(abs(got - want), 0.5)
+
+        self.assertLess(abs(result['tau'] - self.tau), 0.3)
+        self.assertLess(sweep.confidence(result), 0.1)
+
+    def test_bad_params(self):
+        self.assertRaises(KeyError, af.replay, self.samples, {'bogus' : 1})
+        self.assertRaises(ValueError, af.replay, self.samples[:-4])
+
+    def test_parallel_sweep_matches_serial(self):
+        variants = sweep.make_variants({'s_a' : [50.0, 150.0, 500.0],
+            'tau_init' : [-4.5, -3.0]})
+
+        self.assertEqual(len(variants), 6)
+
+        serial = sweep.sweep(self.samples, variants, jobs=1)
+        parallel = sweep.sweep(self.samples, variants, jobs=3)
+
+        self.assertEqual(serial, parallel)
+
+        for (params, result), variant in zip(parallel, variants):
+            self.assertEqual(params, variant)
+
+if __name__ == '__main__':
+    unittest.main()
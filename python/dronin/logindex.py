@@ -0,0 +1,432 @@
+"""
+Columnar decoding of log files straight into numpy arrays.
+
+Copyright (C) 2016 dRonin, http://dronin.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+
+Going through telemetry.FileTelemetry builds a namedtuple for every object
+in the log, which takes minutes and gigabytes on a long flight.  LogIndex
+instead makes one framing pass over the whole log -- finding, checking and
+timestamping every packet with vectorized numpy operations -- and remembers
+where each object type's packets are.  An object type is only decoded when
+it's asked for, by gathering its payloads and viewing them with a packed
+dtype that matches the wire format.
+
+On well formed logs the arrays are identical to as_numpy_array().
+"""
+
+import bisect
+import mmap
+import os
+import re
+
+import numpy as np
+
+from . import uavtalk, uavo_collection, telemetry
+
+__all__ = [ "LogIndex" ]
+
+# Packet types with no object data
+NODATA_TYPES = (uavtalk.TYPE_OBJ_REQ, uavtalk.TYPE_ACK, uavtalk.TYPE_NACK)
+
+# struct format characters to little endian numpy types
+WIRE_TYPES = {
+    'b' : 'i1',
+    'h' : '<i2',
+    'i' : '<i4',
+    'B' : 'u1',
+    'H' : '<u2',
+    'I' : '<u4',
+    'f' : '<f4',
+    }
+
+# Bytes of log searched per numpy pass for sync bytes, bounding temporaries
+SCAN_CHUNK = 16 * 1024 * 1024
+
+# Payloads decoded per gather
+DECODE_CHUNK = 1024 * 1024
+
+CRC_TABLE = np.array(uavtalk.crc_table, dtype=np.uint8)
+
+# Two bytes at a time: the CRC after cs is CRC_TABLE2[(cs << 8) ^ word], for
+# the next two bytes as a big endian word
+CRC_TABLE2 = CRC_TABLE[CRC_TABLE[np.arange(65536) >> 8] ^
+        (np.arange(65536) & 0xff)].astype(np.uint16)
+
+def wire_dtype(cls):
+    """ The packed, little endian numpy layout of a UAVO's payload """
+    counts_codes = re.findall(r'(\d*)([a-zA-Z])', cls._packstruct.format)
+
+    first_field = 3 if cls._single else 4
+    names = cls._fields[first_field:]
+
+    fields = []
+
+    for name, (count, code) in zip(names, counts_codes):
+        count = int(count) if count else 1
+
+        if count == 1:
+            fields.append((name, WIRE_TYPES[code]))
+        else:
+            fields.append((name, WIRE_TYPES[code], (count,)))
+
+    return np.dtype(fields)
+
+def crc8(buf, pos, length):
+    """ Computes the UAVTalk CRC of length bytes at each of pos, at once """
+    cs = np.empty(len(pos), dtype=np.uint8)
+    cols = np.arange(length & ~1)
+
+    for lo in range(0, len(pos), DECODE_CHUNK):
+        hi = min(lo + DECODE_CHUNK, len(pos))
+
+        words = buf[pos[lo:hi, None] + cols].view('>u2')
+        c = np.zeros(hi - lo, dtype=np.uint16)
+
+        for i in range(words.shape[1]):
+            c = CRC_TABLE2[(c << 8) ^ words[:, i]]
+
+        if length & 1:
+            c = CRC_TABLE[c ^ buf[pos[lo:hi] + length - 1]]
+
+        cs[lo:hi] = c
+
+    return cs
+
+class LogIndex(object):
+    """ An index of every object in a log file, decoding one object type at
+    a time into numpy arrays. """
+
+    def __init__(self, file_name, parse_header=True, githash=None,
+            gcs_timestamps=None, uavo_defs=None):
+        """ Frames the whole log.  No objects are decoded yet.
+
+         - file_name: the log to read
+         - parse_header: whether the log starts with a header like the GCS
+           writes.  If so, the UAVO definitions come from its git hash.
+         - githash: the UAVO definitions to use when there's no header; if
+           unspecified, the ones in this source tree
+         - gcs_timestamps: whether each packet is preceded by a GCS log
+           timestamp.  If None, request autodetection
+         - uavo_defs: an already loaded UAVOCollection, overriding githash
+        """
+
+        self.f = open(file_name, 'rb')
+        self.mm = None
+
+        if parse_header:
+            githash = telemetry.read_log_header(self.f)
+
+        if uavo_defs is None:
+            uavo_defs = uavo_collection.UAVOCollection()
+
+            if githash:
+                uavo_defs.from_git_hash(githash)
+            else:
+                xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                        "shared", "uavobjectdefinition")
+                uavo_defs.from_uavo_xml_path(xml_path)
+
+        self.uavo_defs = uavo_defs
+        self.githash = githash
+
+        body_start = self.f.tell()
+
+        if self.f.read(7) == b'##\nDRLZ':
+            self.buf = self._inflate()
+            start = 0
+        elif os.fstat(self.f.fileno()).st_size > body_start:
+            self.mm = mmap.mmap(self.f.fileno(), 0, access=mmap.ACCESS_READ)
+            self.buf = np.frombuffer(self.mm, dtype=np.uint8)
+            start = body_start
+        else:
+            self.buf = np.zeros(0, dtype=np.uint8)
+            start = 0
+
+        if gcs_timestamps is None:
+            gcs_timestamps, start = self._detect_gcs_timestamps(start)
+
+        self.gcs_timestamps = gcs_timestamps
+
+        self._frame(start)
+
+        self.decoded = {}
+
+    def close(self):
+        """ Releases the log.  Arrays already returned remain valid. """
+        self.buf = None
+
+        if self.mm is not None:
+            self.mm.close()
+            self.mm = None
+
+        self.f.close()
+
+    def _inflate(self):
+        """ Reads an entire compressed log body into memory """
+        blocks = [ telemetry.read_compressed_block(self.f) ]
+
+        while self.f.read(4) == b'DRLZ':
+            blocks.append(telemetry.read_compressed_block(self.f))
+
+        return np.frombuffer(b''.join(blocks), dtype=np.uint8)
+
+    def _detect_gcs_timestamps(self, start):
+        """ The same guess process_stream makes, over the first packets.
+        Returns the guess and where the first packet is. """
+        buf = self.buf
+        hdr_len = uavtalk.logheader_fmt.size
+
+        limit = min(len(buf) - hdr_len - uavtalk.header_fmt.size, start + 65536)
+
+        for pos in range(start, limit):
+            timestamp, length = uavtalk.logheader_fmt.unpack_from(buf, pos)
+
+            if (length > 1000) or (timestamp > 100000000):
+                if buf[pos] == uavtalk.SYNC_VAL:
+                    return False, pos
+            elif buf[pos + hdr_len] == uavtalk.SYNC_VAL:
+                return True, pos + hdr_len
+
+        return False, start
+
+    def _candidates(self, start):
+        """ Positions of every sync byte followed by the right version """
+        buf = self.buf
+        end = len(buf) - uavtalk.header_fmt.size
+
+        found = []
+
+        for lo in range(start, max(end, start), SCAN_CHUNK):
+            hi = min(lo + SCAN_CHUNK, end)
+
+            pos = np.flatnonzero(buf[lo:hi] == uavtalk.SYNC_VAL) + lo
+            pos = pos[(buf[pos + 1] & uavtalk.TYPE_MASK) == uavtalk.TYPE_VER]
+
+            found.append(pos)
+
+        if not found:
+            return np.zeros(0, dtype=np.int64)
+
+        return np.concatenate(found).astype(np.int64)
+
+    def _frame(self, start):
+        """ Finds every packet process_stream would accept, and groups the
+        objects by type. """
+        buf = self.buf
+        hdr_len = uavtalk.header_fmt.size
+
+        if self.gcs_timestamps:
+            log_hdr_len = uavtalk.logheader_fmt.size
+        else:
+            log_hdr_len = 0
+
+        pos = self._candidates(start)
+
+        pack_type = buf[pos + 1].astype(np.int64) & ~uavtalk.TYPE_MASK
+        pack_len = buf[pos + 2].astype(np.int64) | (buf[pos + 3].astype(np.int64) << 8)
+        obj_id = (buf[pos + 4].astype(np.int64) |
+                (buf[pos + 5].astype(np.int64) << 8) |
+                (buf[pos + 6].astype(np.int64) << 16) |
+                (buf[pos + 7].astype(np.int64) << 24))
+
+        # Look up each distinct object id once
+        ids = np.unique(obj_id)
+        which = np.searchsorted(ids, obj_id)
+
+        classes = [ self.uavo_defs.get('{0:08x}'.format(i)) for i in ids ]
+
+        known = np.array([ c is not None for c in classes ], dtype=bool)
+        obj_len = np.array([ c.get_size_of_data() if c is not None else 0
+                for c in classes ], dtype=np.int64)
+        inst_len = np.array([ 2 if c is not None and not c._single else 0
+                for c in classes ], dtype=np.int64)
+
+        is_known = known[which]
+        has_data = ~np.isin(pack_type, NODATA_TYPES)
+        has_ts = has_data & is_known & np.isin(pack_type,
+                (uavtalk.TYPE_OBJ_TS, uavtalk.TYPE_OBJ_ACK_TS))
+
+        # Where the CRC is, worked out the way process_stream does
+        calc_size = np.where(is_known,
+                hdr_len + inst_len[which] + 2 * has_ts + obj_len[which],
+                pack_len)
+        calc_size[~has_data] = hdr_len
+
+        valid = ((pack_len >= uavtalk.MIN_HEADER_LENGTH) &
+                (pack_len <= uavtalk.MAX_HEADER_LENGTH + uavtalk.MAX_PAYLOAD_LENGTH) &
+                (calc_size == pack_len) &
+                (pos + calc_size < len(buf)))
+
+        if self.gcs_timestamps:
+            valid &= pos >= log_hdr_len
+
+        del pack_type, pack_len, obj_id
+
+        for size in np.unique(calc_size[valid]):
+            sel = np.flatnonzero(valid & (calc_size == size))
+            valid[sel] = crc8(buf, pos[sel], size) == buf[pos[sel] + size]
+
+        pos = pos[valid]
+        calc_size = calc_size[valid]
+        has_data = has_data[valid]
+        has_ts = has_ts[valid]
+        is_known = is_known[valid]
+        which = which[valid]
+
+        # A good packet is followed by the next good one at or after its
+        # end; anything between is skipped as process_stream would.  Almost
+        # always that's simply the next one, so only the exceptions are
+        # walked one at a time.
+        n = len(pos)
+        succ = np.searchsorted(pos, pos + calc_size + 1 + log_hdr_len)
+
+        jumps = np.flatnonzero(succ != np.arange(1, n + 1))
+        jump_to = succ[jumps].tolist()
+        jumps = jumps.tolist()
+
+        chain = np.zeros(n + 1, dtype=np.int64)
+        i = 0
+        k = 0
+
+        while i < n:
+            k = bisect.bisect_left(jumps, i, k)
+
+            # Everything from i up to the next jump is in sequence
+            end = jumps[k] if k < len(jumps) else n - 1
+            chain[i] += 1
+            chain[end + 1] -= 1
+
+            if k == len(jumps):
+                break
+
+            i = jump_to[k]
+
+        chain = np.flatnonzero(np.cumsum(chain[:n]))
+
+        pos = pos[chain]
+        has_data = has_data[chain]
+        has_ts = has_ts[chain]
+        is_known = is_known[chain]
+        which = which[chain]
+
+        timestamps = self._timestamps(pos, has_ts, inst_len[which])
+
+        # Group the objects by type, keeping log order within each
+        emit = has_data & is_known
+
+        self.packets = {}
+
+        for w in np.unique(which[emit]):
+            sel = np.flatnonzero(emit & (which == w))
+
+            self.packets[classes[w]] = (pos[sel], has_ts[sel], timestamps[sel])
+
+    def _timestamps(self, pos, has_ts, inst):
+        """ Millisecond timestamps for each packet, unwrapping the 16 bit
+        packet timestamps and carrying the last one through packets without
+        one. """
+        buf = self.buf
+
+        if self.gcs_timestamps:
+            p = pos - uavtalk.logheader_fmt.size
+
+            return (buf[p].astype(np.int64) |
+                    (buf[p + 1].astype(np.int64) << 8) |
+                    (buf[p + 2].astype(np.int64) << 16) |
+                    (buf[p + 3].astype(np.int64) << 24))
+
+        idx = np.flatnonzero(has_ts)
+        p = pos[idx] + uavtalk.header_fmt.size
+
+        # Multi-instance objects have the instance id first
+        p = p + inst[idx]
+
+        raw = buf[p].astype(np.int64) | (buf[p + 1].astype(np.int64) << 8)
+
+        wraps = np.zeros(len(raw), dtype=np.int64)
+        wraps[1:] = raw[1:] < raw[:-1]
+
+        unwrapped = np.zeros(len(pos), dtype=np.int64)
+        unwrapped[idx] = raw + 65536 * np.cumsum(wraps)
+
+        last = np.where(has_ts, np.arange(len(pos)), -1)
+        last = np.maximum.accumulate(last) if len(last) else last
+
+        return np.where(last >= 0, unwrapped[np.maximum(last, 0)], 0)
+
+    def types(self):
+        """ The UAVO classes that appear in the log """
+        return sorted(self.packets.keys(), key=lambda c: c._name)
+
+    def count(self, match_class):
+        """ How many instances of match_class the log contains """
+        if match_class not in self.packets:
+            return 0
+
+        return len(self.packets[match_class][0])
+
+    def __contains__(self, match_class):
+        return match_class in self.packets
+
+    def __getitem__(self, match_class):
+        """ The decoded array for a UAVO class, or its name """
+        if not isinstance(match_class, type):
+            name = match_class
+            match_class = self.uavo_defs.find_by_name(name)
+
+            if match_class is None:
+                raise KeyError(name)
+
+        return self.as_numpy_array(match_class)
+
+    def as_numpy_array(self, match_class):
+        """ Transforms all instances of a given object to a numpy array, like
+        TelemetryBase.as_numpy_array.  Decoded arrays are cached.
+
+        match_class: the UAVO_* class you'd like to match.
+        """
+
+        if match_class in self.decoded:
+            return self.decoded[match_class]
+
+        arr = self._decode(match_class)
+        self.decoded[match_class] = arr
+
+        return arr
+
+    def _decode(self, cls):
+        """ Gathers the payloads of one type and views them as its wire
+        layout, filling in the header fields """
+        out = np.zeros(self.count(cls), dtype=cls._dtype)
+
+        if len(out) == 0:
+            return out
+
+        buf = self.buf
+        pos, has_ts, timestamps = self.packets[cls]
+
+        inst_len = 0 if cls._single else 2
+        data = pos + uavtalk.header_fmt.size + inst_len + 2 * has_ts
+
+        wire = wire_dtype(cls)
+        cols = np.arange(wire.itemsize)
+
+        out['name'] = cls._name
+        out['time'] = timestamps / 1000.0
+        out['uavo_id'] = cls._id
+
+        if inst_len:
+            p = pos + uavtalk.header_fmt.size
+            out['inst_id'] = buf[p].astype(np.uint32) | (buf[p + 1].astype(np.uint32) << 8)
+
+        for lo in range(0, len(out), DECODE_CHUNK):
+            hi = min(lo + DECODE_CHUNK, len(out))
+
+            rows = buf[data[lo:hi, None] + cols]
+            rec = np.frombuffer(rows, dtype=wire)
+
+            for name in wire.names:
+                out[name][lo:hi] = rec[name]
+
+        return out
@@ -59,9 +59,13 @@ class TelemetryBase(with_metaclass(ABCMeta)):
         self.githash = githash
 
         self.uavo_defs = uavo_defs
+
+        # Metadata received, by the id of the object it describes
+        self.metadata = {}
+
         self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
             use_walltime=use_walltime, gcs_timestamps=gcs_timestamps,
-            progress_callback=progress_callback)
+            progress_callback=progress_callback, metadata=self.metadata)
 
         self.uavtalk_generator.send(None)
 
@@ -175,6 +179,48 @@ class TelemetryBase(with_metaclass(ABCMeta)):
 
             self.send_object(send_obj)
 
+    def get_metadata(self, obj, timeout=5.0):
+        """ Fetches obj's metadata from the flight side, as a (flags,
+        telemetry period, gcs period, logging period) tuple. """
+        if not self.do_handshaking:
+            raise ValueError("Can only request on handshaking/bidir sessions")
+
+        with self.cond:
+            self.metadata.pop(obj._id, None)
+
+        self._send(uavtalk.request_metadata(obj))
+
+        finish_time = time.time() + timeout
+
+        with self.cond:
+            while obj._id not in self.metadata:
+                remaining = finish_time - time.time()
+
+                if remaining <= 0:
+                    raise ValueError("No metadata received for %s" % (obj._name))
+
+                if self.service_in_iter:
+                    # Nothing else reads the connection
+                    self.cond.release()
+                    try:
+                        self.service_connection(remaining)
+                    finally:
+                        self.cond.acquire()
+                else:
+                    self.cond.wait(remaining)
+
+            return self.metadata[obj._id]
+
+    def set_telemetry_period(self, obj, period):
+        """ Asks the flight side to send obj every period ms. """
+        if not self.do_handshaking:
+            raise ValueError("Can only change metadata on handshaking/bidir sessions")
+
+        current = self.get_metadata(obj)
+
+        self._send(uavtalk.send_metadata(obj, current,
+                uavtalk.UPDATEMODE_PERIODIC, period))
+
     def request_object(self, obj):
         if not self.do_handshaking:
             raise ValueError("Can only request on handshaking/bidir sessions")
@@ -617,6 +663,52 @@ class HIDTelemetry(BidirTelemetry):
 
         return did_stuff
 
+def read_log_header(f):
+    """ Reads the header the GCS and flight side write at the start of a
+    log, leaving f at the first byte after it.  Returns the git hash the
+    log was written with.
+
+    Raises IOError if there's no recognizable header.
+    """
+
+    # Check the header signature
+    #    First line is "dRonin git hash:" or "Tau Labs git hash:"
+    #    Second line is the actual git hash
+    #    Third line is the UAVO hash
+    #    Fourth line is "##" (only from GCS)
+
+    # Scan up to 100 "lines" looking for the signature, in case
+    # there's garbage at the beginning of the log
+    found = False
+
+    for i in range(100):
+        sig = f.readline()
+        if sig.endswith(b'dRonin git hash:\n') or sig.endswith(b'Tau Labs git hash:\n'):
+            found = True
+            break;
+
+    if not found:
+        print("Source file does not have a recognized header signature")
+        raise IOError("no header signature")
+
+    # Determine the git hash that this log file is based on
+    githash = f.readline()[:-1]
+    if githash.find(b':') != -1:
+        import re
+        githash = re.search(b':(\w*)\W', githash).group(1)
+
+    # For python3, convert from byte string.
+    githash = githash.decode('latin-1')
+
+    print("Log file is based on git hash: %s" % githash)
+
+    uavohash = f.readline()
+    # divider only occurs on GCS-type streams.  This causes us to
+    # miss first objects in telemetry-type streams
+    # divider = f.readline()
+
+    return githash
+
 class FileTelemetry(TelemetryBase):
     """ Telemetry interface to data in a file """
 
@@ -635,41 +727,7 @@ class FileTelemetry(TelemetryBase):
         self.f = file_obj
 
         if parse_header:
-            # Check the header signature
-            #    First line is "dRonin git hash:" or "Tau Labs git hash:"
-            #    Second line is the actual git hash
-            #    Third line is the UAVO hash
-            #    Fourth line is "##" (only from GCS)
-
-            # Scan up to 100 "lines" looking for the signature, in case
-            # there's garbage at the beginning of the log
-            found = False
-
-            for i in range(100):
-                sig = self.f.readline()
-                if sig.endswith(b'dRonin git hash:\n') or sig.endswith(b'Tau Labs git hash:\n'):
-                    found = True
-                    break;
-
-            if not found:
-                print("Source file does not have a recognized header signature")
-                raise IOError("no header signature")
-
-            # Determine the git hash that this log file is based on
-            githash = self.f.readline()[:-1]
-            if githash.find(b':') != -1:
-                import re
-                githash = re.search(b':(\w*)\W', githash).group(1)
-
-            # For python3, convert from byte string.
-            githash = githash.decode('latin-1')
-
-            print("Log file is based on git hash: %s" % githash)
-
-            uavohash = self.f.readline()
-            # divider only occurs on GCS-type streams.  This causes us to
-            # miss first objects in telemetry-type streams
-            # divider = self.f.readline()
+            githash = read_log_header(self.f)
 
             TelemetryBase.__init__(self, iter_blocks=True,
                 do_handshaking=False, githash=githash, use_walltime=False,
@@ -679,14 +737,56 @@ class FileTelemetry(TelemetryBase):
                 do_handshaking=False, use_walltime=False, *args, **kwargs)
 
         self.done=False
+        self.compressed = None
 
     def _receive(self, finish_time):
         """ Fetch available data from file """
 
+        if self.compressed is None:
+            # The GCS raw recorder can write the body as compressed blocks
+            head = self.f.read(7)
+
+            self.compressed = (head == b'##\nDRLZ')
+
+            if not self.compressed:
+                return head + self.f.read(524288)
+
+            return self._read_block()
+
+        if self.compressed:
+            if self.f.read(4) != b'DRLZ':
+                # Block index or end of file
+                return b''
+
+            return self._read_block()
+
         buf = self.f.read(524288)   # 512k
 
         return buf
 
+    def _read_block(self):
+        """ Inflate one compressed block, the magic already consumed """
+        return read_compressed_block(self.f)
+
+def read_compressed_block(f):
+    """ Inflates one block of a compressed log body, the DRLZ magic already
+    consumed.  Returns b'' at a short read. """
+    import struct
+    import zlib
+
+    hdr = f.read(12)
+    if len(hdr) < 12:
+        return b''
+
+    first_ts, raw_size, comp_size = struct.unpack('<III', hdr)
+
+    # qCompress() output: big endian length, then a zlib stream
+    data = f.read(comp_size)
+    if len(data) < comp_size:
+        return b''
+
+    return zlib.decompress(data[4:])
+
 def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
         iter_blocks=True):
     """ Parses command line to decide how to get a telemetry object. """
@@ -45,7 +45,11 @@ class UAVTupleClass():
 
     def to_bytes(self):
         """ Serializes this object into a byte stream. """
-        return self._packstruct.pack(*flatten(self[3:]))
+        if self._single:
+            return self._packstruct.pack(*flatten(self[3:]))
+
+        # Skip the instance id too
+        return self._packstruct.pack(*flatten(self[4:]))
 
     @classmethod
     def get_size_of_data(cls):
@@ -188,9 +192,16 @@ struct_element_map = {
     'enum'    : 'B',
     }
 
-# This is a very long, scary method.  It parses an XML file describing
-# a UAVO and builds an implementation class.
 def make_class(collection, xml_file, update_globals=True):
+    """ Parses an XML file describing a UAVO and builds an implementation
+    class. """
+    return make_class_from_descriptor(parse_xml(collection, xml_file),
+            update_globals=update_globals)
+
+# This is a very long, scary method.  It parses an XML file describing
+# a UAVO into a descriptor: plain data, from which make_class_from_descriptor
+# builds the class without needing the XML or any other class.
+def parse_xml(collection, xml_file):
     fields = []
 
     ##### PARSE THE XML FILE INTO INTERNAL REPRESENTATIONS #####
@@ -357,7 +368,7 @@ def make_class(collection, xml_file, update_globals=True):
 
         formats.append('' + f['elements'].__str__() + struct_element_map[f['type']])
 
-    fmt = Struct('<' + ''.join(formats))
+    fmt = '<' + ''.join(formats)
 
     ##### CALCULATE THE NUMPY TYPE ASSOCIATED WITH THIS CLASS #####
     dtype  = [('name', 'S20'), ('time', 'double'), ('uavo_id', 'uint')]
@@ -371,25 +382,44 @@ def make_class(collection, xml_file, update_globals=True):
         else:
             dtype += [(f['name'], type_numpy_map[f['type']])]
 
-    ##### DYNAMICALLY CREATE A CLASS TO CONTAIN THIS OBJECT #####
     tuple_fields = ['name', 'time', 'uavo_id']
     if not is_single_inst:
         tuple_fields.append("inst_id")
 
     tuple_fields.extend([f['name'] for f in fields])
 
-    name = 'UAVO_' + name
+    return {
+        'name'         : 'UAVO_' + name,
+        'id'           : uavo_id,
+        'single'       : is_single_inst,
+        'settings'     : is_settings,
+        'fields'       : fields,
+        'tuple_fields' : tuple_fields,
+        'format'       : fmt,
+        'flat'         : is_flat,
+        'num_subelems' : num_subelems,
+        'dtype'        : dtype,
+        }
+
+def make_class_from_descriptor(desc, update_globals=True):
+    """ Builds the implementation class for a descriptor from parse_xml """
 
-    class tmpClass(UAVTupleClass, namedtuple(name, tuple_fields)):
-        _packstruct = fmt
-        _flat = is_flat
+    name = desc['name']
+    fields = desc['fields']
+    uavo_id = desc['id']
+
+    ##### DYNAMICALLY CREATE A CLASS TO CONTAIN THIS OBJECT #####
+    class tmpClass(UAVTupleClass, namedtuple(name, desc['tuple_fields'])):
+        _packstruct = Struct(desc['format'])
+        _flat = desc['flat']
         _name = name
         _id = uavo_id
-        _single = is_single_inst
-        _num_subelems = num_subelems
-        _dtype = dtype
-        _is_settings = is_settings
+        _single = desc['single']
+        _num_subelems = desc['num_subelems']
+        _dtype = desc['dtype']
+        _is_settings = desc['settings']
         _units = {f['name'] : f['units'] for f in fields}
+        _elemnames = {f['name'] : f['elementnames'] for f in fields}
 
     # This is magic for two reasons.  First, we create the class to have
     # the proper dynamic name.  Second, we override __slots__, so that
@@ -10,10 +10,107 @@ Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER
 from . import uavo
 
 import operator
+import os
 import os.path as op
 
 GITHASH_OF_LAST_RESORT = 'Release-20160120.3'
 
+# Bump when the descriptors uavo.parse_xml produces change meaning without
+# uavo.py itself changing
+CACHE_VERSION = 1
+
+def cache_dir():
+    """ Where compiled definition sets are kept.  DRONIN_UAVO_CACHE overrides
+    the location; setting it empty turns the cache off. """
+    path = os.environ.get('DRONIN_UAVO_CACHE')
+
+    if path is not None:
+        return path or None
+
+    base = os.environ.get('XDG_CACHE_HOME') or op.join(op.expanduser('~'), '.cache')
+
+    return op.join(base, 'dronin', 'uavo')
+
+def definition_hash(content_list):
+    """ Identifies a set of definitions, and the code that compiles them """
+    import hashlib
+    import sys
+
+    h = hashlib.sha1()
+
+    h.update(('%d %d\n' % (CACHE_VERSION, sys.version_info[0])).encode())
+
+    try:
+        with open(uavo.__file__.replace('.pyc', '.py'), 'rb') as f:
+            h.update(f.read())
+    except IOError:
+        # No source to look at; CACHE_VERSION will have to do
+        pass
+
+    digests = []
+
+    for contents in content_list:
+        if not isinstance(contents, bytes):
+            contents = contents.encode('utf-8')
+
+        digests.append(hashlib.sha1(contents).hexdigest())
+
+    # The same files in any order are the same set
+    for d in sorted(digests):
+        h.update(d.encode())
+
+    return h.hexdigest()
+
+def load_cached(key):
+    """ The descriptors stored under key, or None """
+    import pickle
+
+    path = cache_dir()
+    if path is None:
+        return None
+
+    try:
+        with open(op.join(path, key), 'rb') as f:
+            stored_key, descriptors = pickle.load(f)
+    except Exception:
+        # Missing, or unreadable; either way it'll be rebuilt
+        return None
+
+    if stored_key != key:
+        return None
+
+    return descriptors
+
+def store_cached(key, descriptors):
+    """ Stores descriptors under key.  Other processes may be reading or
+    writing the same entry, so it's written aside and renamed into place. """
+    import pickle
+    import tempfile
+
+    path = cache_dir()
+    if path is None:
+        return
+
+    try:
+        if not op.isdir(path):
+            os.makedirs(path)
+
+        fd, tmp_name = tempfile.mkstemp(dir=path, prefix='.' + key)
+
+        with os.fdopen(fd, 'wb') as f:
+            pickle.dump((key, descriptors), f, 2)
+
+        try:
+            os.rename(tmp_name, op.join(path, key))
+        except OSError:
+            # Windows won't rename over an existing file; someone else
+            # already stored it.
+            os.remove(tmp_name)
+    except Exception:
+        # A cache that can't be written (read only home directory, etc)
+        # just means compiling every time.
+        pass
+
 class UAVOCollection(dict):
     def __init__(self):
         self.clear()
@@ -34,7 +131,27 @@ class UAVOCollection(dict):
 
         return objs
 
+    def add_descriptors(self, descriptors):
+        for desc in descriptors:
+            u = uavo.make_class_from_descriptor(desc)
+
+            # add this uavo definition to our dictionary
+            self.update([('{0:08x}'.format(u._id), u)])
+
     def from_file_contents(self, content_list):
+        """ Adds the classes for a list of XML definitions, compiling them
+        only if they're not already in the cache.  Returns the descriptors
+        of the classes added. """
+        key = definition_hash(content_list)
+
+        descriptors = load_cached(key)
+
+        if descriptors is not None:
+            self.add_descriptors(descriptors)
+            return descriptors
+
+        descriptors = []
+
         some_processed = True
 
         # There are dependencies here
@@ -46,11 +163,14 @@ class UAVOCollection(dict):
             # Build up the UAV objects from the xml definitions
             for contents in content_list:
                 try:
-                    u = uavo.make_class(self, contents)
+                    desc = uavo.parse_xml(self, contents)
+                    u = uavo.make_class_from_descriptor(desc)
 
                     # add this uavo definition to our dictionary
                     self.update([('{0:08x}'.format(u._id), u)])
 
+                    descriptors.append(desc)
+
                     some_processed = True
                 except Exception:
                     unprocessed.append(contents)
@@ -60,6 +180,10 @@ class UAVOCollection(dict):
         if len(content_list):
             raise Exception("Unable to parse some uavo files")
 
+        store_cached(key, descriptors)
+
+        return descriptors
+
     def from_tar_file(self, t):
         # Get the file members
         content_list = []
@@ -75,7 +199,7 @@ class UAVOCollection(dict):
             content_list.append(f.read())
             f.close()
 
-        self.from_file_contents(content_list)
+        return self.from_file_contents(content_list)
 
     def from_tar_bytes(self, contents):
         from io import BytesIO
@@ -86,7 +210,7 @@ class UAVOCollection(dict):
 
         # feed the tar file data to a tarfile object
         with tarfile.open(fileobj=fobj) as t:
-            self.from_tar_file(t)
+            return self.from_tar_file(t)
 
     def from_git_hash(self, githashes):
         if not isinstance(githashes, list):
@@ -103,6 +227,25 @@ class UAVOCollection(dict):
                 # Get the directory where the code is located
                 src_dir = op.join(op.dirname(__file__), "..", "..")
 
+                # The id of the definitions' tree names the set exactly,
+                # without having to archive and hash it
+                p = subprocess.Popen(['git', 'rev-parse', '--verify', '-q',
+                                      h + ':shared/uavobjectdefinition'],
+                                     stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                                     cwd=src_dir)
+                tree_id, errors = p.communicate()
+
+                tree_key = None
+
+                if p.returncode == 0:
+                    tree_key = definition_hash([ b'tree ' + tree_id.strip() ])
+
+                    descriptors = load_cached(tree_key)
+
+                    if descriptors is not None:
+                        self.add_descriptors(descriptors)
+                        return
+
                 p = subprocess.Popen(['git', 'archive', h, '--', 'shared/uavobjectdefinition/'],
                                      stdout=subprocess.PIPE, stderr=subprocess.PIPE,
                                      cwd=src_dir)
@@ -110,7 +253,11 @@ class UAVOCollection(dict):
                 git_archive_data, git_archive_errors = p.communicate()
 
                 if p.returncode == 0:
-                    self.from_tar_bytes(git_archive_data)
+                    descriptors = self.from_tar_bytes(git_archive_data)
+
+                    if tree_key is not None:
+                        store_cached(tree_key, descriptors)
+
                     return
             except Exception:
                 # Popen isn't available on GAE, so all of the above fails.
@@ -139,7 +286,7 @@ class UAVOCollection(dict):
         content_list = []
 
         for file_name in glob.glob(os.path.join(path, '*.xml')):
-            with open(file_name, 'rU') as f:
+            with open(file_name, 'rb') as f:
                 content_list.append(f.read())
 
-        self.from_file_contents(content_list)
+        return self.from_file_contents(content_list)
@@ -36,6 +36,14 @@ logheader_fmt = Struct("<IQ")
 timestamp_fmt = Struct("<H")
 instance_fmt = Struct("<H")
 
+# flags(1) + telemetry period(2) + gcs period(2) + logging period(2)
+metadata_fmt = Struct("<BHHH")
+
+# Update modes, see UAVObjUpdateMode
+(UPDATEMODE_MANUAL, UPDATEMODE_PERIODIC, UPDATEMODE_ONCHANGE, UPDATEMODE_THROTTLED) = (0, 1, 2, 3)
+TELEMETRY_UPDATE_MODE_SHIFT = 4
+TELEMETRY_UPDATE_MODE_MASK = 0x3 << TELEMETRY_UPDATE_MODE_SHIFT
+
 # CRC lookup table
 crc_table = [
     0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
@@ -57,12 +65,16 @@ crc_table = [
 ]
 
 def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
-        progress_callback=None):
+        progress_callback=None, metadata=None):
     """Generator function that parses uavotalk stream.
     
     You are expected to send more bytes, or '' to it, until EOF.  Then send
     None.  After that, you may continue to receive objects back because of
-    buffering."""
+    buffering.
+
+    If metadata is a dict, metadata objects received are stored in it as
+    (flags, telemetry period, gcs period, logging period) tuples, keyed by
+    the id of the object they describe."""
 
     # These are used for accounting for timestamp wraparound
     timestamp_base = 0
@@ -257,7 +269,7 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
             last_timestamp = timestamp
             timestamp += timestamp_base
         else:
-            timestamp = last_timestamp
+            timestamp = last_timestamp + timestamp_base
 
         if use_walltime:
             timestamp = int(time.time()*1000.0)
@@ -265,6 +277,13 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
         if gcs_timestamps:
             timestamp = overrideTimestamp
 
+        if (obj is None and metadata is not None and
+                pack_type in (TYPE_OBJ, TYPE_OBJ_ACK) and
+                obj_len == metadata_fmt.size and
+                '{0:08x}'.format(objId - 1) in uavo_defs):
+            metadata[objId - 1] = metadata_fmt.unpack_from(buf,
+                header_fmt.size + buf_offset)
+
         if obj is not None:
             offset = header_fmt.size + instance_len + timestamp_len + buf_offset
             objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
@@ -286,11 +305,37 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=None,
 def send_object(obj):
     """Generates a string containing a UAVTalk packet describing this object"""
 
+    if obj._single:
+        inst = b''
+    else:
+        inst = instance_fmt.pack(obj.inst_id)
+
     hdr = header_fmt.pack(SYNC_VAL, TYPE_OBJ | TYPE_VER,
-        header_fmt.size + obj.get_size_of_data(),
+        header_fmt.size + len(inst) + obj.get_size_of_data(),
         obj._id)
 
-    packet = hdr + obj.to_bytes()
+    packet = hdr + inst + obj.to_bytes()
+
+    packet += int2byte(calcCRC(packet))
+
+    return packet
+
+def send_metadata(obj, current, update_mode, period):
+    """Generates a packet that changes how often the flight side sends obj.
+    current is the object's metadata as received; everything but the flight
+    side's update mode and period is sent back as it was."""
+
+    (flags, _, gcs_period, logging_period) = current
+
+    flags &= ~TELEMETRY_UPDATE_MODE_MASK
+    flags |= update_mode << TELEMETRY_UPDATE_MODE_SHIFT
+    data = metadata_fmt.pack(flags, period, gcs_period, logging_period)
+
+    # The metadata object's id is the next one after the object's
+    hdr = header_fmt.pack(SYNC_VAL, TYPE_OBJ | TYPE_VER,
+        header_fmt.size + len(data), obj._id + 1)
+
+    packet = hdr + data
 
     packet += int2byte(calcCRC(packet))
 
@@ -305,6 +350,15 @@ def request_object(obj):
 
     return packet
 
+def request_metadata(obj):
+    """Makes a request for this object's metadata"""
+    packet = header_fmt.pack(SYNC_VAL, TYPE_OBJ_REQ | TYPE_VER,
+        header_fmt.size, obj._id + 1)
+
+    packet += int2byte(calcCRC(packet))
+
+    return packet
+
 def calcCRC(s):
     """
     Calculate a CRC consistently with how they are computed on the firmware side
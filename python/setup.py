@@ -88,7 +88,8 @@ setup(
 
     scripts = [ 'dronin-dumplog', 'dronin-halt',
         'dronin-getconfig', 'dronin-logfsimport',
-        'dronin-shell' ],
+        'dronin-shell', 'dronin-linkbench', 'dronin-simrun',
+        'dronin-decodebench' ],
 #    package_data={
 #        'sample': ['package_data.dat'],
 #    },
@@ -1,11 +1,109 @@
 #!/usr/bin/env python
 
-def main():
+import glob
+import os
+import shutil
+import tempfile
+import time
 
-    # Load the UAVO xml files in the workspace
+XML_PATH = 'shared/uavobjectdefinition'
+
+def load_definitions():
     import dronin
     uavo_defs = dronin.uavo_collection.UAVOCollection()
-    uavo_defs.from_uavo_xml_path('shared/uavobjectdefinition')
+    uavo_defs.from_uavo_xml_path(XML_PATH)
+
+    return uavo_defs
+
+def read_definitions():
+    content_list = []
+
+    for file_name in sorted(glob.glob(os.path.join(XML_PATH, '*.xml'))):
+        with open(file_name, 'rb') as f:
+            content_list.append(f.read())
+
+    return content_list
+
+def describe(uavo_defs):
+    """ Everything about the classes that the cache has to reproduce """
+    desc = {}
+
+    for key, u in uavo_defs.items():
+        enums = dict((name, getattr(u, name)) for name in dir(u)
+                if name.startswith('ENUM'))
+
+        desc[key] = (u._name, u._id, u._single, u._is_settings, u._flat,
+                u._fields, u._packstruct.size, u._num_subelems, u._dtype,
+                u._units, u._elemnames, u.__new__.__defaults__, enums)
+
+    return desc
+
+def test_cache():
+    """ Load the definitions cold, then warm from the cache """
+    from dronin import uavo_collection
+
+    cache = tempfile.mkdtemp()
+    os.environ['DRONIN_UAVO_CACHE'] = cache
+
+    try:
+        start = time.time()
+        cold = load_definitions()
+        cold_secs = time.time() - start
+
+        assert len(os.listdir(cache)) == 1
+
+        warm_secs = None
+
+        for i in range(5):
+            start = time.time()
+            warm = load_definitions()
+            warm_secs = min(warm_secs or 1e9, time.time() - start)
+
+        print("%d UAVOs: %.1f ms cold, %.1f ms warm" %
+                (len(cold), cold_secs * 1000, warm_secs * 1000))
+
+        # Timings are only reported; they vary too much with machine load
+        assert describe(cold) == describe(warm)
+
+        # The entry is keyed by the definitions and matches a parse that
+        # doesn't use the cache at all
+        content_list = read_definitions()
+        entry = os.path.join(cache, uavo_collection.definition_hash(content_list))
+
+        assert os.listdir(cache) == [os.path.basename(entry)]
+
+        os.environ['DRONIN_UAVO_CACHE'] = ''
+        uncached = load_definitions()
+        os.environ['DRONIN_UAVO_CACHE'] = cache
+
+        assert describe(uncached) == describe(warm)
+
+        # Different definitions are a different entry
+
+        fewer = uavo_collection.UAVOCollection()
+        fewer.from_file_contents(content_list[1:])
+
+        assert len(fewer) == len(cold) - 1
+        assert len(os.listdir(cache)) == 2
+
+        # A damaged entry is ignored and replaced
+        with open(entry, 'wb') as f:
+            f.write(b'garbage')
+
+        assert describe(load_definitions()) == describe(cold)
+        assert os.path.getsize(entry) > 100
+    finally:
+        shutil.rmtree(cache)
+        del os.environ['DRONIN_UAVO_CACHE']
+
+def main():
+
+    # Load the UAVO xml files in the workspace
+    os.environ['DRONIN_UAVO_CACHE'] = ''
+    load_definitions()
+    del os.environ['DRONIN_UAVO_CACHE']
+
+    test_cache()
 
 #-------------------------------------------------------------------------------
 if __name__ == "__main__":